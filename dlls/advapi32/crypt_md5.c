@@ -33,6 +33,8 @@
  * will fill a supplied 16-byte array with the digest.
  */
 
+#include "config.h"
+
 #include <stdarg.h>
 
 #include "windef.h"
@@ -47,9 +49,9 @@ typedef struct
 
 static void MD5Transform( unsigned int buf[4], const unsigned int in[16] );
 
-/*
- * Note: this code is harmless on little-endian machines.
- */
+#ifndef WORDS_BIGENDIAN
+#define byteReverse( buf, longs ) /* Nothing */
+#else
 static void byteReverse( unsigned char *buf, unsigned longs )
 {
     unsigned int t;
@@ -61,6 +63,7 @@ static void byteReverse( unsigned char *buf, unsigned longs )
         buf += 4;
     } while (--longs);
 }
+#endif
 
 /*
  * Start MD5 accumulation.  Set bit count to 0 and buffer to mysterious
@@ -117,10 +120,18 @@ VOID WINAPI MD5Update( MD5_CTX *ctx, const unsigned char *buf, unsigned int len
     /* Process data in 64-byte chunks */
     while (len >= 64)
     {
-        memcpy( ctx->in, buf, 64 );
-        byteReverse( ctx->in, 16 );
+#ifndef WORDS_BIGENDIAN
+        /* Aligned input can be used in place */
+        if (!((ULONG_PTR)buf & 3))
+            MD5Transform( ctx->buf, (const unsigned int *)buf );
+        else
+#endif
+        {
+            memcpy( ctx->in, buf, 64 );
+            byteReverse( ctx->in, 16 );
 
-        MD5Transform( ctx->buf, (unsigned int *)ctx->in );
+            MD5Transform( ctx->buf, (unsigned int *)ctx->in );
+        }
 
         buf += 64;
         len -= 64;
@@ -96,6 +96,119 @@ static void SHA1Transform(ULONG State[5], UCHAR Buffer[64])
    a = b = c = d = e = 0;
 }
 
+/* Processors with the SHA extensions get a transform using them. */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA_NI_KERNELS
+
+#ifdef __i386__
+#define SHA_NI_FUNC __attribute__((__target__("sha,sse4.1,ssse3"), __force_align_arg_pointer__))
+#else
+#define SHA_NI_FUNC __attribute__((__target__("sha,sse4.1,ssse3")))
+#endif
+
+static BOOL use_sha_ni(void)
+{
+   static int supported = -1;
+   unsigned int eax, ebx, ecx, edx;
+
+   if (supported == -1)
+   {
+      supported = 0;
+      if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3) && (ecx & bit_SSE4_1) &&
+          __get_cpuid_max(0, NULL) >= 7)
+      {
+         __cpuid_count(7, 0, eax, ebx, ecx, edx);
+         supported = (ebx & (1 << 29)) != 0;
+      }
+   }
+   return supported;
+}
+
+/* Four rounds, with the message schedule for the following rounds
+ * interleaved. m0 holds the words for these rounds, m1 to m3 the next ones. */
+#define SHA1_NI_ROUNDS(i, e_in, e_out, m0, m1, m2, m3) \
+   e_in = _mm_sha1nexte_epu32(e_in, m0); \
+   e_out = abcd; \
+   if (i >= 3 && i <= 18) m1 = _mm_sha1msg2_epu32(m1, m0); \
+   abcd = _mm_sha1rnds4_epu32(abcd, e_in, (i) / 5); \
+   if (i >= 1 && i <= 16) m3 = _mm_sha1msg1_epu32(m3, m0); \
+   if (i >= 2 && i <= 17) m2 = _mm_xor_si128(m2, m0);
+
+static void SHA_NI_FUNC SHA1Transform_ni(ULONG State[5], const UCHAR *Buffer, UINT Blocks)
+{
+   const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+   __m128i abcd, e0, e1, abcd_save, e_save, msg0, msg1, msg2, msg3;
+
+   abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)State), 0x1b);
+   e0 = _mm_set_epi32(State[4], 0, 0, 0);
+
+   for (; Blocks; Blocks--, Buffer += 64)
+   {
+      abcd_save = abcd;
+      e_save = e0;
+
+      msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)Buffer), mask);
+      e0 = _mm_add_epi32(e0, msg0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+      msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 16)), mask);
+      SHA1_NI_ROUNDS( 1, e1, e0, msg1, msg2, msg3, msg0);
+      msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 32)), mask);
+      SHA1_NI_ROUNDS( 2, e0, e1, msg2, msg3, msg0, msg1);
+      msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 48)), mask);
+      SHA1_NI_ROUNDS( 3, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_NI_ROUNDS( 4, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_NI_ROUNDS( 5, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_NI_ROUNDS( 6, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_NI_ROUNDS( 7, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_NI_ROUNDS( 8, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_NI_ROUNDS( 9, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_NI_ROUNDS(10, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_NI_ROUNDS(11, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_NI_ROUNDS(12, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_NI_ROUNDS(13, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_NI_ROUNDS(14, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_NI_ROUNDS(15, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_NI_ROUNDS(16, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_NI_ROUNDS(17, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_NI_ROUNDS(18, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_NI_ROUNDS(19, e1, e0, msg3, msg0, msg1, msg2);
+
+      e0 = _mm_sha1nexte_epu32(e0, e_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+   }
+
+   _mm_storeu_si128((__m128i *)State, _mm_shuffle_epi32(abcd, 0x1b));
+   State[4] = _mm_extract_epi32(e0, 3);
+}
+
+#endif /* SHA_NI_KERNELS */
+
+/* Hash whole 64-byte blocks, without modifying the input. */
+static void SHA1Blocks(ULONG State[5], const UCHAR *Buffer, UINT Blocks)
+{
+   ULONG Block[16];
+
+#ifdef SHA_NI_KERNELS
+   if (use_sha_ni())
+   {
+      SHA1Transform_ni(State, Buffer, Blocks);
+      return;
+   }
+#endif
+   for (; Blocks; Blocks--, Buffer += 64)
+   {
+      RtlCopyMemory(Block, Buffer, 64);
+      SHA1Transform(State, (UCHAR *)Block);
+   }
+}
+
 
 /******************************************************************************
  * A_SHAInit [ADVAPI32.@]
@@ -152,16 +265,22 @@ A_SHAUpdate(PSHA_CTX Context, const unsigned char *Buffer, UINT BufferSize)
    }
    else
    {
-      while (BufferContentSize + BufferSize >= 64)
+      if (BufferContentSize)
       {
          RtlCopyMemory(Context->Buffer + BufferContentSize, Buffer,
                        64 - BufferContentSize);
          Buffer += 64 - BufferContentSize;
          BufferSize -= 64 - BufferContentSize;
-         SHA1Transform(Context->State, Context->Buffer);
-         BufferContentSize = 0;
+         SHA1Blocks(Context->State, Context->Buffer, 1);
+      }
+      /* Whole blocks are hashed straight from the caller's buffer */
+      if (BufferSize >= 64)
+      {
+         SHA1Blocks(Context->State, Buffer, BufferSize / 64);
+         Buffer += BufferSize & ~63;
+         BufferSize &= 63;
       }
-      RtlCopyMemory(Context->Buffer + BufferContentSize, Buffer, BufferSize);
+      RtlCopyMemory(Context->Buffer, Buffer, BufferSize);
    }
 }
 
@@ -273,6 +273,7 @@ typedef struct tagLISTVIEW_INFO
   /* sorting */
   PFNLVCOMPARE pfnCompare;      /* sorting callback pointer */
   LPARAM lParamSort;
+  BOOL bSorted;                 /* items are known to be in the order of the LVS_SORT* style */
 
   /* style */
   DWORD dwStyle;		/* the cached window GWL_STYLE */
@@ -4246,6 +4247,9 @@ static BOOL set_main_item(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem, BOOL
     if (lpLVItem->mask & LVIF_TEXT)
         textsetptrT(&lpItem->hdr.pszText, lpLVItem->pszText, isW);
 
+    /* the item may now be out of order */
+    if (!isNew && (uChanged & LVIF_TEXT)) infoPtr->bSorted = FALSE;
+
     if (lpLVItem->mask & LVIF_IMAGE)
 	lpItem->hdr.iImage = lpLVItem->iImage;
 
@@ -7695,23 +7699,50 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
     {
         HDPA hItem;
         ITEM_INFO *item_s;
-        INT i = 0, cmpv;
+        INT low = 0, high = infoPtr->nItemCount, i, cmpv;
+        LPWSTR text = textdupTtoW(lpLVItem->pszText, isW);
+
+        /* find the first item that doesn't sort before the new one */
+        if (infoPtr->bSorted)
+        {
+            while (low < high)
+            {
+                i = (low + high) / 2;
+                hItem  = DPA_GetPtr( infoPtr->hdpaItems, i);
+                item_s = DPA_GetPtr(hItem, 0);
 
-        while (i < infoPtr->nItemCount)
+                cmpv = textcmpWT(item_s->hdr.pszText, text, TRUE);
+                if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
+
+                if (cmpv >= 0) high = i;
+                else low = i + 1;
+            }
+        }
+        else
         {
-            hItem  = DPA_GetPtr( infoPtr->hdpaItems, i);
-            item_s = DPA_GetPtr(hItem, 0);
+            while (low < high)
+            {
+                hItem  = DPA_GetPtr( infoPtr->hdpaItems, low);
+                item_s = DPA_GetPtr(hItem, 0);
 
-            cmpv = textcmpWT(item_s->hdr.pszText, lpLVItem->pszText, isW);
-            if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
+                cmpv = textcmpWT(item_s->hdr.pszText, text, TRUE);
+                if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
 
-            if (cmpv >= 0) break;
-            i++;
+                if (cmpv >= 0) break;
+                low++;
+            }
         }
-        nItem = i;
+        textfreeT(text, isW);
+        nItem = low;
+
+        /* an insertion into a list of less than two items keeps it sorted */
+        if (infoPtr->nItemCount < 2) infoPtr->bSorted = TRUE;
     }
     else
+    {
         nItem = min(lpLVItem->iItem, infoPtr->nItemCount);
+        infoPtr->bSorted = FALSE;
+    }
 
     TRACE(" inserting at %d, sorted=%d, count=%d, iItem=%d\n", nItem, is_sorted, infoPtr->nItemCount, lpLVItem->iItem);
     nItem = DPA_InsertPtr( infoPtr->hdpaItems, nItem, hdpaSubItems );
@@ -9142,6 +9173,7 @@ static BOOL LISTVIEW_SortItems(LISTVIEW_INFO *infoPtr, PFNLVCOMPARE pfnCompare,
         DPA_Sort(infoPtr->hdpaItems, LISTVIEW_CallBackCompareEx, (LPARAM)infoPtr);
     else
         DPA_Sort(infoPtr->hdpaItems, LISTVIEW_CallBackCompare, (LPARAM)infoPtr);
+    infoPtr->bSorted = FALSE;
 
     /* restore selection ranges */
     for (i=0; i < infoPtr->nItemCount; i++)
@@ -10907,6 +10939,9 @@ static INT LISTVIEW_StyleChanged(LISTVIEW_INFO *infoPtr, WPARAM wStyleType,
     infoPtr->dwStyle = lpss->styleNew;
     map_style_view(infoPtr);
 
+    if ((lpss->styleOld ^ lpss->styleNew) & (LVS_SORTASCENDING | LVS_SORTDESCENDING))
+        infoPtr->bSorted = FALSE;
+
     if (((lpss->styleOld & WS_HSCROLL) != 0)&&
         ((lpss->styleNew & WS_HSCROLL) == 0))
        ShowScrollBar(infoPtr->hwndSelf, SB_HORZ, FALSE);
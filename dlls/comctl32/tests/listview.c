@@ -2599,6 +2599,121 @@ static void test_sorting(void)
     DestroyWindow(hwnd);
 }
 
+static void test_sorted_insert(void)
+{
+    static const DWORD styles[] = { LVS_SORTASCENDING, LVS_SORTDESCENDING };
+    CHAR text[8], buff[8], prev[8];
+    LVITEMA item;
+    DWORD seed;
+    HWND hwnd;
+    INT i, j, k, r, count;
+
+    for (i = 0; i < 4; i++)
+    {
+        hwnd = create_listview_control(LVS_REPORT | styles[i % 2]);
+        ok(hwnd != NULL, "failed to create a listview window\n");
+
+        /* the insertion point doesn't depend on redraw being enabled */
+        if (i >= 2) SendMessage(hwnd, WM_SETREDRAW, FALSE, 0);
+
+        seed = 12345;
+        for (j = 0; j < 200; j++)
+        {
+            /* few distinct keys, so duplicates are inserted too */
+            for (k = 0; k < 3; k++)
+            {
+                seed = seed * 1103515245 + 12345;
+                text[k] = 'a' + (seed >> 16) % 6;
+            }
+            text[k] = 0;
+
+            item.mask = LVIF_TEXT;
+            item.iItem = j;
+            item.iSubItem = 0;
+            item.pszText = text;
+            r = SendMessage(hwnd, LVM_INSERTITEM, 0, (LPARAM)&item);
+            ok(r >= 0 && r <= j, "%d: got %d for item %d\n", i, r, j);
+
+            item.iItem = r;
+            item.pszText = buff;
+            item.cchTextMax = sizeof(buff);
+            buff[0] = 0;
+            SendMessage(hwnd, LVM_GETITEM, 0, (LPARAM)&item);
+            ok(!lstrcmp(buff, text), "%d: expected %s at %d, got %s\n", i, text, r, buff);
+        }
+
+        if (i >= 2) SendMessage(hwnd, WM_SETREDRAW, TRUE, 0);
+
+        count = SendMessage(hwnd, LVM_GETITEMCOUNT, 0, 0);
+        expect(200, count);
+
+        prev[0] = 0;
+        for (j = 0; j < count; j++)
+        {
+            item.mask = LVIF_TEXT;
+            item.iItem = j;
+            item.iSubItem = 0;
+            item.pszText = buff;
+            item.cchTextMax = sizeof(buff);
+            SendMessage(hwnd, LVM_GETITEM, 0, (LPARAM)&item);
+            if (j)
+            {
+                r = lstrcmp(prev, buff);
+                if (styles[i % 2] == LVS_SORTDESCENDING) r = -r;
+                ok(r <= 0, "%d: item %d %s is out of order after %s\n", i, j, buff, prev);
+            }
+            lstrcpy(prev, buff);
+        }
+
+        DestroyWindow(hwnd);
+    }
+
+    /* items inserted before the sort style is set aren't sorted */
+    hwnd = create_listview_control(LVS_REPORT);
+    ok(hwnd != NULL, "failed to create a listview window\n");
+    for (j = 0; j < 3; j++)
+    {
+        text[0] = "CAB"[j];
+        text[1] = 0;
+        item.mask = LVIF_TEXT;
+        item.iItem = j;
+        item.iSubItem = 0;
+        item.pszText = text;
+        r = SendMessage(hwnd, LVM_INSERTITEM, 0, (LPARAM)&item);
+        expect(j, r);
+    }
+    SetWindowLongA(hwnd, GWL_STYLE, GetWindowLongA(hwnd, GWL_STYLE) | LVS_SORTASCENDING);
+    item.iItem = 3;
+    item.pszText = (LPSTR)"B0";
+    r = SendMessage(hwnd, LVM_INSERTITEM, 0, (LPARAM)&item);
+    expect(0, r);
+    DestroyWindow(hwnd);
+
+    /* changing the text of an item breaks the order too */
+    hwnd = create_listview_control(LVS_REPORT | LVS_SORTASCENDING);
+    ok(hwnd != NULL, "failed to create a listview window\n");
+    for (j = 0; j < 3; j++)
+    {
+        text[0] = "ABC"[j];
+        text[1] = 0;
+        item.mask = LVIF_TEXT;
+        item.iItem = j;
+        item.iSubItem = 0;
+        item.pszText = text;
+        r = SendMessage(hwnd, LVM_INSERTITEM, 0, (LPARAM)&item);
+        expect(j, r);
+    }
+    item.iSubItem = 0;
+    item.pszText = (LPSTR)"D";
+    r = SendMessage(hwnd, LVM_SETITEMTEXT, 0, (LPARAM)&item);
+    expect(TRUE, r);
+    item.iItem = 3;
+    item.pszText = (LPSTR)"C0";
+    r = SendMessage(hwnd, LVM_INSERTITEM, 0, (LPARAM)&item);
+    expect(0, r);
+    DestroyWindow(hwnd);
+}
+
 static void test_ownerdata(void)
 {
     HWND hwnd;
@@ -4819,6 +4934,7 @@ START_TEST(listview)
     test_getitemrect();
     test_subitem_rect();
     test_sorting();
+    test_sorted_insert();
     test_ownerdata();
     test_norecompute();
     test_nosortheader();
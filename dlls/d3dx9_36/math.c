@@ -48,6 +48,242 @@ typedef struct ID3DXMatrixStackImpl
 } ID3DXMatrixStackImpl;
 
 
+/*_________________SSE2 kernels_________________*/
+
+/* The batch transforms and matrix products have SSE2 versions, used when
+ * the processor supports it. They perform the same operations in the same
+ * order as the C versions, so the results only differ where the C code is
+ * compiled to x87 instructions. */
+#if defined(__x86_64__) || (defined(__i386__) && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+
+#include <emmintrin.h>
+
+#define D3DX_SSE2_KERNELS
+
+#ifdef __i386__
+#define SSE2_FUNC __attribute__((__target__("sse2"), __force_align_arg_pointer__))
+#else
+#define SSE2_FUNC
+#endif
+
+static BOOL use_sse2(void)
+{
+    static int supported = -1;
+
+    if (supported == -1)
+        supported = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE);
+    return supported;
+}
+
+static void SSE2_FUNC matrix_multiply_sse2(D3DXMATRIX *pout, const D3DXMATRIX *pm1, const D3DXMATRIX *pm2)
+{
+    __m128 r0 = _mm_loadu_ps(pm2->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(pm2->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(pm2->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(pm2->u.m[3]);
+    __m128 out[4];
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        out[i] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(pm1->u.m[i][0]), r0),
+                _mm_mul_ps(_mm_set1_ps(pm1->u.m[i][1]), r1)),
+                _mm_mul_ps(_mm_set1_ps(pm1->u.m[i][2]), r2)),
+                _mm_mul_ps(_mm_set1_ps(pm1->u.m[i][3]), r3));
+    }
+
+    for (i = 0; i < 4; i++)
+        _mm_storeu_ps(pout->u.m[i], out[i]);
+}
+
+#define SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+
+/* Products of 2x2 matrices stored row by row in a single vector. */
+static inline __m128 SSE2_FUNC mat2_mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/* adj(a) * b */
+static inline __m128 SSE2_FUNC mat2_adj_mul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+/* a * adj(b) */
+static inline __m128 SSE2_FUNC mat2_mul_adj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/* Computes the inverse from the 2x2 blocks of the matrix. The determinant
+ * is computed by the caller, so that singular matrices are detected exactly
+ * as in the C version. */
+static void SSE2_FUNC matrix_inverse_sse2(D3DXMATRIX *pout, const D3DXMATRIX *pm, FLOAT det)
+{
+    __m128 r0 = _mm_loadu_ps(pm->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(pm->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(pm->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(pm->u.m[3]);
+    __m128 a = _mm_movelh_ps(r0, r1);
+    __m128 b = _mm_movehl_ps(r1, r0);
+    __m128 c = _mm_movelh_ps(r2, r3);
+    __m128 d = _mm_movehl_ps(r3, r2);
+    __m128 det_sub, det_a, det_b, det_c, det_d, d_c, a_b, x, y, z, w, rdet;
+
+    det_sub = _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+            _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+    det_a = SWIZZLE(det_sub, 0, 0, 0, 0);
+    det_b = SWIZZLE(det_sub, 1, 1, 1, 1);
+    det_c = SWIZZLE(det_sub, 2, 2, 2, 2);
+    det_d = SWIZZLE(det_sub, 3, 3, 3, 3);
+
+    d_c = mat2_adj_mul(d, c);
+    a_b = mat2_adj_mul(a, b);
+    x = _mm_sub_ps(_mm_mul_ps(det_d, a), mat2_mul(b, d_c));
+    w = _mm_sub_ps(_mm_mul_ps(det_a, d), mat2_mul(c, a_b));
+    y = _mm_sub_ps(_mm_mul_ps(det_b, c), mat2_mul_adj(d, a_b));
+    z = _mm_sub_ps(_mm_mul_ps(det_c, b), mat2_mul_adj(a, d_c));
+
+    rdet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), _mm_set1_ps(det));
+    x = _mm_mul_ps(x, rdet);
+    y = _mm_mul_ps(y, rdet);
+    z = _mm_mul_ps(z, rdet);
+    w = _mm_mul_ps(w, rdet);
+
+    _mm_storeu_ps(pout->u.m[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(pout->u.m[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(pout->u.m[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(pout->u.m[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+}
+
+#undef SWIZZLE
+
+/* Transforms (x, y, z, 1), used by D3DXVec3TransformArray. */
+static void SSE2_FUNC vec3_transform_array_sse2(D3DXVECTOR4 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 r0 = _mm_loadu_ps(matrix->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(matrix->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(matrix->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(matrix->u.m[3]);
+    UINT i;
+
+    for (i = 0; i < elements; ++i)
+    {
+        const D3DXVECTOR3 *v = (const D3DXVECTOR3 *)((const char *)in + instride * i);
+        __m128 res = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(r0, _mm_set1_ps(v->x)),
+                _mm_mul_ps(r1, _mm_set1_ps(v->y))),
+                _mm_mul_ps(r2, _mm_set1_ps(v->z))), r3);
+
+        _mm_storeu_ps((float *)((char *)out + outstride * i), res);
+    }
+}
+
+/* Transforms (x, y, z, 1) and projects back into w = 1. */
+static void SSE2_FUNC vec3_transform_coord_array_sse2(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 r0 = _mm_loadu_ps(matrix->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(matrix->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(matrix->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(matrix->u.m[3]);
+    UINT i;
+
+    for (i = 0; i < elements; ++i)
+    {
+        const D3DXVECTOR3 *v = (const D3DXVECTOR3 *)((const char *)in + instride * i);
+        float *dst = (float *)((char *)out + outstride * i);
+        __m128 res = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(r0, _mm_set1_ps(v->x)),
+                _mm_mul_ps(r1, _mm_set1_ps(v->y))),
+                _mm_mul_ps(r2, _mm_set1_ps(v->z))), r3);
+
+        res = _mm_div_ps(res, _mm_shuffle_ps(res, res, _MM_SHUFFLE(3, 3, 3, 3)));
+        _mm_storel_pi((__m64 *)dst, res);
+        _mm_store_ss(dst + 2, _mm_movehl_ps(res, res));
+    }
+}
+
+/* Transforms 4 component vectors, used for both vectors and planes. */
+static void SSE2_FUNC vec4_transform_array_sse2(void *out, UINT outstride,
+        const void *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 r0 = _mm_loadu_ps(matrix->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(matrix->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(matrix->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(matrix->u.m[3]);
+    UINT i;
+
+    for (i = 0; i < elements; ++i)
+    {
+        const float *v = (const float *)((const char *)in + instride * i);
+        __m128 res = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(r0, _mm_set1_ps(v[0])),
+                _mm_mul_ps(r1, _mm_set1_ps(v[1]))),
+                _mm_mul_ps(r2, _mm_set1_ps(v[2]))),
+                _mm_mul_ps(r3, _mm_set1_ps(v[3])));
+
+        _mm_storeu_ps((float *)((char *)out + outstride * i), res);
+    }
+}
+
+static unsigned short float_32_to_16(const float in);
+
+/* Converts 4 floats at a time when they all map to normal half floats or
+ * overflow, the other ones go through float_32_to_16. */
+static void SSE2_FUNC float_32_to_16_array_sse2(D3DXFLOAT16 *pout, const FLOAT *pin, UINT n)
+{
+    const __m128i abs_mask = _mm_set1_epi32(0x7fffffff);
+    const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i round = _mm_set1_epi32(0xfff);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i bias = _mm_set1_epi32((127 - 15) << 10);
+    const __m128i max_half = _mm_set1_epi32(0x7fff);
+    UINT i, j;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128i bits = _mm_castps_si128(_mm_loadu_ps(pin + i));
+        __m128i abs = _mm_and_si128(bits, abs_mask);
+        __m128i half, sign, big;
+
+        /* denormals and zeros have their own rounding rules */
+        if (_mm_movemask_epi8(_mm_cmplt_epi32(abs, min_normal)))
+        {
+            for (j = i; j < i + 4; j++)
+                pout[j].value = float_32_to_16(pin[j]);
+            continue;
+        }
+
+        /* round the mantissa half to even, the carry goes into the exponent */
+        half = _mm_add_epi32(abs, _mm_add_epi32(round, _mm_and_si128(_mm_srli_epi32(abs, 13), one)));
+        half = _mm_sub_epi32(_mm_srli_epi32(half, 13), bias);
+
+        /* too big, infinity and NaN all give the largest half float */
+        big = _mm_cmpgt_epi32(half, max_half);
+        half = _mm_or_si128(_mm_and_si128(big, max_half), _mm_andnot_si128(big, half));
+
+        /* add the sign, and sign extend so that the pack doesn't saturate */
+        sign = _mm_srli_epi32(_mm_andnot_si128(abs_mask, bits), 16);
+        half = _mm_or_si128(half, sign);
+        half = _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+        _mm_storel_epi64((__m128i *)(pout + i), _mm_packs_epi32(half, half));
+    }
+
+    for (; i < n; i++)
+        pout[i].value = float_32_to_16(pin[i]);
+}
+
+#endif /* SSE2 kernels */
+
 /*_________________D3DXColor____________________*/
 
 D3DXCOLOR* WINAPI D3DXColorAdjustContrast(D3DXCOLOR *pout, CONST D3DXCOLOR *pc, FLOAT s)
@@ -234,6 +470,13 @@ D3DXMATRIX* WINAPI D3DXMatrixInverse(D3DXMATRIX *pout, FLOAT *pdeterminant, CONS
     det = D3DXMatrixDeterminant(pm);
     if ( !det ) return NULL;
     if ( pdeterminant ) *pdeterminant = det;
+#ifdef D3DX_SSE2_KERNELS
+    if (use_sse2())
+    {
+        matrix_inverse_sse2(pout, pm, det);
+        return pout;
+    }
+#endif
     for (i=0; i<4; i++)
     {
         for (j=0; j<4; j++)
@@ -322,6 +565,13 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, CONST D3DXMATRIX *pm1, C
     D3DXMATRIX out;
     int i,j;
 
+#ifdef D3DX_SSE2_KERNELS
+    if (use_sse2())
+    {
+        matrix_multiply_sse2(pout, pm1, pm2);
+        return pout;
+    }
+#endif
     for (i=0; i<4; i++)
     {
         for (j=0; j<4; j++)
@@ -1153,6 +1403,13 @@ D3DXPLANE* WINAPI D3DXPlaneTransformArray(D3DXPLANE* out, UINT outstride, CONST
 {
     UINT i;
 
+#ifdef D3DX_SSE2_KERNELS
+    if (use_sse2())
+    {
+        vec4_transform_array_sse2(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
     for (i = 0; i < elements; ++i) {
         D3DXPlaneTransform(
             (D3DXPLANE*)((char*)out + outstride * i),
@@ -1595,6 +1852,13 @@ D3DXVECTOR4* WINAPI D3DXVec3TransformArray(D3DXVECTOR4* out, UINT outstride, CON
 {
     UINT i;
 
+#ifdef D3DX_SSE2_KERNELS
+    if (use_sse2())
+    {
+        vec3_transform_array_sse2(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
     for (i = 0; i < elements; ++i) {
         D3DXVec3Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1624,6 +1888,13 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformCoordArray(D3DXVECTOR3* out, UINT outstride
 {
     UINT i;
 
+#ifdef D3DX_SSE2_KERNELS
+    if (use_sse2())
+    {
+        vec3_transform_coord_array_sse2(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformCoord(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -1763,6 +2034,13 @@ D3DXVECTOR4* WINAPI D3DXVec4TransformArray(D3DXVECTOR4* out, UINT outstride, CON
 {
     UINT i;
 
+#ifdef D3DX_SSE2_KERNELS
+    if (use_sse2())
+    {
+        vec4_transform_array_sse2(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
     for (i = 0; i < elements; ++i) {
         D3DXVec4Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1861,6 +2139,13 @@ D3DXFLOAT16 *WINAPI D3DXFloat32To16Array(D3DXFLOAT16 *pout, CONST FLOAT *pin, UI
 {
     unsigned int i;
 
+#ifdef D3DX_SSE2_KERNELS
+    if (use_sse2())
+    {
+        float_32_to_16_array_sse2(pout, pin, n);
+        return pout;
+    }
+#endif
     for (i = 0; i < n; ++i)
     {
         pout[i].value = float_32_to_16(pin[i]);
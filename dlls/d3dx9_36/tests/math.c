@@ -2225,8 +2225,8 @@ static void test_D3DXFloat_Array(void)
     float nan = -nnan;
     unsigned int i;
     void *out = NULL;
-    D3DXFLOAT16 half;
-    FLOAT single;
+    D3DXFLOAT16 half, half_out[32];
+    FLOAT single, single_in[32];
     struct
     {
         FLOAT single_in;
@@ -2291,6 +2291,119 @@ static void test_D3DXFloat_Array(void)
         ok(relative_error(single, testdata[i].single_out_ver2) < admitted_error,
            "Got %g, expected %g for index %d.\n", single, testdata[i].single_out_ver2, i);
     }
+
+    /* the whole table at once */
+    for (i = 0; i < sizeof(testdata)/sizeof(testdata[0]); i++)
+        single_in[i] = testdata[i].single_in;
+    out = D3DXFloat32To16Array(half_out, single_in, sizeof(testdata)/sizeof(testdata[0]));
+    ok(out == half_out, "Got %p, expected %p.\n", out, half_out);
+    for (i = 0; i < sizeof(testdata)/sizeof(testdata[0]); i++)
+        ok(half_out[i].value == testdata[i].half_ver1 || half_out[i].value == testdata[i].half_ver2,
+           "Got %x, expected %x or %x for index %d.\n", half_out[i].value, testdata[i].half_ver1,
+           testdata[i].half_ver2, i);
+}
+
+static void test_D3DX_batch_transforms(void)
+{
+    static const unsigned int count = 1001;
+    D3DXMATRIX mat, mat2, res, res2;
+    D3DXVECTOR4 *vec4, *out4, exp4;
+    D3DXVECTOR3 exp3;
+    DWORD start, time_array, time_single;
+    unsigned int i, j, errors;
+    FLOAT det;
+
+    for (i = 0; i < 16; i++)
+    {
+        U(mat).m[i / 4][i % 4] = (i * 7 % 11) - 5.0f + i * 0.25f;
+        U(mat2).m[i / 4][i % 4] = (i % 5 == 0) ? 4.0f + i * 0.5f : (i * 5 % 13) * 0.25f - 1.5f;
+    }
+    U(mat).m[0][3] = U(mat).m[1][3] = U(mat).m[2][3] = 0.01f;
+    U(mat).m[3][3] = 1.0f;
+
+    vec4 = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*vec4));
+    out4 = HeapAlloc(GetProcessHeap(), 0, (count + 1) * sizeof(*out4));
+    for (i = 0; i < count; i++)
+    {
+        vec4[i].x = (i % 17) - 8.5f;
+        vec4[i].y = (i % 23) * 0.5f;
+        vec4[i].z = (i % 7) - 3.0f;
+        vec4[i].w = 1.0f + (i % 3);
+    }
+
+    /* strided arrays of D3DXVECTOR3 in D3DXVECTOR4 storage */
+    D3DXVec3TransformArray(out4, sizeof(*out4), (D3DXVECTOR3 *)vec4, sizeof(*vec4), &mat, count);
+    for (i = 0, errors = 0; i < count; i++)
+    {
+        D3DXVec3Transform(&exp4, (D3DXVECTOR3 *)&vec4[i], &mat);
+        if (relative_error(exp4.x, out4[i].x) > admitted_error || relative_error(exp4.y, out4[i].y) > admitted_error ||
+            relative_error(exp4.z, out4[i].z) > admitted_error || relative_error(exp4.w, out4[i].w) > admitted_error)
+            errors++;
+    }
+    ok(!errors, "D3DXVec3TransformArray: %u mismatches.\n", errors);
+
+    out4[count].x = 42.0f;
+    for (i = 0; i < count; i++) out4[i].w = 42.0f;
+    D3DXVec3TransformCoordArray((D3DXVECTOR3 *)out4, sizeof(*out4), (D3DXVECTOR3 *)vec4, sizeof(*vec4), &mat, count);
+    for (i = 0, errors = 0; i < count; i++)
+    {
+        D3DXVec3TransformCoord(&exp3, (D3DXVECTOR3 *)&vec4[i], &mat);
+        if (relative_error(exp3.x, out4[i].x) > admitted_error || relative_error(exp3.y, out4[i].y) > admitted_error ||
+            relative_error(exp3.z, out4[i].z) > admitted_error || out4[i].w != 42.0f)
+            errors++;
+    }
+    ok(!errors, "D3DXVec3TransformCoordArray: %u mismatches.\n", errors);
+    ok(out4[count].x == 42.0f, "D3DXVec3TransformCoordArray wrote past the end.\n");
+
+    D3DXVec4TransformArray(out4, sizeof(*out4), vec4, sizeof(*vec4), &mat, count);
+    for (i = 0, errors = 0; i < count; i++)
+    {
+        D3DXVec4Transform(&exp4, &vec4[i], &mat);
+        if (relative_error(exp4.x, out4[i].x) > admitted_error || relative_error(exp4.y, out4[i].y) > admitted_error ||
+            relative_error(exp4.z, out4[i].z) > admitted_error || relative_error(exp4.w, out4[i].w) > admitted_error)
+            errors++;
+    }
+    ok(!errors, "D3DXVec4TransformArray: %u mismatches.\n", errors);
+
+    D3DXPlaneTransformArray((D3DXPLANE *)out4, sizeof(*out4), (D3DXPLANE *)vec4, sizeof(*vec4), &mat, count);
+    for (i = 0, errors = 0; i < count; i++)
+    {
+        D3DXPlaneTransform((D3DXPLANE *)&exp4, (D3DXPLANE *)&vec4[i], &mat);
+        if (relative_error(exp4.x, out4[i].x) > admitted_error || relative_error(exp4.y, out4[i].y) > admitted_error ||
+            relative_error(exp4.z, out4[i].z) > admitted_error || relative_error(exp4.w, out4[i].w) > admitted_error)
+            errors++;
+    }
+    ok(!errors, "D3DXPlaneTransformArray: %u mismatches.\n", errors);
+
+    /* the inverse times the matrix gives the identity */
+    D3DXMatrixMultiply(&res, &mat2, &mat2);
+    ok(D3DXMatrixInverse(&res2, &det, &res) == &res2, "D3DXMatrixInverse failed.\n");
+    ok(relative_error(D3DXMatrixDeterminant(&res), det) < admitted_error, "Got determinant %f.\n", det);
+    D3DXMatrixMultiply(&res, &res, &res2);
+    for (i = 0, errors = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            if (fabs(U(res).m[i][j] - (i == j ? 1.0f : 0.0f)) > admitted_error) errors++;
+    ok(!errors, "Expected identity, got %f %f %f %f / %f %f %f %f.\n",
+       U(res).m[0][0], U(res).m[0][1], U(res).m[0][2], U(res).m[0][3],
+       U(res).m[1][0], U(res).m[1][1], U(res).m[1][2], U(res).m[1][3]);
+
+    /* rough comparison with element by element transforms */
+    if (winetest_debug > 1)
+    {
+        start = GetTickCount();
+        for (i = 0; i < 1000; i++)
+            D3DXVec3TransformArray(out4, sizeof(*out4), (D3DXVECTOR3 *)vec4, sizeof(*vec4), &mat, count);
+        time_array = GetTickCount() - start;
+        start = GetTickCount();
+        for (i = 0; i < 1000; i++)
+            for (j = 0; j < count; j++)
+                D3DXVec3Transform(&out4[j], (D3DXVECTOR3 *)&vec4[j], &mat);
+        time_single = GetTickCount() - start;
+        trace("D3DXVec3TransformArray: %u ms, D3DXVec3Transform: %u ms.\n", time_array, time_single);
+    }
+
+    HeapFree(GetProcessHeap(), 0, out4);
+    HeapFree(GetProcessHeap(), 0, vec4);
 }
 
 START_TEST(math)
@@ -2309,4 +2422,5 @@ START_TEST(math)
     test_Matrix_Transformation2D();
     test_D3DXVec_Array();
     test_D3DXFloat_Array();
+    test_D3DX_batch_transforms();
 }
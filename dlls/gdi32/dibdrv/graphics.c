@@ -56,6 +56,92 @@ static RECT get_device_rect( HDC hdc, int left, int top, int right, int bottom,
     return rect;
 }
 
+/* fill a region in device coordinates with the brush */
+static BOOL brush_region( dibdrv_physdev *pdev, HRGN rgn )
+{
+    const WINEREGION *region;
+    BOOL ret;
+
+    region = get_wine_region( rgn );
+    if(!region) return FALSE;
+
+    ret = brush_rects( pdev, region->numRects, region->rects );
+
+    release_wine_region( rgn );
+    return ret;
+}
+
+/* fill a region in device coordinates with the pen color, the region is clipped in place */
+static BOOL pen_region( dibdrv_physdev *pdev, HRGN rgn )
+{
+    const WINEREGION *region;
+
+    /* the pen has no clipped variant of solid_rects */
+    CombineRgn( rgn, rgn, pdev->clip, RGN_AND );
+
+    region = get_wine_region( rgn );
+    if(!region) return FALSE;
+
+    pdev->dib.funcs->solid_rects( &pdev->dib, region->numRects, region->rects,
+                                  pdev->pen_and, pdev->pen_xor );
+
+    release_wine_region( rgn );
+    return TRUE;
+}
+
+/* draw a rounded rectangle in device coordinates, as a pen frame around the brush interior */
+static BOOL draw_round_rect( dibdrv_physdev *pdev, const RECT *rect, int ellipse_width, int ellipse_height )
+{
+    HRGN outline, interior;
+
+    /* FIXME: dashed outlines would need to follow the curve */
+    if (pdev->pen_style != PS_SOLID && pdev->pen_style != PS_NULL) return FALSE;
+
+    if (rect->right - rect->left > 2 && rect->bottom - rect->top > 2)
+        interior = CreateRoundRectRgn( rect->left + 1, rect->top + 1, rect->right - 1, rect->bottom - 1,
+                                       ellipse_width - 2, ellipse_height - 2 );
+    else
+        interior = CreateRectRgn( 0, 0, 0, 0 );
+    if (!interior) return FALSE;
+
+    if (pdev->pen_style == PS_SOLID)
+    {
+        if (!(outline = CreateRoundRectRgn( rect->left, rect->top, rect->right, rect->bottom,
+                                            ellipse_width, ellipse_height )))
+        {
+            DeleteObject( interior );
+            return FALSE;
+        }
+        CombineRgn( outline, outline, interior, RGN_DIFF );
+        pen_region( pdev, outline );
+        DeleteObject( outline );
+    }
+
+    brush_region( pdev, interior );
+    DeleteObject( interior );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           dibdrv_Ellipse
+ */
+BOOL dibdrv_Ellipse( PHYSDEV dev, INT left, INT top, INT right, INT bottom )
+{
+    PHYSDEV next = GET_NEXT_PHYSDEV( dev, pEllipse );
+    dibdrv_physdev *pdev = get_dibdrv_pdev(dev);
+    RECT rect = get_device_rect( dev->hdc, left, top, right, bottom, TRUE );
+
+    TRACE("(%p, %d, %d, %d, %d)\n", dev, left, top, right, bottom);
+
+    if(rect.left == rect.right || rect.top == rect.bottom) return TRUE;
+
+    if(defer_pen(pdev) || defer_brush(pdev) ||
+       !draw_round_rect( pdev, &rect, rect.right - rect.left, rect.bottom - rect.top ))
+        return next->funcs->pEllipse( next, left, top, right, bottom );
+
+    return TRUE;
+}
+
 /***********************************************************************
  *           dibdrv_GetPixel
  */
@@ -79,6 +165,207 @@ COLORREF dibdrv_GetPixel( PHYSDEV dev, INT x, INT y )
     return pdev->dib.funcs->pixel_to_colorref( &pdev->dib, pixel );
 }
 
+static void solid_rect_clipped( dibdrv_physdev *pdev, const WINEREGION *clip, const RECT *rect,
+                                DWORD and, DWORD xor )
+{
+    RECT clipped_rect;
+    int i;
+
+    for (i = 0; i < clip->numRects; i++)
+    {
+        if (clip->rects[i].top >= rect->bottom) break;
+        if (intersect_rect( &clipped_rect, rect, clip->rects + i ))
+            pdev->dib.funcs->solid_rects( &pdev->dib, 1, &clipped_rect, and, xor );
+    }
+}
+
+/* draw one line of a triangle gradient, merging the runs of identical pixels */
+static void gradient_span( dibdrv_physdev *pdev, const WINEREGION *clip, int y, int x1, int x2,
+                           int r1, int g1, int b1, int r2, int g2, int b2 )
+{
+    int x, dx = x2 - x1;
+    DWORD pixel, run_pixel = 0;
+    RECT rect;
+
+    rect.top = y;
+    rect.bottom = y + 1;
+    rect.left = x1;
+    for (x = 0; x < dx; x++)
+    {
+        pixel = get_pixel_color( pdev, RGB( (r1 * (dx - x) + r2 * x) / dx >> 8,
+                                            (g1 * (dx - x) + g2 * x) / dx >> 8,
+                                            (b1 * (dx - x) + b2 * x) / dx >> 8 ), FALSE );
+        if (x && pixel != run_pixel)
+        {
+            rect.right = x1 + x;
+            solid_rect_clipped( pdev, clip, &rect, 0, run_pixel );
+            rect.left = rect.right;
+        }
+        run_pixel = pixel;
+    }
+    if (dx > 0)
+    {
+        rect.right = x2;
+        solid_rect_clipped( pdev, clip, &rect, 0, run_pixel );
+    }
+}
+
+/***********************************************************************
+ *           dibdrv_GradientFill
+ *
+ * Same interpolation as nulldrv_GradientFill, but filling the device spans directly.
+ */
+BOOL dibdrv_GradientFill( PHYSDEV dev, TRIVERTEX *vert_array, ULONG nvert,
+                          void *grad_array, ULONG ngrad, ULONG mode )
+{
+    PHYSDEV next = GET_NEXT_PHYSDEV( dev, pGradientFill );
+    dibdrv_physdev *pdev = get_dibdrv_pdev(dev);
+    const WINEREGION *clip;
+    POINT *pts;
+    RECT rect;
+    DWORD and, xor;
+    BOOL ret = TRUE;
+    unsigned int i;
+    int rop2 = GetROP2( dev->hdc );
+
+    TRACE("(%p, %p, %u, %p, %u, %u)\n", dev, vert_array, nvert, grad_array, ngrad, mode);
+
+    if (pdev->defer & DEFER_FORMAT)
+        return next->funcs->pGradientFill( next, vert_array, nvert, grad_array, ngrad, mode );
+
+    if (mode != GRADIENT_FILL_RECT_H && mode != GRADIENT_FILL_RECT_V && mode != GRADIENT_FILL_TRIANGLE)
+        return FALSE;
+
+    pts = HeapAlloc( GetProcessHeap(), 0, nvert * sizeof(*pts) );
+    if (!pts) return FALSE;
+    for (i = 0; i < nvert; i++)
+    {
+        pts[i].x = vert_array[i].x;
+        pts[i].y = vert_array[i].y;
+    }
+    LPtoDP( dev->hdc, pts, nvert );
+
+    clip = get_wine_region( pdev->clip );
+
+    switch(mode)
+    {
+    case GRADIENT_FILL_RECT_H:
+    case GRADIENT_FILL_RECT_V:
+        for (i = 0; i < ngrad; i++)
+        {
+            GRADIENT_RECT *grad_rect = ((GRADIENT_RECT *)grad_array) + i;
+            const TRIVERTEX *v1, *v2;
+            int pos, len;
+
+            if (grad_rect->UpperLeft >= nvert || grad_rect->LowerRight >= nvert)
+            {
+                ret = FALSE;
+                break;
+            }
+            v1 = vert_array + grad_rect->UpperLeft;
+            v2 = vert_array + grad_rect->LowerRight;
+            rect.left   = min( pts[grad_rect->UpperLeft].x, pts[grad_rect->LowerRight].x );
+            rect.right  = max( pts[grad_rect->UpperLeft].x, pts[grad_rect->LowerRight].x );
+            rect.top    = min( pts[grad_rect->UpperLeft].y, pts[grad_rect->LowerRight].y );
+            rect.bottom = max( pts[grad_rect->UpperLeft].y, pts[grad_rect->LowerRight].y );
+
+            /* the colors go from the left (top) vertex to the right (bottom) one */
+            if (mode == GRADIENT_FILL_RECT_H ? pts[grad_rect->UpperLeft].x > pts[grad_rect->LowerRight].x
+                                             : pts[grad_rect->UpperLeft].y > pts[grad_rect->LowerRight].y)
+            {
+                const TRIVERTEX *t = v1;
+                v1 = v2;
+                v2 = t;
+            }
+
+            /* like the pen lines drawn by the generic version, each step is a single color */
+            len = mode == GRADIENT_FILL_RECT_H ? rect.right - rect.left : rect.bottom - rect.top;
+            for (pos = 0; pos < len; pos++)
+            {
+                RECT step = rect;
+                COLORREF color = RGB( (v1->Red   * (len - pos) + v2->Red   * pos) / len >> 8,
+                                      (v1->Green * (len - pos) + v2->Green * pos) / len >> 8,
+                                      (v1->Blue  * (len - pos) + v2->Blue  * pos) / len >> 8 );
+
+                calc_and_xor_masks( rop2, get_pixel_color( pdev, color, TRUE ), &and, &xor );
+                if (mode == GRADIENT_FILL_RECT_H)
+                {
+                    step.left = rect.left + pos;
+                    step.right = step.left + 1;
+                }
+                else
+                {
+                    step.top = rect.top + pos;
+                    step.bottom = step.top + 1;
+                }
+                solid_rect_clipped( pdev, clip, &step, and, xor );
+            }
+        }
+        break;
+
+    case GRADIENT_FILL_TRIANGLE:
+        for (i = 0; i < ngrad; i++)
+        {
+            GRADIENT_TRIANGLE *tri = ((GRADIENT_TRIANGLE *)grad_array) + i;
+            const TRIVERTEX *v1, *v2, *v3, *t;
+            const POINT *p1, *p2, *p3, *pt;
+            int y, dy;
+
+            if (tri->Vertex1 >= nvert || tri->Vertex2 >= nvert || tri->Vertex3 >= nvert)
+            {
+                ret = FALSE;
+                break;
+            }
+            v1 = vert_array + tri->Vertex1;
+            v2 = vert_array + tri->Vertex2;
+            v3 = vert_array + tri->Vertex3;
+            p1 = pts + tri->Vertex1;
+            p2 = pts + tri->Vertex2;
+            p3 = pts + tri->Vertex3;
+
+            if (p1->y > p2->y)
+            { t = v1; v1 = v2; v2 = t; pt = p1; p1 = p2; p2 = pt; }
+            if (p2->y > p3->y)
+            {
+                t = v2; v2 = v3; v3 = t; pt = p2; p2 = p3; p3 = pt;
+                if (p1->y > p2->y)
+                { t = v1; v1 = v2; v2 = t; pt = p1; p1 = p2; p2 = pt; }
+            }
+            /* p1->y <= p2->y <= p3->y */
+
+            dy = p3->y - p1->y;
+            for (y = 0; y < dy; y++)
+            {
+                /* p1->y <= y < p3->y */
+                const TRIVERTEX *v = y < (p2->y - p1->y) ? v1 : v3;
+                const POINT *p = y < (p2->y - p1->y) ? p1 : p3;
+                /* (p->y <= y < p2->y) || (p2->y <= y < p->y) */
+                int dy2 = p2->y - p->y;
+                int y2 = y + p1->y - p->y;
+
+                int x1 = (p3->x     * y  + p1->x     * (dy  - y )) / dy;
+                int x2 = (p2->x     * y2 + p->x      * (dy2 - y2)) / dy2;
+                int r1 = (v3->Red   * y  + v1->Red   * (dy  - y )) / dy;
+                int r2 = (v2->Red   * y2 + v->Red    * (dy2 - y2)) / dy2;
+                int g1 = (v3->Green * y  + v1->Green * (dy  - y )) / dy;
+                int g2 = (v2->Green * y2 + v->Green  * (dy2 - y2)) / dy2;
+                int b1 = (v3->Blue  * y  + v1->Blue  * (dy  - y )) / dy;
+                int b2 = (v2->Blue  * y2 + v->Blue   * (dy2 - y2)) / dy2;
+
+                if (x1 < x2)
+                    gradient_span( pdev, clip, y + p1->y, x1, x2, r1, g1, b1, r2, g2, b2 );
+                else
+                    gradient_span( pdev, clip, y + p1->y, x2, x1, r2, g2, b2, r1, g1, b1 );
+            }
+        }
+        break;
+    }
+
+    release_wine_region( pdev->clip );
+    HeapFree( GetProcessHeap(), 0, pts );
+    return ret;
+}
+
 /***********************************************************************
  *           dibdrv_LineTo
  */
@@ -169,6 +456,60 @@ BOOL dibdrv_PaintRgn( PHYSDEV dev, HRGN rgn )
     return TRUE;
 }
 
+/***********************************************************************
+ *           dibdrv_PolyPolygon
+ */
+BOOL dibdrv_PolyPolygon( PHYSDEV dev, const POINT *pt, const INT *counts, UINT polygons )
+{
+    dibdrv_physdev *pdev = get_dibdrv_pdev(dev);
+    PHYSDEV next = GET_NEXT_PHYSDEV( dev, pPolyPolygon );
+    DWORD total = 0, max_points = 0, i;
+    POINT *points, *line;
+    HRGN rgn;
+
+    TRACE("(%p, %p, %p, %u)\n", dev, pt, counts, polygons);
+
+    if (defer_pen( pdev ) || defer_brush( pdev ))
+        return next->funcs->pPolyPolygon( next, pt, counts, polygons );
+
+    for (i = 0; i < polygons; i++)
+    {
+        if (counts[i] < 0) return FALSE;
+        total += counts[i];
+        max_points = max( counts[i], max_points );
+    }
+
+    /* room for the device points, followed by a closed copy of the largest polygon */
+    points = HeapAlloc( GetProcessHeap(), 0, (total + max_points + 1) * sizeof(*pt) );
+    if (!points) return FALSE;
+    line = points + total;
+
+    memcpy( points, pt, total * sizeof(*pt) );
+    LPtoDP( dev->hdc, points, total );
+
+    /* the region code does the scan conversion for both fill modes */
+    if (!(rgn = CreatePolyPolygonRgn( points, counts, polygons, GetPolyFillMode( dev->hdc ) )))
+    {
+        HeapFree( GetProcessHeap(), 0, points );
+        return FALSE;
+    }
+    brush_region( pdev, rgn );
+    DeleteObject( rgn );
+
+    for (i = 0, pt = points; i < polygons; pt += counts[i++])
+    {
+        if (!counts[i]) continue;
+        memcpy( line, pt, counts[i] * sizeof(*pt) );
+        line[counts[i]] = pt[0];
+
+        reset_dash_origin( pdev );
+        pdev->pen_lines( pdev, counts[i] + 1, line );
+    }
+
+    HeapFree( GetProcessHeap(), 0, points );
+    return TRUE;
+}
+
 /***********************************************************************
  *           dibdrv_PolyPolyline
  */
@@ -200,6 +541,14 @@ BOOL dibdrv_PolyPolyline( PHYSDEV dev, const POINT* pt, const DWORD* counts, DWO
     return TRUE;
 }
 
+/***********************************************************************
+ *           dibdrv_Polygon
+ */
+BOOL dibdrv_Polygon( PHYSDEV dev, const POINT *pt, INT count )
+{
+    return dibdrv_PolyPolygon( dev, pt, &count, 1 );
+}
+
 /***********************************************************************
  *           dibdrv_Polyline
  */
@@ -264,6 +613,34 @@ BOOL dibdrv_Rectangle( PHYSDEV dev, INT left, INT top, INT right, INT bottom )
     return TRUE;
 }
 
+/***********************************************************************
+ *           dibdrv_RoundRect
+ */
+BOOL dibdrv_RoundRect( PHYSDEV dev, INT left, INT top, INT right, INT bottom,
+                       INT ellipse_width, INT ellipse_height )
+{
+    PHYSDEV next = GET_NEXT_PHYSDEV( dev, pRoundRect );
+    dibdrv_physdev *pdev = get_dibdrv_pdev(dev);
+    RECT rect = get_device_rect( dev->hdc, left, top, right, bottom, TRUE );
+    POINT pts[2];
+
+    TRACE("(%p, %d, %d, %d, %d, %d, %d)\n", dev, left, top, right, bottom, ellipse_width, ellipse_height);
+
+    if(rect.left == rect.right || rect.top == rect.bottom) return TRUE;
+
+    /* the ellipse size is a distance, only the scaling applies */
+    pts[0].x = pts[0].y = 0;
+    pts[1].x = ellipse_width;
+    pts[1].y = ellipse_height;
+    LPtoDP( dev->hdc, pts, 2 );
+
+    if(defer_pen(pdev) || defer_brush(pdev) ||
+       !draw_round_rect( pdev, &rect, abs( pts[1].x - pts[0].x ), abs( pts[1].y - pts[0].y ) ))
+        return next->funcs->pRoundRect( next, left, top, right, bottom, ellipse_width, ellipse_height );
+
+    return TRUE;
+}
+
 /***********************************************************************
  *           dibdrv_SetPixel
  */
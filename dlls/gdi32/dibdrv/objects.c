@@ -1043,6 +1043,7 @@ HPEN dibdrv_SelectPen( PHYSDEV dev, HPEN hpen )
     pdev->defer |= DEFER_PEN;
 
     style = logpen.lopnStyle & PS_STYLE_MASK;
+    pdev->pen_style = style;
 
     switch(style)
     {
@@ -1217,6 +1217,286 @@ static inline BOOL bit_fields_match(const dib_info *d1, const dib_info *d2)
            d1->blue_mask  == d2->blue_mask;
 }
 
+/*
+ * Vector versions of the most common conversion and blending loops.
+ * They process the bulk of a row and return the number of pixels done,
+ * the scalar loops finish the row. Results are identical to the scalar code.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+
+#include <cpuid.h>
+#include <tmmintrin.h>
+
+#ifdef __i386__
+#define SSE2_FUNC  __attribute__((__target__("sse2"), __force_align_arg_pointer__))
+#define SSSE3_FUNC __attribute__((__target__("ssse3"), __force_align_arg_pointer__))
+#else
+#define SSE2_FUNC  __attribute__((__target__("sse2")))
+#define SSSE3_FUNC __attribute__((__target__("ssse3")))
+#endif
+
+enum simd_level { SIMD_UNKNOWN = -1, SIMD_NONE, SIMD_SSE2, SIMD_SSSE3 };
+
+static enum simd_level simd_level = SIMD_UNKNOWN;
+
+static enum simd_level get_simd_level(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    enum simd_level level = SIMD_NONE;
+
+    if (simd_level != SIMD_UNKNOWN) return simd_level;
+
+    if (__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) && (edx & bit_SSE2))
+        level = (ecx & bit_SSSE3) ? SIMD_SSSE3 : SIMD_SSE2;
+    TRACE( "using simd level %u\n", level );
+    return simd_level = level;
+}
+
+/* rearrange the bytes of 32-bpp pixels, map[i] is the source byte of destination byte i */
+static int SSSE3_FUNC shuffle_row_32_ssse3( DWORD *dst, const DWORD *src, int len, const char map[4] )
+{
+    __m128i mask = _mm_setr_epi8( map[0],      map[1],      map[2],      map[3],
+                                  map[0] | 4,  map[1] | 4,  map[2] | 4,  map[3] | 4,
+                                  map[0] | 8,  map[1] | 8,  map[2] | 8,  map[3] | 8,
+                                  map[0] | 12, map[1] | 12, map[2] | 12, map[3] | 12 );
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+        _mm_storeu_si128( (__m128i *)(dst + x),
+                          _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(src + x) ), mask ));
+    return x;
+}
+
+/* the 16-byte loads and stores need two pixels of slack at the end of the row */
+static int SSSE3_FUNC expand_row_24_ssse3( DWORD *dst, const BYTE *src, int len )
+{
+    const __m128i mask = _mm_setr_epi8( 0, 1, 2, 0x80, 3, 4, 5, 0x80, 6, 7, 8, 0x80, 9, 10, 11, 0x80 );
+    int x;
+
+    for (x = 0; x + 6 <= len; x += 4)
+        _mm_storeu_si128( (__m128i *)(dst + x),
+                          _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(src + x * 3) ), mask ));
+    return x;
+}
+
+static int SSSE3_FUNC pack_row_24_ssse3( BYTE *dst, const DWORD *src, int len, const char map[3] )
+{
+    __m128i mask = _mm_setr_epi8( map[0],      map[1],      map[2],
+                                  map[0] | 4,  map[1] | 4,  map[2] | 4,
+                                  map[0] | 8,  map[1] | 8,  map[2] | 8,
+                                  map[0] | 12, map[1] | 12, map[2] | 12,
+                                  0x80, 0x80, 0x80, 0x80 );
+    int x;
+
+    for (x = 0; x + 6 <= len; x += 4)
+        _mm_storeu_si128( (__m128i *)(dst + x * 3),
+                          _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(src + x) ), mask ));
+    return x;
+}
+
+/* 8888 to 555 (green_len 5) or 565 (green_len 6) with the usual field positions */
+static int SSE2_FUNC pack_row_16_sse2( WORD *dst, const DWORD *src, int len, int green_len )
+{
+    const __m128i red_shift = _mm_cvtsi32_si128( green_len == 6 ? 8 : 9 );
+    const __m128i green_shift = _mm_cvtsi32_si128( green_len == 6 ? 5 : 6 );
+    const __m128i red_mask = _mm_set1_epi32( green_len == 6 ? 0xf800 : 0x7c00 );
+    const __m128i green_mask = _mm_set1_epi32( green_len == 6 ? 0x07e0 : 0x03e0 );
+    const __m128i blue_mask = _mm_set1_epi32( 0x001f );
+    __m128i lo, hi;
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        lo = _mm_loadu_si128( (const __m128i *)(src + x) );
+        hi = _mm_loadu_si128( (const __m128i *)(src + x + 4) );
+        lo = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_srl_epi32( lo, red_shift ), red_mask ),
+                                         _mm_and_si128( _mm_srl_epi32( lo, green_shift ), green_mask )),
+                           _mm_and_si128( _mm_srli_epi32( lo, 3 ), blue_mask ));
+        hi = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_srl_epi32( hi, red_shift ), red_mask ),
+                                         _mm_and_si128( _mm_srl_epi32( hi, green_shift ), green_mask )),
+                           _mm_and_si128( _mm_srli_epi32( hi, 3 ), blue_mask ));
+        /* sign extend so that the saturating pack keeps all 16 bits */
+        lo = _mm_srai_epi32( _mm_slli_epi32( lo, 16 ), 16 );
+        hi = _mm_srai_epi32( _mm_slli_epi32( hi, 16 ), 16 );
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_packs_epi32( lo, hi ));
+    }
+    return x;
+}
+
+static inline __m128i SSE2_FUNC expand_16_sse2( __m128i val, int green_len )
+{
+    if (green_len == 6)
+        return _mm_or_si128(
+            _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_slli_epi32( val, 8 ), _mm_set1_epi32( 0xf80000 )),
+                                        _mm_and_si128( _mm_slli_epi32( val, 3 ), _mm_set1_epi32( 0x070000 ))),
+                          _mm_or_si128( _mm_and_si128( _mm_slli_epi32( val, 5 ), _mm_set1_epi32( 0x00fc00 )),
+                                        _mm_and_si128( _mm_srli_epi32( val, 1 ), _mm_set1_epi32( 0x000300 )))),
+            _mm_or_si128( _mm_and_si128( _mm_slli_epi32( val, 3 ), _mm_set1_epi32( 0x0000f8 )),
+                          _mm_and_si128( _mm_srli_epi32( val, 2 ), _mm_set1_epi32( 0x000007 ))));
+
+    return _mm_or_si128(
+        _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_slli_epi32( val, 9 ), _mm_set1_epi32( 0xf80000 )),
+                                    _mm_and_si128( _mm_slli_epi32( val, 4 ), _mm_set1_epi32( 0x070000 ))),
+                      _mm_or_si128( _mm_and_si128( _mm_slli_epi32( val, 6 ), _mm_set1_epi32( 0x00f800 )),
+                                    _mm_and_si128( _mm_slli_epi32( val, 1 ), _mm_set1_epi32( 0x000700 )))),
+        _mm_or_si128( _mm_and_si128( _mm_slli_epi32( val, 3 ), _mm_set1_epi32( 0x0000f8 )),
+                      _mm_and_si128( _mm_srli_epi32( val, 2 ), _mm_set1_epi32( 0x000007 ))));
+}
+
+/* 555 (green_len 5) or 565 (green_len 6) to 8888 */
+static int SSE2_FUNC expand_row_16_sse2( DWORD *dst, const WORD *src, int len, int green_len )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i val;
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        val = _mm_loadu_si128( (const __m128i *)(src + x) );
+        _mm_storeu_si128( (__m128i *)(dst + x), expand_16_sse2( _mm_unpacklo_epi16( val, zero ), green_len ));
+        _mm_storeu_si128( (__m128i *)(dst + x + 4), expand_16_sse2( _mm_unpackhi_epi16( val, zero ), green_len ));
+    }
+    return x;
+}
+
+/* (val + 127) / 255 for val up to 255 * 255 */
+static inline __m128i SSE2_FUNC div255_sse2( __m128i val )
+{
+    val = _mm_add_epi16( val, _mm_set1_epi16( 127 ));
+    return _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( val, _mm_set1_epi16( 1 )),
+                                          _mm_srli_epi16( val, 8 )), 8 );
+}
+
+static inline __m128i SSE2_FUNC blend_argb_sse2( __m128i dst, __m128i src, __m128i alpha, __m128i inv_alpha )
+{
+    return div255_sse2( _mm_add_epi16( _mm_mullo_epi16( src, alpha ), _mm_mullo_epi16( dst, inv_alpha )));
+}
+
+static int SSE2_FUNC blend_row_argb_sse2( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i a = _mm_set1_epi16( alpha ), inv = _mm_set1_epi16( 255 - alpha );
+    __m128i s, d;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        d = _mm_packus_epi16( blend_argb_sse2( _mm_unpacklo_epi8( d, zero ), _mm_unpacklo_epi8( s, zero ), a, inv ),
+                              blend_argb_sse2( _mm_unpackhi_epi8( d, zero ), _mm_unpackhi_epi8( s, zero ), a, inv ));
+        _mm_storeu_si128( (__m128i *)(dst + x), d );
+    }
+    return x;
+}
+
+static inline __m128i SSE2_FUNC blend_argb_alpha_sse2( __m128i dst, __m128i src, __m128i alpha )
+{
+    __m128i inv, sum;
+
+    src = div255_sse2( _mm_mullo_epi16( src, alpha ));
+    inv = _mm_shufflehi_epi16( _mm_shufflelo_epi16( src, 0xff ), 0xff );
+    inv = _mm_sub_epi16( _mm_set1_epi16( 255 ), inv );
+    sum = _mm_add_epi16( src, div255_sse2( _mm_mullo_epi16( dst, inv )));
+    /* the scalar code ORs the channels together, so a channel that overflows
+     * sets the low bit of the next one */
+    sum = _mm_or_si128( sum, _mm_slli_epi64( _mm_srli_epi16( sum, 8 ), 16 ));
+    return _mm_and_si128( sum, _mm_set1_epi16( 0xff ));
+}
+
+static int SSE2_FUNC blend_row_argb_alpha_sse2( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i a = _mm_set1_epi16( alpha );
+    __m128i s, d;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        d = _mm_packus_epi16( blend_argb_alpha_sse2( _mm_unpacklo_epi8( d, zero ), _mm_unpacklo_epi8( s, zero ), a ),
+                              blend_argb_alpha_sse2( _mm_unpackhi_epi8( d, zero ), _mm_unpackhi_epi8( s, zero ), a ));
+        _mm_storeu_si128( (__m128i *)(dst + x), d );
+    }
+    return x;
+}
+
+static inline int shuffle_row_32( DWORD *dst, const DWORD *src, int len, const char map[4] )
+{
+    if (get_simd_level() < SIMD_SSSE3) return 0;
+    return shuffle_row_32_ssse3( dst, src, len, map );
+}
+
+static inline int expand_row_24( DWORD *dst, const BYTE *src, int len )
+{
+    if (get_simd_level() < SIMD_SSSE3) return 0;
+    return expand_row_24_ssse3( dst, src, len );
+}
+
+static inline int pack_row_24( BYTE *dst, const DWORD *src, int len, const char map[3] )
+{
+    if (get_simd_level() < SIMD_SSSE3) return 0;
+    return pack_row_24_ssse3( dst, src, len, map );
+}
+
+static inline int pack_row_16( WORD *dst, const DWORD *src, int len, int green_len )
+{
+    if (get_simd_level() < SIMD_SSE2) return 0;
+    return pack_row_16_sse2( dst, src, len, green_len );
+}
+
+static inline int expand_row_16( DWORD *dst, const WORD *src, int len, int green_len )
+{
+    if (get_simd_level() < SIMD_SSE2) return 0;
+    return expand_row_16_sse2( dst, src, len, green_len );
+}
+
+static inline int blend_row_argb( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    if (get_simd_level() < SIMD_SSE2) return 0;
+    return blend_row_argb_sse2( dst, src, len, alpha );
+}
+
+static inline int blend_row_argb_alpha( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    if (get_simd_level() < SIMD_SSE2) return 0;
+    return blend_row_argb_alpha_sse2( dst, src, len, alpha );
+}
+
+#else  /* no vector support */
+
+static inline int shuffle_row_32( DWORD *dst, const DWORD *src, int len, const char map[4] ) { return 0; }
+static inline int expand_row_24( DWORD *dst, const BYTE *src, int len ) { return 0; }
+static inline int pack_row_24( BYTE *dst, const DWORD *src, int len, const char map[3] ) { return 0; }
+static inline int pack_row_16( WORD *dst, const DWORD *src, int len, int green_len ) { return 0; }
+static inline int expand_row_16( DWORD *dst, const WORD *src, int len, int green_len ) { return 0; }
+static inline int blend_row_argb( DWORD *dst, const DWORD *src, int len, DWORD alpha ) { return 0; }
+static inline int blend_row_argb_alpha( DWORD *dst, const DWORD *src, int len, DWORD alpha ) { return 0; }
+
+#endif
+
+/* byte positions of the fields of a 32-bpp dib, if they are all 8 bits wide and byte aligned */
+static inline BOOL get_byte_fields_32( const dib_info *dib, char *red, char *green, char *blue )
+{
+    if (dib->red_len != 8 || dib->green_len != 8 || dib->blue_len != 8) return FALSE;
+    if ((dib->red_shift | dib->green_shift | dib->blue_shift) & 7) return FALSE;
+    *red   = dib->red_shift / 8;
+    *green = dib->green_shift / 8;
+    *blue  = dib->blue_shift / 8;
+    return TRUE;
+}
+
+/* standard 555 or 565 field layout, returns the green field length or 0 */
+static inline int get_std_fields_16( const dib_info *dib )
+{
+    if (dib->red_len != 5 || dib->blue_len != 5 || dib->blue_shift != 0) return 0;
+    if (dib->green_len == 5 && dib->green_shift == 5 && dib->red_shift == 10) return 5;
+    if (dib->green_len == 6 && dib->green_shift == 5 && dib->red_shift == 11) return 6;
+    return 0;
+}
+
 static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_rect)
 {
     DWORD *dst_start = get_pixel_ptr_32(dst, 0, 0), *dst_pixel, src_val;
@@ -1244,11 +1524,16 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
         }
         else if(src->red_len == 8 && src->green_len == 8 && src->blue_len == 8)
         {
+            char map[4] = { 0, 0, 0, 0x80 };
+            BOOL aligned = get_byte_fields_32(src, &map[2], &map[1], &map[0]);
+            int done;
+
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = aligned ? shuffle_row_32(dst_start, src_start, src_rect->right - src_rect->left, map) : 0;
+                dst_pixel = dst_start + done;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = (((src_val >> src->red_shift)   & 0xff) << 16) |
@@ -1284,12 +1569,14 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
     case 24:
     {
         BYTE *src_start = get_pixel_ptr_24(src, src_rect->left, src_rect->top), *src_pixel;
+        int done;
 
         for(y = src_rect->top; y < src_rect->bottom; y++)
         {
-            dst_pixel = dst_start;
-            src_pixel = src_start;
-            for(x = src_rect->left; x < src_rect->right; x++)
+            done = expand_row_24(dst_start, src_start, src_rect->right - src_rect->left);
+            dst_pixel = dst_start + done;
+            src_pixel = src_start + done * 3;
+            for(x = src_rect->left + done; x < src_rect->right; x++)
             {
                 RGBQUAD rgb;
                 rgb.rgbBlue  = *src_pixel++;
@@ -1310,11 +1597,14 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
         WORD *src_start = get_pixel_ptr_16(src, src_rect->left, src_rect->top), *src_pixel;
         if(src->funcs == &funcs_555)
         {
+            int done;
+
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = expand_row_16(dst_start, src_start, src_rect->right - src_rect->left, 5);
+                dst_pixel = dst_start + done;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = ((src_val << 9) & 0xf80000) | ((src_val << 4) & 0x070000) |
@@ -1349,11 +1639,15 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
         }
         else if(src->red_len == 5 && src->green_len == 6 && src->blue_len == 5)
         {
+            BOOL std = get_std_fields_16(src) == 6;
+            int done;
+
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = std ? expand_row_16(dst_start, src_start, src_rect->right - src_rect->left, 6) : 0;
+                dst_pixel = dst_start + done;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = (((src_val >> src->red_shift)   << 19) & 0xf80000) |
@@ -1468,11 +1762,22 @@ static void convert_to_32(dib_info *dst, const dib_info *src, const RECT *src_re
 
         if(src->funcs == &funcs_8888)
         {
+            char map[4] = { 0x80, 0x80, 0x80, 0x80 }, red, green, blue;
+            BOOL aligned = get_byte_fields_32(dst, &red, &green, &blue);
+            int done;
+
+            if (aligned)
+            {
+                map[(int)red] = 2;
+                map[(int)green] = 1;
+                map[(int)blue] = 0;
+            }
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = aligned ? shuffle_row_32(dst_start, src_start, src_rect->right - src_rect->left, map) : 0;
+                dst_pixel = dst_start + done;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = put_field(src_val >> 16, dst->red_shift,   dst->red_len)   |
@@ -1734,11 +2039,15 @@ static void convert_to_24(dib_info *dst, const dib_info *src, const RECT *src_re
         DWORD *src_start = get_pixel_ptr_32(src, src_rect->left, src_rect->top), *src_pixel;
         if(src->funcs == &funcs_8888)
         {
+            static const char map[3] = { 0, 1, 2 };
+            int done;
+
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = pack_row_24(dst_start, src_start, src_rect->right - src_rect->left, map);
+                dst_pixel = dst_start + done * 3;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ =  src_val        & 0xff;
@@ -1752,11 +2061,16 @@ static void convert_to_24(dib_info *dst, const dib_info *src, const RECT *src_re
         }
         else if(src->red_len == 8 && src->green_len == 8 && src->blue_len == 8)
         {
+            char map[3];
+            BOOL aligned = get_byte_fields_32(src, &map[2], &map[1], &map[0]);
+            int done;
+
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = aligned ? pack_row_24(dst_start, src_start, src_rect->right - src_rect->left, map) : 0;
+                dst_pixel = dst_start + done * 3;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = (src_val >> src->blue_shift)  & 0xff;
@@ -1978,11 +2292,14 @@ static void convert_to_555(dib_info *dst, const dib_info *src, const RECT *src_r
 
         if(src->funcs == &funcs_8888)
         {
+            int done;
+
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = pack_row_16(dst_start, src_start, src_rect->right - src_rect->left, 5);
+                dst_pixel = dst_start + done;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = ((src_val >> 9) & 0x7c00) |
@@ -2220,11 +2537,14 @@ static void convert_to_16(dib_info *dst, const dib_info *src, const RECT *src_re
 
         if(src->funcs == &funcs_8888)
         {
+            int green_len = get_std_fields_16(dst), done;
+
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                done = green_len ? pack_row_16(dst_start, src_start, src_rect->right - src_rect->left, green_len) : 0;
+                dst_pixel = dst_start + done;
+                src_pixel = src_start + done;
+                for(x = src_rect->left + done; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = put_field(src_val >> 16, dst->red_shift,   dst->red_len)   |
@@ -3575,15 +3895,15 @@ static void blend_rect_8888(const dib_info *dst, const RECT *rc,
 {
     DWORD *src_ptr = get_pixel_ptr_32( src, origin->x, origin->y );
     DWORD *dst_ptr = get_pixel_ptr_32( dst, rc->left, rc->top );
-    int x, y;
+    int x, y, width = rc->right - rc->left;
 
     if (blend.AlphaFormat & AC_SRC_ALPHA)
         for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-            for (x = 0; x < rc->right - rc->left; x++)
+            for (x = blend_row_argb_alpha( dst_ptr, src_ptr, width, blend.SourceConstantAlpha ); x < width; x++)
                 dst_ptr[x] = blend_argb_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
     else
         for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-            for (x = 0; x < rc->right - rc->left; x++)
+            for (x = blend_row_argb( dst_ptr, src_ptr, width, blend.SourceConstantAlpha ); x < width; x++)
                 dst_ptr[x] = blend_argb( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
 }
 
@@ -3441,6 +3441,143 @@ static void test_32bit_bitmap_blt(void)
     DeleteDC(hdcScreen);
 }
 
+static HBITMAP create_test_dib( int bpp, const DWORD *masks, int width, int height, void **bits )
+{
+    char buffer[FIELD_OFFSET( BITMAPINFO, bmiColors[3] )];
+    BITMAPINFO *info = (BITMAPINFO *)buffer;
+
+    memset( buffer, 0, sizeof(buffer) );
+    info->bmiHeader.biSize = sizeof(info->bmiHeader);
+    info->bmiHeader.biWidth = width;
+    info->bmiHeader.biHeight = -height;
+    info->bmiHeader.biPlanes = 1;
+    info->bmiHeader.biBitCount = bpp;
+    info->bmiHeader.biCompression = masks ? BI_BITFIELDS : BI_RGB;
+    if (masks) memcpy( info->bmiColors, masks, 3 * sizeof(DWORD) );
+    return CreateDIBSection( 0, info, DIB_RGB_COLORS, bits, NULL, 0 );
+}
+
+/* Converting or blending a whole rectangle must give the same result as
+ * doing it one column at a time, whatever code handles the long rows. */
+static void test_wide_rows(void)
+{
+    static const DWORD masks_565[3] = { 0xf800, 0x07e0, 0x001f };
+    static const DWORD masks_bgr[3] = { 0x0000ff, 0x00ff00, 0xff0000 };
+    static const struct
+    {
+        int bpp;
+        const DWORD *masks;
+    } formats[] =
+    {
+        { 32, NULL }, { 32, masks_bgr }, { 24, NULL }, { 16, NULL }, { 16, masks_565 }
+    };
+    const int width = 61, height = 3;
+    HDC hdc_src, hdc_dst;
+    HBITMAP src, dst, old_src, old_dst;
+    BYTE *src_bits, *dst_bits, *ref_bits, *col_bits;
+    BLENDFUNCTION blend;
+    int i, j, k, x, size;
+    BOOL ret;
+
+    hdc_src = CreateCompatibleDC( 0 );
+    hdc_dst = CreateCompatibleDC( 0 );
+
+    for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+    {
+        for (j = 0; j < sizeof(formats) / sizeof(formats[0]); j++)
+        {
+            if (i == j) continue;
+            src = create_test_dib( formats[i].bpp, formats[i].masks, width, height, (void **)&src_bits );
+            dst = create_test_dib( formats[j].bpp, formats[j].masks, width, height, (void **)&dst_bits );
+            ok( src != NULL && dst != NULL, "failed to create dibs\n" );
+            size = ((width * formats[j].bpp + 31) / 32) * 4 * height;
+            for (k = 0; k < ((width * formats[i].bpp + 31) / 32) * 4 * height; k++)
+                src_bits[k] = k * 97 + (k >> 3) * 13;
+            old_src = SelectObject( hdc_src, src );
+            old_dst = SelectObject( hdc_dst, dst );
+
+            for (x = 0; x < width; x++)
+                BitBlt( hdc_dst, x, 0, 1, height, hdc_src, x, 0, SRCCOPY );
+            GdiFlush();
+            ref_bits = HeapAlloc( GetProcessHeap(), 0, size );
+            memcpy( ref_bits, dst_bits, size );
+            memset( dst_bits, 0, size );
+            BitBlt( hdc_dst, 0, 0, width, height, hdc_src, 0, 0, SRCCOPY );
+            GdiFlush();
+            ok( !memcmp( dst_bits, ref_bits, size ), "%u/%u -> %u/%u: rows differ from columns\n",
+                formats[i].bpp, formats[i].masks ? formats[i].masks[0] : 0,
+                formats[j].bpp, formats[j].masks ? formats[j].masks[0] : 0 );
+            HeapFree( GetProcessHeap(), 0, ref_bits );
+
+            SelectObject( hdc_src, old_src );
+            SelectObject( hdc_dst, old_dst );
+            DeleteObject( src );
+            DeleteObject( dst );
+        }
+    }
+
+    if (!pGdiAlphaBlend)
+    {
+        win_skip( "GdiAlphaBlend() is not implemented\n" );
+        goto done;
+    }
+
+    src = create_test_dib( 32, NULL, width, height, (void **)&src_bits );
+    dst = create_test_dib( 32, NULL, width, height, (void **)&dst_bits );
+    size = width * height * 4;
+    ref_bits = HeapAlloc( GetProcessHeap(), 0, size );
+    col_bits = HeapAlloc( GetProcessHeap(), 0, size );
+    old_src = SelectObject( hdc_src, src );
+    old_dst = SelectObject( hdc_dst, dst );
+
+    blend.BlendOp = AC_SRC_OVER;
+    blend.BlendFlags = 0;
+    for (i = 0; i < 4; i++)
+    {
+        blend.SourceConstantAlpha = (i & 1) ? 255 : 77;
+        blend.AlphaFormat = (i & 2) ? AC_SRC_ALPHA : 0;
+        for (k = 0; k < size; k++)
+        {
+            src_bits[k] = k * 59 + i;
+            dst_bits[k] = k * 31 + (k >> 2);
+        }
+        /* keep the source premultiplied */
+        if (blend.AlphaFormat)
+            for (k = 0; k < size; k += 4)
+            {
+                src_bits[k]     = src_bits[k]     * src_bits[k + 3] / 255;
+                src_bits[k + 1] = src_bits[k + 1] * src_bits[k + 3] / 255;
+                src_bits[k + 2] = src_bits[k + 2] * src_bits[k + 3] / 255;
+            }
+        memcpy( ref_bits, dst_bits, size );
+
+        for (x = 0; x < width; x++)
+        {
+            ret = pGdiAlphaBlend( hdc_dst, x, 0, 1, height, hdc_src, x, 0, 1, height, blend );
+            ok( ret, "GdiAlphaBlend failed err %u\n", GetLastError() );
+        }
+        GdiFlush();
+        memcpy( col_bits, dst_bits, size );
+        memcpy( dst_bits, ref_bits, size );
+        ret = pGdiAlphaBlend( hdc_dst, 0, 0, width, height, hdc_src, 0, 0, width, height, blend );
+        ok( ret, "GdiAlphaBlend failed err %u\n", GetLastError() );
+        GdiFlush();
+        ok( !memcmp( dst_bits, col_bits, size ), "%u/%02x: rows differ from columns\n",
+            blend.SourceConstantAlpha, blend.AlphaFormat );
+    }
+
+    HeapFree( GetProcessHeap(), 0, ref_bits );
+    HeapFree( GetProcessHeap(), 0, col_bits );
+    SelectObject( hdc_src, old_src );
+    SelectObject( hdc_dst, old_dst );
+    DeleteObject( src );
+    DeleteObject( dst );
+
+done:
+    DeleteDC( hdc_src );
+    DeleteDC( hdc_dst );
+}
+
 /*
  * Used by test_GetDIBits_top_down to create the bitmap to test against.
  */
@@ -4934,6 +5071,7 @@ START_TEST(bitmap)
     test_StretchDIBits();
     test_GdiAlphaBlend();
     test_32bit_bitmap_blt();
+    test_wide_rows();
     test_bitmapinfoheadersize();
     test_get16dibits();
     test_clipping();
@@ -33,6 +33,7 @@
 
 static HCRYPTPROV crypt_prov;
 static BOOL (WINAPI *pGdiAlphaBlend)(HDC,int,int,int,int,HDC,int,int,int,int,BLENDFUNCTION);
+static BOOL (WINAPI *pGdiGradientFill)(HDC,TRIVERTEX*,ULONG,void*,ULONG,ULONG);
 static DWORD (WINAPI *pSetLayout)(HDC hdc, DWORD layout);
 
 static const DWORD rop3[256] =
@@ -2362,15 +2363,204 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+static inline DWORD get_pixel_32(const DWORD *bits, int x, int y)
+{
+    return bits[y * 64 + x] & 0xffffff;
+}
+
+static void test_filled_shapes(void)
+{
+    static const POINT star[5] = {{32, 2}, {50, 60}, {2, 22}, {62, 22}, {14, 60}};
+    static const POINT squares[8] = {{4, 4}, {40, 4}, {40, 40}, {4, 40},
+                                     {20, 20}, {56, 20}, {56, 56}, {20, 56}};
+    static const POINT square[4] = {{10, 10}, {30, 10}, {30, 30}, {10, 30}};
+    static const INT counts[2] = {4, 4};
+    static const INT modes[2] = {ALTERNATE, WINDING};
+    static const DWORD bk = 0xcccccc, fill = 0x123456, outline = 0xff0000;
+    TRIVERTEX vert[3];
+    GRADIENT_RECT rect = {0, 1};
+    GRADIENT_TRIANGLE tri = {0, 1, 2};
+    BITMAPINFO bmi;
+    HDC hdc;
+    HBITMAP dib, orig_bm;
+    DWORD *bits, prev;
+    HBRUSH brush, orig_brush;
+    HPEN pen, orig_pen;
+    HRGN clip;
+    int i, x, y;
+
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biHeight = -64;
+    bmi.bmiHeader.biWidth = 64;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    hdc = CreateCompatibleDC(NULL);
+    dib = CreateDIBSection(0, &bmi, DIB_RGB_COLORS, (void**)&bits, NULL, 0);
+    ok(dib != NULL, "ret NULL\n");
+    orig_bm = SelectObject(hdc, dib);
+
+    brush = CreateSolidBrush(RGB(0x12, 0x34, 0x56));
+    pen = CreatePen(PS_SOLID, 1, RGB(0xff, 0, 0));
+    orig_brush = SelectObject(hdc, brush);
+    orig_pen = SelectObject(hdc, GetStockObject(NULL_PEN));
+
+    /* with a null pen only the interior is filled, following the fill mode */
+    clip = CreateRectRgn(8, 0, 64, 50);
+    SelectClipRgn(hdc, clip);
+    for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        SetPolyFillMode(hdc, modes[i]);
+
+        memset(bits, 0xcc, 64 * 64 * 4);
+        Polygon(hdc, star, sizeof(star) / sizeof(star[0]));
+        ok(get_pixel_32(bits, 32, 10) == fill, "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 32, 10));
+        ok(get_pixel_32(bits, 32, 33) == (modes[i] == WINDING ? fill : bk),
+           "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 32, 33));
+        ok(get_pixel_32(bits, 2, 2) == bk, "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 2, 2));
+
+        memset(bits, 0xcc, 64 * 64 * 4);
+        PolyPolygon(hdc, squares, counts, 2);
+        ok(get_pixel_32(bits, 12, 12) == fill, "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 12, 12));
+        ok(get_pixel_32(bits, 30, 30) == (modes[i] == WINDING ? fill : bk),
+           "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 30, 30));
+        ok(get_pixel_32(bits, 45, 45) == fill, "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 45, 45));
+        /* clipped */
+        ok(get_pixel_32(bits, 5, 10) == bk, "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 5, 10));
+        ok(get_pixel_32(bits, 30, 52) == bk, "mode %d: got %06x\n", modes[i], get_pixel_32(bits, 30, 52));
+    }
+    SelectClipRgn(hdc, NULL);
+    DeleteObject(clip);
+
+    /* a visible pen draws the outline over the fill */
+    SelectObject(hdc, pen);
+
+    memset(bits, 0xcc, 64 * 64 * 4);
+    Polygon(hdc, square, sizeof(square) / sizeof(square[0]));
+    ok(get_pixel_32(bits, 10, 10) == outline, "got %06x\n", get_pixel_32(bits, 10, 10));
+    ok(get_pixel_32(bits, 20, 10) == outline, "got %06x\n", get_pixel_32(bits, 20, 10));
+    ok(get_pixel_32(bits, 30, 20) == outline, "got %06x\n", get_pixel_32(bits, 30, 20));
+    ok(get_pixel_32(bits, 20, 30) == outline, "got %06x\n", get_pixel_32(bits, 20, 30));
+    ok(get_pixel_32(bits, 10, 20) == outline, "got %06x\n", get_pixel_32(bits, 10, 20));
+    ok(get_pixel_32(bits, 20, 20) == fill, "got %06x\n", get_pixel_32(bits, 20, 20));
+    ok(get_pixel_32(bits, 31, 20) == bk, "got %06x\n", get_pixel_32(bits, 31, 20));
+
+    memset(bits, 0xcc, 64 * 64 * 4);
+    PolyPolygon(hdc, squares, counts, 2);
+    ok(get_pixel_32(bits, 4, 20) == outline, "got %06x\n", get_pixel_32(bits, 4, 20));
+    ok(get_pixel_32(bits, 56, 40) == outline, "got %06x\n", get_pixel_32(bits, 56, 40));
+    ok(get_pixel_32(bits, 30, 20) == outline, "got %06x\n", get_pixel_32(bits, 30, 20));
+    ok(get_pixel_32(bits, 12, 12) == fill, "got %06x\n", get_pixel_32(bits, 12, 12));
+    ok(get_pixel_32(bits, 60, 60) == bk, "got %06x\n", get_pixel_32(bits, 60, 60));
+
+    /* the outline stays inside the bounding rectangle, right and bottom excluded */
+    memset(bits, 0xcc, 64 * 64 * 4);
+    Ellipse(hdc, 10, 10, 50, 40);
+    ok(get_pixel_32(bits, 30, 25) == fill, "got %06x\n", get_pixel_32(bits, 30, 25));
+    ok(get_pixel_32(bits, 10, 10) == bk, "got %06x\n", get_pixel_32(bits, 10, 10));
+    ok(get_pixel_32(bits, 49, 39) == bk, "got %06x\n", get_pixel_32(bits, 49, 39));
+    ok(get_pixel_32(bits, 50, 25) == bk, "got %06x\n", get_pixel_32(bits, 50, 25));
+    ok(get_pixel_32(bits, 30, 40) == bk, "got %06x\n", get_pixel_32(bits, 30, 40));
+
+    memset(bits, 0xcc, 64 * 64 * 4);
+    RoundRect(hdc, 10, 10, 50, 40, 10, 10);
+    ok(get_pixel_32(bits, 30, 25) == fill, "got %06x\n", get_pixel_32(bits, 30, 25));
+    ok(get_pixel_32(bits, 10, 10) == bk, "got %06x\n", get_pixel_32(bits, 10, 10));
+    ok(get_pixel_32(bits, 30, 10) == outline, "got %06x\n", get_pixel_32(bits, 30, 10));
+    ok(get_pixel_32(bits, 10, 25) == outline, "got %06x\n", get_pixel_32(bits, 10, 25));
+    ok(get_pixel_32(bits, 49, 25) == outline, "got %06x\n", get_pixel_32(bits, 49, 25));
+    ok(get_pixel_32(bits, 30, 39) == outline, "got %06x\n", get_pixel_32(bits, 30, 39));
+    ok(get_pixel_32(bits, 50, 25) == bk, "got %06x\n", get_pixel_32(bits, 50, 25));
+    ok(get_pixel_32(bits, 30, 40) == bk, "got %06x\n", get_pixel_32(bits, 30, 40));
+
+    if (!pGdiGradientFill)
+    {
+        win_skip("GdiGradientFill not supported\n");
+        goto done;
+    }
+
+    /* gradients start at the exact color of the first vertex */
+    memset(vert, 0, sizeof(vert));
+    vert[0].x = 0;
+    vert[0].y = 0;
+    vert[0].Red = 0xff00;
+    vert[1].x = 64;
+    vert[1].y = 8;
+    vert[1].Blue = 0xff00;
+
+    memset(bits, 0xcc, 64 * 64 * 4);
+    pGdiGradientFill(hdc, vert, 2, &rect, 1, GRADIENT_FILL_RECT_H);
+    ok(get_pixel_32(bits, 0, 4) == 0xff0000, "got %06x\n", get_pixel_32(bits, 0, 4));
+    ok(get_pixel_32(bits, 0, 8) == bk, "got %06x\n", get_pixel_32(bits, 0, 8));
+    prev = get_pixel_32(bits, 0, 4);
+    for (x = 1; x < 64; x++)
+    {
+        DWORD color = get_pixel_32(bits, x, 4);
+        ok((color >> 16) <= (prev >> 16) && (color & 0xff) >= (prev & 0xff) && !(color & 0xff00),
+           "pixel %d: got %06x, previous %06x\n", x, color, prev);
+        prev = color;
+    }
+    ok(prev != 0xff0000, "no gradient, got %06x\n", prev);
+
+    vert[1].x = 8;
+    vert[1].y = 64;
+
+    memset(bits, 0xcc, 64 * 64 * 4);
+    pGdiGradientFill(hdc, vert, 2, &rect, 1, GRADIENT_FILL_RECT_V);
+    ok(get_pixel_32(bits, 4, 0) == 0xff0000, "got %06x\n", get_pixel_32(bits, 4, 0));
+    ok(get_pixel_32(bits, 8, 0) == bk, "got %06x\n", get_pixel_32(bits, 8, 0));
+    prev = get_pixel_32(bits, 4, 0);
+    for (y = 1; y < 64; y++)
+    {
+        DWORD color = get_pixel_32(bits, 4, y);
+        ok((color >> 16) <= (prev >> 16) && (color & 0xff) >= (prev & 0xff) && !(color & 0xff00),
+           "pixel %d: got %06x, previous %06x\n", y, color, prev);
+        prev = color;
+    }
+    ok(prev != 0xff0000, "no gradient, got %06x\n", prev);
+
+    /* a triangle with a single color is filled with exactly that color */
+    for (i = 0; i < 3; i++)
+    {
+        vert[i].Red = vert[i].Blue = 0;
+        vert[i].Green = 0xff00;
+    }
+    vert[0].x = 0;
+    vert[0].y = 0;
+    vert[1].x = 63;
+    vert[1].y = 0;
+    vert[2].x = 0;
+    vert[2].y = 63;
+
+    memset(bits, 0xcc, 64 * 64 * 4);
+    pGdiGradientFill(hdc, vert, 3, &tri, 1, GRADIENT_FILL_TRIANGLE);
+    ok(get_pixel_32(bits, 10, 10) == 0x00ff00, "got %06x\n", get_pixel_32(bits, 10, 10));
+    ok(get_pixel_32(bits, 20, 30) == 0x00ff00, "got %06x\n", get_pixel_32(bits, 20, 30));
+    ok(get_pixel_32(bits, 40, 40) == bk, "got %06x\n", get_pixel_32(bits, 40, 40));
+
+done:
+    SelectObject(hdc, orig_brush);
+    SelectObject(hdc, orig_pen);
+    SelectObject(hdc, orig_bm);
+    DeleteObject(dib);
+    DeleteObject(pen);
+    DeleteObject(brush);
+    DeleteDC(hdc);
+}
+
 START_TEST(dib)
 {
     HMODULE mod = GetModuleHandleA("gdi32.dll");
     pSetLayout = (void *)GetProcAddress( mod, "SetLayout" );
     pGdiAlphaBlend = (void *)GetProcAddress( mod, "GdiAlphaBlend" );
+    pGdiGradientFill = (void *)GetProcAddress( mod, "GdiGradientFill" );
 
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
+    test_filled_shapes();
 
     CryptReleaseContext(crypt_prov, 0);
 }
@@ -500,11 +500,31 @@ static void apply_image_attributes(const GpImageAttributes *attributes, LPBYTE d
     }
 }
 
+/* Distance in source pixels the filter reaches from a sample point. */
+static REAL filter_radius(InterpolationMode interpolation, REAL step)
+{
+    switch (interpolation)
+    {
+    case InterpolationModeBilinear:
+        return 1.0f;
+    case InterpolationModeBicubic:
+        return 2.0f;
+    /* the high quality modes widen the kernel when shrinking the image */
+    case InterpolationModeHighQualityBilinear:
+        return step > 1.0f ? step : 1.0f;
+    case InterpolationModeHighQualityBicubic:
+        return step > 1.0f ? 2.0f * step : 2.0f;
+    case InterpolationModeNearestNeighbor:
+    default:
+        return 0.0f;
+    }
+}
+
 /* Given a bitmap and its source rectangle, find the smallest rectangle in the
  * bitmap that contains all the pixels we may need to draw it. */
 static void get_bitmap_sample_size(InterpolationMode interpolation, WrapMode wrap,
     GpBitmap* bitmap, REAL srcx, REAL srcy, REAL srcwidth, REAL srcheight,
-    GpRect *rect)
+    REAL xradius, REAL yradius, GpRect *rect)
 {
     INT left, top, right, bottom;
 
@@ -512,13 +532,13 @@ static void get_bitmap_sample_size(InterpolationMode interpolation, WrapMode wra
     {
     case InterpolationModeHighQualityBilinear:
     case InterpolationModeHighQualityBicubic:
-    /* FIXME: Include a greater range for the prefilter? */
     case InterpolationModeBicubic:
     case InterpolationModeBilinear:
-        left = (INT)(floorf(srcx));
-        top = (INT)(floorf(srcy));
-        right = (INT)(ceilf(srcx+srcwidth));
-        bottom = (INT)(ceilf(srcy+srcheight));
+        /* include every pixel the filter reaches from the source rectangle */
+        left = (INT)(floorf(srcx-xradius)) + 1;
+        top = (INT)(floorf(srcy-yradius)) + 1;
+        right = (INT)(ceilf(srcx+srcwidth+xradius));
+        bottom = (INT)(ceilf(srcy+srcheight+yradius));
         break;
     case InterpolationModeNearestNeighbor:
     default:
@@ -664,6 +684,288 @@ static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT
     }
 }
 
+/* Weights of a separable filter along one axis, in 1.14 fixed point. */
+struct resample_filter
+{
+    INT  taps;      /* number of source pixels per destination pixel */
+    INT *index;     /* source pixel of each tap, -1 for the outside color */
+    INT *coeffs;    /* weight of each tap, they add up to 1 << 14 */
+};
+
+static REAL filter_kernel(InterpolationMode interpolation, REAL x)
+{
+    x = fabsf(x);
+
+    switch (interpolation)
+    {
+    case InterpolationModeBicubic:
+    case InterpolationModeHighQualityBicubic:
+        /* Keys cubic convolution, a = -0.5 */
+        if (x < 1.0f) return (1.5f * x - 2.5f) * x * x + 1.0f;
+        if (x < 2.0f) return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+        return 0.0f;
+    default:
+        return x < 1.0f ? 1.0f - x : 0.0f;
+    }
+}
+
+/* Map a bitmap coordinate to a pixel of the sampled area, following the wrap
+ * mode like sample_bitmap_pixel does. */
+static INT map_sample_coordinate(INT x, INT size, INT area_start, INT area_size,
+    WrapMode wrap, BOOL flip)
+{
+    if (wrap == WrapModeClamp)
+    {
+        if (x < 0 || x >= size)
+            return -1;
+    }
+    else
+    {
+        if (x < 0)
+            x = size*2 + x % (size * 2);
+        if (flip && (x / size) % 2 == 1)
+            x = size - 1 - x % size;
+        else
+            x = x % size;
+    }
+
+    /* the sampled area covers the filter around every sample inside the
+     * source rectangle, only samples that are discarded can end up here */
+    x -= area_start;
+    if (x < 0) return 0;
+    if (x >= area_size) return area_size - 1;
+    return x;
+}
+
+static GpStatus init_resample_filter(struct resample_filter *filter, InterpolationMode interpolation,
+    REAL start, REAL step, INT count, INT size, INT area_start, INT area_size, WrapMode wrap, BOOL flip)
+{
+    REAL radius = filter_radius(interpolation, step), scale = 1.0f;
+    INT i, j;
+
+    if ((interpolation == InterpolationModeHighQualityBilinear ||
+         interpolation == InterpolationModeHighQualityBicubic) && step > 1.0f)
+        scale = step;
+
+    filter->taps = (INT)ceilf(2.0f * radius);
+    filter->index = GdipAlloc(sizeof(INT) * filter->taps * count);
+    filter->coeffs = GdipAlloc(sizeof(INT) * filter->taps * count);
+    if (!filter->index || !filter->coeffs)
+    {
+        GdipFree(filter->index);
+        GdipFree(filter->coeffs);
+        return OutOfMemory;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        REAL pos = start + i * step, weights[64], sum = 0.0f;
+        INT *index = filter->index + i * filter->taps;
+        INT *coeffs = filter->coeffs + i * filter->taps;
+        INT first = (INT)floorf(pos - radius) + 1, total = 0, largest = 0;
+        REAL *w = filter->taps <= 64 ? weights : GdipAlloc(sizeof(REAL) * filter->taps);
+
+        if (!w)
+        {
+            GdipFree(filter->index);
+            GdipFree(filter->coeffs);
+            return OutOfMemory;
+        }
+
+        for (j = 0; j < filter->taps; j++)
+        {
+            w[j] = filter_kernel(interpolation, (first + j - pos) / scale);
+            sum += w[j];
+        }
+        for (j = 0; j < filter->taps; j++)
+        {
+            index[j] = map_sample_coordinate(first + j, size, area_start, area_size, wrap, flip);
+            coeffs[j] = roundr(w[j] / sum * (1 << 14));
+            total += coeffs[j];
+            if (coeffs[j] > coeffs[largest]) largest = j;
+        }
+        coeffs[largest] += (1 << 14) - total;
+
+        if (w != weights) GdipFree(w);
+    }
+
+    return Ok;
+}
+
+static void free_resample_filter(struct resample_filter *filter)
+{
+    GdipFree(filter->index);
+    GdipFree(filter->coeffs);
+}
+
+/* Filter one source row horizontally, the result has 8 fractional bits. */
+static void resample_row(const struct resample_filter *filter, const ARGB *src, ARGB outside,
+    INT count, INT *dst)
+{
+    INT i, j;
+
+    for (i = 0; i < count; i++, dst += 4)
+    {
+        const INT *index = filter->index + i * filter->taps;
+        const INT *coeffs = filter->coeffs + i * filter->taps;
+        INT a = 0, r = 0, g = 0, b = 0;
+
+        for (j = 0; j < filter->taps; j++)
+        {
+            ARGB color = index[j] == -1 ? outside : src[index[j]];
+            a += coeffs[j] * (INT)(color >> 24);
+            r += coeffs[j] * (INT)((color >> 16) & 0xff);
+            g += coeffs[j] * (INT)((color >> 8) & 0xff);
+            b += coeffs[j] * (INT)(color & 0xff);
+        }
+        dst[0] = (a + (1 << 5)) >> 6;
+        dst[1] = (r + (1 << 5)) >> 6;
+        dst[2] = (g + (1 << 5)) >> 6;
+        dst[3] = (b + (1 << 5)) >> 6;
+    }
+}
+
+static inline BYTE clamp_channel(INT value)
+{
+    value = (value + (1 << 21)) >> 22;
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+/* Scale the sampled area to an axis aligned destination, filtering rows and
+ * columns separately. Each source row is filtered horizontally once and kept
+ * while the destination rows still need it. */
+static GpStatus resample_bitmap_scaled(GDIPCONST GpRect *src_area, LPBYTE src_data,
+    UINT width, UINT height, GDIPCONST GpImageAttributes *attributes,
+    InterpolationMode interpolation, GDIPCONST GpPointF *origin, REAL x_dx, REAL y_dy,
+    REAL srcx, REAL srcy, REAL srcwidth, REAL srcheight,
+    GDIPCONST RECT *dst_area, LPBYTE dst_data, INT dst_stride)
+{
+    INT dst_width = dst_area->right - dst_area->left, dst_height = dst_area->bottom - dst_area->top;
+    struct resample_filter xfilter, yfilter;
+    INT *rows, *row_tags, *row_used, x, y, i, j;
+    const INT **tap_rows;
+    BOOL *columns;
+    GpStatus stat;
+
+    stat = init_resample_filter(&xfilter, interpolation, origin->X + dst_area->left * x_dx, x_dx,
+        dst_width, width, src_area->X, src_area->Width, attributes->wrap, (attributes->wrap & 1) == 1);
+    if (stat != Ok) return stat;
+
+    stat = init_resample_filter(&yfilter, interpolation, origin->Y + dst_area->top * y_dy, y_dy,
+        dst_height, height, src_area->Y, src_area->Height, attributes->wrap, (attributes->wrap & 2) == 2);
+    if (stat != Ok)
+    {
+        free_resample_filter(&xfilter);
+        return stat;
+    }
+
+    rows = GdipAlloc(sizeof(INT) * 4 * dst_width * yfilter.taps);
+    row_tags = GdipAlloc(sizeof(INT) * yfilter.taps * 2);
+    tap_rows = GdipAlloc(sizeof(INT *) * yfilter.taps);
+    columns = GdipAlloc(sizeof(BOOL) * dst_width);
+    if (!rows || !row_tags || !tap_rows || !columns)
+    {
+        GdipFree(rows);
+        GdipFree(row_tags);
+        GdipFree(tap_rows);
+        GdipFree(columns);
+        free_resample_filter(&xfilter);
+        free_resample_filter(&yfilter);
+        return OutOfMemory;
+    }
+    row_used = row_tags + yfilter.taps;
+    for (i = 0; i < yfilter.taps; i++)
+    {
+        row_tags[i] = -2;
+        row_used[i] = -1;
+    }
+
+    for (x = 0; x < dst_width; x++)
+    {
+        REAL src_x = origin->X + (x + dst_area->left) * x_dx;
+        columns[x] = src_x >= srcx && src_x < srcx + srcwidth;
+    }
+
+    for (y = 0; y < dst_height; y++)
+    {
+        REAL src_y = origin->Y + (y + dst_area->top) * y_dy;
+        const INT *index = yfilter.index + y * yfilter.taps;
+        const INT *coeffs = yfilter.coeffs + y * yfilter.taps;
+        ARGB *dst_color = (ARGB *)(dst_data + dst_stride * y);
+
+        if (!(src_y >= srcy && src_y < srcy + srcheight))
+        {
+            memset(dst_color, 0, sizeof(ARGB) * dst_width);
+            continue;
+        }
+
+        /* find or compute the horizontally filtered source rows */
+        for (i = 0; i < yfilter.taps; i++)
+        {
+            INT slot = -1;
+
+            for (j = 0; j < yfilter.taps; j++)
+                if (row_tags[j] == index[i]) slot = j;
+
+            if (slot == -1)
+            {
+                for (j = 0; j < yfilter.taps; j++)
+                    if (row_used[j] < y && (slot == -1 || row_used[j] < row_used[slot])) slot = j;
+
+                row_tags[slot] = index[i];
+                if (index[i] == -1)
+                {
+                    ARGB outside = attributes->outside_color;
+                    INT *row = rows + slot * 4 * dst_width;
+
+                    for (x = 0; x < dst_width; x++, row += 4)
+                    {
+                        row[0] = (outside >> 24) << 8;
+                        row[1] = ((outside >> 16) & 0xff) << 8;
+                        row[2] = ((outside >> 8) & 0xff) << 8;
+                        row[3] = (outside & 0xff) << 8;
+                    }
+                }
+                else
+                    resample_row(&xfilter, (const ARGB *)(src_data + sizeof(ARGB) * src_area->Width * index[i]),
+                        attributes->outside_color, dst_width, rows + slot * 4 * dst_width);
+            }
+            row_used[slot] = y;
+            tap_rows[i] = rows + slot * 4 * dst_width;
+        }
+
+        for (x = 0; x < dst_width; x++)
+        {
+            INT a = 0, r = 0, g = 0, b = 0;
+
+            if (!columns[x])
+            {
+                dst_color[x] = 0;
+                continue;
+            }
+
+            for (i = 0; i < yfilter.taps; i++)
+            {
+                const INT *src = tap_rows[i] + x * 4;
+                a += coeffs[i] * src[0];
+                r += coeffs[i] * src[1];
+                g += coeffs[i] * src[2];
+                b += coeffs[i] * src[3];
+            }
+            dst_color[x] = clamp_channel(a) << 24 | clamp_channel(r) << 16 |
+                           clamp_channel(g) << 8 | clamp_channel(b);
+        }
+    }
+
+    GdipFree(rows);
+    GdipFree(row_tags);
+    GdipFree(tap_rows);
+    GdipFree(columns);
+    free_resample_filter(&xfilter);
+    free_resample_filter(&yfilter);
+    return Ok;
+}
+
 static INT brush_can_fill_path(GpBrush *brush)
 {
     switch (brush->bt)
@@ -2635,7 +2937,8 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
             BitmapData lockeddata;
             InterpolationMode interpolation = graphics->interpolation;
             GpPointF dst_to_src_points[3] = {{0.0, 0.0}, {1.0, 0.0}, {0.0, 1.0}};
-            REAL x_dx, x_dy, y_dx, y_dy;
+            REAL x_dx, x_dy, y_dx, y_dy, xradius, yradius;
+            BOOL scaled;
             static const GpImageAttributes defaultImageAttributes = {WrapModeClamp, 0, FALSE};
 
             if (!imageAttributes)
@@ -2677,8 +2980,22 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
 
             dst_stride = sizeof(ARGB) * (dst_area.right - dst_area.left);
 
+            GdipTransformMatrixPoints(dst_to_src, dst_to_src_points, 3);
+
+            x_dx = dst_to_src_points[1].X - dst_to_src_points[0].X;
+            x_dy = dst_to_src_points[1].Y - dst_to_src_points[0].Y;
+            y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
+            y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
+
+            /* plain scales go through the separable filter */
+            scaled = x_dy == 0.0 && y_dx == 0.0 && x_dx > 0.0 && y_dy > 0.0 &&
+                     interpolation != InterpolationModeNearestNeighbor;
+
+            xradius = filter_radius(interpolation, scaled ? x_dx : 1.0f);
+            yradius = filter_radius(interpolation, scaled ? y_dy : 1.0f);
+
             get_bitmap_sample_size(interpolation, imageAttributes->wrap,
-                bitmap, srcx, srcy, srcwidth, srcheight, &src_area);
+                bitmap, srcx, srcy, srcwidth, srcheight, xradius, yradius, &src_area);
 
             src_data = GdipAlloc(sizeof(ARGB) * src_area.Width * src_area.Height);
             if (!src_data)
@@ -2716,29 +3033,38 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
                 src_stride, ColorAdjustTypeBitmap);
 
             /* Transform the bits as needed to the destination. */
-            GdipTransformMatrixPoints(dst_to_src, dst_to_src_points, 3);
-
-            x_dx = dst_to_src_points[1].X - dst_to_src_points[0].X;
-            x_dy = dst_to_src_points[1].Y - dst_to_src_points[0].Y;
-            y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
-            y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
-
-            for (x=dst_area.left; x<dst_area.right; x++)
+            if (scaled)
             {
-                for (y=dst_area.top; y<dst_area.bottom; y++)
+                stat = resample_bitmap_scaled(&src_area, src_data, bitmap->width, bitmap->height,
+                    imageAttributes, interpolation, &dst_to_src_points[0], x_dx, y_dy,
+                    srcx, srcy, srcwidth, srcheight, &dst_area, dst_data, dst_stride);
+                if (stat != Ok)
                 {
-                    GpPointF src_pointf;
-                    ARGB *dst_color;
+                    GdipFree(src_data);
+                    GdipFree(dst_data);
+                    GdipDeleteMatrix(dst_to_src);
+                    return stat;
+                }
+            }
+            else
+            {
+                for (x=dst_area.left; x<dst_area.right; x++)
+                {
+                    for (y=dst_area.top; y<dst_area.bottom; y++)
+                    {
+                        GpPointF src_pointf;
+                        ARGB *dst_color;
 
-                    src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
-                    src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
+                        src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
+                        src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
 
-                    dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
+                        dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
 
-                    if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
-                        *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf, imageAttributes, interpolation);
-                    else
-                        *dst_color = 0;
+                        if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
+                            *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf, imageAttributes, interpolation);
+                        else
+                            *dst_color = 0;
+                    }
                 }
             }
 
@@ -2556,6 +2556,154 @@ static void test_dispose(void)
     expect(ObjectBusy, stat);
 }
 
+static void test_scaling(void)
+{
+    static const InterpolationMode modes[] = {InterpolationModeBilinear, InterpolationModeBicubic,
+        InterpolationModeHighQualityBilinear, InterpolationModeHighQualityBicubic};
+    static const GpPointF scale_points[3] = {{0.0, 0.0}, {32.0, 0.0}, {0.0, 32.0}};
+    static const GpPointF skew_points[3] = {{0.0, 0.0}, {32.0, 0.0}, {0.01, 32.0}};
+    GpStatus stat;
+    GpBitmap *bitmap1, *bitmap2, *bitmap3;
+    GpGraphics *graphics, *graphics3;
+    ARGB color, color3, prev;
+    int i, x, y;
+
+    stat = GdipCreateBitmapFromScan0(32, 32, 0, PixelFormat32bppARGB, NULL, &bitmap1);
+    expect(Ok, stat);
+
+    stat = GdipCreateBitmapFromScan0(32, 32, 0, PixelFormat32bppARGB, NULL, &bitmap2);
+    expect(Ok, stat);
+
+    stat = GdipCreateBitmapFromScan0(32, 32, 0, PixelFormat32bppARGB, NULL, &bitmap3);
+    expect(Ok, stat);
+
+    stat = GdipGetImageGraphicsContext((GpImage*)bitmap2, &graphics);
+    expect(Ok, stat);
+
+    stat = GdipGetImageGraphicsContext((GpImage*)bitmap3, &graphics3);
+    expect(Ok, stat);
+
+    for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+    {
+        stat = GdipSetInterpolationMode(graphics, modes[i]);
+        expect(Ok, stat);
+
+        /* a solid color stays the same when enlarged or shrunk */
+        for (y = 0; y < 32; y++)
+            for (x = 0; x < 32; x++)
+                GdipBitmapSetPixel(bitmap1, x, y, 0xff4080c0);
+
+        stat = GdipGraphicsClear(graphics, 0);
+        expect(Ok, stat);
+
+        stat = GdipDrawImageRectRectI(graphics, (GpImage*)bitmap1, 0,0,32,32, 0,0,4,4,
+            UnitPixel, NULL, NULL, NULL);
+        expect(Ok, stat);
+
+        stat = GdipBitmapGetPixel(bitmap2, 2, 2, &color);
+        expect(Ok, stat);
+        ok(color_match(0xff4080c0, color, 1), "mode %d: expected ff4080c0, got %.8x\n", modes[i], color);
+
+        stat = GdipBitmapGetPixel(bitmap2, 16, 16, &color);
+        expect(Ok, stat);
+        expect(0, color);
+
+        stat = GdipGraphicsClear(graphics, 0);
+        expect(Ok, stat);
+
+        stat = GdipDrawImageRectRectI(graphics, (GpImage*)bitmap1, 0,0,4,4, 0,0,32,32,
+            UnitPixel, NULL, NULL, NULL);
+        expect(Ok, stat);
+
+        stat = GdipBitmapGetPixel(bitmap2, 16, 16, &color);
+        expect(Ok, stat);
+        ok(color_match(0xff4080c0, color, 1), "mode %d: expected ff4080c0, got %.8x\n", modes[i], color);
+
+        /* a ramp stays a ramp */
+        for (y = 0; y < 32; y++)
+            for (x = 0; x < 32; x++)
+                GdipBitmapSetPixel(bitmap1, x, y, 0xff000000 | (x * 8));
+
+        stat = GdipGraphicsClear(graphics, 0);
+        expect(Ok, stat);
+
+        stat = GdipDrawImageRectRectI(graphics, (GpImage*)bitmap1, 0,0,32,32, 0,0,4,4,
+            UnitPixel, NULL, NULL, NULL);
+        expect(Ok, stat);
+
+        stat = GdipBitmapGetPixel(bitmap2, 0, 2, &prev);
+        expect(Ok, stat);
+        for (x = 1; x < 4; x++)
+        {
+            stat = GdipBitmapGetPixel(bitmap2, x, 2, &color);
+            expect(Ok, stat);
+            ok((color & 0xff) > (prev & 0xff), "mode %d: pixel %d is %.8x, previous %.8x\n",
+               modes[i], x, color, prev);
+            prev = color;
+        }
+
+        stat = GdipGraphicsClear(graphics, 0);
+        expect(Ok, stat);
+
+        stat = GdipDrawImageRectRectI(graphics, (GpImage*)bitmap1, 0,0,4,4, 0,0,32,32,
+            UnitPixel, NULL, NULL, NULL);
+        expect(Ok, stat);
+
+        prev = 0;
+        for (x = 4; x < 28; x++)
+        {
+            stat = GdipBitmapGetPixel(bitmap2, x, 16, &color);
+            expect(Ok, stat);
+            ok((color & 0xff) >= (prev & 0xff), "mode %d: pixel %d is %.8x, previous %.8x\n",
+               modes[i], x, color, prev);
+            prev = color;
+        }
+    }
+
+    /* a plain scale and a transform that is almost one give the same result,
+     * the latter goes through the general per pixel sampler */
+    stat = GdipSetInterpolationMode(graphics, InterpolationModeBilinear);
+    expect(Ok, stat);
+
+    stat = GdipSetInterpolationMode(graphics3, InterpolationModeBilinear);
+    expect(Ok, stat);
+
+    for (y = 0; y < 32; y++)
+        for (x = 0; x < 32; x++)
+            GdipBitmapSetPixel(bitmap1, x, y, 0xff000000 | (x * 0x55) << 8 | (y * 0x55));
+
+    stat = GdipGraphicsClear(graphics, 0);
+    expect(Ok, stat);
+
+    stat = GdipGraphicsClear(graphics3, 0);
+    expect(Ok, stat);
+
+    stat = GdipDrawImagePointsRect(graphics, (GpImage*)bitmap1, scale_points, 3, 0, 0, 4, 4,
+        UnitPixel, NULL, NULL, NULL);
+    expect(Ok, stat);
+
+    stat = GdipDrawImagePointsRect(graphics3, (GpImage*)bitmap1, skew_points, 3, 0, 0, 4, 4,
+        UnitPixel, NULL, NULL, NULL);
+    expect(Ok, stat);
+
+    for (y = 4; y < 28; y++)
+        for (x = 4; x < 28; x++)
+        {
+            stat = GdipBitmapGetPixel(bitmap2, x, y, &color);
+            expect(Ok, stat);
+            stat = GdipBitmapGetPixel(bitmap3, x, y, &color3);
+            expect(Ok, stat);
+            ok(color_match(color3, color, 2), "pixel %d,%d: expected %.8x, got %.8x\n",
+               x, y, color3, color);
+        }
+
+    GdipDeleteGraphics(graphics);
+    GdipDeleteGraphics(graphics3);
+    GdipDisposeImage((GpImage*)bitmap1);
+    GdipDisposeImage((GpImage*)bitmap2);
+    GdipDisposeImage((GpImage*)bitmap3);
+}
+
 START_TEST(image)
 {
     struct GdiplusStartupInput gdiplusStartupInput;
@@ -2597,6 +2745,7 @@ START_TEST(image)
     test_remaptable();
     test_colorkey();
     test_dispose();
+    test_scaling();
 
     GdiplusShutdown(gdiplusToken);
 }
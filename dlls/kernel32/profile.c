@@ -50,6 +50,7 @@ typedef struct tagPROFILEKEY
 {
     WCHAR                 *value;
     struct tagPROFILEKEY  *next;
+    struct tagPROFILEKEY  *hash_next;  /* next key in the same hash bucket */
     WCHAR                  name[1];
 } PROFILEKEY;
 
@@ -57,6 +58,11 @@ typedef struct tagPROFILESECTION
 {
     struct tagPROFILEKEY       *key;
     struct tagPROFILESECTION   *next;
+    struct tagPROFILESECTION   *hash_next;      /* next section in the same hash bucket */
+    struct tagPROFILEKEY      **key_hash;       /* key index, built on first lookup */
+    struct tagPROFILEKEY       *last_key;       /* tail of the key list, valid with key_hash */
+    UINT                        key_hash_size;
+    UINT                        key_count;
     WCHAR                       name[1];
 } PROFILESECTION;
 
@@ -68,10 +74,17 @@ typedef struct
     WCHAR           *filename;
     FILETIME LastWriteTime;
     ENCODING encoding;
+    PROFILESECTION **section_hash;    /* section index, built on first lookup */
+    PROFILESECTION  *last_section;    /* tail of the section list, valid with section_hash */
+    UINT             section_hash_size;
+    UINT             section_count;
 } PROFILE;
 
 
-#define N_CACHED_PROFILES 10
+#define N_CACHED_PROFILES 32
+
+/* Minimum number of buckets in a section or key index (must be a power of 2) */
+#define PROFILE_MIN_HASH_SIZE 8
 
 /* Cached profile files */
 static PROFILE *MRUProfile[N_CACHED_PROFILES]={NULL};
@@ -191,41 +204,47 @@ static void PROFILE_WriteLine( HANDLE hFile, WCHAR * szLine, int len, ENCODING e
  *           PROFILE_Save
  *
  * Save a profile tree to a file.
+ * The whole tree is converted in a single buffer so that it only takes
+ * one write to the file.
  */
 static void PROFILE_Save( HANDLE hFile, const PROFILESECTION *section, ENCODING encoding )
 {
+    const PROFILESECTION *sec;
     PROFILEKEY *key;
     WCHAR *buffer, *p;
+    int len = 0;
 
     PROFILE_WriteMarker(hFile, encoding);
 
-    for ( ; section; section = section->next)
+    for (sec = section; sec; sec = sec->next)
     {
-        int len = 0;
-
-        if (section->name[0]) len += strlenW(section->name) + 4;
+        if (sec->name[0]) len += strlenW(sec->name) + 4;
 
-        for (key = section->key; key; key = key->next)
+        for (key = sec->key; key; key = key->next)
         {
             len += strlenW(key->name) + 2;
             if (key->value) len += strlenW(key->value) + 1;
         }
+    }
+    if (!len) return;
 
-        buffer = HeapAlloc(GetProcessHeap(), 0, len * sizeof(WCHAR));
-        if (!buffer) return;
+    buffer = HeapAlloc(GetProcessHeap(), 0, (len + 1) * sizeof(WCHAR));
+    if (!buffer) return;
 
-        p = buffer;
-        if (section->name[0])
+    p = buffer;
+    for (sec = section; sec; sec = sec->next)
+    {
+        if (sec->name[0])
         {
             *p++ = '[';
-            strcpyW( p, section->name );
+            strcpyW( p, sec->name );
             p += strlenW(p);
             *p++ = ']';
             *p++ = '\r';
             *p++ = '\n';
         }
 
-        for (key = section->key; key; key = key->next)
+        for (key = sec->key; key; key = key->next)
         {
             strcpyW( p, key->name );
             p += strlenW(p);
@@ -238,9 +257,9 @@ static void PROFILE_Save( HANDLE hFile, const PROFILESECTION *section, ENCODING
             *p++ = '\r';
             *p++ = '\n';
         }
-        PROFILE_WriteLine( hFile, buffer, len, encoding );
-        HeapFree(GetProcessHeap(), 0, buffer);
     }
+    PROFILE_WriteLine( hFile, buffer, len, encoding );
+    HeapFree(GetProcessHeap(), 0, buffer);
 }
 
 
@@ -263,6 +282,7 @@ static void PROFILE_Free( PROFILESECTION *section )
             HeapFree( GetProcessHeap(), 0, key );
         }
         next_section = section->next;
+        HeapFree( GetProcessHeap(), 0, section->key_hash );
         HeapFree( GetProcessHeap(), 0, section );
     }
 }
@@ -393,6 +413,7 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
     }
     first_section->name[0] = 0;
     first_section->key  = NULL;
+    first_section->key_hash = NULL;
     first_section->next = NULL;
     next_section = &first_section->next;
     next_key     = &first_section->key;
@@ -436,6 +457,7 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
                 section->name[len] = '\0';
                 section->key  = NULL;
                 section->next = NULL;
+                section->key_hash = NULL;
                 *next_section = section;
                 next_section  = &section->next;
                 next_key      = &section->key;
@@ -491,13 +513,207 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
 }
 
 
+/***********************************************************************
+ *           PROFILE_Hash
+ *
+ * Case-insensitive hash of the first len characters of a name.
+ */
+static inline UINT PROFILE_Hash( LPCWSTR name, int len )
+{
+    UINT hash = 0;
+    while (len-- > 0) hash = hash * 31 + tolowerW( *name++ );
+    return hash;
+}
+
+static inline UINT PROFILE_HashSize( UINT count )
+{
+    UINT size = PROFILE_MIN_HASH_SIZE;
+    while (size < count) size *= 2;
+    return size;
+}
+
+static void PROFILE_FreeSectionIndex( PROFILE *profile )
+{
+    HeapFree( GetProcessHeap(), 0, profile->section_hash );
+    profile->section_hash = NULL;
+}
+
+static void PROFILE_FreeKeyIndex( PROFILESECTION *section )
+{
+    HeapFree( GetProcessHeap(), 0, section->key_hash );
+    section->key_hash = NULL;
+}
+
+/* add a section to the tail of its hash bucket, so that lookups return
+ * the first one in file order when a name is present more than once */
+static void PROFILE_IndexSection( PROFILE *profile, PROFILESECTION *section )
+{
+    PROFILESECTION **bucket;
+
+    bucket = &profile->section_hash[PROFILE_Hash( section->name, strlenW(section->name) ) &
+                                    (profile->section_hash_size - 1)];
+    while (*bucket) bucket = &(*bucket)->hash_next;
+    *bucket = section;
+    section->hash_next = NULL;
+    profile->last_section = section;
+}
+
+static void PROFILE_IndexKey( PROFILESECTION *section, PROFILEKEY *key )
+{
+    PROFILEKEY **bucket;
+
+    bucket = &section->key_hash[PROFILE_Hash( key->name, strlenW(key->name) ) &
+                                (section->key_hash_size - 1)];
+    while (*bucket) bucket = &(*bucket)->hash_next;
+    *bucket = key;
+    key->hash_next = NULL;
+    section->last_key = key;
+}
+
+/***********************************************************************
+ *           PROFILE_BuildSectionIndex
+ *
+ * Build the section index of a profile if it doesn't exist yet.
+ */
+static BOOL PROFILE_BuildSectionIndex( PROFILE *profile )
+{
+    PROFILESECTION *section;
+    UINT count = 0;
+
+    if (profile->section_hash) return TRUE;
+    if (!profile->section) return FALSE;
+
+    for (section = profile->section; section; section = section->next) count++;
+    profile->section_hash_size = PROFILE_HashSize( count );
+    profile->section_hash = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                       profile->section_hash_size * sizeof(*profile->section_hash) );
+    if (!profile->section_hash) return FALSE;
+
+    profile->section_count = count;
+    for (section = profile->section; section; section = section->next)
+        PROFILE_IndexSection( profile, section );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           PROFILE_BuildKeyIndex
+ *
+ * Build the key index of a section if it doesn't exist yet.
+ */
+static BOOL PROFILE_BuildKeyIndex( PROFILESECTION *section )
+{
+    PROFILEKEY *key;
+    UINT count = 0;
+
+    if (section->key_hash) return TRUE;
+
+    for (key = section->key; key; key = key->next) count++;
+    section->key_hash_size = PROFILE_HashSize( count );
+    section->key_hash = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                   section->key_hash_size * sizeof(*section->key_hash) );
+    if (!section->key_hash) return FALSE;
+
+    section->key_count = count;
+    section->last_key = NULL;
+    for (key = section->key; key; key = key->next)
+        PROFILE_IndexKey( section, key );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           PROFILE_FindSection
+ *
+ * Find the first section matching the first len characters of name.
+ */
+static PROFILESECTION *PROFILE_FindSection( PROFILE *profile, LPCWSTR name, int len )
+{
+    PROFILESECTION *section;
+
+    if (PROFILE_BuildSectionIndex( profile ))
+        section = profile->section_hash[PROFILE_Hash( name, len ) & (profile->section_hash_size - 1)];
+    else
+        section = profile->section;
+
+    for ( ; section; section = profile->section_hash ? section->hash_next : section->next)
+    {
+        if (section->name[0] && !strncmpiW( section->name, name, len ) && !section->name[len])
+            return section;
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           PROFILE_FindKey
+ *
+ * Find the first key of a section matching the first len characters of name.
+ */
+static PROFILEKEY *PROFILE_FindKey( PROFILESECTION *section, LPCWSTR name, int len )
+{
+    PROFILEKEY *key;
+
+    if (PROFILE_BuildKeyIndex( section ))
+        key = section->key_hash[PROFILE_Hash( name, len ) & (section->key_hash_size - 1)];
+    else
+        key = section->key;
+
+    for ( ; key; key = section->key_hash ? key->hash_next : key->next)
+    {
+        if (!strncmpiW( key->name, name, len ) && !key->name[len])
+            return key;
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           PROFILE_AppendSection
+ *
+ * Add a new section at the end of a profile.
+ */
+static void PROFILE_AppendSection( PROFILE *profile, PROFILESECTION *new_section )
+{
+    PROFILESECTION **section = &profile->section;
+
+    if (profile->section_hash) section = &profile->last_section->next;
+    while (*section) section = &(*section)->next;
+    *section = new_section;
+
+    if (!profile->section_hash) return;
+    if (++profile->section_count > 2 * profile->section_hash_size)
+        PROFILE_FreeSectionIndex( profile );  /* rebuilt with more buckets on next lookup */
+    else
+        PROFILE_IndexSection( profile, new_section );
+}
+
+/***********************************************************************
+ *           PROFILE_AppendKey
+ *
+ * Add a new key at the end of a section.
+ */
+static void PROFILE_AppendKey( PROFILESECTION *section, PROFILEKEY *new_key )
+{
+    PROFILEKEY **key = &section->key;
+
+    if (section->key_hash && section->last_key) key = &section->last_key->next;
+    while (*key) key = &(*key)->next;
+    *key = new_key;
+
+    if (!section->key_hash) return;
+    if (++section->key_count > 2 * section->key_hash_size)
+        PROFILE_FreeKeyIndex( section );
+    else
+        PROFILE_IndexKey( section, new_key );
+}
+
+
 /***********************************************************************
  *           PROFILE_DeleteSection
  *
  * Delete a section from a profile tree.
  */
-static BOOL PROFILE_DeleteSection( PROFILESECTION **section, LPCWSTR name )
+static BOOL PROFILE_DeleteSection( PROFILE *profile, LPCWSTR name )
 {
+    PROFILESECTION **section = &profile->section;
+
     while (*section)
     {
         if ((*section)->name[0] && !strcmpiW( (*section)->name, name ))
@@ -506,6 +722,7 @@ static BOOL PROFILE_DeleteSection( PROFILESECTION **section, LPCWSTR name )
             *section = to_del->next;
             to_del->next = NULL;
             PROFILE_Free( to_del );
+            PROFILE_FreeSectionIndex( profile );
             return TRUE;
         }
         section = &(*section)->next;
@@ -519,14 +736,15 @@ static BOOL PROFILE_DeleteSection( PROFILESECTION **section, LPCWSTR name )
  *
  * Delete a key from a profile tree.
  */
-static BOOL PROFILE_DeleteKey( PROFILESECTION **section,
-			       LPCWSTR section_name, LPCWSTR key_name )
+static BOOL PROFILE_DeleteKey( PROFILE *profile, LPCWSTR section_name, LPCWSTR key_name )
 {
-    while (*section)
+    PROFILESECTION *section;
+
+    for (section = profile->section; section; section = section->next)
     {
-        if ((*section)->name[0] && !strcmpiW( (*section)->name, section_name ))
+        if (section->name[0] && !strcmpiW( section->name, section_name ))
         {
-            PROFILEKEY **key = &(*section)->key;
+            PROFILEKEY **key = &section->key;
             while (*key)
             {
                 if (!strcmpiW( (*key)->name, key_name ))
@@ -535,12 +753,12 @@ static BOOL PROFILE_DeleteKey( PROFILESECTION **section,
                     *key = to_del->next;
                     HeapFree( GetProcessHeap(), 0, to_del->value);
                     HeapFree( GetProcessHeap(), 0, to_del );
+                    PROFILE_FreeKeyIndex( section );
                     return TRUE;
                 }
                 key = &(*key)->next;
             }
         }
-        section = &(*section)->next;
     }
     return FALSE;
 }
@@ -567,6 +785,7 @@ static void PROFILE_DeleteAllKeys( LPCWSTR section_name)
 		HeapFree( GetProcessHeap(), 0, to_del );
 		CurProfile->changed =TRUE;
             }
+            PROFILE_FreeKeyIndex( *section );
         }
         section = &(*section)->next;
     }
@@ -578,11 +797,13 @@ static void PROFILE_DeleteAllKeys( LPCWSTR section_name)
  *
  * Find a key in a profile tree, optionally creating it.
  */
-static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
+static PROFILEKEY *PROFILE_Find( PROFILE *profile, LPCWSTR section_name,
                                  LPCWSTR key_name, BOOL create, BOOL create_always )
 {
     LPCWSTR p;
     int seclen, keylen;
+    PROFILESECTION *section;
+    PROFILEKEY *key;
 
     while (PROFILE_isspaceW(*section_name)) section_name++;
     if (*section_name)
@@ -602,54 +823,41 @@ static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
     while ((p > key_name) && PROFILE_isspaceW(*p)) p--;
     keylen = p - key_name + 1;
 
-    while (*section)
+    if ((section = PROFILE_FindSection( profile, section_name, seclen )))
     {
-        if ( ((*section)->name[0])
-             && (!(strncmpiW( (*section)->name, section_name, seclen )))
-             && (((*section)->name)[seclen] == '\0') )
-        {
-            PROFILEKEY **key = &(*section)->key;
-
-            while (*key)
-            {
-                /* If create_always is FALSE then we check if the keyname
-                 * already exists. Otherwise we add it regardless of its
-                 * existence, to allow keys to be added more than once in
-                 * some cases.
-                 */
-                if(!create_always)
-                {
-                    if ( (!(strncmpiW( (*key)->name, key_name, keylen )))
-                         && (((*key)->name)[keylen] == '\0') )
-                        return *key;
-                }
-                key = &(*key)->next;
-            }
-            if (!create) return NULL;
-            if (!(*key = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
-                return NULL;
-            strcpyW( (*key)->name, key_name );
-            (*key)->value = NULL;
-            (*key)->next  = NULL;
-            return *key;
-        }
-        section = &(*section)->next;
+        /* If create_always is FALSE then we check if the keyname
+         * already exists. Otherwise we add it regardless of its
+         * existence, to allow keys to be added more than once in
+         * some cases.
+         */
+        if (!create_always && (key = PROFILE_FindKey( section, key_name, keylen )))
+            return key;
+        if (!create) return NULL;
+        if (!(key = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
+            return NULL;
+        strcpyW( key->name, key_name );
+        key->value = NULL;
+        key->next  = NULL;
+        PROFILE_AppendKey( section, key );
+        return key;
     }
     if (!create) return NULL;
-    *section = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILESECTION) + strlenW(section_name) * sizeof(WCHAR) );
-    if(*section == NULL) return NULL;
-    strcpyW( (*section)->name, section_name );
-    (*section)->next = NULL;
-    if (!((*section)->key  = HeapAlloc( GetProcessHeap(), 0,
-                                        sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
+    section = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILESECTION) + strlenW(section_name) * sizeof(WCHAR) );
+    if(section == NULL) return NULL;
+    strcpyW( section->name, section_name );
+    section->next = NULL;
+    section->key_hash = NULL;
+    if (!(section->key  = HeapAlloc( GetProcessHeap(), 0,
+                                     sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
     {
-        HeapFree(GetProcessHeap(), 0, *section);
+        HeapFree(GetProcessHeap(), 0, section);
         return NULL;
     }
-    strcpyW( (*section)->key->name, key_name );
-    (*section)->key->value = NULL;
-    (*section)->key->next  = NULL;
-    return (*section)->key;
+    strcpyW( section->key->name, key_name );
+    section->key->value = NULL;
+    section->key->next  = NULL;
+    PROFILE_AppendSection( profile, section );
+    return section->key;
 }
 
 
@@ -699,6 +907,7 @@ static void PROFILE_ReleaseFile(void)
 {
     PROFILE_FlushFile();
     PROFILE_Free( CurProfile->section );
+    PROFILE_FreeSectionIndex( CurProfile );
     HeapFree( GetProcessHeap(), 0, CurProfile->filename );
     CurProfile->changed = FALSE;
     CurProfile->section = NULL;
@@ -737,6 +946,7 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
     WCHAR buffer[MAX_PATH];
     HANDLE hFile = INVALID_HANDLE_VALUE;
     FILETIME LastWriteTime;
+    WIN32_FILE_ATTRIBUTE_DATA data;
     int i,j;
     PROFILE *tempProfile;
     
@@ -753,6 +963,7 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
           MRUProfile[i]->section=NULL;
           MRUProfile[i]->filename=NULL;
           MRUProfile[i]->encoding=ENCODING_ANSI;
+          MRUProfile[i]->section_hash=NULL;
           ZeroMemory(&MRUProfile[i]->LastWriteTime, sizeof(FILETIME));
        }
 
@@ -777,6 +988,30 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
         
     TRACE("path: %s\n", debugstr_w(buffer));
 
+    /* Reading from an up to date cached profile only needs the file
+     * attributes, the file itself is opened only if it has to be loaded.
+     * Writes still go through the full open to report access errors. */
+    if (!write_access && GetFileAttributesExW( buffer, GetFileExInfoStandard, &data ) &&
+        !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+        is_not_current( &data.ftLastWriteTime ))
+    {
+        for(i=0;i<N_CACHED_PROFILES;i++)
+        {
+            if (!MRUProfile[i]->filename || strcmpiW( buffer, MRUProfile[i]->filename )) continue;
+            if (memcmp( &MRUProfile[i]->LastWriteTime, &data.ftLastWriteTime, sizeof(FILETIME) )) break;
+            if(i)
+            {
+                PROFILE_FlushFile();
+                tempProfile=MRUProfile[i];
+                for(j=i;j>0;j--)
+                    MRUProfile[j]=MRUProfile[j-1];
+                CurProfile=tempProfile;
+            }
+            TRACE("(%s): already opened (mru=%d)\n", debugstr_w(buffer), i);
+            return TRUE;
+        }
+    }
+
     hFile = CreateFileW(buffer, GENERIC_READ | (write_access ? GENERIC_WRITE : 0),
                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
@@ -813,6 +1048,7 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
                     TRACE("(%s): already opened, needs refreshing (mru=%d)\n",
                           debugstr_w(buffer), i);
                     PROFILE_Free(CurProfile->section);
+                    PROFILE_FreeSectionIndex(CurProfile);
                     CurProfile->section = PROFILE_Load(hFile, &CurProfile->encoding);
                     CurProfile->LastWriteTime = LastWriteTime;
                 }
@@ -862,52 +1098,49 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
  * Returns all keys of a section.
  * If return_values is TRUE, also include the corresponding values.
  */
-static INT PROFILE_GetSection( PROFILESECTION *section, LPCWSTR section_name,
+static INT PROFILE_GetSection( PROFILE *profile, LPCWSTR section_name,
 			       LPWSTR buffer, UINT len, BOOL return_values )
 {
+    PROFILESECTION *section;
     PROFILEKEY *key;
 
     if(!buffer) return 0;
 
     TRACE("%s,%p,%u\n", debugstr_w(section_name), buffer, len);
 
-    while (section)
+    if ((section = PROFILE_FindSection( profile, section_name, strlenW(section_name) )))
     {
-        if (section->name[0] && !strcmpiW( section->name, section_name ))
+        UINT oldlen = len;
+        for (key = section->key; key; key = key->next)
         {
-            UINT oldlen = len;
-            for (key = section->key; key; key = key->next)
-            {
-                if (len <= 2) break;
-                if (!*key->name) continue;  /* Skip empty lines */
-                if (IS_ENTRY_COMMENT(key->name)) continue;  /* Skip comments */
-                if (!return_values && !key->value) continue;  /* Skip lines w.o. '=' */
-                PROFILE_CopyEntry( buffer, key->name, len - 1, 0 );
+            if (len <= 2) break;
+            if (!*key->name) continue;  /* Skip empty lines */
+            if (IS_ENTRY_COMMENT(key->name)) continue;  /* Skip comments */
+            if (!return_values && !key->value) continue;  /* Skip lines w.o. '=' */
+            PROFILE_CopyEntry( buffer, key->name, len - 1, 0 );
+            len -= strlenW(buffer) + 1;
+            buffer += strlenW(buffer) + 1;
+            if (len < 2)
+                break;
+            if (return_values && key->value) {
+                buffer[-1] = '=';
+                PROFILE_CopyEntry ( buffer, key->value, len - 1, 0 );
                 len -= strlenW(buffer) + 1;
                 buffer += strlenW(buffer) + 1;
-		if (len < 2)
-		    break;
-		if (return_values && key->value) {
-			buffer[-1] = '=';
-			PROFILE_CopyEntry ( buffer, key->value, len - 1, 0 );
-			len -= strlenW(buffer) + 1;
-			buffer += strlenW(buffer) + 1;
-                }
-            }
-            *buffer = '\0';
-            if (len <= 1)
-                /*If either lpszSection or lpszKey is NULL and the supplied
-                  destination buffer is too small to hold all the strings,
-                  the last string is truncated and followed by two null characters.
-                  In this case, the return value is equal to cchReturnBuffer
-                  minus two. */
-            {
-		buffer[-1] = '\0';
-                return oldlen - 2;
             }
-            return oldlen - len;
         }
-        section = section->next;
+        *buffer = '\0';
+        if (len <= 1)
+            /*If either lpszSection or lpszKey is NULL and the supplied
+              destination buffer is too small to hold all the strings,
+              the last string is truncated and followed by two null characters.
+              In this case, the return value is equal to cchReturnBuffer
+              minus two. */
+        {
+            buffer[-1] = '\0';
+            return oldlen - 2;
+        }
+        return oldlen - len;
     }
     buffer[0] = buffer[1] = '\0';
     return 0;
@@ -993,7 +1226,7 @@ static INT PROFILE_GetString( LPCWSTR section, LPCWSTR key_name,
             PROFILE_CopyEntry(buffer, def_val, len, TRUE);
             return strlenW(buffer);
         }
-        key = PROFILE_Find( &CurProfile->section, section, key_name, FALSE, FALSE);
+        key = PROFILE_Find( CurProfile, section, key_name, FALSE, FALSE);
         PROFILE_CopyEntry( buffer, (key && key->value) ? key->value : def_val,
                            len, TRUE );
         TRACE("(%s,%s,%s): returning %s\n",
@@ -1004,7 +1237,7 @@ static INT PROFILE_GetString( LPCWSTR section, LPCWSTR key_name,
     /* no "else" here ! */
     if (section && section[0])
     {
-        INT ret = PROFILE_GetSection(CurProfile->section, section, buffer, len, FALSE);
+        INT ret = PROFILE_GetSection(CurProfile, section, buffer, len, FALSE);
         if (!buffer[0]) /* no luck -> def_val */
         {
             PROFILE_CopyEntry(buffer, def_val, len, TRUE);
@@ -1028,21 +1261,19 @@ static BOOL PROFILE_SetString( LPCWSTR section_name, LPCWSTR key_name,
     if (!key_name)  /* Delete a whole section */
     {
         TRACE("(%s)\n", debugstr_w(section_name));
-        CurProfile->changed |= PROFILE_DeleteSection( &CurProfile->section,
-                                                      section_name );
+        CurProfile->changed |= PROFILE_DeleteSection( CurProfile, section_name );
         return TRUE;         /* Even if PROFILE_DeleteSection() has failed,
                                 this is not an error on application's level.*/
     }
     else if (!value)  /* Delete a key */
     {
         TRACE("(%s,%s)\n", debugstr_w(section_name), debugstr_w(key_name) );
-        CurProfile->changed |= PROFILE_DeleteKey( &CurProfile->section,
-                                                  section_name, key_name );
+        CurProfile->changed |= PROFILE_DeleteKey( CurProfile, section_name, key_name );
         return TRUE;          /* same error handling as above */
     }
     else  /* Set the key value */
     {
-        PROFILEKEY *key = PROFILE_Find(&CurProfile->section, section_name,
+        PROFILEKEY *key = PROFILE_Find( CurProfile, section_name,
                                         key_name, TRUE, create_always );
         TRACE("(%s,%s,%s):\n",
               debugstr_w(section_name), debugstr_w(key_name), debugstr_w(value) );
@@ -1299,7 +1530,7 @@ INT WINAPI GetPrivateProfileSectionW( LPCWSTR section, LPWSTR buffer,
     RtlEnterCriticalSection( &PROFILE_CritSect );
 
     if (PROFILE_Open( filename, FALSE ))
-        ret = PROFILE_GetSection(CurProfile->section, section, buffer, len, TRUE);
+        ret = PROFILE_GetSection(CurProfile, section, buffer, len, TRUE);
 
     RtlLeaveCriticalSection( &PROFILE_CritSect );
 
@@ -1624,7 +1855,7 @@ BOOL WINAPI GetPrivateProfileStructW (LPCWSTR section, LPCWSTR key,
     RtlEnterCriticalSection( &PROFILE_CritSect );
 
     if (PROFILE_Open( filename, FALSE )) {
-        PROFILEKEY *k = PROFILE_Find ( &CurProfile->section, section, key, FALSE, FALSE);
+        PROFILEKEY *k = PROFILE_Find ( CurProfile, section, key, FALSE, FALSE);
 	if (k) {
 	    TRACE("value (at %p): %s\n", k->value, debugstr_w(k->value));
 	    if (((strlenW(k->value) - 2) / 2) == len)
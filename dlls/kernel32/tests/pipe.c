@@ -209,9 +209,7 @@ static void test_CreateNamedPipe(int pipemode)
             ok(readden == sizeof(obuf) + sizeof(obuf2), "read 4 got %d bytes\n", readden);
         }
         else {
-            todo_wine {
-                ok(readden == sizeof(obuf), "read 4 got %d bytes\n", readden);
-            }
+            ok(readden == sizeof(obuf), "read 4 got %d bytes\n", readden);
         }
         pbuf = ibuf;
         ok(memcmp(obuf, pbuf, sizeof(obuf)) == 0, "content 4a check\n");
@@ -228,9 +226,7 @@ static void test_CreateNamedPipe(int pipemode)
             ok(!SetNamedPipeHandleState(hFile, &lpmode, NULL, NULL), "Change mode\n");
         }
         else {
-            todo_wine {
-                ok(SetNamedPipeHandleState(hFile, &lpmode, NULL, NULL), "Change mode\n");
-            }
+            ok(SetNamedPipeHandleState(hFile, &lpmode, NULL, NULL), "Change mode\n");
         
             memset(ibuf, 0, sizeof(ibuf));
             ok(WriteFile(hnp, obuf, sizeof(obuf), &written, NULL), "WriteFile5a\n");
@@ -249,19 +245,15 @@ static void test_CreateNamedPipe(int pipemode)
             pbuf = ibuf;
             ok(memcmp(obuf, pbuf, sizeof(obuf)) == 0, "content 5a check\n");
             ok(ReadFile(hFile, ibuf, sizeof(ibuf), &readden, NULL), "ReadFile\n");
-            todo_wine {
-                ok(readden == sizeof(obuf), "read 5 got %d bytes\n", readden);
-            }
+            ok(readden == sizeof(obuf), "read 5 got %d bytes\n", readden);
             pbuf = ibuf;
             ok(memcmp(obuf, pbuf, sizeof(obuf)) == 0, "content 5a check\n");
     
             /* Multiple writes in the reverse direction */
             /* the write of obuf2 from write4 should still be in the buffer */
             ok(PeekNamedPipe(hnp, ibuf, sizeof(ibuf), &readden, &avail, NULL), "Peek6a\n");
-            todo_wine {
-                ok(readden == sizeof(obuf2), "peek6a got %d bytes\n", readden);
-                ok(avail == sizeof(obuf2), "peek6a got %d bytes available\n", avail);
-            }
+            ok(readden == sizeof(obuf2), "peek6a got %d bytes\n", readden);
+            ok(avail == sizeof(obuf2), "peek6a got %d bytes available\n", avail);
             if (avail > 0) {
                 ok(ReadFile(hnp, ibuf, sizeof(ibuf), &readden, NULL), "ReadFile\n");
                 ok(readden == sizeof(obuf2), "read 6a got %d bytes\n", readden);
@@ -283,9 +275,7 @@ static void test_CreateNamedPipe(int pipemode)
             pbuf = ibuf;
             ok(memcmp(obuf, pbuf, sizeof(obuf)) == 0, "content 6a check\n");
             ok(ReadFile(hnp, ibuf, sizeof(ibuf), &readden, NULL), "ReadFile\n");
-            todo_wine {
-                ok(readden == sizeof(obuf), "read 6b got %d bytes\n", readden);
-            }
+            ok(readden == sizeof(obuf), "read 6b got %d bytes\n", readden);
             pbuf = ibuf;
             ok(memcmp(obuf, pbuf, sizeof(obuf)) == 0, "content 6a check\n");
         }
@@ -1567,7 +1557,6 @@ static void test_NamedPipeHandleState(void)
     state = PIPE_READMODE_MESSAGE;
     SetLastError(0xdeadbeef);
     ret = SetNamedPipeHandleState(server, &state, NULL, NULL);
-    todo_wine
     ok(!ret && GetLastError() == ERROR_INVALID_PARAMETER,
        "expected ERROR_INVALID_PARAMETER, got %d\n", GetLastError());
 
@@ -1577,13 +1566,11 @@ static void test_NamedPipeHandleState(void)
 
     state = PIPE_READMODE_BYTE;
     ret = SetNamedPipeHandleState(client, &state, NULL, NULL);
-    todo_wine
     ok(ret, "SetNamedPipeHandleState failed: %d\n", GetLastError());
     /* A byte-mode pipe client can't be changed to message mode, either. */
     state = PIPE_READMODE_MESSAGE;
     SetLastError(0xdeadbeef);
     ret = SetNamedPipeHandleState(server, &state, NULL, NULL);
-    todo_wine
     ok(!ret && GetLastError() == ERROR_INVALID_PARAMETER,
        "expected ERROR_INVALID_PARAMETER, got %d\n", GetLastError());
 
@@ -1615,7 +1602,6 @@ static void test_NamedPipeHandleState(void)
      */
     state = PIPE_READMODE_BYTE;
     ret = SetNamedPipeHandleState(server, &state, NULL, NULL);
-    todo_wine
     ok(ret, "SetNamedPipeHandleState failed: %d\n", GetLastError());
 
     client = CreateFileA(PIPENAME, GENERIC_READ|GENERIC_WRITE, 0, NULL,
@@ -1624,19 +1610,165 @@ static void test_NamedPipeHandleState(void)
 
     state = PIPE_READMODE_MESSAGE;
     ret = SetNamedPipeHandleState(client, &state, NULL, NULL);
-    todo_wine
     ok(ret, "SetNamedPipeHandleState failed: %d\n", GetLastError());
     /* A message-mode pipe client can also be changed to byte mode.
      */
     state = PIPE_READMODE_BYTE;
     ret = SetNamedPipeHandleState(client, &state, NULL, NULL);
-    todo_wine
     ok(ret, "SetNamedPipeHandleState failed: %d\n", GetLastError());
 
     CloseHandle(client);
     CloseHandle(server);
 }
 
+static DWORD CALLBACK pingpong_thread(LPVOID arg)
+{
+    HANDLE pipe = arg;
+    char buf[64];
+    DWORD count;
+
+    while (ReadFile(pipe, buf, sizeof(buf), &count, NULL) && count)
+        if (!WriteFile(pipe, buf, count, &count, NULL)) break;
+    return 0;
+}
+
+#define LARGE_MESSAGE_SIZE 300000
+
+static DWORD CALLBACK large_write_thread(LPVOID arg)
+{
+    HANDLE pipe = arg;
+    char *buf = HeapAlloc(GetProcessHeap(), 0, LARGE_MESSAGE_SIZE);
+    DWORD i, count;
+    BOOL ret;
+
+    for (i = 0; i < LARGE_MESSAGE_SIZE; i++) buf[i] = i * 7;
+    ret = WriteFile(pipe, buf, LARGE_MESSAGE_SIZE, &count, NULL);
+    ok(ret, "WriteFile failed: %u\n", GetLastError());
+    ok(count == LARGE_MESSAGE_SIZE, "wrote %u bytes\n", count);
+    HeapFree(GetProcessHeap(), 0, buf);
+    return 0;
+}
+
+static void test_message_mode(void)
+{
+    static const char msg1[] = "first message";
+    static const char msg2[] = "second";
+    HANDLE server, client, thread, dup;
+    char buf[64], *large;
+    DWORD mode, count, avail, left, start, i;
+    BOOL ret;
+
+    server = CreateNamedPipe(PIPENAME, PIPE_ACCESS_DUPLEX,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
+        1, 1024, 1024, NMPWAIT_USE_DEFAULT_WAIT, NULL);
+    ok(server != INVALID_HANDLE_VALUE, "CreateNamedPipe failed: %u\n", GetLastError());
+    client = CreateFileA(PIPENAME, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(client != INVALID_HANDLE_VALUE, "CreateFile failed: %u\n", GetLastError());
+    mode = PIPE_READMODE_MESSAGE;
+    ret = SetNamedPipeHandleState(client, &mode, NULL, NULL);
+    ok(ret, "SetNamedPipeHandleState failed: %u\n", GetLastError());
+
+    /* message boundaries are kept */
+    ok(WriteFile(client, msg1, sizeof(msg1), &count, NULL), "WriteFile failed\n");
+    ok(WriteFile(client, msg2, sizeof(msg2), &count, NULL), "WriteFile failed\n");
+    ret = PeekNamedPipe(server, buf, sizeof(buf), &count, &avail, &left);
+    ok(ret, "PeekNamedPipe failed: %u\n", GetLastError());
+    ok(count == sizeof(msg1), "peek got %u bytes\n", count);
+    ok(avail == sizeof(msg1) + sizeof(msg2), "expected %u bytes available, got %u\n",
+       (DWORD)(sizeof(msg1) + sizeof(msg2)), avail);
+    ok(left == 0, "expected no bytes left in message, got %u\n", left);
+    ret = ReadFile(server, buf, sizeof(buf), &count, NULL);
+    ok(ret, "ReadFile failed: %u\n", GetLastError());
+    ok(count == sizeof(msg1), "read got %u bytes\n", count);
+    ok(!memcmp(buf, msg1, sizeof(msg1)), "wrong data\n");
+
+    /* a message that doesn't fit is returned in pieces */
+    ret = PeekNamedPipe(server, buf, 2, &count, &avail, &left);
+    ok(ret, "PeekNamedPipe failed: %u\n", GetLastError());
+    ok(count == 2, "peek got %u bytes\n", count);
+    ok(left == sizeof(msg2) - 2, "expected %u bytes left in message, got %u\n",
+       (DWORD)sizeof(msg2) - 2, left);
+    SetLastError(0xdeadbeef);
+    ret = ReadFile(server, buf, 2, &count, NULL);
+    ok(!ret && GetLastError() == ERROR_MORE_DATA, "expected ERROR_MORE_DATA, got %d/%u\n", ret, GetLastError());
+    ok(count == 2, "read got %u bytes\n", count);
+    ret = PeekNamedPipe(server, NULL, 0, NULL, &avail, NULL);
+    ok(ret, "PeekNamedPipe failed: %u\n", GetLastError());
+    ok(avail == sizeof(msg2) - 2, "expected %u bytes available, got %u\n",
+       (DWORD)sizeof(msg2) - 2, avail);
+
+    /* the rest of the message belongs to the pipe end, not to the handle */
+    ret = DuplicateHandle(GetCurrentProcess(), server, GetCurrentProcess(), &dup, 0, FALSE, DUPLICATE_SAME_ACCESS);
+    ok(ret, "DuplicateHandle failed: %u\n", GetLastError());
+    ret = ReadFile(dup, buf + 2, sizeof(buf) - 2, &count, NULL);
+    ok(ret, "ReadFile failed: %u\n", GetLastError());
+    ok(count == sizeof(msg2) - 2, "read got %u bytes\n", count);
+    ok(!memcmp(buf, msg2, sizeof(msg2)), "wrong data\n");
+
+    /* in byte read mode the messages are concatenated, the mode is set
+     * through one handle and used by the other */
+    mode = PIPE_READMODE_BYTE;
+    ret = SetNamedPipeHandleState(dup, &mode, NULL, NULL);
+    ok(ret, "SetNamedPipeHandleState failed: %u\n", GetLastError());
+    CloseHandle(dup);
+    ok(WriteFile(client, msg1, sizeof(msg1), &count, NULL), "WriteFile failed\n");
+    ok(WriteFile(client, msg2, sizeof(msg2), &count, NULL), "WriteFile failed\n");
+    ret = ReadFile(server, buf, sizeof(buf), &count, NULL);
+    ok(ret, "ReadFile failed: %u\n", GetLastError());
+    ok(count == sizeof(msg1) + sizeof(msg2), "read got %u bytes\n", count);
+    ok(!memcmp(buf, msg1, sizeof(msg1)), "wrong data\n");
+    ok(!memcmp(buf + sizeof(msg1), msg2, sizeof(msg2)), "wrong data\n");
+    mode = PIPE_READMODE_MESSAGE;
+    ret = SetNamedPipeHandleState(server, &mode, NULL, NULL);
+    ok(ret, "SetNamedPipeHandleState failed: %u\n", GetLastError());
+
+    /* a message larger than the pipe buffers is read in one piece */
+    large = HeapAlloc(GetProcessHeap(), 0, LARGE_MESSAGE_SIZE);
+    thread = CreateThread(NULL, 0, large_write_thread, client, 0, NULL);
+    ok(thread != NULL, "CreateThread failed: %u\n", GetLastError());
+    ret = ReadFile(server, large, LARGE_MESSAGE_SIZE, &count, NULL);
+    ok(ret, "ReadFile failed: %u\n", GetLastError());
+    ok(count == LARGE_MESSAGE_SIZE, "read got %u bytes\n", count);
+    for (i = 0; i < LARGE_MESSAGE_SIZE; i++) if (large[i] != (char)(i * 7)) break;
+    ok(i == LARGE_MESSAGE_SIZE, "wrong data at %u\n", i);
+    ok(WaitForSingleObject(thread, 5000) == WAIT_OBJECT_0, "thread didn't exit\n");
+    CloseHandle(thread);
+    HeapFree(GetProcessHeap(), 0, large);
+
+    /* round trips through a message pipe */
+    thread = CreateThread(NULL, 0, pingpong_thread, server, 0, NULL);
+    ok(thread != NULL, "CreateThread failed: %u\n", GetLastError());
+    start = GetTickCount();
+    for (i = 0; i < 1000; i++)
+    {
+        ret = TransactNamedPipe(client, (void *)msg1, sizeof(msg1), buf, sizeof(buf), &count, NULL);
+        if (!ret || count != sizeof(msg1)) break;
+    }
+    ok(i == 1000, "round trip %u failed: %d/%u\n", i, ret, GetLastError());
+    if (winetest_debug > 1)
+        trace("%u message round trips in %u ms\n", i, GetTickCount() - start);
+
+    CloseHandle(client);
+    ok(WaitForSingleObject(thread, 5000) == WAIT_OBJECT_0, "thread didn't exit\n");
+    CloseHandle(thread);
+    CloseHandle(server);
+
+    /* changing the read mode of a read-only client needs FILE_WRITE_ATTRIBUTES */
+    server = CreateNamedPipe(PIPENAME, PIPE_ACCESS_DUPLEX,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
+        1, 1024, 1024, NMPWAIT_USE_DEFAULT_WAIT, NULL);
+    ok(server != INVALID_HANDLE_VALUE, "CreateNamedPipe failed: %u\n", GetLastError());
+    client = CreateFileA(PIPENAME, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(client != INVALID_HANDLE_VALUE, "CreateFile failed: %u\n", GetLastError());
+    mode = PIPE_READMODE_MESSAGE;
+    SetLastError(0xdeadbeef);
+    ret = SetNamedPipeHandleState(client, &mode, NULL, NULL);
+    ok(!ret && GetLastError() == ERROR_ACCESS_DENIED, "expected ERROR_ACCESS_DENIED, got %d/%u\n",
+       ret, GetLastError());
+    CloseHandle(client);
+    CloseHandle(server);
+}
+
 START_TEST(pipe)
 {
     HMODULE hmod;
@@ -1656,4 +1788,5 @@ START_TEST(pipe)
     test_impersonation();
     test_overlapped();
     test_NamedPipeHandleState();
+    test_message_mode();
 }
@@ -502,6 +502,81 @@ static void test_profile_refresh(void)
     CloseHandle(h);
 }
 
+static void test_profile_large_file(void)
+{
+    static const char testfile[] = ".\\winetest6.ini";
+    static const char testfile2[] = ".\\winetest7.ini";
+    char section[32], key[32], value[32], buf[256];
+    DWORD ret;
+    int i, j;
+
+    DeleteFileA(testfile);
+    DeleteFileA(testfile2);
+
+    for (i = 0; i < 50; i++)
+        for (j = 0; j < 10; j++)
+        {
+            sprintf(section, "section%d", i);
+            sprintf(key, "key%d", j);
+            sprintf(value, "%d.%d", i, j);
+            ret = WritePrivateProfileStringA(section, key, value, testfile);
+            ok(ret, "WritePrivateProfileString(%s, %s) failed\n", section, key);
+        }
+
+    /* interleave accesses to another file */
+    ret = WritePrivateProfileStringA("other", "key0", "other", testfile2);
+    ok(ret, "WritePrivateProfileString failed\n");
+
+    for (i = 0; i < 50; i++)
+        for (j = 0; j < 10; j++)
+        {
+            sprintf(section, (i & 1) ? " SECTION%d " : "section%d", i);
+            sprintf(key, (j & 1) ? "KEY%d  " : "key%d", j);
+            sprintf(value, "%d.%d", i, j);
+            ret = GetPrivateProfileStringA(section, key, "default", buf, sizeof(buf), testfile);
+            ok(ret == strlen(value) && !strcmp(buf, value),
+               "%s/%s: got %u %s, expected %s\n", section, key, ret, buf, value);
+        }
+
+    ret = GetPrivateProfileStringA("other", "key0", "default", buf, sizeof(buf), testfile2);
+    ok(ret == 5 && !strcmp(buf, "other"), "got %u %s\n", ret, buf);
+    ret = GetPrivateProfileStringA("other", "key0", "default", buf, sizeof(buf), testfile);
+    ok(ret == 7 && !strcmp(buf, "default"), "got %u %s\n", ret, buf);
+
+    /* delete a key and a section, then add them back at the end */
+    ret = WritePrivateProfileStringA("section10", "key5", NULL, testfile);
+    ok(ret, "WritePrivateProfileString failed\n");
+    ret = GetPrivateProfileStringA("section10", "key5", "default", buf, sizeof(buf), testfile);
+    ok(ret == 7 && !strcmp(buf, "default"), "got %u %s\n", ret, buf);
+    ret = GetPrivateProfileStringA("section10", "key6", "default", buf, sizeof(buf), testfile);
+    ok(ret == 4 && !strcmp(buf, "10.6"), "got %u %s\n", ret, buf);
+
+    ret = WritePrivateProfileStringA("section20", NULL, NULL, testfile);
+    ok(ret, "WritePrivateProfileString failed\n");
+    ret = GetPrivateProfileStringA("section20", "key0", "default", buf, sizeof(buf), testfile);
+    ok(ret == 7 && !strcmp(buf, "default"), "got %u %s\n", ret, buf);
+    ret = GetPrivateProfileStringA("section21", "key0", "default", buf, sizeof(buf), testfile);
+    ok(ret == 4 && !strcmp(buf, "21.0"), "got %u %s\n", ret, buf);
+
+    ret = WritePrivateProfileStringA("section20", "key5", "new", testfile);
+    ok(ret, "WritePrivateProfileString failed\n");
+    ret = GetPrivateProfileSectionA("section20", buf, sizeof(buf), testfile);
+    ok(ret == 9 && !memcmp(buf, "key5=new\0", 10), "got %u %s\n", ret, buf);
+
+    /* the first of several identical keys wins */
+    ret = WritePrivateProfileSectionA("section30", "dup=1\0DUP=2\0other=3\0", testfile);
+    ok(ret, "WritePrivateProfileSection failed\n");
+    ret = GetPrivateProfileStringA("section30", "Dup", "default", buf, sizeof(buf), testfile);
+    ok(ret == 1 && !strcmp(buf, "1"), "got %u %s\n", ret, buf);
+    ret = GetPrivateProfileStringA("section30", "key0", "default", buf, sizeof(buf), testfile);
+    ok(ret == 7 && !strcmp(buf, "default"), "got %u %s\n", ret, buf);
+    ret = GetPrivateProfileStringA("section31", "key9", "default", buf, sizeof(buf), testfile);
+    ok(ret == 4 && !strcmp(buf, "31.9"), "got %u %s\n", ret, buf);
+
+    DeleteFileA(testfile);
+    DeleteFileA(testfile2);
+}
+
 static void create_test_file(LPCSTR name, LPCSTR data, DWORD size)
 {
     HANDLE hfile;
@@ -1121,6 +1196,7 @@ START_TEST(profile)
     test_profile_existing();
     test_profile_delete_on_close();
     test_profile_refresh();
+    test_profile_large_file();
     test_GetPrivateProfileString(
         "[section1]\r\n"
         "name1=val1\r\n"
@@ -349,6 +349,7 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
             data.package = package;
             data.cb = installfiles_cb;
             data.user = (PVOID)(UINT_PTR)mi->disk_id;
+            data.need_file = FALSE;
 
             if (file->IsCompressed &&
                 !msi_cabextract(package, mi, &data))
@@ -530,6 +531,7 @@ UINT ACTION_PatchFiles( MSIPACKAGE *package )
             data.package = package;
             data.cb = patchfiles_cb;
             data.user = (PVOID)(UINT_PTR)mi->disk_id;
+            data.need_file = TRUE;
 
             if (!msi_cabextract(package, mi, &data))
             {
@@ -138,8 +138,28 @@ static void CDECL cabinet_free(void *pv)
     msi_free(pv);
 }
 
+/* The handles passed to FDI, for both the cabinets and the extracted files */
+struct cabinet_file
+{
+    HANDLE                 handle;
+    IStream               *stream;  /* cabinet stream in the package */
+    struct cabinet_writer *writer;  /* writes to this file are queued */
+};
+
+static INT_PTR create_cabinet_file( HANDLE handle, IStream *stream, struct cabinet_writer *writer )
+{
+    struct cabinet_file *file;
+
+    if (!(file = msi_alloc( sizeof(*file) ))) return 0;
+    file->handle = handle;
+    file->stream = stream;
+    file->writer = writer;
+    return (INT_PTR)file;
+}
+
 static INT_PTR CDECL cabinet_open(char *pszFile, int oflag, int pmode)
 {
+    INT_PTR file;
     HANDLE handle;
     DWORD dwAccess = 0;
     DWORD dwShareMode = 0;
@@ -171,12 +191,13 @@ static INT_PTR CDECL cabinet_open(char *pszFile, int oflag, int pmode)
     if (handle == INVALID_HANDLE_VALUE)
         return 0;
 
-    return (INT_PTR)handle;
+    if (!(file = create_cabinet_file( handle, NULL, NULL ))) CloseHandle( handle );
+    return file;
 }
 
 static UINT CDECL cabinet_read(INT_PTR hf, void *pv, UINT cb)
 {
-    HANDLE handle = (HANDLE)hf;
+    HANDLE handle = ((struct cabinet_file *)hf)->handle;
     DWORD read;
 
     if (ReadFile(handle, pv, cb, &read, NULL))
@@ -185,12 +206,228 @@ static UINT CDECL cabinet_read(INT_PTR hf, void *pv, UINT cb)
     return 0;
 }
 
+/* The extracted files are written out on a separate thread, so that writing
+ * to disk overlaps with the decompression done by FDICopy. Requests for all
+ * files go through a single queue and are therefore completed in order, so
+ * waiting for a file only waits for the requests queued before its own. */
+#define WRITER_QUEUE_LIMIT (4 * 1024 * 1024)
+
+struct write_request
+{
+    struct list entry;
+    HANDLE      handle;
+    BOOL        close;  /* set the file time and close the handle */
+    FILETIME    time;
+    UINT        size;
+    BYTE        data[1];
+};
+
+struct cabinet_writer
+{
+    HANDLE           thread;
+    CRITICAL_SECTION cs;
+    HANDLE           work_event;  /* requests were queued */
+    HANDLE           space_event; /* the queue went below the limit */
+    HANDLE           done_event;  /* a request has been completed */
+    struct list      queue;
+    UINT             queued;      /* bytes waiting in the queue */
+    ULONG            submitted;   /* number of requests queued so far */
+    ULONG            completed;   /* number of requests completed so far */
+    BOOL             shutdown;
+    BOOL             failed;
+    ULONGLONG        bytes;
+    UINT             files;
+    DWORD            busy_ticks;  /* time spent writing */
+    DWORD            wait_ticks;  /* time the extraction waited for the writer */
+};
+
+static BOOL process_write_request( struct write_request *req )
+{
+    DWORD written;
+
+    if (req->close)
+    {
+        BOOL ret = SetFileTime( req->handle, &req->time, 0, &req->time );
+        CloseHandle( req->handle );
+        return ret;
+    }
+    return WriteFile( req->handle, req->data, req->size, &written, NULL ) && written == req->size;
+}
+
+static DWORD WINAPI cabinet_writer_thread( void *arg )
+{
+    struct cabinet_writer *writer = arg;
+    struct write_request *req;
+    struct list *entry;
+    DWORD start;
+    BOOL ret;
+
+    for (;;)
+    {
+        EnterCriticalSection( &writer->cs );
+        while (!(entry = list_head( &writer->queue )) && !writer->shutdown)
+        {
+            LeaveCriticalSection( &writer->cs );
+            WaitForSingleObject( writer->work_event, INFINITE );
+            EnterCriticalSection( &writer->cs );
+        }
+        if (!entry)
+        {
+            LeaveCriticalSection( &writer->cs );
+            break;
+        }
+        list_remove( entry );
+        LeaveCriticalSection( &writer->cs );
+
+        req = LIST_ENTRY( entry, struct write_request, entry );
+        start = GetTickCount();
+        ret = process_write_request( req );
+        writer->busy_ticks += GetTickCount() - start;
+        if (!ret) WARN("failed to write extracted file (error %u)\n", GetLastError());
+
+        EnterCriticalSection( &writer->cs );
+        writer->queued -= req->size;
+        if (writer->queued < WRITER_QUEUE_LIMIT) SetEvent( writer->space_event );
+        if (!ret) writer->failed = TRUE;
+        writer->completed++;
+        SetEvent( writer->done_event );
+        LeaveCriticalSection( &writer->cs );
+        msi_free( req );
+    }
+    return 0;
+}
+
+static struct cabinet_writer *create_cabinet_writer(void)
+{
+    struct cabinet_writer *writer;
+
+    if (!(writer = msi_alloc_zero( sizeof(*writer) ))) return NULL;
+
+    list_init( &writer->queue );
+    InitializeCriticalSection( &writer->cs );
+    writer->work_event = CreateEventW( NULL, FALSE, FALSE, NULL );
+    writer->space_event = CreateEventW( NULL, TRUE, TRUE, NULL );
+    writer->done_event = CreateEventW( NULL, TRUE, FALSE, NULL );
+    if (writer->work_event && writer->space_event && writer->done_event &&
+        (writer->thread = CreateThread( NULL, 0, cabinet_writer_thread, writer, 0, NULL )))
+        return writer;
+
+    WARN("failed to start writer thread, writing synchronously\n");
+    if (writer->work_event) CloseHandle( writer->work_event );
+    if (writer->space_event) CloseHandle( writer->space_event );
+    if (writer->done_event) CloseHandle( writer->done_event );
+    DeleteCriticalSection( &writer->cs );
+    msi_free( writer );
+    return NULL;
+}
+
+/* returns the sequence number of the request, or 0 on failure */
+static ULONG queue_write_request( struct cabinet_writer *writer, struct write_request *req )
+{
+    DWORD start;
+    ULONG seq;
+
+    EnterCriticalSection( &writer->cs );
+    while (writer->queued >= WRITER_QUEUE_LIMIT && !writer->failed)
+    {
+        ResetEvent( writer->space_event );
+        LeaveCriticalSection( &writer->cs );
+        start = GetTickCount();
+        WaitForSingleObject( writer->space_event, INFINITE );
+        writer->wait_ticks += GetTickCount() - start;
+        EnterCriticalSection( &writer->cs );
+    }
+    if (writer->failed)
+    {
+        LeaveCriticalSection( &writer->cs );
+        if (req->close) CloseHandle( req->handle );
+        msi_free( req );
+        return 0;
+    }
+    list_add_tail( &writer->queue, &req->entry );
+    writer->queued += req->size;
+    writer->bytes += req->size;
+    if (req->close) writer->files++;
+    seq = ++writer->submitted;
+    LeaveCriticalSection( &writer->cs );
+
+    SetEvent( writer->work_event );
+    return seq;
+}
+
+/* waits until the request with the given sequence number and all requests
+ * queued before it are completed */
+static BOOL wait_cabinet_writer( struct cabinet_writer *writer, ULONG seq )
+{
+    DWORD start;
+    BOOL ret;
+
+    EnterCriticalSection( &writer->cs );
+    while ((LONG)(writer->completed - seq) < 0 && !writer->failed)
+    {
+        ResetEvent( writer->done_event );
+        LeaveCriticalSection( &writer->cs );
+        start = GetTickCount();
+        WaitForSingleObject( writer->done_event, INFINITE );
+        writer->wait_ticks += GetTickCount() - start;
+        EnterCriticalSection( &writer->cs );
+    }
+    ret = !writer->failed;
+    LeaveCriticalSection( &writer->cs );
+    return ret;
+}
+
+/* waits until all queued requests are completed */
+static BOOL flush_cabinet_writer( struct cabinet_writer *writer )
+{
+    ULONG seq;
+
+    EnterCriticalSection( &writer->cs );
+    seq = writer->submitted;
+    LeaveCriticalSection( &writer->cs );
+    return wait_cabinet_writer( writer, seq );
+}
+
+static BOOL destroy_cabinet_writer( struct cabinet_writer *writer, DWORD start )
+{
+    BOOL ret = flush_cabinet_writer( writer );
+
+    EnterCriticalSection( &writer->cs );
+    writer->shutdown = TRUE;
+    LeaveCriticalSection( &writer->cs );
+    SetEvent( writer->work_event );
+    WaitForSingleObject( writer->thread, INFINITE );
+
+    TRACE("%u files, %s bytes in %u ms, writer busy %u ms, extraction waited %u ms\n",
+          writer->files, wine_dbgstr_longlong(writer->bytes), GetTickCount() - start,
+          writer->busy_ticks, writer->wait_ticks);
+
+    CloseHandle( writer->thread );
+    CloseHandle( writer->work_event );
+    CloseHandle( writer->space_event );
+    CloseHandle( writer->done_event );
+    DeleteCriticalSection( &writer->cs );
+    msi_free( writer );
+    return ret;
+}
+
 static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 {
-    HANDLE handle = (HANDLE)hf;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
+    struct write_request *req;
     DWORD written;
 
-    if (WriteFile(handle, pv, cb, &written, NULL))
+    if (file->writer)
+    {
+        if (!(req = msi_alloc( FIELD_OFFSET( struct write_request, data[cb] ) ))) return 0;
+        req->handle = file->handle;
+        req->close = FALSE;
+        req->size = cb;
+        memcpy( req->data, pv, cb );
+        return queue_write_request( file->writer, req ) ? cb : 0;
+    }
+
+    if (WriteFile(file->handle, pv, cb, &written, NULL))
         return written;
 
     return 0;
@@ -198,13 +435,20 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 
 static int CDECL cabinet_close(INT_PTR hf)
 {
-    HANDLE handle = (HANDLE)hf;
-    return CloseHandle(handle) ? 0 : -1;
+    struct cabinet_file *file = (struct cabinet_file *)hf;
+    int ret = 0;
+
+    /* FDI closes the destination file itself if the extraction fails */
+    if (file->writer) flush_cabinet_writer( file->writer );
+    if (file->stream) IStream_Release( file->stream );
+    else if (!CloseHandle( file->handle )) ret = -1;
+    msi_free( file );
+    return ret;
 }
 
 static LONG CDECL cabinet_seek(INT_PTR hf, LONG dist, int seektype)
 {
-    HANDLE handle = (HANDLE)hf;
+    HANDLE handle = ((struct cabinet_file *)hf)->handle;
     /* flags are compatible and so are passed straight through */
     return SetFilePointer(handle, dist, NULL, seektype);
 }
@@ -219,6 +463,7 @@ static struct package_disk package_disk;
 
 static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
 {
+    INT_PTR file;
     MSICABINETSTREAM *cab;
     IStream *stream;
     WCHAR *encoded;
@@ -246,12 +491,13 @@ static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
         }
     }
     msi_free( encoded );
-    return (INT_PTR)stream;
+    if (!(file = create_cabinet_file( NULL, stream, NULL ))) IStream_Release( stream );
+    return file;
 }
 
 static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
 {
-    IStream *stm = (IStream *)hf;
+    IStream *stm = ((struct cabinet_file *)hf)->stream;
     DWORD read;
     HRESULT hr;
 
@@ -262,16 +508,9 @@ static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
     return 0;
 }
 
-static int CDECL cabinet_close_stream( INT_PTR hf )
-{
-    IStream *stm = (IStream *)hf;
-    IStream_Release( stm );
-    return 0;
-}
-
 static LONG CDECL cabinet_seek_stream( INT_PTR hf, LONG dist, int seektype )
 {
-    IStream *stm = (IStream *)hf;
+    IStream *stm = ((struct cabinet_file *)hf)->stream;
     LARGE_INTEGER move;
     ULARGE_INTEGER newpos;
     HRESULT hr;
@@ -419,6 +658,7 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
     HANDLE handle = 0;
     LPWSTR path = NULL;
     DWORD attrs;
+    INT_PTR file;
 
     data->curfile = strdupAtoW(pfdin->psz1);
     if (!data->cb(data->package, data->curfile, MSICABEXTRACT_BEGINEXTRACT, &path,
@@ -437,6 +677,13 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 
     handle = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0,
                          NULL, CREATE_ALWAYS, attrs, NULL);
+    if (handle == INVALID_HANDLE_VALUE && data->writer && GetLastError() == ERROR_SHARING_VIOLATION)
+    {
+        /* an earlier file with the same name may still be open in the writer */
+        flush_cabinet_writer( data->writer );
+        handle = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0,
+                             NULL, CREATE_ALWAYS, attrs, NULL);
+    }
     if (handle == INVALID_HANDLE_VALUE)
     {
         DWORD err = GetLastError();
@@ -496,7 +743,15 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 done:
     msi_free(path);
 
-    return (INT_PTR)handle;
+    if (!handle || handle == INVALID_HANDLE_VALUE)
+        return (INT_PTR)handle;
+
+    if (!(file = create_cabinet_file( handle, NULL, data->writer )))
+    {
+        CloseHandle( handle );
+        return -1;
+    }
+    return file;
 }
 
 static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
@@ -505,18 +760,51 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
     MSICABDATA *data = pfdin->pv;
     FILETIME ft;
     FILETIME ftLocal;
-    HANDLE handle = (HANDLE)pfdin->hf;
+    struct cabinet_file *file = (struct cabinet_file *)pfdin->hf;
+    HANDLE handle = file->handle;
+    struct cabinet_writer *writer = file->writer;
 
     data->mi->is_continuous = FALSE;
 
-    if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
-        return -1;
-    if (!LocalFileTimeToFileTime(&ft, &ftLocal))
-        return -1;
-    if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
+    if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft) ||
+        !LocalFileTimeToFileTime(&ft, &ftLocal))
+    {
+        cabinet_close( pfdin->hf );
         return -1;
+    }
+    msi_free( file );
 
-    CloseHandle(handle);
+    if (writer)
+    {
+        struct write_request *req;
+        ULONG seq;
+
+        if (!(req = msi_alloc( sizeof(*req) )))
+        {
+            flush_cabinet_writer( writer );
+            CloseHandle( handle );
+            return -1;
+        }
+        req->handle = handle;
+        req->close = TRUE;
+        req->time = ftLocal;
+        req->size = 0;
+
+        if (!(seq = queue_write_request( writer, req ))) return -1;
+
+        /* only wait for this file if the callback is going to use it */
+        if (data->need_file && !wait_cabinet_writer( writer, seq )) return -1;
+    }
+    else
+    {
+        if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
+        {
+            CloseHandle(handle);
+            return -1;
+        }
+
+        CloseHandle(handle);
+    }
 
     data->cb(data->package, data->curfile, MSICABEXTRACT_FILEEXTRACTED, NULL, NULL,
              data->user);
@@ -579,6 +867,8 @@ static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data
     HFDI hfdi;
     ERF erf;
     BOOL ret = FALSE;
+    DWORD start;
+    MSICABDATA *cab_data = data;
 
     TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
 
@@ -598,7 +888,14 @@ static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data
     if (!cab_path)
         goto done;
 
+    start = GetTickCount();
+    cab_data->writer = create_cabinet_writer();
+
     ret = FDICopy( hfdi, cabinet, cab_path, 0, cabinet_notify, NULL, data );
+
+    if (cab_data->writer && !destroy_cabinet_writer( cab_data->writer, start ))
+        ret = FALSE;
+    cab_data->writer = NULL;
     if (!ret)
         ERR("FDICopy failed\n");
 
@@ -619,11 +916,13 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
     HFDI hfdi;
     ERF erf;
     BOOL ret = FALSE;
+    DWORD start;
+    MSICABDATA *cab_data = data;
 
     TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
 
     hfdi = FDICreate( cabinet_alloc, cabinet_free, cabinet_open_stream, cabinet_read_stream,
-                      cabinet_write, cabinet_close_stream, cabinet_seek_stream, 0, &erf );
+                      cabinet_write, cabinet_close, cabinet_seek_stream, 0, &erf );
     if (!hfdi)
     {
         ERR("FDICreate failed\n");
@@ -633,7 +932,13 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
     package_disk.package = package;
     package_disk.id      = mi->disk_id;
 
+    start = GetTickCount();
+    cab_data->writer = create_cabinet_writer();
+
     ret = FDICopy( hfdi, filename, NULL, 0, cabinet_notify_stream, NULL, data );
+
+    if (cab_data->writer && !destroy_cabinet_writer( cab_data->writer, start )) ret = FALSE;
+    cab_data->writer = NULL;
     if (!ret) ERR("FDICopy failed\n");
 
     FDIDestroy( hfdi );
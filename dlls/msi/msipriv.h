@@ -1039,6 +1039,8 @@ typedef struct
     PMSICABEXTRACTCB cb;
     LPWSTR curfile;
     PVOID user;
+    BOOL need_file; /* the callback reads the file on MSICABEXTRACT_FILEEXTRACTED */
+    struct cabinet_writer *writer;
 } MSICABDATA;
 
 extern UINT ready_media(MSIPACKAGE *package, UINT Sequence, BOOL IsCompressed, MSIMEDIAINFO *mi) DECLSPEC_HIDDEN;
@@ -3884,6 +3884,70 @@ static void test_join(void)
     ok( r == ERROR_BAD_QUERY_SYNTAX,
         "Expected ERROR_BAD_QUERY_SYNTAX, got %d\n", r );
 
+    /* equality tests against parameters and other tables */
+    query = "SELECT `Component`.`ComponentId` FROM `Component`, `FeatureComponents` "
+            "WHERE `Component`.`Component` = `FeatureComponents`.`Component_` "
+            "AND `FeatureComponents`.`Feature_` = ?";
+    r = MsiDatabaseOpenView(hdb, query, &hview);
+    ok( r == ERROR_SUCCESS, "failed to open view: %d\n", r );
+
+    hrec = MsiCreateRecord( 1 );
+    MsiRecordSetString( hrec, 1, "nasalis" );
+    r = MsiViewExecute(hview, hrec);
+    ok( r == ERROR_SUCCESS, "failed to execute view: %d\n", r );
+    MsiCloseHandle(hrec);
+
+    i = 0;
+    data_correct = TRUE;
+    while ((r = MsiViewFetch(hview, &hrec)) == ERROR_SUCCESS)
+    {
+        size = MAX_PATH;
+        r = MsiRecordGetString( hrec, 1, buf, &size );
+        ok( r == ERROR_SUCCESS, "failed to get record string: %d\n", r );
+        if (lstrcmp( buf, "septum" ) && lstrcmp( buf, "ramus" ))
+            data_correct = FALSE;
+
+        i++;
+        MsiCloseHandle(hrec);
+    }
+    ok( data_correct, "data returned does not match\n" );
+    ok( i == 2, "Expected 2 rows, got %d\n", i );
+    ok( r == ERROR_NO_MORE_ITEMS, "expected no more items: %d\n", r );
+
+    MsiViewClose(hview);
+
+    hrec = MsiCreateRecord( 1 );
+    MsiRecordSetString( hrec, 1, "notafeature" );
+    r = MsiViewExecute(hview, hrec);
+    ok( r == ERROR_SUCCESS, "failed to execute view: %d\n", r );
+    MsiCloseHandle(hrec);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok( r == ERROR_NO_MORE_ITEMS, "expected no more items: %d\n", r );
+
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+
+    query = "SELECT `Three`.`F` FROM `One`, `Three` WHERE `Three`.`E` = 9 AND `One`.`A` = 1";
+    r = MsiDatabaseOpenView(hdb, query, &hview);
+    ok( r == ERROR_SUCCESS, "failed to open view: %d\n", r );
+
+    r = MsiViewExecute(hview, 0);
+    ok( r == ERROR_SUCCESS, "failed to execute view: %d\n", r );
+
+    r = MsiViewFetch(hview, &hrec);
+    ok( r == ERROR_SUCCESS, "failed to fetch view: %d\n", r );
+
+    r = MsiRecordGetInteger( hrec, 1 );
+    ok( r == 10, "Expected 10, got %d\n", r );
+    MsiCloseHandle(hrec);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok( r == ERROR_NO_MORE_ITEMS, "expected no more items: %d\n", r );
+
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+
     /* try updating a row in a join table */
     query = "SELECT `Component`.`ComponentId`, `FeatureComponents`.`Feature_` "
             "FROM `Component`, `FeatureComponents` "
@@ -7486,6 +7550,30 @@ static void test_storages_table(void)
     MsiViewClose(hview);
     MsiCloseHandle(hview);
 
+    /* the only storage is also the last one */
+    query = "SELECT `Name` FROM `_Storages` WHERE `Name` = 'stgname'";
+    r = MsiDatabaseOpenView(hdb, query, &hview);
+    ok(r == ERROR_SUCCESS, "Failed to open database hview: %d\n", r);
+
+    r = MsiViewExecute(hview, 0);
+    ok(r == ERROR_SUCCESS, "Failed to execute hview: %d\n", r);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok(r == ERROR_SUCCESS, "Failed to fetch hrecord: %d\n", r);
+
+    size = MAX_PATH;
+    r = MsiRecordGetString(hrec, 1, file, &size);
+    ok(r == ERROR_SUCCESS, "Failed to get string: %d\n", r);
+    ok(!lstrcmp(file, "stgname"), "Expected \"stgname\", got \"%s\"\n", file);
+
+    MsiCloseHandle(hrec);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok(r == ERROR_NO_MORE_ITEMS, "Expected ERROR_NO_MORE_ITEMS, got %d\n", r);
+
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+
     MsiDatabaseCommit(hdb);
     MsiCloseHandle(hdb);
 
@@ -395,6 +395,18 @@ static const CHAR cc_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tV
                                    "2\t2\t\ttest2.cab\tDISK2\t\n"
                                    "3\t12\t\ttest3.cab\tDISK3\t\n";
 
+static const CHAR cf_file_dat[] = "File\tComponent_\tFileName\tFileSize\tVersion\tLanguage\tAttributes\tSequence\n"
+                                  "s72\ts72\tl255\ti4\tS72\tS20\tI2\ti2\n"
+                                  "File\tFile\n"
+                                  "maximus\tmaximus\tmaximus\t500\t\t\t16384\t1\n"
+                                  "augustus\taugustus\taugustus\t50000\t\t\t16384\t2\n"
+                                  "caesar\tcaesar\tcaesar\t500\t\t\t16384\t3";
+
+static const CHAR cf_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tVolumeLabel\tSource\n"
+                                   "i2\ti4\tL64\tS255\tS32\tS72\n"
+                                   "Media\tDiskId\n"
+                                   "1\t3\t\ttest1.cab\tDISK1\t\n";
+
 static const CHAR co_file_dat[] = "File\tComponent_\tFileName\tFileSize\tVersion\tLanguage\tAttributes\tSequence\n"
                                   "s72\ts72\tl255\ti4\tS72\tS20\tI2\ti2\n"
                                   "File\tFile\n"
@@ -1527,6 +1539,18 @@ static const msi_table cie_tables[] =
     ADD_TABLE(property),
 };
 
+static const msi_table cf_tables[] =
+{
+    ADD_TABLE(cc_component),
+    ADD_TABLE(directory),
+    ADD_TABLE(cc_feature),
+    ADD_TABLE(cc_feature_comp),
+    ADD_TABLE(cf_file),
+    ADD_TABLE(install_exec_seq),
+    ADD_TABLE(cf_media),
+    ADD_TABLE(property),
+};
+
 static const msi_table ci_tables[] =
 {
     ADD_TABLE(ci_component),
@@ -2202,6 +2226,40 @@ static void create_cab_file(const CHAR *name, DWORD max_size, const CHAR *files)
     ok(res, "Failed to destroy the cabinet\n");
 }
 
+/* like create_cab_file, but puts each file in a folder of its own */
+static void create_cab_file_folders(const CHAR *name, const CHAR *files)
+{
+    CCAB cabParams;
+    LPCSTR ptr;
+    HFCI hfci;
+    ERF erf;
+    BOOL res;
+
+    set_cab_parameters(&cabParams, name, MEDIA_SIZE);
+
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                      fci_read, fci_write, fci_close, fci_seek, fci_delete,
+                      get_temp_file, &cabParams, NULL);
+
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+
+    ptr = files;
+    while (*ptr)
+    {
+        res = add_file(hfci, ptr, tcompTYPE_MSZIP);
+        ok(res, "Failed to add file: %s\n", ptr);
+        res = FCIFlushFolder(hfci, get_next_cabinet, progress);
+        ok(res, "Failed to flush the folder\n");
+        ptr += lstrlen(ptr) + 1;
+    }
+
+    res = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(res, "Failed to flush the cabinet\n");
+
+    res = FCIDestroy(hfci);
+    ok(res, "Failed to destroy the cabinet\n");
+}
+
 static BOOL get_user_dirs(void)
 {
     HKEY hkey;
@@ -3555,6 +3613,73 @@ error:
     RemoveDirectory("msitest");
 }
 
+static void check_pf_file(const CHAR *rel_path, const CHAR *data, DWORD size)
+{
+    CHAR path[MAX_PATH], buf[16];
+    HANDLE file;
+    DWORD count;
+
+    lstrcpyA(path, PROG_FILES_DIR);
+    lstrcatA(path, "\\");
+    lstrcatA(path, rel_path);
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to open %s (%u)\n", path, GetLastError());
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    count = GetFileSize(file, NULL);
+    ok(count == size, "%s: expected size %u, got %u\n", rel_path, size, count);
+
+    memset(buf, 0, sizeof(buf));
+    ReadFile(file, buf, sizeof(buf) - 1, &count, NULL);
+    ok(!memcmp(buf, data, strlen(data)), "%s: unexpected data %s\n", rel_path, buf);
+    CloseHandle(file);
+}
+
+static void test_cabfolders(void)
+{
+    UINT r;
+
+    if (is_process_limited())
+    {
+        skip("process is limited\n");
+        return;
+    }
+
+    create_file("maximus", 500);
+    create_file("augustus", 50000);
+    create_file("caesar", 500);
+
+    create_cab_file_folders("test1.cab", "maximus\0augustus\0caesar\0");
+
+    create_database(msifile, cf_tables, sizeof(cf_tables) / sizeof(msi_table));
+
+    MsiSetInternalUI(INSTALLUILEVEL_NONE, NULL);
+
+    r = MsiInstallProductA(msifile, NULL);
+    if (r == ERROR_INSTALL_PACKAGE_REJECTED)
+    {
+        skip("Not enough rights to perform tests\n");
+        goto error;
+    }
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    check_pf_file("msitest\\maximus", "maximus", 500);
+    check_pf_file("msitest\\augustus", "augustus", 50000);
+    check_pf_file("msitest\\caesar", "caesar", 500);
+    ok(delete_pf("msitest\\maximus", TRUE), "File not installed\n");
+    ok(delete_pf("msitest\\augustus", TRUE), "File not installed\n");
+    ok(delete_pf("msitest\\caesar", TRUE), "File not installed\n");
+    ok(delete_pf("msitest", FALSE), "Directory not created\n");
+
+error:
+    /* Delete the files in the temp (current) folder */
+    delete_cab_files();
+    DeleteFile(msifile);
+    DeleteFile("maximus");
+    DeleteFile("augustus");
+    DeleteFile("caesar");
+}
+
 static void test_concurrentinstall(void)
 {
     UINT r;
@@ -6676,6 +6801,7 @@ START_TEST(install)
     test_readonlyfile_cab();
     test_setdirproperty();
     test_cabisextracted();
+    test_cabfolders();
     test_concurrentinstall();
     test_setpropertyfolder();
     test_transformprop();
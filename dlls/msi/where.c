@@ -52,6 +52,10 @@ typedef struct tagJOINTABLE
     UINT col_count;
     UINT row_count;
     UINT table_index;
+    UINT lookup_col;                 /* column used for an index lookup, 0 for a full scan */
+    const struct expr *lookup_column; /* expression of the lookup column */
+    const struct expr *lookup_value; /* value the lookup column has to match */
+    UINT lookup_field;               /* record field of lookup_value if it is a wildcard */
 } JOINTABLE;
 
 typedef struct tagMSIORDERINFO
@@ -599,16 +603,111 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static inline UINT expr_bias( const struct expr *expr )
+{
+    switch (expr->type)
+    {
+    case EXPR_COL_NUMBER:
+        return 0x8000;
+    case EXPR_COL_NUMBER32:
+        return 0x80000000;
+    default:
+        return 0;
+    }
+}
+
+/* computes the stored value the lookup column of the table has to match,
+ * ERROR_NO_MORE_ITEMS means that no row can match */
+static UINT lookup_key( MSIWHEREVIEW *wv, const JOINTABLE *table, const UINT rows[],
+                        MSIRECORD *record, UINT *key )
+{
+    const struct expr *value = table->lookup_value;
+    UINT bias = expr_bias( table->lookup_column );
+    const WCHAR *str;
+    UINT r, val;
+
+    switch (value->type)
+    {
+    case EXPR_UVAL:
+        *key = value->u.uval + bias;
+        return ERROR_SUCCESS;
+
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        r = expr_fetch_value( &value->u.column, rows, &val );
+        if (r != ERROR_SUCCESS)
+            return r;
+        *key = val - expr_bias( value ) + bias;
+        return ERROR_SUCCESS;
+
+    case EXPR_SVAL:
+        str = value->u.sval;
+        break;
+
+    case EXPR_WILDCARD:
+        if (table->lookup_column->type != EXPR_COL_NUMBER_STRING)
+        {
+            *key = MSI_RecordGetInteger( record, table->lookup_field ) + bias;
+            return ERROR_SUCCESS;
+        }
+        str = MSI_RecordGetString( record, table->lookup_field );
+        break;
+
+    default:
+        ERR("Invalid expression type\n");
+        return ERROR_FUNCTION_FAILED;
+    }
+
+    /* empty strings are never added to the string table */
+    if (!str || !*str)
+    {
+        *key = 0;
+        return ERROR_SUCCESS;
+    }
+    if (msi_string2idW( wv->db->strings, str, key ) != ERROR_SUCCESS)
+        return ERROR_NO_MORE_ITEMS;
+    return ERROR_SUCCESS;
+}
+
+static UINT get_next_row( const JOINTABLE *table, UINT key, UINT row, MSIITERHANDLE *handle )
+{
+    if (table->lookup_col)
+    {
+        if (table->view->ops->find_matching_rows( table->view, table->lookup_col,
+                                                  key, &row, handle ) != ERROR_SUCCESS)
+            return INVALID_ROW_INDEX;
+        return row;
+    }
+
+    row = (row == INVALID_ROW_INDEX) ? 0 : row + 1;
+    return row < table->row_count ? row : INVALID_ROW_INDEX;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    UINT r = ERROR_SUCCESS;
+    JOINTABLE *table = *tables;
+    MSIITERHANDLE handle = NULL;
+    UINT row, key = 0;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    if (table->lookup_col)
     {
+        r = lookup_key( wv, table, table_rows, record, &key );
+        if (r == ERROR_NO_MORE_ITEMS)
+            return ERROR_SUCCESS;
+        if (r != ERROR_SUCCESS)
+            return r;
+    }
+
+    for (row = get_next_row( table, key, INVALID_ROW_INDEX, &handle );
+         row != INVALID_ROW_INDEX;
+         row = get_next_row( table, key, row, &handle ))
+    {
+        table_rows[table->table_index] = row;
+
         val = 0;
         wv->rec_index = 0;
         r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
@@ -630,7 +729,7 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **ta
             }
         }
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    table_rows[table->table_index] = INVALID_ROW_INDEX;
     return r;
 }
 
@@ -763,6 +862,201 @@ static JOINTABLE **ordertables( MSIWHEREVIEW *wv )
     return tables;
 }
 
+static UINT count_wildcards( const struct expr *expr )
+{
+    switch (expr->type)
+    {
+    case EXPR_WILDCARD:
+        return 1;
+    case EXPR_COMPLEX:
+    case EXPR_STRCMP:
+        return count_wildcards( expr->u.expr.left ) + count_wildcards( expr->u.expr.right );
+    default:
+        return 0;
+    }
+}
+
+static BOOL is_bound( JOINTABLE **ordered_tables, const JOINTABLE *table, const JOINTABLE *current )
+{
+    while (*ordered_tables != current)
+    {
+        if (*ordered_tables == table)
+            return TRUE;
+        ordered_tables++;
+    }
+    return FALSE;
+}
+
+/* checks whether column = value can be answered with an index lookup on the
+ * current table, field is the record field used if value is a wildcard */
+static BOOL set_lookup( JOINTABLE **ordered_tables, JOINTABLE *current, BOOL joins,
+                        const struct expr *cond, const struct expr *column,
+                        const struct expr *value, UINT field, MSIRECORD *record )
+{
+    BOOL string = (cond->type == EXPR_STRCMP);
+
+    switch (column->type)
+    {
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+        if (string)
+            return FALSE;
+        break;
+    case EXPR_COL_NUMBER_STRING:
+        if (!string)
+            return FALSE;
+        break;
+    default:
+        return FALSE;
+    }
+    if (column->u.column.parsed.table != current)
+        return FALSE;
+
+    switch (value->type)
+    {
+    case EXPR_UVAL:
+        if (string)
+            return FALSE;
+        break;
+    case EXPR_SVAL:
+        if (!string)
+            return FALSE;
+        break;
+    case EXPR_WILDCARD:
+        if (!record)
+            return FALSE;
+        break;
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        if ((value->type == EXPR_COL_NUMBER_STRING) != string)
+            return FALSE;
+        if (!joins || !is_bound( ordered_tables, value->u.column.parsed.table, current ))
+            return FALSE;
+        break;
+    default:
+        return FALSE;
+    }
+
+    current->lookup_col = column->u.column.parsed.column;
+    current->lookup_column = column;
+    current->lookup_value = value;
+    current->lookup_field = field;
+    return TRUE;
+}
+
+/* looks for an equality test in the top level conjunction of the condition,
+ * wildcards counts the wildcards evaluated before cond */
+static BOOL find_lookup( JOINTABLE **ordered_tables, JOINTABLE *current, BOOL joins,
+                         const struct expr *cond, UINT *wildcards, MSIRECORD *record )
+{
+    const struct expr *left, *right;
+    UINT before = *wildcards;
+
+    switch (cond->type)
+    {
+    case EXPR_COMPLEX:
+        if (cond->u.expr.op == OP_AND)
+        {
+            if (find_lookup( ordered_tables, current, joins, cond->u.expr.left, wildcards, record ))
+                return TRUE;
+            return find_lookup( ordered_tables, current, joins, cond->u.expr.right, wildcards, record );
+        }
+        /* fall through */
+    case EXPR_STRCMP:
+        *wildcards += count_wildcards( cond );
+        if (cond->u.expr.op != OP_EQ)
+            return FALSE;
+
+        left = cond->u.expr.left;
+        right = cond->u.expr.right;
+        if (set_lookup( ordered_tables, current, joins, cond, left, right,
+                        before + count_wildcards( left ) + 1, record ))
+            return TRUE;
+        return set_lookup( ordered_tables, current, joins, cond, right, left, before + 1, record );
+
+    default:
+        *wildcards += count_wildcards( cond );
+        return FALSE;
+    }
+}
+
+static const char *debugstr_lookup_value( const JOINTABLE *table )
+{
+    const struct expr *value = table->lookup_value;
+    LPCWSTR name, table_name;
+
+    switch (value->type)
+    {
+    case EXPR_UVAL:
+        return wine_dbg_sprintf( "%d", value->u.uval );
+    case EXPR_SVAL:
+        return debugstr_w( value->u.sval );
+    case EXPR_WILDCARD:
+        return wine_dbg_sprintf( "record field %u", table->lookup_field );
+    default:
+        value->u.column.parsed.table->view->ops->get_column_info( value->u.column.parsed.table->view,
+                value->u.column.parsed.column, &name, NULL, NULL, &table_name );
+        return wine_dbg_sprintf( "%s.%s", debugstr_w(table_name), debugstr_w(name) );
+    }
+}
+
+static void trace_plan( JOINTABLE **ordered_tables )
+{
+    LPCWSTR name, table_name;
+    const char *kind;
+    JOINTABLE *table;
+    UINT i;
+
+    for (i = 0; (table = ordered_tables[i]); i++)
+    {
+        if (!table->lookup_col)
+        {
+            table->view->ops->get_column_info( table->view, 1, NULL, NULL, NULL, &table_name );
+            TRACE("plan %u: %s, full scan of %u rows\n", i, debugstr_w(table_name), table->row_count);
+            continue;
+        }
+        switch (table->lookup_value->type)
+        {
+        case EXPR_COL_NUMBER:
+        case EXPR_COL_NUMBER32:
+        case EXPR_COL_NUMBER_STRING:
+            kind = "hash join";
+            break;
+        default:
+            kind = "index lookup";
+            break;
+        }
+        table->view->ops->get_column_info( table->view, table->lookup_col, &name, NULL, NULL, &table_name );
+        TRACE("plan %u: %s, %s on %s = %s\n", i, debugstr_w(table_name), kind,
+              debugstr_w(name), debugstr_lookup_value( table ));
+    }
+}
+
+/* pushes the equality tests of the condition down to the per column hash
+ * indexes of the tables, constants are preferred over joined columns */
+static void plan_lookups( MSIWHEREVIEW *wv, JOINTABLE **ordered_tables, MSIRECORD *record )
+{
+    JOINTABLE *table;
+    UINT i, wildcards;
+
+    for (i = 0; (table = ordered_tables[i]); i++)
+    {
+        table->lookup_col = 0;
+        if (!wv->cond)
+            continue;
+
+        wildcards = 0;
+        if (find_lookup( ordered_tables, table, FALSE, wv->cond, &wildcards, record ))
+            continue;
+        wildcards = 0;
+        find_lookup( ordered_tables, table, TRUE, wv->cond, &wildcards, record );
+    }
+
+    if (TRACE_ON(msidb))
+        trace_plan( ordered_tables );
+}
+
 static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
 {
     MSIWHEREVIEW *wv = (MSIWHEREVIEW*)view;
@@ -799,6 +1093,7 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     while ((table = table->next));
 
     ordered_tables = ordertables( wv );
+    plan_lookups( wv, ordered_tables, record );
 
     rows = msi_alloc( wv->table_count * sizeof(*rows) );
     for (i = 0; i < wv->table_count; i++)
@@ -80,6 +80,7 @@
 #include "wine/unicode.h"
 #include "wine/debug.h"
 #include "wine/server.h"
+#include "wine/list.h"
 #include "ntdll_misc.h"
 
 #include "winternl.h"
@@ -358,6 +359,385 @@ NTSTATUS FILE_GetNtStatus(void)
     }
 }
 
+/* Each packet on the socket of a message-type pipe starts with a flag byte,
+ * so that messages larger than a packet can be split, and so that an empty
+ * message can't be mistaken for the end of the pipe. */
+#define PIPE_PACKET_MORE  0x01  /* the message continues in the next packet */
+
+/* part of a pipe message that didn't fit in the buffer of the reader. It
+ * belongs to the pipe end rather than to a handle, so it is looked up by the
+ * identity of the socket and shared by all the handles of the process.
+ * FIXME: it isn't shared with other processes, and it is leaked if the last
+ * handle is closed before the rest of the message is read. */
+struct pipe_remainder
+{
+    struct list entry;
+    dev_t       dev;      /* socket that the data was read from */
+    ino_t       ino;
+    BOOL        more;     /* the message continues in the next packet */
+    ULONG       size;
+    ULONG       pos;
+    char        data[1];
+};
+
+static struct list pipe_remainders = LIST_INIT( pipe_remainders );
+
+static RTL_CRITICAL_SECTION pipe_section;
+static RTL_CRITICAL_SECTION_DEBUG pipe_critsect_debug =
+{
+    0, 0, &pipe_section,
+    { &pipe_critsect_debug.ProcessLocksList, &pipe_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": pipe_section") }
+};
+static RTL_CRITICAL_SECTION pipe_section = { &pipe_critsect_debug, -1, 0, 0, 0, 0 };
+
+static BOOL get_pipe_socket_id( int fd, dev_t *dev, ino_t *ino )
+{
+    struct stat st;
+
+    if (fstat( fd, &st ) == -1) return FALSE;
+    *dev = st.st_dev;
+    *ino = st.st_ino;
+    return TRUE;
+}
+
+/* pipe_section must be held */
+static struct pipe_remainder *find_pipe_remainder( dev_t dev, ino_t ino )
+{
+    struct pipe_remainder *rem;
+
+    LIST_FOR_EACH_ENTRY( rem, &pipe_remainders, struct pipe_remainder, entry )
+        if (rem->dev == dev && rem->ino == ino) return rem;
+    return NULL;
+}
+
+static BOOL keep_pipe_remainder( int fd, const char *data, ULONG size, BOOL more )
+{
+    struct pipe_remainder *rem;
+
+    if (!(rem = RtlAllocateHeap( GetProcessHeap(), 0, FIELD_OFFSET( struct pipe_remainder, data[size] ) )))
+        return FALSE;
+    if (!get_pipe_socket_id( fd, &rem->dev, &rem->ino ))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, rem );
+        return FALSE;
+    }
+    rem->more = more;
+    rem->size = size;
+    rem->pos = 0;
+    if (size) memcpy( rem->data, data, size );
+
+    RtlEnterCriticalSection( &pipe_section );
+    list_add_tail( &pipe_remainders, &rem->entry );
+    RtlLeaveCriticalSection( &pipe_section );
+    return TRUE;
+}
+
+/* drop the unread part of a message when the pipe end is disconnected */
+static void discard_pipe_remainder( int fd )
+{
+    struct pipe_remainder *rem;
+    dev_t dev;
+    ino_t ino;
+
+    if (list_empty( &pipe_remainders ) || !get_pipe_socket_id( fd, &dev, &ino )) return;
+
+    RtlEnterCriticalSection( &pipe_section );
+    if ((rem = find_pipe_remainder( dev, ino )))
+    {
+        list_remove( &rem->entry );
+        RtlFreeHeap( GetProcessHeap(), 0, rem );
+    }
+    RtlLeaveCriticalSection( &pipe_section );
+}
+
+/***********************************************************************
+ *           get_pipe_read_mode
+ *
+ * The read mode can be changed through any handle to the pipe end, in any
+ * process, so it isn't cached with the fd but asked from the server, once
+ * per read and only when the result of the read depends on it. *mode is -1
+ * until it is known.
+ */
+static BOOL get_pipe_read_mode( HANDLE handle, int *mode )
+{
+    if (*mode == -1)
+    {
+        *mode = 0;
+        SERVER_START_REQ( get_named_pipe_info )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            if (!wine_server_call( req ))
+                *mode = (reply->flags & NAMED_PIPE_MESSAGE_STREAM_READ) != 0;
+        }
+        SERVER_END_REQ;
+    }
+    return *mode;
+}
+
+/* a complete message has been read and there is room left in the buffer,
+ * check whether the read continues with the next message (byte read mode) */
+static BOOL read_next_pipe_message( HANDLE handle, int fd, int *mode )
+{
+#ifdef FIONREAD
+    int avail = 0;
+
+    if (ioctl( fd, FIONREAD, &avail ) == 0 && !avail) return FALSE;
+#endif
+    return !get_pipe_read_mode( handle, mode );
+}
+
+/***********************************************************************
+ *           recv_pipe_packet
+ *
+ * Receive a single packet from the socket of a message pipe. Returns the
+ * size of the data, 0 when the pipe is closed or -1 on error.
+ */
+static ssize_t recv_pipe_packet( int fd, char *data, ULONG size, int flags, BOOL *more )
+{
+    unsigned char flag = 0;
+    struct iovec iov[2];
+    struct msghdr msg;
+    ssize_t ret;
+
+    iov[0].iov_base = &flag;
+    iov[0].iov_len  = 1;
+    iov[1].iov_base = data;
+    iov[1].iov_len  = size;
+    memset( &msg, 0, sizeof(msg) );
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = 2;
+
+    /* with MSG_TRUNC the full size of the packet is returned */
+    if ((ret = recvmsg( fd, &msg, flags | MSG_TRUNC )) <= 0) return ret;
+    if (!(flags & MSG_PEEK) && ((msg.msg_flags & MSG_TRUNC) || ret - 1 > size))
+    {
+        ERR( "lost the end of a %ld byte packet\n", (long)ret - 1 );
+        ret = size + 1;
+    }
+    *more = (flag & PIPE_PACKET_MORE) != 0;
+    return ret;
+}
+
+/***********************************************************************
+ *           count_pipe_packets
+ *
+ * Count the data and the messages queued on the socket of a message pipe,
+ * and the size of the data up to the end of the first message. FIONREAD
+ * returns the size of all the packets including their flag bytes, so the
+ * packets are walked with a peek offset to find out how many there are.
+ */
+static void count_pipe_packets( int fd, int total, ULONG *avail, ULONG *messages, ULONG *first )
+{
+    BOOL in_first = TRUE;
+
+    *avail = *messages = *first = 0;
+    if (total <= 0) return;
+
+#ifdef SO_PEEK_OFF
+    {
+        int off = 0, none = -1;
+        unsigned char flag;
+        ssize_t ret;
+
+        /* FIXME: a concurrent peek on the same socket may see the wrong packet */
+        while (off < total && !setsockopt( fd, SOL_SOCKET, SO_PEEK_OFF, &off, sizeof(off) ))
+        {
+            /* with MSG_TRUNC the size of the rest of the packet is returned */
+            if ((ret = recv( fd, &flag, 1, MSG_PEEK | MSG_DONTWAIT | MSG_TRUNC )) <= 0) break;
+            off += ret;
+            *avail += ret - 1;
+            if (in_first) *first += ret - 1;
+            if (!(flag & PIPE_PACKET_MORE))
+            {
+                (*messages)++;
+                in_first = FALSE;
+            }
+        }
+        if (off)
+        {
+            setsockopt( fd, SOL_SOCKET, SO_PEEK_OFF, &none, sizeof(none) );
+            return;
+        }
+    }
+#endif
+    /* assume that a single packet is queued */
+    FIXME( "can't count the packets, reporting %d bytes\n", total - 1 );
+    *avail = *first = total - 1;
+    *messages = 1;
+}
+
+/***********************************************************************
+ *           write_message_pipe
+ *
+ * Send the part of a message that starts at pos. A message that doesn't fit
+ * in a packet of the socket is split in several packets. Returns the amount
+ * of data sent, or -1 on error if nothing could be sent.
+ */
+static int write_message_pipe( int fd, const char *buffer, ULONG length, ULONG pos )
+{
+    ULONG chunk = length - pos, sent = pos;
+    unsigned char flag;
+    struct iovec iov[2];
+    struct msghdr msg;
+    ssize_t ret;
+
+    /* FIXME: the packets of a split message may be interleaved with another thread's */
+    for (;;)
+    {
+        flag = (sent + chunk < length) ? PIPE_PACKET_MORE : 0;
+        iov[0].iov_base = &flag;
+        iov[0].iov_len  = 1;
+        iov[1].iov_base = (char *)buffer + sent;
+        iov[1].iov_len  = chunk;
+        memset( &msg, 0, sizeof(msg) );
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = 2;
+
+        if ((ret = sendmsg( fd, &msg, 0 )) < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EMSGSIZE && chunk > 1)
+            {
+                chunk /= 2;
+                continue;
+            }
+            break;
+        }
+        sent += chunk;
+        if (sent == length) break;
+        chunk = min( chunk, length - sent );
+    }
+    if (sent > pos) return sent - pos;
+    return ret < 0 ? -1 : 0;
+}
+
+/***********************************************************************
+ *           read_message_pipe
+ *
+ * Read from a pipe whose socket keeps the message boundaries. In message
+ * read mode a single message is returned, with STATUS_BUFFER_OVERFLOW if it
+ * didn't fit; in byte mode the available messages are concatenated. The part
+ * of a message that doesn't fit is kept for the next read of the pipe end.
+ * When the rest of a split message isn't there yet, the read waits for it if
+ * wait is set, otherwise STATUS_PENDING is returned and the read resumes in
+ * the middle of the message the next time.
+ */
+static NTSTATUS read_message_pipe( HANDLE handle, int fd, char *buffer, ULONG length,
+                                   ULONG *total, BOOL wait )
+{
+    struct pipe_remainder *rem;
+    int mode = -1, max_size = 0;
+    BOOL more = FALSE;
+    char *data = NULL;
+    socklen_t len;
+    ssize_t size;
+    NTSTATUS status;
+    dev_t dev;
+    ino_t ino;
+
+    if (!list_empty( &pipe_remainders ) && get_pipe_socket_id( fd, &dev, &ino ))
+    {
+        BOOL found = FALSE;
+
+        RtlEnterCriticalSection( &pipe_section );
+        if ((rem = find_pipe_remainder( dev, ino )))
+        {
+            ULONG count = min( length - *total, rem->size - rem->pos );
+
+            memcpy( buffer + *total, rem->data + rem->pos, count );
+            *total += count;
+            rem->pos += count;
+            more = rem->more;
+            found = TRUE;
+            /* keep an empty entry if the buffer is full before the next packet of the message */
+            if (rem->pos == rem->size && (!more || *total < length))
+            {
+                list_remove( &rem->entry );
+                RtlFreeHeap( GetProcessHeap(), 0, rem );
+                rem = NULL;
+            }
+        }
+        RtlLeaveCriticalSection( &pipe_section );
+
+        if (rem) return get_pipe_read_mode( handle, &mode ) ? STATUS_BUFFER_OVERFLOW : STATUS_SUCCESS;
+        if (found && !more && (*total == length || !read_next_pipe_message( handle, fd, &mode )))
+            return STATUS_SUCCESS;
+    }
+
+    /* a packet is at most the size of the send buffer, which is the same on both ends */
+    len = sizeof(max_size);
+    if (getsockopt( fd, SOL_SOCKET, SO_SNDBUF, &max_size, &len ) || max_size <= 0)
+        max_size = 65536;
+
+    for (;;)
+    {
+        ULONG space = length - *total, count;
+
+        if (space >= max_size)
+            size = recv_pipe_packet( fd, buffer + *total, space, MSG_DONTWAIT, &more );
+        else if (data || (data = RtlAllocateHeap( GetProcessHeap(), 0, max_size )))
+            size = recv_pipe_packet( fd, data, max_size, MSG_DONTWAIT, &more );
+        else
+        {
+            status = *total ? STATUS_SUCCESS : STATUS_NO_MEMORY;
+            break;
+        }
+
+        if (size < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN && more)
+            {
+                /* the rest of a split message is sent right away */
+                if (wait)
+                {
+                    struct pollfd pfd;
+
+                    pfd.fd = fd;
+                    pfd.events = POLLIN;
+                    pfd.revents = 0;
+                    poll( &pfd, 1, -1 );
+                    continue;
+                }
+                if (!keep_pipe_remainder( fd, NULL, 0, TRUE ))
+                    WARN( "lost the position in a message\n" );
+                status = STATUS_PENDING;
+                break;
+            }
+            if (*total) status = STATUS_SUCCESS;
+            else status = (errno == EAGAIN) ? STATUS_PENDING : FILE_GetNtStatus();
+            break;
+        }
+        if (!size)  /* the pipe was closed */
+        {
+            status = *total ? STATUS_SUCCESS : STATUS_PIPE_BROKEN;
+            break;
+        }
+
+        size--;  /* the flag byte */
+        count = min( space, size );
+        if (space < max_size) memcpy( buffer + *total, data, count );
+        *total += count;
+
+        if (count < size || (more && *total == length))
+        {
+            if (!keep_pipe_remainder( fd, data ? data + count : NULL, size - count, more ))
+                WARN( "lost %ld bytes of a message\n", (long)(size - count) );
+            status = get_pipe_read_mode( handle, &mode ) ? STATUS_BUFFER_OVERFLOW : STATUS_SUCCESS;
+            break;
+        }
+        if (!more && (*total == length || !read_next_pipe_message( handle, fd, &mode )))
+        {
+            status = STATUS_SUCCESS;
+            break;
+        }
+    }
+
+    RtlFreeHeap( GetProcessHeap(), 0, data );
+    return status;
+}
+
 /***********************************************************************
  *             FILE_AsyncReadService      (INTERNAL)
  */
@@ -365,14 +745,23 @@ static NTSTATUS FILE_AsyncReadService(void *user, PIO_STATUS_BLOCK iosb, NTSTATU
 {
     async_fileio_read *fileio = user;
     int fd, needs_close, result;
+    enum server_fd_type type;
 
     switch (status)
     {
     case STATUS_ALERTED: /* got some new data */
         /* check to see if the data is ready (non-blocking) */
         if ((status = server_get_unix_fd( fileio->io.handle, FILE_READ_DATA, &fd,
-                                          &needs_close, NULL, NULL )))
+                                          &needs_close, &type, NULL )))
+            break;
+
+        if (type == FD_TYPE_PIPE_MESSAGE)
+        {
+            status = read_message_pipe( fileio->io.handle, fd, fileio->buffer,
+                                        fileio->count, &fileio->already, FALSE );
+            if (needs_close) close( fd );
             break;
+        }
 
         result = read(fd, &fileio->buffer[fileio->already], fileio->count - fileio->already);
         if (needs_close) close( fd );
@@ -487,6 +876,7 @@ static NTSTATUS get_io_timeouts( HANDLE handle, enum server_fd_type type, ULONG
         break;
     case FD_TYPE_SOCKET:
     case FD_TYPE_PIPE:
+    case FD_TYPE_PIPE_MESSAGE:
     case FD_TYPE_CHAR:
         if (is_read) timeouts->interval = 0;  /* return as soon as we got something */
         break;
@@ -540,6 +930,7 @@ static NTSTATUS get_io_avail_mode( HANDLE handle, enum server_fd_type type, BOOL
     case FD_TYPE_MAILSLOT:
     case FD_TYPE_SOCKET:
     case FD_TYPE_PIPE:
+    case FD_TYPE_PIPE_MESSAGE:
     case FD_TYPE_CHAR:
         *avail_mode = TRUE;
         break;
@@ -624,7 +1015,13 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
 
     for (;;)
     {
-        if ((result = read( unix_handle, (char *)buffer + total, length - total )) >= 0)
+        if (type == FD_TYPE_PIPE_MESSAGE)
+        {
+            status = read_message_pipe( hFile, unix_handle, buffer, length, &total,
+                                        (options & (FILE_SYNCHRONOUS_IO_ALERT | FILE_SYNCHRONOUS_IO_NONALERT)) != 0 );
+            if (status != STATUS_PENDING) goto done;
+        }
+        else if ((result = read( unix_handle, (char *)buffer + total, length - total )) >= 0)
         {
             total += result;
             if (!result || total == length)
@@ -663,7 +1060,8 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
 
             if ((status = get_io_avail_mode( hFile, type, &avail_mode )))
                 goto err;
-            if (total && avail_mode)
+            /* a message pipe is pending only in the middle of a message */
+            if (total && avail_mode && type != FD_TYPE_PIPE_MESSAGE)
             {
                 status = STATUS_SUCCESS;
                 goto done;
@@ -738,11 +1136,11 @@ done:
 
 err:
     if (needs_close) close( unix_handle );
-    if (status == STATUS_SUCCESS)
+    if (status == STATUS_SUCCESS || status == STATUS_BUFFER_OVERFLOW)
     {
         io_status->u.Status = status;
         io_status->Information = total;
-        TRACE("= SUCCESS (%u)\n", total);
+        TRACE("= 0x%08x (%u)\n", status, total);
         if (hEvent) NtSetEvent( hEvent, NULL );
         if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc,
                                    (ULONG_PTR)apc_user, (ULONG_PTR)io_status, 0 );
@@ -864,7 +1262,10 @@ static NTSTATUS FILE_AsyncWriteService(void *user, IO_STATUS_BLOCK *iosb, NTSTAT
                                           &needs_close, &type, NULL )))
             break;
 
-        if (!fileio->count && (type == FD_TYPE_MAILSLOT || type == FD_TYPE_PIPE || type == FD_TYPE_SOCKET))
+        if (type == FD_TYPE_PIPE_MESSAGE)
+            result = write_message_pipe( fd, fileio->buffer, fileio->count, fileio->already );
+        else if (!fileio->count && (type == FD_TYPE_MAILSLOT || type == FD_TYPE_PIPE ||
+                                    type == FD_TYPE_SOCKET))
             result = send( fd, fileio->buffer, 0, 0 );
         else
             result = write( fd, &fileio->buffer[fileio->already], fileio->count - fileio->already );
@@ -973,8 +1374,11 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
 
     for (;;)
     {
+        if (type == FD_TYPE_PIPE_MESSAGE)
+            result = write_message_pipe( unix_handle, buffer, length, total );
         /* zero-length writes on sockets may not work with plain write(2) */
-        if (!length && (type == FD_TYPE_MAILSLOT || type == FD_TYPE_PIPE || type == FD_TYPE_SOCKET))
+        else if (!length && (type == FD_TYPE_MAILSLOT || type == FD_TYPE_PIPE ||
+                             type == FD_TYPE_SOCKET))
             result = send( unix_handle, buffer, 0, 0 );
         else
             result = write( unix_handle, (const char *)buffer + total, length - total );
@@ -1422,14 +1826,18 @@ NTSTATUS WINAPI NtFsControlFile(HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc
         {
             FILE_PIPE_PEEK_BUFFER *buffer = out_buffer;
             int avail = 0, fd, needs_close;
+            ULONG data_size, kept = 0, messages = 0, message_length = 0;
+            enum server_fd_type type;
+            BOOL found = FALSE;
 
             if (out_size < FIELD_OFFSET( FILE_PIPE_PEEK_BUFFER, Data ))
             {
                 status = STATUS_INFO_LENGTH_MISMATCH;
                 break;
             }
+            data_size = out_size - FIELD_OFFSET( FILE_PIPE_PEEK_BUFFER, Data );
 
-            if ((status = server_get_unix_fd( handle, FILE_READ_DATA, &fd, &needs_close, NULL, NULL )))
+            if ((status = server_get_unix_fd( handle, FILE_READ_DATA, &fd, &needs_close, &type, NULL )))
                 break;
 
 #ifdef FIONREAD
@@ -1441,7 +1849,37 @@ NTSTATUS WINAPI NtFsControlFile(HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc
                 break;
             }
 #endif
-            if (!avail)  /* check for closed pipe */
+            if (type == FD_TYPE_PIPE_MESSAGE)
+            {
+                struct pipe_remainder *rem;
+                ULONG data_avail, first;
+                dev_t dev;
+                ino_t ino;
+
+                count_pipe_packets( fd, avail, &data_avail, &messages, &first );
+                avail = data_avail;
+                message_length = first;
+
+                /* the rest of a partially read message comes first */
+                if (!list_empty( &pipe_remainders ) && get_pipe_socket_id( fd, &dev, &ino ))
+                {
+                    RtlEnterCriticalSection( &pipe_section );
+                    if ((rem = find_pipe_remainder( dev, ino )))
+                    {
+                        found = TRUE;
+                        kept = rem->size - rem->pos;
+                        memcpy( buffer->Data, rem->data + rem->pos, min( kept, data_size ) );
+                        if (rem->more) message_length += kept;
+                        else
+                        {
+                            message_length = kept;
+                            messages++;
+                        }
+                    }
+                    RtlLeaveCriticalSection( &pipe_section );
+                }
+            }
+            if (!avail && !kept)  /* check for closed pipe */
             {
                 struct pollfd pollfd;
                 int ret;
@@ -1458,14 +1896,22 @@ NTSTATUS WINAPI NtFsControlFile(HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc
                 }
             }
             buffer->NamedPipeState    = 0;  /* FIXME */
-            buffer->ReadDataAvailable = avail;
-            buffer->NumberOfMessages  = 0;  /* FIXME */
-            buffer->MessageLength     = 0;  /* FIXME */
+            buffer->ReadDataAvailable = avail + kept;
+            buffer->NumberOfMessages  = messages;
+            buffer->MessageLength     = message_length;
             io->Information = FIELD_OFFSET( FILE_PIPE_PEEK_BUFFER, Data );
             status = STATUS_SUCCESS;
-            if (avail)
+            if (found)
+                io->Information += min( kept, data_size );
+            else if (type == FD_TYPE_PIPE_MESSAGE)
+            {
+                BOOL more;
+                ssize_t res = recv_pipe_packet( fd, buffer->Data, data_size, MSG_PEEK | MSG_DONTWAIT, &more );
+
+                if (res > 0) io->Information += min( res - 1, data_size );
+            }
+            else if (avail)
             {
-                ULONG data_size = out_size - FIELD_OFFSET( FILE_PIPE_PEEK_BUFFER, Data );
                 if (data_size)
                 {
                     int res = recv( fd, buffer->Data, data_size, MSG_PEEK );
@@ -1482,7 +1928,11 @@ NTSTATUS WINAPI NtFsControlFile(HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc
         if (!status)
         {
             int fd = server_remove_fd_from_cache( handle );
-            if (fd != -1) close( fd );
+            if (fd != -1)
+            {
+                discard_pipe_remainder( fd );
+                close( fd );
+            }
         }
         break;
 
@@ -2167,6 +2617,29 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
         }
         break;
 
+    case FilePipeInformation:
+        if (len >= sizeof(FILE_PIPE_INFORMATION))
+        {
+            FILE_PIPE_INFORMATION *info = ptr;
+
+            if ((info->CompletionMode | info->ReadMode) & ~1)
+            {
+                io->u.Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            SERVER_START_REQ( set_named_pipe_info )
+            {
+                req->handle = wine_server_obj_handle( handle );
+                req->flags  = (info->CompletionMode ? NAMED_PIPE_NONBLOCKING_MODE : 0) |
+                              (info->ReadMode ? NAMED_PIPE_MESSAGE_STREAM_READ : 0);
+                io->u.Status = wine_server_call( req );
+            }
+            SERVER_END_REQ;
+        }
+        else io->u.Status = STATUS_INVALID_PARAMETER_3;
+        break;
+
     case FileCompletionInformation:
         if (len >= sizeof(FILE_COMPLETION_INFORMATION))
         {
@@ -326,6 +326,250 @@ static ULONG StorageImpl_GetBigBlockOffset(StorageImpl* This, ULONG index)
     return (index+1) * This->bigBlockSize;
 }
 
+/************************************************************************
+** Sector cache
+**
+** Recently used sectors of the file are kept in a small LRU cache, so that
+** walking the depots and the directory does not go back to the ILockBytes
+** for every block. Single sector writes are kept in the cache and written
+** back in runs of adjacent sectors when they are evicted or on flush.
+** Larger requests only use the cache for the sectors it already holds, the
+** rest is transferred directly. The header is never cached.
+*/
+
+#define SECTOR_CACHE_SIZE   128
+#define SECTOR_WRITE_BATCH  32
+#define SECTOR_READ_AHEAD   16
+
+typedef struct SectorCacheEntry
+{
+  struct list lru_entry;
+  struct list hash_entry;
+  ULONG sector;
+  BOOL  dirty;
+  BYTE  data[1];
+} SectorCacheEntry;
+
+static SectorCacheEntry *SectorCache_Find(StorageImpl *This, ULONG sector)
+{
+  SectorCacheEntry *entry;
+
+  LIST_FOR_EACH_ENTRY(entry, &This->sectorCacheHash[sector % SECTOR_CACHE_HASH_SIZE],
+                      SectorCacheEntry, hash_entry)
+  {
+    if (entry->sector == sector)
+      return entry;
+  }
+
+  return NULL;
+}
+
+static void SectorCache_Touch(StorageImpl *This, SectorCacheEntry *entry)
+{
+  list_remove(&entry->lru_entry);
+  list_add_head(&This->sectorCacheLru, &entry->lru_entry);
+}
+
+/* Write a dirty sector back, along with the dirty sectors adjacent to it. */
+static HRESULT SectorCache_WriteBack(StorageImpl *This, SectorCacheEntry *entry)
+{
+  SectorCacheEntry *run[SECTOR_WRITE_BATCH], *cur;
+  ULONG first = entry->sector, count = 0, i, written, size;
+  ULARGE_INTEGER offset;
+  BYTE *buffer = NULL;
+  HRESULT hr;
+
+  while (first > 1 && entry->sector - first + 1 < SECTOR_WRITE_BATCH &&
+         (cur = SectorCache_Find(This, first - 1)) && cur->dirty)
+    first--;
+
+  while (count < SECTOR_WRITE_BATCH &&
+         (cur = SectorCache_Find(This, first + count)) && cur->dirty)
+    run[count++] = cur;
+
+  if (count > 1)
+    buffer = HeapAlloc(GetProcessHeap(), 0, count * This->bigBlockSize);
+
+  if (buffer)
+  {
+    for (i = 0; i < count; i++)
+      memcpy(buffer + i * This->bigBlockSize, run[i]->data, This->bigBlockSize);
+  }
+  else
+  {
+    first = entry->sector;
+    run[0] = entry;
+    count = 1;
+  }
+
+  size = count * This->bigBlockSize;
+  offset.QuadPart = (ULONGLONG)first * This->bigBlockSize;
+  hr = ILockBytes_WriteAt(This->lockBytes, offset, buffer ? buffer : entry->data, size, &written);
+  if (SUCCEEDED(hr) && written != size)
+    hr = STG_E_WRITEFAULT;
+
+  HeapFree(GetProcessHeap(), 0, buffer);
+
+  if (SUCCEEDED(hr))
+  {
+    for (i = 0; i < count; i++)
+      run[i]->dirty = FALSE;
+
+    This->sectorCacheWritten += count;
+    This->sectorCacheWriteBatches++;
+  }
+
+  return hr;
+}
+
+static HRESULT SectorCache_Evict(StorageImpl *This)
+{
+  SectorCacheEntry *entry = LIST_ENTRY(list_tail(&This->sectorCacheLru), SectorCacheEntry, lru_entry);
+  HRESULT hr;
+
+  if (entry->dirty)
+  {
+    hr = SectorCache_WriteBack(This, entry);
+    if (FAILED(hr))
+      return hr;
+  }
+
+  list_remove(&entry->lru_entry);
+  list_remove(&entry->hash_entry);
+  HeapFree(GetProcessHeap(), 0, entry);
+  This->sectorCacheCount--;
+
+  return S_OK;
+}
+
+/* Add an entry for a sector to the cache, the caller fills in the data. */
+static SectorCacheEntry *SectorCache_Insert(StorageImpl *This, ULONG sector)
+{
+  SectorCacheEntry *entry;
+
+  if (This->sectorCacheCount >= SECTOR_CACHE_SIZE &&
+      FAILED(SectorCache_Evict(This)))
+    return NULL;
+
+  entry = HeapAlloc(GetProcessHeap(), 0,
+                    FIELD_OFFSET(SectorCacheEntry, data[This->bigBlockSize]));
+  if (!entry)
+    return NULL;
+
+  entry->sector = sector;
+  entry->dirty = FALSE;
+  list_add_head(&This->sectorCacheLru, &entry->lru_entry);
+  list_add_head(&This->sectorCacheHash[sector % SECTOR_CACHE_HASH_SIZE], &entry->hash_entry);
+  This->sectorCacheCount++;
+
+  return entry;
+}
+
+static void SectorCache_Remove(StorageImpl *This, SectorCacheEntry *entry)
+{
+  list_remove(&entry->lru_entry);
+  list_remove(&entry->hash_entry);
+  HeapFree(GetProcessHeap(), 0, entry);
+  This->sectorCacheCount--;
+}
+
+/* Read a sector into the cache. Sectors that are not entirely present in the
+ * file are not cached, so that the file size seen through the cache always
+ * matches the ILockBytes. */
+static SectorCacheEntry *SectorCache_Load(StorageImpl *This, ULONG sector)
+{
+  SectorCacheEntry *entry;
+  ULARGE_INTEGER offset;
+  ULONG read;
+  HRESULT hr;
+
+  entry = SectorCache_Insert(This, sector);
+  if (!entry)
+    return NULL;
+
+  offset.QuadPart = (ULONGLONG)sector * This->bigBlockSize;
+  hr = ILockBytes_ReadAt(This->lockBytes, offset, entry->data, This->bigBlockSize, &read);
+  if (FAILED(hr) || read != This->bigBlockSize)
+  {
+    SectorCache_Remove(This, entry);
+    return NULL;
+  }
+
+  This->sectorCacheMisses++;
+  return entry;
+}
+
+static HRESULT SectorCache_Flush(StorageImpl *This)
+{
+  SectorCacheEntry *entry;
+  HRESULT hr = S_OK;
+
+  LIST_FOR_EACH_ENTRY(entry, &This->sectorCacheLru, SectorCacheEntry, lru_entry)
+  {
+    if (entry->dirty)
+    {
+      hr = SectorCache_WriteBack(This, entry);
+      if (FAILED(hr))
+        break;
+    }
+  }
+
+  return hr;
+}
+
+static void SectorCache_Destroy(StorageImpl *This)
+{
+  SectorCacheEntry *entry, *next;
+
+  SectorCache_Flush(This);
+
+  TRACE("%p: %u hits, %u misses, %u sectors read ahead, %u sectors written in %u batches\n",
+        This, This->sectorCacheHits, This->sectorCacheMisses, This->sectorCacheReadAhead,
+        This->sectorCacheWritten, This->sectorCacheWriteBatches);
+
+  LIST_FOR_EACH_ENTRY_SAFE(entry, next, &This->sectorCacheLru, SectorCacheEntry, lru_entry)
+    SectorCache_Remove(This, entry);
+}
+
+/* Read a run of file-contiguous big blocks into the cache with a single
+ * request, stopping at the first one that is already cached. */
+static void StorageImpl_ReadAhead(StorageImpl *This, ULONG blockIndex, ULONG count)
+{
+  ULONG sector = blockIndex + 1, read, i;
+  ULARGE_INTEGER offset;
+  SectorCacheEntry *entry;
+  BYTE *buffer;
+
+  count = min(count, SECTOR_CACHE_SIZE / 4);
+  for (i = 0; i < count; i++)
+    if (SectorCache_Find(This, sector + i))
+      break;
+  count = i;
+  if (!count)
+    return;
+
+  buffer = HeapAlloc(GetProcessHeap(), 0, count * This->bigBlockSize);
+  if (!buffer)
+    return;
+
+  offset.QuadPart = (ULONGLONG)sector * This->bigBlockSize;
+  if (SUCCEEDED(ILockBytes_ReadAt(This->lockBytes, offset, buffer,
+                                  count * This->bigBlockSize, &read)))
+  {
+    count = read / This->bigBlockSize;
+    for (i = 0; i < count; i++)
+    {
+      entry = SectorCache_Insert(This, sector + i);
+      if (!entry)
+        break;
+      memcpy(entry->data, buffer + i * This->bigBlockSize, This->bigBlockSize);
+    }
+    This->sectorCacheReadAhead += i;
+  }
+
+  HeapFree(GetProcessHeap(), 0, buffer);
+}
+
 /************************************************************************
 ** Storage32BaseImpl implementation
 */
@@ -335,7 +579,57 @@ static HRESULT StorageImpl_ReadAt(StorageImpl* This,
   ULONG          size,
   ULONG*         bytesRead)
 {
-    return ILockBytes_ReadAt(This->lockBytes,offset,buffer,size,bytesRead);
+  BOOL single = size <= This->bigBlockSize;
+  BYTE *dest = buffer;
+  HRESULT hr = S_OK;
+
+  *bytesRead = 0;
+
+  while (size)
+  {
+    ULONG sector = offset.QuadPart / This->bigBlockSize;
+    ULONG inner = offset.QuadPart % This->bigBlockSize;
+    ULONG chunk = min(This->bigBlockSize - inner, size);
+    SectorCacheEntry *entry = NULL;
+    ULONG read;
+
+    if (sector)
+    {
+      entry = SectorCache_Find(This, sector);
+      if (entry)
+        This->sectorCacheHits++;
+      else if (single)
+        entry = SectorCache_Load(This, sector);
+    }
+
+    if (entry)
+    {
+      SectorCache_Touch(This, entry);
+      memcpy(dest, entry->data + inner, chunk);
+      read = chunk;
+    }
+    else
+    {
+      /* read whole sectors that are not cached in one go */
+      while (sector && !inner && size - chunk >= This->bigBlockSize &&
+             !SectorCache_Find(This, sector + chunk / This->bigBlockSize))
+        chunk += This->bigBlockSize;
+
+      hr = ILockBytes_ReadAt(This->lockBytes, offset, dest, chunk, &read);
+      if (FAILED(hr))
+        break;
+    }
+
+    dest += read;
+    size -= read;
+    *bytesRead += read;
+    offset.QuadPart += read;
+
+    if (read != chunk)
+      break;
+  }
+
+  return hr;
 }
 
 static HRESULT StorageImpl_WriteAt(StorageImpl* This,
@@ -344,7 +638,61 @@ static HRESULT StorageImpl_WriteAt(StorageImpl* This,
   const ULONG    size,
   ULONG*         bytesWritten)
 {
-    return ILockBytes_WriteAt(This->lockBytes,offset,buffer,size,bytesWritten);
+  BOOL single = size <= This->bigBlockSize;
+  const BYTE *src = buffer;
+  ULONG left = size;
+  HRESULT hr = S_OK;
+
+  *bytesWritten = 0;
+
+  while (left)
+  {
+    ULONG sector = offset.QuadPart / This->bigBlockSize;
+    ULONG inner = offset.QuadPart % This->bigBlockSize;
+    ULONG chunk = min(This->bigBlockSize - inner, left);
+    SectorCacheEntry *entry = NULL;
+    ULONG written;
+
+    if (sector)
+    {
+      entry = SectorCache_Find(This, sector);
+      if (entry)
+        This->sectorCacheHits++;
+      else if (single && chunk == This->bigBlockSize)
+        entry = SectorCache_Insert(This, sector);
+      else if (single)
+        entry = SectorCache_Load(This, sector);
+    }
+
+    if (entry)
+    {
+      SectorCache_Touch(This, entry);
+      memcpy(entry->data + inner, src, chunk);
+      entry->dirty = TRUE;
+      written = chunk;
+    }
+    else
+    {
+      /* write whole sectors that are not cached in one go */
+      while (sector && !inner && left - chunk >= This->bigBlockSize &&
+             !SectorCache_Find(This, sector + chunk / This->bigBlockSize))
+        chunk += This->bigBlockSize;
+
+      hr = ILockBytes_WriteAt(This->lockBytes, offset, src, chunk, &written);
+      if (FAILED(hr))
+        break;
+    }
+
+    src += written;
+    left -= written;
+    *bytesWritten += written;
+    offset.QuadPart += written;
+
+    if (written != chunk)
+      break;
+  }
+
+  return hr;
 }
 
 /************************************************************************
@@ -2696,6 +3044,7 @@ static HRESULT StorageImpl_Construct(
   HRESULT     hr = S_OK;
   DirEntry currentEntry;
   DirRef      currentEntryRef;
+  int         i;
 
   if ( FAILED( validateSTGM(openFlags) ))
     return STG_E_INVALIDFLAG;
@@ -2710,6 +3059,10 @@ static HRESULT StorageImpl_Construct(
 
   list_init(&This->base.storageHead);
 
+  list_init(&This->sectorCacheLru);
+  for (i=0; i<SECTOR_CACHE_HASH_SIZE; i++)
+    list_init(&This->sectorCacheHash[i]);
+
   This->base.lpVtbl = &Storage32Impl_Vtbl;
   This->base.pssVtbl = &IPropertySetStorage_Vtbl;
   This->base.baseVtbl = &StorageImpl_BaseVtbl;
@@ -2969,6 +3322,8 @@ static void StorageImpl_Destroy(StorageBaseImpl* iface)
   for (i=0; i<BLOCKCHAIN_CACHE_SIZE; i++)
     BlockChainStream_Destroy(This->blockChainCache[i]);
 
+  SectorCache_Destroy(This);
+
   if (This->lockBytes)
     ILockBytes_Release(This->lockBytes);
   HeapFree(GetProcessHeap(), 0, This);
@@ -2993,6 +3348,9 @@ static HRESULT StorageImpl_Flush(StorageBaseImpl* iface)
     if (This->blockChainCache[i])
       hr = BlockChainStream_Flush(This->blockChainCache[i]);
 
+  if (SUCCEEDED(hr))
+    hr = SectorCache_Flush(This);
+
   if (SUCCEEDED(hr))
     hr = ILockBytes_Flush(This->lockBytes);
 
@@ -6019,6 +6377,8 @@ BlockChainStream* BlockChainStream_Construct(
   newStream->cachedBlocks[1].index = 0xffffffff;
   newStream->cachedBlocks[1].dirty = 0;
   newStream->blockToEvict          = 0;
+  newStream->lastReadEnd           = 0xffffffff;
+  newStream->readAheadBlock        = 0;
 
   if (FAILED(BlockChainStream_UpdateIndexCache(newStream)))
   {
@@ -6100,6 +6460,36 @@ static ULONG BlockChainStream_GetCount(BlockChainStream* This)
   return This->numBlocks;
 }
 
+/* Prefetch the blocks following the given one into the sector cache,
+ * keeping about SECTOR_READ_AHEAD blocks ahead of a sequential reader. */
+static void BlockChainStream_ReadAhead(BlockChainStream* This, ULONG block)
+{
+  ULONG start = This->readAheadBlock;
+  ULONG last = min(block + SECTOR_READ_AHEAD, This->numBlocks);
+  ULONG sector, count;
+
+  if (start <= block || start > block + SECTOR_READ_AHEAD)
+    start = block;
+  else if (start - block >= SECTOR_READ_AHEAD / 2)
+    return;
+
+  while (start < last)
+  {
+    sector = BlockChainStream_GetSectorOfOffset(This, start);
+    if (sector == BLOCK_END_OF_CHAIN)
+      break;
+
+    for (count = 1; start + count < last; count++)
+      if (BlockChainStream_GetSectorOfOffset(This, start + count) != sector + count)
+        break;
+
+    StorageImpl_ReadAhead(This->parentStorage, sector, count);
+    start += count;
+  }
+
+  This->readAheadBlock = last;
+}
+
 /******************************************************************************
  *      BlockChainStream_ReadAt
  *
@@ -6137,6 +6527,16 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
   else
     return S_OK;
 
+  /*
+   * Small sequential reads of a large stream read ahead.
+   */
+  if (offset.u.LowPart == This->lastReadEnd &&
+      size < This->parentStorage->bigBlockSize * (SECTOR_READ_AHEAD / 2) &&
+      This->numBlocks > SECTOR_READ_AHEAD)
+    BlockChainStream_ReadAhead(This, blockNoInSequence);
+
+  This->lastReadEnd = offset.u.LowPart + size;
+
   /*
    * Start reading the buffer.
    */
@@ -6160,7 +6560,19 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
 
     if (!cachedBlock)
     {
-      /* Not in cache, and we're going to read past the end of the block. */
+      ULONG blocks = 1;
+
+      /* Not in cache, and we're going to read past the end of the block.
+       * Whole blocks stored right after this one are read along with it. */
+      while (size - bytesToReadInBuffer >= This->parentStorage->bigBlockSize &&
+             This->cachedBlocks[0].index != blockNoInSequence + blocks &&
+             This->cachedBlocks[1].index != blockNoInSequence + blocks &&
+             BlockChainStream_GetSectorOfOffset(This, blockNoInSequence + blocks) == blockIndex + blocks)
+      {
+        bytesToReadInBuffer += This->parentStorage->bigBlockSize;
+        blocks++;
+      }
+
       ulOffset.u.HighPart = 0;
       ulOffset.u.LowPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex) +
                                offsetInBlock;
@@ -6170,6 +6582,8 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
            bufferWalker,
            bytesToReadInBuffer,
            &bytesReadAt);
+
+      blockNoInSequence += blocks - 1;
     }
     else
     {
@@ -331,6 +331,9 @@ void StorageBaseImpl_RemoveStream(StorageBaseImpl * stg, StgStreamImpl * strm) D
 /* Number of BlockChainStream objects to cache in a StorageImpl */
 #define BLOCKCHAIN_CACHE_SIZE 4
 
+/* Number of hash buckets of the sector cache of a StorageImpl */
+#define SECTOR_CACHE_HASH_SIZE 64
+
 /****************************************************************************
  * Storage32Impl definitions.
  *
@@ -379,6 +382,18 @@ struct StorageImpl
   BlockChainStream* blockChainCache[BLOCKCHAIN_CACHE_SIZE];
   UINT blockChainToEvict;
 
+  /* Cache of recently used sectors of the file, in LRU order */
+  struct list sectorCacheLru;
+  struct list sectorCacheHash[SECTOR_CACHE_HASH_SIZE];
+  ULONG sectorCacheCount;
+
+  /* Sector cache statistics */
+  ULONG sectorCacheHits;
+  ULONG sectorCacheMisses;
+  ULONG sectorCacheReadAhead;
+  ULONG sectorCacheWritten;
+  ULONG sectorCacheWriteBatches;
+
   ILockBytes* lockBytes;
 };
 
@@ -539,6 +554,8 @@ struct BlockChainStream
   ULONG        blockToEvict;
   ULONG        tailIndex;
   ULONG        numBlocks;
+  ULONG        lastReadEnd;
+  ULONG        readAheadBlock;
 };
 
 /*
@@ -2989,6 +2989,83 @@ static void test_hglobal_storage_creation(void)
     ILockBytes_Release(ilb);
 }
 
+static void test_large_streams(void)
+{
+    IStorage *stg;
+    IStream *stm[2];
+    HRESULT r;
+    ULONG count, i, j, k;
+    LARGE_INTEGER pos;
+    BYTE buffer[1000], *big;
+    static const WCHAR *names[2] = { strmA_name, strmB_name };
+
+    DeleteFileA(filenameA);
+
+    r = StgCreateDocfile( filename, STGM_CREATE | STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, &stg);
+    ok(r==S_OK, "StgCreateDocfile failed, hr=%08x\n", r);
+
+    for (i = 0; i < 2; i++)
+    {
+        r = IStorage_CreateStream(stg, names[i], STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &stm[i]);
+        ok(r==S_OK, "IStorage->CreateStream failed, hr=%08x\n", r);
+    }
+
+    /* interleave the writes so that the chains of both streams are fragmented */
+    for (j = 0; j < 300; j++)
+    {
+        for (i = 0; i < 2; i++)
+        {
+            for (k = 0; k < sizeof(buffer); k++)
+                buffer[k] = (BYTE)(i + j * 7 + k);
+            r = IStream_Write(stm[i], buffer, sizeof(buffer), &count);
+            ok(r==S_OK && count == sizeof(buffer), "IStream->Write failed, hr=%08x count=%u\n", r, count);
+        }
+    }
+
+    for (i = 0; i < 2; i++)
+        IStream_Release(stm[i]);
+    IStorage_Release(stg);
+
+    r = StgOpenStorage( filename, NULL, STGM_SHARE_EXCLUSIVE | STGM_READ, NULL, 0, &stg);
+    ok(r==S_OK, "StgOpenStorage failed, hr=%08x\n", r);
+
+    big = HeapAlloc(GetProcessHeap(), 0, 300 * sizeof(buffer));
+
+    for (i = 0; i < 2; i++)
+    {
+        r = IStorage_OpenStream(stg, names[i], NULL, STGM_SHARE_EXCLUSIVE | STGM_READ, 0, &stm[i]);
+        ok(r==S_OK, "IStorage->OpenStream failed, hr=%08x\n", r);
+
+        /* small sequential reads */
+        for (j = 0; j < 300; j++)
+        {
+            r = IStream_Read(stm[i], buffer, sizeof(buffer), &count);
+            ok(r==S_OK && count == sizeof(buffer), "IStream->Read failed, hr=%08x count=%u\n", r, count);
+            for (k = 0; k < sizeof(buffer); k++)
+                if (buffer[k] != (BYTE)(i + j * 7 + k)) break;
+            ok(k == sizeof(buffer), "stream %u: wrong data in chunk %u at %u\n", i, j, k);
+        }
+
+        /* one large read */
+        pos.QuadPart = 0;
+        r = IStream_Seek(stm[i], pos, STREAM_SEEK_SET, NULL);
+        ok(r==S_OK, "IStream->Seek failed, hr=%08x\n", r);
+        r = IStream_Read(stm[i], big, 300 * sizeof(buffer), &count);
+        ok(r==S_OK && count == 300 * sizeof(buffer), "IStream->Read failed, hr=%08x count=%u\n", r, count);
+        for (k = 0; k < 300 * sizeof(buffer); k++)
+            if (big[k] != (BYTE)(i + (k / sizeof(buffer)) * 7 + k % sizeof(buffer))) break;
+        ok(k == 300 * sizeof(buffer), "stream %u: wrong data at %u\n", i, k);
+
+        IStream_Release(stm[i]);
+    }
+
+    HeapFree(GetProcessHeap(), 0, big);
+    IStorage_Release(stg);
+
+    r = DeleteFileA(filenameA);
+    ok( r == TRUE, "deleted file\n");
+}
+
 START_TEST(storage32)
 {
     CHAR temp[MAX_PATH];
@@ -3032,4 +3109,5 @@ START_TEST(storage32)
     test_copyto_locking();
     test_copyto_recursive();
     test_hglobal_storage_creation();
+    test_large_streams();
 }
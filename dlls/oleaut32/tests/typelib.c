@@ -543,6 +543,12 @@ static void test_TypeInfo(void)
     static WCHAR wszBogus[] = { 'b','o','g','u','s',0 };
     static WCHAR wszGetTypeInfo[] = { 'G','e','t','T','y','p','e','I','n','f','o',0 };
     static WCHAR wszClone[] = {'C','l','o','n','e',0};
+    static WCHAR wszSetRatio[] = {'s','E','T','r','A','T','I','O',0};
+    static WCHAR wszCyHimetric[] = {'C','Y','h','i','m','e','t','r','i','c',0};
+    OLECHAR *set_ratio_names[2] = { wszSetRatio, wszCyHimetric };
+    DISPID set_ratio_ids[2];
+    FUNCDESC *pFuncDesc;
+    UINT index;
     OLECHAR* bogus = wszBogus;
     OLECHAR* pwszGetTypeInfo = wszGetTypeInfo;
     OLECHAR* pwszClone = wszClone;
@@ -587,6 +593,24 @@ static void test_TypeInfo(void)
        "ITypeInfo_GetIDsOfNames should have returned DISP_E_UNKNOWNNAME instead of 0x%08x\n",
        hr);
 
+    /* names are matched case insensitively, parameter names return their position */
+    hr = ITypeInfo_GetIDsOfNames(pTypeInfo, set_ratio_names, 2, set_ratio_ids);
+    ok_ole_success(hr, ITypeInfo_GetIDsOfNames);
+    ok(set_ratio_ids[1] == 1, "got %d\n", set_ratio_ids[1]);
+
+    hr = ITypeInfo_QueryInterface(pTypeInfo, &IID_ITypeInfo2, (void **)&pTypeInfo2);
+    ok_ole_success(hr, ITypeInfo_QueryInterface);
+    hr = ITypeInfo2_GetFuncIndexOfMemId(pTypeInfo2, set_ratio_ids[0], INVOKE_FUNC, &index);
+    ok_ole_success(hr, ITypeInfo2_GetFuncIndexOfMemId);
+    hr = ITypeInfo_GetFuncDesc(pTypeInfo, index, &pFuncDesc);
+    ok_ole_success(hr, ITypeInfo_GetFuncDesc);
+    ok(pFuncDesc->memid == set_ratio_ids[0], "got memid 0x%08x, expected 0x%08x\n", pFuncDesc->memid, set_ratio_ids[0]);
+    ok(pFuncDesc->cParams == 2, "got %d params\n", pFuncDesc->cParams);
+    ITypeInfo_ReleaseFuncDesc(pTypeInfo, pFuncDesc);
+    hr = ITypeInfo2_GetFuncIndexOfMemId(pTypeInfo2, set_ratio_ids[0], INVOKE_PROPERTYGET, &index);
+    ok(hr == TYPE_E_ELEMENTNOTFOUND, "got 0x%08x\n", hr);
+    ITypeInfo2_Release(pTypeInfo2);
+
     dispparams.cArgs = 0;
     dispparams.rgdispidNamedArgs = NULL;
     dispparams.rgvarg = NULL;
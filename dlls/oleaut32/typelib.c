@@ -980,6 +980,14 @@ typedef struct tagTLBImpLib
     struct list entry;
 } TLBImpLib;
 
+/* interned name of a MSFT typelib, keyed by its offset in the name table */
+typedef struct tagTLBName
+{
+    int offset;
+    BSTR name;
+    struct tagTLBName *next;    /* next name in the same hash bucket */
+} TLBName;
+
 /* internal ITypeLib data */
 typedef struct tagITypeLibImpl
 {
@@ -1007,6 +1015,9 @@ typedef struct tagITypeLibImpl
 				   typelibs */
     struct list ref_list;       /* list of ref types in this typelib */
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
+    TLBName **name_hash;        /* names shared by all the type infos of a
+                                   MSFT typelib, NULL for other formats */
+    UINT name_hash_size;
 
 
     /* typelibs are cached, keyed by path and index, so store the linked list info within them */
@@ -1091,6 +1102,23 @@ typedef struct tagTLBImplType
     struct list custdata_list;
 } TLBImplType;
 
+/* index of the functions and variables of a type info, by name and by
+ * member id. Members are numbered with the functions first, followed by
+ * the variables, and the hash chains are sorted by member number. */
+typedef struct tagTLBMemberIndex
+{
+    UINT size;              /* number of hash buckets, a power of 2 */
+    UINT count;             /* number of members */
+    UINT *name_hash;        /* first member of each name bucket */
+    UINT *memid_hash;       /* first member of each member id bucket */
+    UINT *name_next;        /* next member in the same name bucket */
+    UINT *memid_next;       /* next member in the same member id bucket */
+    UINT *unhashed;         /* members with names that can't be hashed */
+    UINT unhashed_count;
+} TLBMemberIndex;
+
+#define TLB_NO_MEMBER (~0u)
+
 /* internal TypeInfo data */
 typedef struct tagITypeInfoImpl
 {
@@ -1120,6 +1148,9 @@ typedef struct tagITypeInfoImpl
     /* Implemented Interfaces  */
     TLBImplType *impltypes;
 
+    /* lookup tables for GetIDsOfNames and Invoke, built on first use */
+    TLBMemberIndex *member_index;
+
     struct list custdata_list;
 } ITypeInfoImpl;
 
@@ -1607,6 +1638,171 @@ static inline TLBVarDesc *TLB_get_vardesc_by_name(TLBVarDesc *vardescs,
     return NULL;
 }
 
+/* Names made of ASCII letters, digits and underscores only can be hashed
+ * case-insensitively in a way that never disagrees with lstrcmpiW.
+ * Underscores don't contribute to the hash in case the collation ignores
+ * them. Other names are compared one by one. */
+static BOOL TLB_hash_name(const OLECHAR *name, UINT *hash)
+{
+    UINT h = 0;
+
+    if (!name) return FALSE;
+    for ( ; *name; name++)
+    {
+        WCHAR c = *name;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        else if (c == '_') continue;
+        else if ((c < 'a' || c > 'z') && (c < '0' || c > '9')) return FALSE;
+        h = h * 31 + c;
+    }
+    *hash = h;
+    return TRUE;
+}
+
+static inline UINT TLB_hash_memid(MEMBERID memid)
+{
+    return memid ^ (memid >> 16);
+}
+
+static inline const OLECHAR *TLB_member_name(const ITypeInfoImpl *This, UINT member)
+{
+    if (member < This->TypeAttr.cFuncs) return This->funcdescs[member].Name;
+    return This->vardescs[member - This->TypeAttr.cFuncs].Name;
+}
+
+static inline MEMBERID TLB_member_memid(const ITypeInfoImpl *This, UINT member)
+{
+    if (member < This->TypeAttr.cFuncs) return This->funcdescs[member].funcdesc.memid;
+    return This->vardescs[member - This->TypeAttr.cFuncs].vardesc.memid;
+}
+
+static TLBMemberIndex *TLB_build_member_index(const ITypeInfoImpl *This)
+{
+    TLBMemberIndex *index;
+    UINT count = This->TypeAttr.cFuncs + This->TypeAttr.cVars;
+    UINT size = 16, i, hash, bucket;
+
+    while (size < count) size <<= 1;
+    if (!(index = heap_alloc(sizeof(*index) + (2 * size + 3 * count) * sizeof(UINT))))
+        return NULL;
+
+    index->size = size;
+    index->count = count;
+    index->name_hash = (UINT *)(index + 1);
+    index->memid_hash = index->name_hash + size;
+    index->name_next = index->memid_hash + size;
+    index->memid_next = index->name_next + count;
+    index->unhashed = index->memid_next + count;
+    index->unhashed_count = 0;
+    for (i = 0; i < size; i++)
+        index->name_hash[i] = index->memid_hash[i] = TLB_NO_MEMBER;
+
+    /* insert in reverse order so that the chains end up sorted */
+    for (i = count; i-- > 0; )
+    {
+        if (TLB_hash_name(TLB_member_name(This, i), &hash))
+        {
+            bucket = hash & (size - 1);
+            index->name_next[i] = index->name_hash[bucket];
+            index->name_hash[bucket] = i;
+        }
+        bucket = TLB_hash_memid(TLB_member_memid(This, i)) & (size - 1);
+        index->memid_next[i] = index->memid_hash[bucket];
+        index->memid_hash[bucket] = i;
+    }
+    for (i = 0; i < count; i++)
+        if (!TLB_hash_name(TLB_member_name(This, i), &hash))
+            index->unhashed[index->unhashed_count++] = i;
+
+    return index;
+}
+
+/* small type infos are searched linearly */
+#define TLB_MEMBER_INDEX_MIN 8
+
+static const TLBMemberIndex *TLB_get_member_index(ITypeInfoImpl *This)
+{
+    TLBMemberIndex *index = This->member_index, *prev;
+
+    if (index) return index;
+    if (This->TypeAttr.cFuncs + This->TypeAttr.cVars < TLB_MEMBER_INDEX_MIN) return NULL;
+    if (!(index = TLB_build_member_index(This))) return NULL;
+
+    /* type infos are used from several threads, keep the first index built */
+    prev = InterlockedCompareExchangePointer((void **)&This->member_index, index, NULL);
+    if (prev)
+    {
+        heap_free(index);
+        index = prev;
+    }
+    return index;
+}
+
+/* returns the number of the first function or variable called name,
+ * or TLB_NO_MEMBER */
+static UINT TLB_find_member_by_name(ITypeInfoImpl *This, const OLECHAR *name)
+{
+    const TLBMemberIndex *index = TLB_get_member_index(This);
+    UINT i, hash, found = TLB_NO_MEMBER;
+
+    if (index && TLB_hash_name(name, &hash))
+    {
+        for (i = index->name_hash[hash & (index->size - 1)]; i != TLB_NO_MEMBER; i = index->name_next[i])
+            if (!lstrcmpiW(name, TLB_member_name(This, i)))
+            {
+                found = i;
+                break;
+            }
+        for (i = 0; i < index->unhashed_count && index->unhashed[i] < found; i++)
+            if (!lstrcmpiW(name, TLB_member_name(This, index->unhashed[i])))
+                return index->unhashed[i];
+        return found;
+    }
+
+    for (i = 0; i < This->TypeAttr.cFuncs + This->TypeAttr.cVars; i++)
+        if (!lstrcmpiW(name, TLB_member_name(This, i)))
+            return i;
+    return TLB_NO_MEMBER;
+}
+
+/* returns the index of the first function with the given member id that
+ * supports one of the invoke kinds, or cFuncs if there is none */
+static UINT TLB_find_func_by_memid(ITypeInfoImpl *This, MEMBERID memid,
+        INVOKEKIND invkind, BOOL skip_restricted)
+{
+    const TLBMemberIndex *index = TLB_get_member_index(This);
+    const TLBFuncDesc *pFuncInfo;
+    UINT fdc;
+
+    if (index)
+    {
+        for (fdc = index->memid_hash[TLB_hash_memid(memid) & (index->size - 1)];
+             fdc < This->TypeAttr.cFuncs; fdc = index->memid_next[fdc])
+        {
+            pFuncInfo = &This->funcdescs[fdc];
+            if (memid == pFuncInfo->funcdesc.memid && (invkind & pFuncInfo->funcdesc.invkind) &&
+                (!skip_restricted || !(pFuncInfo->funcdesc.wFuncFlags & FUNCFLAG_FRESTRICTED)))
+                return fdc;
+        }
+        return This->TypeAttr.cFuncs;
+    }
+
+    for (fdc = 0; fdc < This->TypeAttr.cFuncs; ++fdc)
+    {
+        pFuncInfo = &This->funcdescs[fdc];
+        if (memid == pFuncInfo->funcdesc.memid && (invkind & pFuncInfo->funcdesc.invkind) &&
+            (!skip_restricted || !(pFuncInfo->funcdesc.wFuncFlags & FUNCFLAG_FRESTRICTED)))
+            break;
+    }
+    return fdc;
+}
+
+/* names of MSFT typelibs are interned, they belong to the library */
+static inline void TLB_FreeName(const ITypeLibImpl *lib, BSTR name)
+{
+    if (!lib || !lib->name_hash) SysFreeString(name);
+}
+
 static inline TLBCustData *TLB_get_custdata_by_guid(struct list *custdata_list, REFGUID guid)
 {
     TLBCustData *cust_data;
@@ -1768,11 +1964,15 @@ static HREFTYPE MSFT_ReadHreftype( TLBContext *pcx, int offset )
     return niName.hreftype;
 }
 
+/* names are interned: every offset of the name table is converted only
+ * once, and the resulting string is shared by all its users */
 static BSTR MSFT_ReadName( TLBContext *pcx, int offset)
 {
-    char * name;
+    ITypeLibImpl *lib = pcx->pLibInfo;
+    TLBName *entry, **bucket;
     MSFT_NameIntro niName;
-    int lengthInChars;
+    const char *name;
+    int lengthInChars, len;
     BSTR bstrName = NULL;
 
     if (offset < 0)
@@ -1780,27 +1980,42 @@ static BSTR MSFT_ReadName( TLBContext *pcx, int offset)
         ERR_(typelib)("bad offset %d\n", offset);
         return NULL;
     }
+
+    bucket = &lib->name_hash[(offset / sizeof(INT)) & (lib->name_hash_size - 1)];
+    for (entry = *bucket; entry; entry = entry->next)
+        if (entry->offset == offset) return entry->name;
+
     MSFT_ReadLEDWords(&niName, sizeof(niName), pcx,
 		      pcx->pTblDir->pNametab.offset+offset);
     niName.namelen &= 0xFF; /* FIXME: correct ? */
-    name = heap_alloc_zero((niName.namelen & 0xff) +1);
-    MSFT_Read(name, (niName.namelen & 0xff), pcx, DO_NOT_SEEK);
-    name[niName.namelen & 0xff]='\0';
 
-    lengthInChars = MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS,
-                                        name, -1, NULL, 0);
+    /* convert straight from the mapping, up to the first null */
+    name = (const char *)pcx->mapping + pcx->pos;
+    len = min( niName.namelen, pcx->length - pcx->pos );
+    len = memchr( name, 0, len ) ? strlen( name ) : len;
+
+    lengthInChars = len ? MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS,
+                                              name, len, NULL, 0) : 0;
 
     /* no invalid characters in string */
-    if (lengthInChars)
+    if (lengthInChars || !len)
     {
-        bstrName = SysAllocStringByteLen(NULL, lengthInChars * sizeof(WCHAR));
+        bstrName = SysAllocStringByteLen(NULL, (lengthInChars + 1) * sizeof(WCHAR));
 
         /* don't check for invalid character since this has been done previously */
-        MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, name, -1, bstrName, lengthInChars);
+        MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, name, len, bstrName, lengthInChars);
+        bstrName[lengthInChars] = 0;
     }
-    heap_free(name);
 
     TRACE_(typelib)("%s %d\n", debugstr_w(bstrName), lengthInChars);
+
+    if ((entry = heap_alloc(sizeof(*entry))))
+    {
+        entry->offset = offset;
+        entry->name = bstrName;
+        entry->next = *bucket;
+        *bucket = entry;
+    }
     return bstrName;
 }
 
@@ -2050,7 +2265,7 @@ MSFT_DoFuncs(TLBContext*     pcx,
         /* nameoffset is sometimes -1 on the second half of a propget/propput
          * pair of functions */
         if ((nameoffset == -1) && (i > 0))
-            ptfd->Name = SysAllocString(ptfd_prev->Name);
+            ptfd->Name = ptfd_prev->Name;
         else
             ptfd->Name = MSFT_ReadName(pcx, nameoffset);
 
@@ -2138,7 +2353,7 @@ MSFT_DoFuncs(TLBContext*     pcx,
                     /* this occurs for [propput] or [propget] methods, so
                      * we should just set the name of the parameter to the
                      * name of the method. */
-                    ptfd->pParamDesc[j].Name = SysAllocString(ptfd->Name);
+                    ptfd->pParamDesc[j].Name = ptfd->Name;
                 else
                     ptfd->pParamDesc[j].Name =
                         MSFT_ReadName( pcx, paraminfo.oName );
@@ -3039,6 +3254,18 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
 	return NULL;
     }
 
+    /* about one name every 16 bytes of the name table */
+    pTypeLibImpl->name_hash_size = 16;
+    while (pTypeLibImpl->name_hash_size < 0x10000 &&
+           pTypeLibImpl->name_hash_size < tlbSegDir.pNametab.length / 16)
+        pTypeLibImpl->name_hash_size <<= 1;
+    pTypeLibImpl->name_hash = heap_alloc_zero(pTypeLibImpl->name_hash_size * sizeof(TLBName *));
+    if (!pTypeLibImpl->name_hash)
+    {
+        heap_free(pTypeLibImpl);
+        return NULL;
+    }
+
     /* now fill our internal data */
     /* TLIBATTR fields */
     MSFT_ReadGuid(&pTypeLibImpl->LibAttr.guid, tlbHeader.posguid, &cx);
@@ -4260,7 +4487,7 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
       }
       TRACE(" destroying ITypeLib(%p)\n",This);
 
-      SysFreeString(This->Name);
+      TLB_FreeName(This, This->Name);
       This->Name = NULL;
 
       SysFreeString(This->DocString);
@@ -4298,6 +4525,18 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
 
       for (i = 0; i < This->TypeInfoCount; ++i)
           ITypeInfoImpl_Destroy(This->typeinfos[i]);
+
+      for (i = 0; i < This->name_hash_size; ++i)
+      {
+          TLBName *name, *next;
+          for (name = This->name_hash[i]; name; name = next)
+          {
+              next = name->next;
+              SysFreeString(name->name);
+              heap_free(name);
+          }
+      }
+      heap_free(This->name_hash);
       heap_free(This->typeinfos);
       heap_free(This);
       return 0;
@@ -5086,7 +5325,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
-    SysFreeString(This->Name);
+    TLB_FreeName(This->pTypeLib, This->Name);
     This->Name = NULL;
 
     SysFreeString(This->DocString);
@@ -5107,7 +5346,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
                 heap_free(elemdesc->u.paramdesc.pparamdescex);
             }
             TLB_FreeCustData(&pFInfo->pParamDesc[j].custdata_list);
-            SysFreeString(pFInfo->pParamDesc[j].Name);
+            TLB_FreeName(This->pTypeLib, pFInfo->pParamDesc[j].Name);
         }
         heap_free(pFInfo->funcdesc.lprgelemdescParam);
         heap_free(pFInfo->pParamDesc);
@@ -5115,7 +5354,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
         if (!IS_INTRESOURCE(pFInfo->Entry) && pFInfo->Entry != (BSTR)-1)
             SysFreeString(pFInfo->Entry);
         SysFreeString(pFInfo->HelpString);
-        SysFreeString(pFInfo->Name);
+        TLB_FreeName(This->pTypeLib, pFInfo->Name);
     }
     heap_free(This->funcdescs);
 
@@ -5128,7 +5367,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
             heap_free(pVInfo->vardesc.u.lpvarValue);
         }
         TLB_FreeCustData(&pVInfo->custdata_list);
-        SysFreeString(pVInfo->Name);
+        TLB_FreeName(This->pTypeLib, pVInfo->Name);
         SysFreeString(pVInfo->HelpString);
     }
     heap_free(This->vardescs);
@@ -5143,6 +5382,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TLB_FreeCustData(&This->custdata_list);
 
+    heap_free(This->member_index);
     heap_free(This);
 }
 
@@ -5160,7 +5400,10 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
         BOOL not_attached_to_typelib = This->not_attached_to_typelib;
         ITypeLib2_Release((ITypeLib2*)This->pTypeLib);
         if (not_attached_to_typelib)
+        {
+            heap_free(This->member_index);
             heap_free(This);
+        }
         /* otherwise This will be freed when typelib is freed */
     }
 
@@ -5703,7 +5946,7 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     ITypeInfoImpl *This = (ITypeInfoImpl *)iface;
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i, member;
 
     TRACE("(%p) Name %s cNames %d\n", This, debugstr_w(*rgszNames),
             cNames);
@@ -5712,26 +5955,25 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->TypeAttr.cFuncs; ++fdc) {
+    member = TLB_find_member_by_name(This, *rgszNames);
+    if (member < This->TypeAttr.cFuncs) {
         int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, pFDesc->Name)) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],pFDesc->pParamDesc[j].Name))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- 0x%08x\n", ret);
-            return ret;
-        }
+        const TLBFuncDesc *pFDesc = &This->funcdescs[member];
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],pFDesc->pParamDesc[j].Name))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- 0x%08x\n", ret);
+        return ret;
     }
-    pVDesc = TLB_get_vardesc_by_name(This->vardescs, This->TypeAttr.cVars, *rgszNames);
-    if(pVDesc){
+    if (member != TLB_NO_MEMBER) {
+        pVDesc = &This->vardescs[member - This->TypeAttr.cFuncs];
         if(cNames)
             *pMemId = pVDesc->vardesc.memid;
         return ret;
@@ -6282,16 +6524,13 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
-    for (fdc = 0; fdc < This->TypeAttr.cFuncs; ++fdc){
-        pFuncInfo = &This->funcdescs[fdc];
-        if ((memid == pFuncInfo->funcdesc.memid) &&
-            (wFlags & pFuncInfo->funcdesc.invkind) &&
-            (pFuncInfo->funcdesc.wFuncFlags & FUNCFLAG_FRESTRICTED) == 0)
-            break;
-    }
+    fdc = TLB_find_func_by_memid(This, memid, wFlags, TRUE);
 
     if (fdc < This->TypeAttr.cFuncs) {
-        const FUNCDESC *func_desc = &pFuncInfo->funcdesc;
+        const FUNCDESC *func_desc;
+
+        pFuncInfo = &This->funcdescs[fdc];
+        func_desc = &pFuncInfo->funcdesc;
 
         if (TRACE_ON(ole))
         {
@@ -6922,6 +7161,8 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
 	   */
 	  *pTypeInfoImpl = *This;
 	  pTypeInfoImpl->ref = 0;
+	  /* the member index is built on demand, don't share the original's */
+	  pTypeInfoImpl->member_index = NULL;
 
 	  /* change the type to interface */
 	  pTypeInfoImpl->TypeAttr.typekind = TKIND_INTERFACE;
@@ -7248,11 +7489,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncIndexOfMemId( ITypeInfo2 * iface,
     UINT fdc;
     HRESULT result;
 
-    for (fdc = 0; fdc < This->TypeAttr.cFuncs; ++fdc){
-        const TLBFuncDesc *pFuncInfo = &This->funcdescs[fdc];
-        if(memid == pFuncInfo->funcdesc.memid && (invKind & pFuncInfo->funcdesc.invkind))
-            break;
-    }
+    fdc = TLB_find_func_by_memid(This, memid, invKind, FALSE);
     if(fdc < This->TypeAttr.cFuncs) {
         *pFuncIndex = fdc;
         result = S_OK;
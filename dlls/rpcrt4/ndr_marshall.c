@@ -156,6 +156,19 @@ static unsigned char * ComplexUnmarshall(PMIDL_STUB_MESSAGE pStubMsg,
 static ULONG ComplexStructMemorySize(PMIDL_STUB_MESSAGE pStubMsg,
                                      PFORMAT_STRING pFormat,
                                      PFORMAT_STRING pPointer);
+
+struct complex_plan;
+static const struct complex_plan *get_complex_plan(PFORMAT_STRING pFormat, PFORMAT_STRING pPointer);
+static unsigned char *complex_plan_buffer_size(PMIDL_STUB_MESSAGE pStubMsg,
+                                               unsigned char *pMemory,
+                                               const struct complex_plan *plan);
+static unsigned char *complex_plan_marshall(PMIDL_STUB_MESSAGE pStubMsg,
+                                            unsigned char *pMemory,
+                                            const struct complex_plan *plan);
+static unsigned char *complex_plan_unmarshall(PMIDL_STUB_MESSAGE pStubMsg,
+                                              unsigned char *pMemory,
+                                              const struct complex_plan *plan,
+                                              unsigned char fMustAlloc);
 static unsigned char * ComplexFree(PMIDL_STUB_MESSAGE pStubMsg,
                                    unsigned char *pMemory,
                                    PFORMAT_STRING pFormat,
@@ -1871,6 +1884,7 @@ static inline void array_buffer_size(
   DWORD i, size;
   DWORD esize;
   unsigned char alignment;
+  const struct complex_plan *plan;
 
   switch (fc)
   {
@@ -1927,8 +1941,12 @@ static inline void array_buffer_size(
     align_length(&pStubMsg->BufferLength, alignment);
 
     size = pStubMsg->ActualCount;
-    for (i = 0; i < size; i++)
-      pMemory = ComplexBufferSize(pStubMsg, pMemory, pFormat, NULL);
+    if ((plan = get_complex_plan(pFormat, NULL)))
+      for (i = 0; i < size; i++)
+        pMemory = complex_plan_buffer_size(pStubMsg, pMemory, plan);
+    else
+      for (i = 0; i < size; i++)
+        pMemory = ComplexBufferSize(pStubMsg, pMemory, pFormat, NULL);
     break;
   default:
     ERR("unknown array format 0x%x\n", fc);
@@ -1994,6 +2012,7 @@ static inline void array_write_variance_and_marshall(
   DWORD i, size;
   DWORD esize;
   unsigned char alignment;
+  const struct complex_plan *plan;
 
   switch (fc)
   {
@@ -2054,8 +2073,12 @@ static inline void array_write_variance_and_marshall(
     align_pointer_clear(&pStubMsg->Buffer, alignment);
 
     size = pStubMsg->ActualCount;
-    for (i = 0; i < size; i++)
-      pMemory = ComplexMarshall(pStubMsg, pMemory, pFormat, NULL);
+    if ((plan = get_complex_plan(pFormat, NULL)))
+      for (i = 0; i < size; i++)
+        pMemory = complex_plan_marshall(pStubMsg, pMemory, plan);
+    else
+      for (i = 0; i < size; i++)
+        pMemory = ComplexMarshall(pStubMsg, pMemory, pFormat, NULL);
     break;
   default:
     ERR("unknown array format 0x%x\n", fc);
@@ -2119,6 +2142,7 @@ static inline ULONG array_read_variance_and_unmarshall(
   unsigned char alignment;
   unsigned char *saved_buffer, *pMemory;
   ULONG i, offset, count;
+  const struct complex_plan *plan;
 
   switch (fc)
   {
@@ -2258,7 +2282,11 @@ static inline ULONG array_read_variance_and_unmarshall(
 
     pMemory = *ppMemory;
     count = pStubMsg->ActualCount;
-    for (i = 0; i < count; i++)
+    if ((plan = get_complex_plan(pFormat, NULL)))
+      for (i = 0; i < count; i++)
+        pMemory = complex_plan_unmarshall(pStubMsg, pMemory, plan, fMustAlloc);
+    else
+      for (i = 0; i < count; i++)
         pMemory = ComplexUnmarshall(pStubMsg, pMemory, pFormat, NULL, fMustAlloc);
     return pStubMsg->Buffer - saved_buffer;
 
@@ -2813,121 +2841,114 @@ static ULONG EmbeddedComplexMemorySize(PMIDL_STUB_MESSAGE pStubMsg,
 }
 
 
-static unsigned char * ComplexMarshall(PMIDL_STUB_MESSAGE pStubMsg,
-                                       unsigned char *pMemory,
-                                       PFORMAT_STRING pFormat,
-                                       PFORMAT_STRING pPointer)
+/* The member list of a complex type would otherwise be decoded again for
+ * every structure and every array element.  The first time a list is used
+ * it is compiled into a plan: runs of simple members, which have the same
+ * layout in memory and in the buffer, are copied in one go and everything
+ * else is handed to the interpreter one member at a time.  Plans are never
+ * freed, so they keep a copy of the format bytes they were compiled from in
+ * case a module is unloaded and another one is loaded at the same address. */
+
+#define COMPLEX_PLAN_HASH_SIZE 256
+#define COMPLEX_PLAN_MAX_OPS 128
+#define COMPLEX_PLAN_MAX_COUNT 4096
+
+enum complex_op_type
 {
-  PFORMAT_STRING desc;
-  NDR_MARSHALL m;
+  COMPLEX_OP_COPY,   /* simple members */
+  COMPLEX_OP_SKIP,   /* structure padding */
+  COMPLEX_OP_ALIGN,  /* memory alignment */
+  COMPLEX_OP_MEMBER  /* any other member, handled by the interpreter */
+};
+
+struct complex_op
+{
+  enum complex_op_type type;
   ULONG size;
+  PFORMAT_STRING format;
+  PFORMAT_STRING pointer;
+};
 
-  while (*pFormat != RPC_FC_END) {
+struct complex_plan
+{
+  struct complex_plan *next;
+  PFORMAT_STRING format;
+  PFORMAT_STRING pointer;
+  ULONG format_len;
+  ULONG pointer_len;
+  ULONG op_count;      /* 0 if the list can't be compiled */
+  ULONG memory_size;   /* only valid if fixed_size is set */
+  BOOL fixed_size;
+  struct complex_op ops[1];
+};
+
+static struct complex_plan *complex_plans[COMPLEX_PLAN_HASH_SIZE];
+static LONG complex_plan_count;
+
+static struct complex_plan *compile_complex_plan(PFORMAT_STRING pFormat, PFORMAT_STRING pPointer)
+{
+  struct complex_op ops[COMPLEX_PLAN_MAX_OPS];
+  PFORMAT_STRING format = pFormat, pointer = pPointer;
+  struct complex_plan *plan;
+  enum complex_op_type type;
+  ULONG count = 0, size = 0, memory_size = 0, format_len, pointer_len;
+  BOOL fixed_size = TRUE, valid = TRUE;
+
+  while (valid && *pFormat != RPC_FC_END)
+  {
+    PFORMAT_STRING member = pFormat, member_pointer = pPointer;
+
+    type = COMPLEX_OP_MEMBER;
     switch (*pFormat) {
     case RPC_FC_BYTE:
     case RPC_FC_CHAR:
     case RPC_FC_SMALL:
     case RPC_FC_USMALL:
-      TRACE("byte=%d <= %p\n", *(WORD*)pMemory, pMemory);
-      safe_copy_to_buffer(pStubMsg, pMemory, 1);
-      pMemory += 1;
+      type = COMPLEX_OP_COPY;
+      size = 1;
       break;
     case RPC_FC_WCHAR:
     case RPC_FC_SHORT:
     case RPC_FC_USHORT:
-      TRACE("short=%d <= %p\n", *(WORD*)pMemory, pMemory);
-      safe_copy_to_buffer(pStubMsg, pMemory, 2);
-      pMemory += 2;
-      break;
-    case RPC_FC_ENUM16:
-    {
-      USHORT val = *(DWORD *)pMemory;
-      TRACE("enum16=%d <= %p\n", *(DWORD*)pMemory, pMemory);
-      if (32767 < *(DWORD*)pMemory)
-        RpcRaiseException(RPC_X_ENUM_VALUE_OUT_OF_RANGE);
-      safe_copy_to_buffer(pStubMsg, &val, 2);
-      pMemory += 4;
+      type = COMPLEX_OP_COPY;
+      size = 2;
       break;
-    }
     case RPC_FC_LONG:
     case RPC_FC_ULONG:
     case RPC_FC_ENUM32:
-      TRACE("long=%d <= %p\n", *(DWORD*)pMemory, pMemory);
-      safe_copy_to_buffer(pStubMsg, pMemory, 4);
-      pMemory += 4;
-      break;
-    case RPC_FC_INT3264:
-    case RPC_FC_UINT3264:
-    {
-      UINT val = *(UINT_PTR *)pMemory;
-      TRACE("int3264=%ld <= %p\n", *(UINT_PTR *)pMemory, pMemory);
-      safe_copy_to_buffer(pStubMsg, &val, sizeof(UINT));
-      pMemory += sizeof(UINT_PTR);
-      break;
-    }
     case RPC_FC_FLOAT:
-      TRACE("float=%f <= %p\n", *(float*)pMemory, pMemory);
-      safe_copy_to_buffer(pStubMsg, pMemory, sizeof(float));
-      pMemory += sizeof(float);
+      type = COMPLEX_OP_COPY;
+      size = 4;
       break;
     case RPC_FC_HYPER:
-      TRACE("longlong=%s <= %p\n", wine_dbgstr_longlong(*(ULONGLONG*)pMemory), pMemory);
-      safe_copy_to_buffer(pStubMsg, pMemory, 8);
-      pMemory += 8;
-      break;
     case RPC_FC_DOUBLE:
-      TRACE("double=%f <= %p\n", *(double*)pMemory, pMemory);
-      safe_copy_to_buffer(pStubMsg, pMemory, sizeof(double));
-      pMemory += sizeof(double);
+      type = COMPLEX_OP_COPY;
+      size = 8;
+      break;
+    case RPC_FC_ENUM16:
+      memory_size += 4;
+      break;
+    case RPC_FC_INT3264:
+    case RPC_FC_UINT3264:
+      memory_size += sizeof(INT_PTR);
       break;
     case RPC_FC_RP:
     case RPC_FC_UP:
     case RPC_FC_OP:
     case RPC_FC_FP:
+      memory_size += sizeof(void *);
+      pFormat += 4;
+      break;
     case RPC_FC_POINTER:
-    {
-      unsigned char *saved_buffer;
-      int pointer_buffer_mark_set = 0;
-      TRACE("pointer=%p <= %p\n", *(unsigned char**)pMemory, pMemory);
-      TRACE("pStubMsg->Buffer before %p\n", pStubMsg->Buffer);
-      if (*pFormat != RPC_FC_POINTER)
-        pPointer = pFormat;
-      if (*pPointer != RPC_FC_RP)
-        align_pointer_clear(&pStubMsg->Buffer, 4);
-      saved_buffer = pStubMsg->Buffer;
-      if (pStubMsg->PointerBufferMark)
-      {
-        pStubMsg->Buffer = pStubMsg->PointerBufferMark;
-        pStubMsg->PointerBufferMark = NULL;
-        pointer_buffer_mark_set = 1;
-      }
-      else if (*pPointer != RPC_FC_RP)
-        safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
-      PointerMarshall(pStubMsg, saved_buffer, *(unsigned char**)pMemory, pPointer);
-      if (pointer_buffer_mark_set)
-      {
-        STD_OVERFLOW_CHECK(pStubMsg);
-        pStubMsg->PointerBufferMark = pStubMsg->Buffer;
-        pStubMsg->Buffer = saved_buffer;
-        if (*pPointer != RPC_FC_RP)
-          safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
-      }
-      TRACE("pStubMsg->Buffer after %p\n", pStubMsg->Buffer);
-      if (*pFormat == RPC_FC_POINTER)
-        pPointer += 4;
-      else
-        pFormat += 4;
-      pMemory += sizeof(void *);
+      memory_size += sizeof(void *);
+      pPointer += 4;
       break;
-    }
     case RPC_FC_ALIGNM2:
-      align_pointer(&pMemory, 2);
-      break;
     case RPC_FC_ALIGNM4:
-      align_pointer(&pMemory, 4);
-      break;
     case RPC_FC_ALIGNM8:
-      align_pointer(&pMemory, 8);
+      type = COMPLEX_OP_ALIGN;
+      size = *pFormat == RPC_FC_ALIGNM2 ? 2 : *pFormat == RPC_FC_ALIGNM4 ? 4 : 8;
+      align_length(&memory_size, size);
       break;
     case RPC_FC_STRUCTPAD1:
     case RPC_FC_STRUCTPAD2:
@@ -2936,341 +2957,713 @@ static unsigned char * ComplexMarshall(PMIDL_STUB_MESSAGE pStubMsg,
     case RPC_FC_STRUCTPAD5:
     case RPC_FC_STRUCTPAD6:
     case RPC_FC_STRUCTPAD7:
-      pMemory += *pFormat - RPC_FC_STRUCTPAD1 + 1;
+      type = COMPLEX_OP_SKIP;
+      size = *pFormat - RPC_FC_STRUCTPAD1 + 1;
       break;
     case RPC_FC_EMBEDDED_COMPLEX:
-      pMemory += pFormat[1];
-      pFormat += 2;
-      desc = pFormat + *(const SHORT*)pFormat;
-      size = EmbeddedComplexSize(pStubMsg, desc);
-      TRACE("embedded complex (size=%d) <= %p\n", size, pMemory);
-      m = NdrMarshaller[*desc & NDR_TABLE_MASK];
-      if (m)
-      {
-        /* for some reason interface pointers aren't generated as
-         * RPC_FC_POINTER, but instead as RPC_FC_EMBEDDED_COMPLEX, yet
-         * they still need the derefencing treatment that pointers are
-         * given */
-        if (*desc == RPC_FC_IP)
-          m(pStubMsg, *(unsigned char **)pMemory, desc);
-        else
-          m(pStubMsg, pMemory, desc);
-      }
-      else FIXME("no marshaller for embedded type %02x\n", *desc);
-      pMemory += size;
-      pFormat += 2;
-      continue;
-    case RPC_FC_PAD:
+      /* the size of the embedded type depends on its own description */
+      fixed_size = FALSE;
+      pFormat += 3;
       break;
+    case RPC_FC_PAD:
+      pFormat++;
+      continue;
     default:
-      FIXME("unhandled format 0x%02x\n", *pFormat);
+      /* leave it to the interpreter to complain */
+      valid = FALSE;
+      continue;
     }
     pFormat++;
+
+    if (type == COMPLEX_OP_COPY || type == COMPLEX_OP_SKIP)
+    {
+      memory_size += size;
+      if (count && ops[count - 1].type == type)
+      {
+        ops[count - 1].size += size;
+        continue;
+      }
+    }
+    if (count == COMPLEX_PLAN_MAX_OPS)
+    {
+      valid = FALSE;
+      continue;
+    }
+    ops[count].type = type;
+    ops[count].size = size;
+    ops[count].format = member;
+    ops[count].pointer = member_pointer;
+    count++;
   }
 
-  return pMemory;
+  format_len = pFormat - format + 1;
+  pointer_len = pointer ? pPointer - pointer : 0;
+  if (!valid) count = 0;
+
+  plan = HeapAlloc(GetProcessHeap(), 0, FIELD_OFFSET(struct complex_plan, ops[count]) +
+                   format_len + pointer_len);
+  if (!plan) return NULL;
+
+  plan->format = format;
+  plan->pointer = pointer;
+  plan->format_len = format_len;
+  plan->pointer_len = pointer_len;
+  plan->op_count = count;
+  plan->memory_size = memory_size;
+  plan->fixed_size = fixed_size;
+  memcpy(plan->ops, ops, count * sizeof(ops[0]));
+  memcpy((unsigned char *)&plan->ops[count], format, format_len);
+  if (pointer_len)
+    memcpy((unsigned char *)&plan->ops[count] + format_len, pointer, pointer_len);
+
+  TRACE("compiled %p/%p into %u operations\n", format, pointer, count);
+  return plan;
 }
 
-static unsigned char * ComplexUnmarshall(PMIDL_STUB_MESSAGE pStubMsg,
-                                         unsigned char *pMemory,
-                                         PFORMAT_STRING pFormat,
-                                         PFORMAT_STRING pPointer,
-                                         unsigned char fMustAlloc)
+static BOOL complex_plan_matches(const struct complex_plan *plan,
+                                 PFORMAT_STRING pFormat, PFORMAT_STRING pPointer)
+{
+  const unsigned char *bytes = (const unsigned char *)&plan->ops[plan->op_count];
+
+  return plan->format == pFormat && plan->pointer == pPointer &&
+         !memcmp(bytes, pFormat, plan->format_len) &&
+         (!plan->pointer_len || !memcmp(bytes + plan->format_len, pPointer, plan->pointer_len));
+}
+
+static const struct complex_plan *get_complex_plan(PFORMAT_STRING pFormat, PFORMAT_STRING pPointer)
+{
+  struct complex_plan **bucket, *plan, *head;
+
+  bucket = &complex_plans[(((ULONG_PTR)pFormat >> 2) ^ ((ULONG_PTR)pPointer >> 2)) % COMPLEX_PLAN_HASH_SIZE];
+
+  for (plan = *bucket; plan; plan = plan->next)
+    if (complex_plan_matches(plan, pFormat, pPointer))
+      return plan->op_count ? plan : NULL;
+
+  if (complex_plan_count >= COMPLEX_PLAN_MAX_COUNT) return NULL;
+  if (!(plan = compile_complex_plan(pFormat, pPointer))) return NULL;
+
+  /* entries are only ever added at the head, so readers don't need a lock */
+  do
+  {
+    head = *bucket;
+    plan->next = head;
+  } while (InterlockedCompareExchangePointer((void **)bucket, plan, head) != head);
+  InterlockedIncrement(&complex_plan_count);
+
+  return plan->op_count ? plan : NULL;
+}
+
+static unsigned char *ComplexMarshallMember(PMIDL_STUB_MESSAGE pStubMsg,
+                                            unsigned char *pMemory,
+                                            PFORMAT_STRING *ppFormat,
+                                            PFORMAT_STRING *ppPointer)
 {
   PFORMAT_STRING desc;
-  NDR_UNMARSHALL m;
+  NDR_MARSHALL m;
   ULONG size;
+  PFORMAT_STRING pFormat = *ppFormat;
+  PFORMAT_STRING pPointer = *ppPointer;
 
-  while (*pFormat != RPC_FC_END) {
-    switch (*pFormat) {
-    case RPC_FC_BYTE:
-    case RPC_FC_CHAR:
-    case RPC_FC_SMALL:
-    case RPC_FC_USMALL:
-      safe_copy_from_buffer(pStubMsg, pMemory, 1);
-      TRACE("byte=%d => %p\n", *(WORD*)pMemory, pMemory);
-      pMemory += 1;
-      break;
-    case RPC_FC_WCHAR:
-    case RPC_FC_SHORT:
-    case RPC_FC_USHORT:
-      safe_copy_from_buffer(pStubMsg, pMemory, 2);
-      TRACE("short=%d => %p\n", *(WORD*)pMemory, pMemory);
-      pMemory += 2;
-      break;
-    case RPC_FC_ENUM16:
+  switch (*pFormat) {
+  case RPC_FC_BYTE:
+  case RPC_FC_CHAR:
+  case RPC_FC_SMALL:
+  case RPC_FC_USMALL:
+    TRACE("byte=%d <= %p\n", *(WORD*)pMemory, pMemory);
+    safe_copy_to_buffer(pStubMsg, pMemory, 1);
+    pMemory += 1;
+    break;
+  case RPC_FC_WCHAR:
+  case RPC_FC_SHORT:
+  case RPC_FC_USHORT:
+    TRACE("short=%d <= %p\n", *(WORD*)pMemory, pMemory);
+    safe_copy_to_buffer(pStubMsg, pMemory, 2);
+    pMemory += 2;
+    break;
+  case RPC_FC_ENUM16:
+  {
+    USHORT val = *(DWORD *)pMemory;
+    TRACE("enum16=%d <= %p\n", *(DWORD*)pMemory, pMemory);
+    if (32767 < *(DWORD*)pMemory)
+      RpcRaiseException(RPC_X_ENUM_VALUE_OUT_OF_RANGE);
+    safe_copy_to_buffer(pStubMsg, &val, 2);
+    pMemory += 4;
+    break;
+  }
+  case RPC_FC_LONG:
+  case RPC_FC_ULONG:
+  case RPC_FC_ENUM32:
+    TRACE("long=%d <= %p\n", *(DWORD*)pMemory, pMemory);
+    safe_copy_to_buffer(pStubMsg, pMemory, 4);
+    pMemory += 4;
+    break;
+  case RPC_FC_INT3264:
+  case RPC_FC_UINT3264:
+  {
+    UINT val = *(UINT_PTR *)pMemory;
+    TRACE("int3264=%ld <= %p\n", *(UINT_PTR *)pMemory, pMemory);
+    safe_copy_to_buffer(pStubMsg, &val, sizeof(UINT));
+    pMemory += sizeof(UINT_PTR);
+    break;
+  }
+  case RPC_FC_FLOAT:
+    TRACE("float=%f <= %p\n", *(float*)pMemory, pMemory);
+    safe_copy_to_buffer(pStubMsg, pMemory, sizeof(float));
+    pMemory += sizeof(float);
+    break;
+  case RPC_FC_HYPER:
+    TRACE("longlong=%s <= %p\n", wine_dbgstr_longlong(*(ULONGLONG*)pMemory), pMemory);
+    safe_copy_to_buffer(pStubMsg, pMemory, 8);
+    pMemory += 8;
+    break;
+  case RPC_FC_DOUBLE:
+    TRACE("double=%f <= %p\n", *(double*)pMemory, pMemory);
+    safe_copy_to_buffer(pStubMsg, pMemory, sizeof(double));
+    pMemory += sizeof(double);
+    break;
+  case RPC_FC_RP:
+  case RPC_FC_UP:
+  case RPC_FC_OP:
+  case RPC_FC_FP:
+  case RPC_FC_POINTER:
+  {
+    unsigned char *saved_buffer;
+    int pointer_buffer_mark_set = 0;
+    TRACE("pointer=%p <= %p\n", *(unsigned char**)pMemory, pMemory);
+    TRACE("pStubMsg->Buffer before %p\n", pStubMsg->Buffer);
+    if (*pFormat != RPC_FC_POINTER)
+      pPointer = pFormat;
+    if (*pPointer != RPC_FC_RP)
+      align_pointer_clear(&pStubMsg->Buffer, 4);
+    saved_buffer = pStubMsg->Buffer;
+    if (pStubMsg->PointerBufferMark)
     {
-      WORD val;
-      safe_copy_from_buffer(pStubMsg, &val, 2);
-      *(DWORD*)pMemory = val;
-      TRACE("enum16=%d => %p\n", *(DWORD*)pMemory, pMemory);
-      if (32767 < *(DWORD*)pMemory)
-        RpcRaiseException(RPC_X_ENUM_VALUE_OUT_OF_RANGE);
-      pMemory += 4;
-      break;
+      pStubMsg->Buffer = pStubMsg->PointerBufferMark;
+      pStubMsg->PointerBufferMark = NULL;
+      pointer_buffer_mark_set = 1;
     }
-    case RPC_FC_LONG:
-    case RPC_FC_ULONG:
-    case RPC_FC_ENUM32:
-      safe_copy_from_buffer(pStubMsg, pMemory, 4);
-      TRACE("long=%d => %p\n", *(DWORD*)pMemory, pMemory);
-      pMemory += 4;
-      break;
-    case RPC_FC_INT3264:
+    else if (*pPointer != RPC_FC_RP)
+      safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
+    PointerMarshall(pStubMsg, saved_buffer, *(unsigned char**)pMemory, pPointer);
+    if (pointer_buffer_mark_set)
     {
-      INT val;
-      safe_copy_from_buffer(pStubMsg, &val, 4);
-      *(INT_PTR *)pMemory = val;
-      TRACE("int3264=%ld => %p\n", *(INT_PTR*)pMemory, pMemory);
-      pMemory += sizeof(INT_PTR);
-      break;
+      STD_OVERFLOW_CHECK(pStubMsg);
+      pStubMsg->PointerBufferMark = pStubMsg->Buffer;
+      pStubMsg->Buffer = saved_buffer;
+      if (*pPointer != RPC_FC_RP)
+        safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
     }
-    case RPC_FC_UINT3264:
-    {
-      UINT val;
-      safe_copy_from_buffer(pStubMsg, &val, 4);
-      *(UINT_PTR *)pMemory = val;
-      TRACE("uint3264=%ld => %p\n", *(UINT_PTR*)pMemory, pMemory);
-      pMemory += sizeof(UINT_PTR);
-      break;
+    TRACE("pStubMsg->Buffer after %p\n", pStubMsg->Buffer);
+    if (*pFormat == RPC_FC_POINTER)
+      pPointer += 4;
+    else
+      pFormat += 4;
+    pMemory += sizeof(void *);
+    break;
+  }
+  case RPC_FC_ALIGNM2:
+    align_pointer(&pMemory, 2);
+    break;
+  case RPC_FC_ALIGNM4:
+    align_pointer(&pMemory, 4);
+    break;
+  case RPC_FC_ALIGNM8:
+    align_pointer(&pMemory, 8);
+    break;
+  case RPC_FC_STRUCTPAD1:
+  case RPC_FC_STRUCTPAD2:
+  case RPC_FC_STRUCTPAD3:
+  case RPC_FC_STRUCTPAD4:
+  case RPC_FC_STRUCTPAD5:
+  case RPC_FC_STRUCTPAD6:
+  case RPC_FC_STRUCTPAD7:
+    pMemory += *pFormat - RPC_FC_STRUCTPAD1 + 1;
+    break;
+  case RPC_FC_EMBEDDED_COMPLEX:
+    pMemory += pFormat[1];
+    pFormat += 2;
+    desc = pFormat + *(const SHORT*)pFormat;
+    size = EmbeddedComplexSize(pStubMsg, desc);
+    TRACE("embedded complex (size=%d) <= %p\n", size, pMemory);
+    m = NdrMarshaller[*desc & NDR_TABLE_MASK];
+    if (m)
+    {
+      /* for some reason interface pointers aren't generated as
+       * RPC_FC_POINTER, but instead as RPC_FC_EMBEDDED_COMPLEX, yet
+       * they still need the derefencing treatment that pointers are
+       * given */
+      if (*desc == RPC_FC_IP)
+        m(pStubMsg, *(unsigned char **)pMemory, desc);
+      else
+        m(pStubMsg, pMemory, desc);
     }
-    case RPC_FC_FLOAT:
-      safe_copy_from_buffer(pStubMsg, pMemory, sizeof(float));
-      TRACE("float=%f => %p\n", *(float*)pMemory, pMemory);
-      pMemory += sizeof(float);
+    else FIXME("no marshaller for embedded type %02x\n", *desc);
+    pMemory += size;
+    *ppFormat = pFormat + 2;
+    return pMemory;
+  case RPC_FC_PAD:
+    break;
+  default:
+    FIXME("unhandled format 0x%02x\n", *pFormat);
+  }
+
+  *ppFormat = pFormat + 1;
+  *ppPointer = pPointer;
+  return pMemory;
+}
+
+static unsigned char *complex_plan_marshall(PMIDL_STUB_MESSAGE pStubMsg,
+                                            unsigned char *pMemory,
+                                            const struct complex_plan *plan)
+{
+  const struct complex_op *op, *end = plan->ops + plan->op_count;
+
+  for (op = plan->ops; op < end; op++)
+  {
+    switch (op->type)
+    {
+    case COMPLEX_OP_COPY:
+      TRACE("%u bytes <= %p\n", op->size, pMemory);
+      safe_copy_to_buffer(pStubMsg, pMemory, op->size);
+      pMemory += op->size;
       break;
-    case RPC_FC_HYPER:
-      safe_copy_from_buffer(pStubMsg, pMemory, 8);
-      TRACE("longlong=%s => %p\n", wine_dbgstr_longlong(*(ULONGLONG*)pMemory), pMemory);
-      pMemory += 8;
+    case COMPLEX_OP_SKIP:
+      pMemory += op->size;
       break;
-    case RPC_FC_DOUBLE:
-      safe_copy_from_buffer(pStubMsg, pMemory, sizeof(double));
-      TRACE("double=%f => %p\n", *(double*)pMemory, pMemory);
-      pMemory += sizeof(double);
+    case COMPLEX_OP_ALIGN:
+      align_pointer(&pMemory, op->size);
       break;
-    case RPC_FC_RP:
-    case RPC_FC_UP:
-    case RPC_FC_OP:
-    case RPC_FC_FP:
-    case RPC_FC_POINTER:
+    case COMPLEX_OP_MEMBER:
     {
-      unsigned char *saved_buffer;
-      int pointer_buffer_mark_set = 0;
-      TRACE("pointer => %p\n", pMemory);
-      if (*pFormat != RPC_FC_POINTER)
-        pPointer = pFormat;
-      if (*pPointer != RPC_FC_RP)
-        align_pointer(&pStubMsg->Buffer, 4);
-      saved_buffer = pStubMsg->Buffer;
-      if (pStubMsg->PointerBufferMark)
-      {
-        pStubMsg->Buffer = pStubMsg->PointerBufferMark;
-        pStubMsg->PointerBufferMark = NULL;
-        pointer_buffer_mark_set = 1;
-      }
-      else if (*pPointer != RPC_FC_RP)
-        safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
+      PFORMAT_STRING format = op->format, pointer = op->pointer;
+      pMemory = ComplexMarshallMember(pStubMsg, pMemory, &format, &pointer);
+      break;
+    }
+    }
+  }
 
-      PointerUnmarshall(pStubMsg, saved_buffer, (unsigned char**)pMemory, *(unsigned char**)pMemory, pPointer, fMustAlloc);
-      if (pointer_buffer_mark_set)
-      {
-        STD_OVERFLOW_CHECK(pStubMsg);
-        pStubMsg->PointerBufferMark = pStubMsg->Buffer;
-        pStubMsg->Buffer = saved_buffer;
-        if (*pPointer != RPC_FC_RP)
-          safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
-      }
-      if (*pFormat == RPC_FC_POINTER)
-        pPointer += 4;
+  return pMemory;
+}
+
+static unsigned char * ComplexMarshall(PMIDL_STUB_MESSAGE pStubMsg,
+                                       unsigned char *pMemory,
+                                       PFORMAT_STRING pFormat,
+                                       PFORMAT_STRING pPointer)
+{
+  const struct complex_plan *plan = get_complex_plan(pFormat, pPointer);
+
+  if (plan)
+    return complex_plan_marshall(pStubMsg, pMemory, plan);
+
+  while (*pFormat != RPC_FC_END)
+    pMemory = ComplexMarshallMember(pStubMsg, pMemory, &pFormat, &pPointer);
+
+  return pMemory;
+}
+
+static unsigned char *ComplexUnmarshallMember(PMIDL_STUB_MESSAGE pStubMsg,
+                                              unsigned char *pMemory,
+                                              PFORMAT_STRING *ppFormat,
+                                              PFORMAT_STRING *ppPointer,
+                                              unsigned char fMustAlloc)
+{
+  PFORMAT_STRING desc;
+  NDR_UNMARSHALL m;
+  ULONG size;
+  PFORMAT_STRING pFormat = *ppFormat;
+  PFORMAT_STRING pPointer = *ppPointer;
+
+  switch (*pFormat) {
+  case RPC_FC_BYTE:
+  case RPC_FC_CHAR:
+  case RPC_FC_SMALL:
+  case RPC_FC_USMALL:
+    safe_copy_from_buffer(pStubMsg, pMemory, 1);
+    TRACE("byte=%d => %p\n", *(WORD*)pMemory, pMemory);
+    pMemory += 1;
+    break;
+  case RPC_FC_WCHAR:
+  case RPC_FC_SHORT:
+  case RPC_FC_USHORT:
+    safe_copy_from_buffer(pStubMsg, pMemory, 2);
+    TRACE("short=%d => %p\n", *(WORD*)pMemory, pMemory);
+    pMemory += 2;
+    break;
+  case RPC_FC_ENUM16:
+  {
+    WORD val;
+    safe_copy_from_buffer(pStubMsg, &val, 2);
+    *(DWORD*)pMemory = val;
+    TRACE("enum16=%d => %p\n", *(DWORD*)pMemory, pMemory);
+    if (32767 < *(DWORD*)pMemory)
+      RpcRaiseException(RPC_X_ENUM_VALUE_OUT_OF_RANGE);
+    pMemory += 4;
+    break;
+  }
+  case RPC_FC_LONG:
+  case RPC_FC_ULONG:
+  case RPC_FC_ENUM32:
+    safe_copy_from_buffer(pStubMsg, pMemory, 4);
+    TRACE("long=%d => %p\n", *(DWORD*)pMemory, pMemory);
+    pMemory += 4;
+    break;
+  case RPC_FC_INT3264:
+  {
+    INT val;
+    safe_copy_from_buffer(pStubMsg, &val, 4);
+    *(INT_PTR *)pMemory = val;
+    TRACE("int3264=%ld => %p\n", *(INT_PTR*)pMemory, pMemory);
+    pMemory += sizeof(INT_PTR);
+    break;
+  }
+  case RPC_FC_UINT3264:
+  {
+    UINT val;
+    safe_copy_from_buffer(pStubMsg, &val, 4);
+    *(UINT_PTR *)pMemory = val;
+    TRACE("uint3264=%ld => %p\n", *(UINT_PTR*)pMemory, pMemory);
+    pMemory += sizeof(UINT_PTR);
+    break;
+  }
+  case RPC_FC_FLOAT:
+    safe_copy_from_buffer(pStubMsg, pMemory, sizeof(float));
+    TRACE("float=%f => %p\n", *(float*)pMemory, pMemory);
+    pMemory += sizeof(float);
+    break;
+  case RPC_FC_HYPER:
+    safe_copy_from_buffer(pStubMsg, pMemory, 8);
+    TRACE("longlong=%s => %p\n", wine_dbgstr_longlong(*(ULONGLONG*)pMemory), pMemory);
+    pMemory += 8;
+    break;
+  case RPC_FC_DOUBLE:
+    safe_copy_from_buffer(pStubMsg, pMemory, sizeof(double));
+    TRACE("double=%f => %p\n", *(double*)pMemory, pMemory);
+    pMemory += sizeof(double);
+    break;
+  case RPC_FC_RP:
+  case RPC_FC_UP:
+  case RPC_FC_OP:
+  case RPC_FC_FP:
+  case RPC_FC_POINTER:
+  {
+    unsigned char *saved_buffer;
+    int pointer_buffer_mark_set = 0;
+    TRACE("pointer => %p\n", pMemory);
+    if (*pFormat != RPC_FC_POINTER)
+      pPointer = pFormat;
+    if (*pPointer != RPC_FC_RP)
+      align_pointer(&pStubMsg->Buffer, 4);
+    saved_buffer = pStubMsg->Buffer;
+    if (pStubMsg->PointerBufferMark)
+    {
+      pStubMsg->Buffer = pStubMsg->PointerBufferMark;
+      pStubMsg->PointerBufferMark = NULL;
+      pointer_buffer_mark_set = 1;
+    }
+    else if (*pPointer != RPC_FC_RP)
+      safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
+
+    PointerUnmarshall(pStubMsg, saved_buffer, (unsigned char**)pMemory, *(unsigned char**)pMemory, pPointer, fMustAlloc);
+    if (pointer_buffer_mark_set)
+    {
+      STD_OVERFLOW_CHECK(pStubMsg);
+      pStubMsg->PointerBufferMark = pStubMsg->Buffer;
+      pStubMsg->Buffer = saved_buffer;
+      if (*pPointer != RPC_FC_RP)
+        safe_buffer_increment(pStubMsg, 4); /* for pointer ID */
+    }
+    if (*pFormat == RPC_FC_POINTER)
+      pPointer += 4;
+    else
+      pFormat += 4;
+    pMemory += sizeof(void *);
+    break;
+  }
+  case RPC_FC_ALIGNM2:
+    align_pointer_clear(&pMemory, 2);
+    break;
+  case RPC_FC_ALIGNM4:
+    align_pointer_clear(&pMemory, 4);
+    break;
+  case RPC_FC_ALIGNM8:
+    align_pointer_clear(&pMemory, 8);
+    break;
+  case RPC_FC_STRUCTPAD1:
+  case RPC_FC_STRUCTPAD2:
+  case RPC_FC_STRUCTPAD3:
+  case RPC_FC_STRUCTPAD4:
+  case RPC_FC_STRUCTPAD5:
+  case RPC_FC_STRUCTPAD6:
+  case RPC_FC_STRUCTPAD7:
+    memset(pMemory, 0, *pFormat - RPC_FC_STRUCTPAD1 + 1);
+    pMemory += *pFormat - RPC_FC_STRUCTPAD1 + 1;
+    break;
+  case RPC_FC_EMBEDDED_COMPLEX:
+    pMemory += pFormat[1];
+    pFormat += 2;
+    desc = pFormat + *(const SHORT*)pFormat;
+    size = EmbeddedComplexSize(pStubMsg, desc);
+    TRACE("embedded complex (size=%d) => %p\n", size, pMemory);
+    if (fMustAlloc)
+      /* we can't pass fMustAlloc=TRUE into the marshaller for this type
+       * since the type is part of the memory block that is encompassed by
+       * the whole complex type. Memory is forced to allocate when pointers
+       * are set to NULL, so we emulate that part of fMustAlloc=TRUE by
+       * clearing the memory we pass in to the unmarshaller */
+      memset(pMemory, 0, size);
+    m = NdrUnmarshaller[*desc & NDR_TABLE_MASK];
+    if (m)
+    {
+      /* for some reason interface pointers aren't generated as
+       * RPC_FC_POINTER, but instead as RPC_FC_EMBEDDED_COMPLEX, yet
+       * they still need the derefencing treatment that pointers are
+       * given */
+      if (*desc == RPC_FC_IP)
+        m(pStubMsg, (unsigned char **)pMemory, desc, FALSE);
       else
-        pFormat += 4;
-      pMemory += sizeof(void *);
-      break;
+        m(pStubMsg, &pMemory, desc, FALSE);
     }
-    case RPC_FC_ALIGNM2:
-      align_pointer_clear(&pMemory, 2);
-      break;
-    case RPC_FC_ALIGNM4:
-      align_pointer_clear(&pMemory, 4);
+    else FIXME("no unmarshaller for embedded type %02x\n", *desc);
+    pMemory += size;
+    *ppFormat = pFormat + 2;
+    return pMemory;
+  case RPC_FC_PAD:
+    break;
+  default:
+    FIXME("unhandled format %d\n", *pFormat);
+  }
+
+  *ppFormat = pFormat + 1;
+  *ppPointer = pPointer;
+  return pMemory;
+}
+
+static unsigned char *complex_plan_unmarshall(PMIDL_STUB_MESSAGE pStubMsg,
+                                              unsigned char *pMemory,
+                                              const struct complex_plan *plan,
+                                              unsigned char fMustAlloc)
+{
+  const struct complex_op *op, *end = plan->ops + plan->op_count;
+
+  for (op = plan->ops; op < end; op++)
+  {
+    switch (op->type)
+    {
+    case COMPLEX_OP_COPY:
+      safe_copy_from_buffer(pStubMsg, pMemory, op->size);
+      TRACE("%u bytes => %p\n", op->size, pMemory);
+      pMemory += op->size;
       break;
-    case RPC_FC_ALIGNM8:
-      align_pointer_clear(&pMemory, 8);
+    case COMPLEX_OP_SKIP:
+      memset(pMemory, 0, op->size);
+      pMemory += op->size;
       break;
-    case RPC_FC_STRUCTPAD1:
-    case RPC_FC_STRUCTPAD2:
-    case RPC_FC_STRUCTPAD3:
-    case RPC_FC_STRUCTPAD4:
-    case RPC_FC_STRUCTPAD5:
-    case RPC_FC_STRUCTPAD6:
-    case RPC_FC_STRUCTPAD7:
-      memset(pMemory, 0, *pFormat - RPC_FC_STRUCTPAD1 + 1);
-      pMemory += *pFormat - RPC_FC_STRUCTPAD1 + 1;
+    case COMPLEX_OP_ALIGN:
+      align_pointer_clear(&pMemory, op->size);
       break;
-    case RPC_FC_EMBEDDED_COMPLEX:
-      pMemory += pFormat[1];
-      pFormat += 2;
-      desc = pFormat + *(const SHORT*)pFormat;
-      size = EmbeddedComplexSize(pStubMsg, desc);
-      TRACE("embedded complex (size=%d) => %p\n", size, pMemory);
-      if (fMustAlloc)
-        /* we can't pass fMustAlloc=TRUE into the marshaller for this type
-         * since the type is part of the memory block that is encompassed by
-         * the whole complex type. Memory is forced to allocate when pointers
-         * are set to NULL, so we emulate that part of fMustAlloc=TRUE by
-         * clearing the memory we pass in to the unmarshaller */
-        memset(pMemory, 0, size);
-      m = NdrUnmarshaller[*desc & NDR_TABLE_MASK];
-      if (m)
-      {
-        /* for some reason interface pointers aren't generated as
-         * RPC_FC_POINTER, but instead as RPC_FC_EMBEDDED_COMPLEX, yet
-         * they still need the derefencing treatment that pointers are
-         * given */
-        if (*desc == RPC_FC_IP)
-          m(pStubMsg, (unsigned char **)pMemory, desc, FALSE);
-        else
-          m(pStubMsg, &pMemory, desc, FALSE);
-      }
-      else FIXME("no unmarshaller for embedded type %02x\n", *desc);
-      pMemory += size;
-      pFormat += 2;
-      continue;
-    case RPC_FC_PAD:
+    case COMPLEX_OP_MEMBER:
+    {
+      PFORMAT_STRING format = op->format, pointer = op->pointer;
+      pMemory = ComplexUnmarshallMember(pStubMsg, pMemory, &format, &pointer, fMustAlloc);
       break;
-    default:
-      FIXME("unhandled format %d\n", *pFormat);
     }
-    pFormat++;
+    }
   }
 
   return pMemory;
 }
 
-static unsigned char * ComplexBufferSize(PMIDL_STUB_MESSAGE pStubMsg,
+static unsigned char * ComplexUnmarshall(PMIDL_STUB_MESSAGE pStubMsg,
                                          unsigned char *pMemory,
                                          PFORMAT_STRING pFormat,
-                                         PFORMAT_STRING pPointer)
+                                         PFORMAT_STRING pPointer,
+                                         unsigned char fMustAlloc)
+{
+  const struct complex_plan *plan = get_complex_plan(pFormat, pPointer);
+
+  if (plan)
+    return complex_plan_unmarshall(pStubMsg, pMemory, plan, fMustAlloc);
+
+  while (*pFormat != RPC_FC_END)
+    pMemory = ComplexUnmarshallMember(pStubMsg, pMemory, &pFormat, &pPointer, fMustAlloc);
+
+  return pMemory;
+}
+
+static unsigned char *ComplexBufferSizeMember(PMIDL_STUB_MESSAGE pStubMsg,
+                                              unsigned char *pMemory,
+                                              PFORMAT_STRING *ppFormat,
+                                              PFORMAT_STRING *ppPointer)
 {
   PFORMAT_STRING desc;
   NDR_BUFFERSIZE m;
   ULONG size;
+  PFORMAT_STRING pFormat = *ppFormat;
+  PFORMAT_STRING pPointer = *ppPointer;
 
-  while (*pFormat != RPC_FC_END) {
-    switch (*pFormat) {
-    case RPC_FC_BYTE:
-    case RPC_FC_CHAR:
-    case RPC_FC_SMALL:
-    case RPC_FC_USMALL:
-      safe_buffer_length_increment(pStubMsg, 1);
-      pMemory += 1;
-      break;
-    case RPC_FC_WCHAR:
-    case RPC_FC_SHORT:
-    case RPC_FC_USHORT:
-      safe_buffer_length_increment(pStubMsg, 2);
-      pMemory += 2;
-      break;
-    case RPC_FC_ENUM16:
-      safe_buffer_length_increment(pStubMsg, 2);
-      pMemory += 4;
-      break;
-    case RPC_FC_LONG:
-    case RPC_FC_ULONG:
-    case RPC_FC_ENUM32:
-    case RPC_FC_FLOAT:
-      safe_buffer_length_increment(pStubMsg, 4);
-      pMemory += 4;
-      break;
-    case RPC_FC_INT3264:
-    case RPC_FC_UINT3264:
+  switch (*pFormat) {
+  case RPC_FC_BYTE:
+  case RPC_FC_CHAR:
+  case RPC_FC_SMALL:
+  case RPC_FC_USMALL:
+    safe_buffer_length_increment(pStubMsg, 1);
+    pMemory += 1;
+    break;
+  case RPC_FC_WCHAR:
+  case RPC_FC_SHORT:
+  case RPC_FC_USHORT:
+    safe_buffer_length_increment(pStubMsg, 2);
+    pMemory += 2;
+    break;
+  case RPC_FC_ENUM16:
+    safe_buffer_length_increment(pStubMsg, 2);
+    pMemory += 4;
+    break;
+  case RPC_FC_LONG:
+  case RPC_FC_ULONG:
+  case RPC_FC_ENUM32:
+  case RPC_FC_FLOAT:
+    safe_buffer_length_increment(pStubMsg, 4);
+    pMemory += 4;
+    break;
+  case RPC_FC_INT3264:
+  case RPC_FC_UINT3264:
+    safe_buffer_length_increment(pStubMsg, 4);
+    pMemory += sizeof(INT_PTR);
+    break;
+  case RPC_FC_HYPER:
+  case RPC_FC_DOUBLE:
+    safe_buffer_length_increment(pStubMsg, 8);
+    pMemory += 8;
+    break;
+  case RPC_FC_RP:
+  case RPC_FC_UP:
+  case RPC_FC_OP:
+  case RPC_FC_FP:
+  case RPC_FC_POINTER:
+    if (*pFormat != RPC_FC_POINTER)
+      pPointer = pFormat;
+    if (!pStubMsg->IgnoreEmbeddedPointers)
+    {
+      int saved_buffer_length = pStubMsg->BufferLength;
+      pStubMsg->BufferLength = pStubMsg->PointerLength;
+      pStubMsg->PointerLength = 0;
+      if(!pStubMsg->BufferLength)
+        ERR("BufferLength == 0??\n");
+      PointerBufferSize(pStubMsg, *(unsigned char**)pMemory, pPointer);
+      pStubMsg->PointerLength = pStubMsg->BufferLength;
+      pStubMsg->BufferLength = saved_buffer_length;
+    }
+    if (*pPointer != RPC_FC_RP)
+    {
+      align_length(&pStubMsg->BufferLength, 4);
       safe_buffer_length_increment(pStubMsg, 4);
-      pMemory += sizeof(INT_PTR);
-      break;
-    case RPC_FC_HYPER:
-    case RPC_FC_DOUBLE:
-      safe_buffer_length_increment(pStubMsg, 8);
-      pMemory += 8;
-      break;
-    case RPC_FC_RP:
-    case RPC_FC_UP:
-    case RPC_FC_OP:
-    case RPC_FC_FP:
-    case RPC_FC_POINTER:
-      if (*pFormat != RPC_FC_POINTER)
-        pPointer = pFormat;
-      if (!pStubMsg->IgnoreEmbeddedPointers)
-      {
-        int saved_buffer_length = pStubMsg->BufferLength;
-        pStubMsg->BufferLength = pStubMsg->PointerLength;
-        pStubMsg->PointerLength = 0;
-        if(!pStubMsg->BufferLength)
-          ERR("BufferLength == 0??\n");
-        PointerBufferSize(pStubMsg, *(unsigned char**)pMemory, pPointer);
-        pStubMsg->PointerLength = pStubMsg->BufferLength;
-        pStubMsg->BufferLength = saved_buffer_length;
-      }
-      if (*pPointer != RPC_FC_RP)
-      {
-        align_length(&pStubMsg->BufferLength, 4);
-        safe_buffer_length_increment(pStubMsg, 4);
-      }
-      if (*pFormat == RPC_FC_POINTER)
-        pPointer += 4;
+    }
+    if (*pFormat == RPC_FC_POINTER)
+      pPointer += 4;
+    else
+      pFormat += 4;
+    pMemory += sizeof(void*);
+    break;
+  case RPC_FC_ALIGNM2:
+    align_pointer(&pMemory, 2);
+    break;
+  case RPC_FC_ALIGNM4:
+    align_pointer(&pMemory, 4);
+    break;
+  case RPC_FC_ALIGNM8:
+    align_pointer(&pMemory, 8);
+    break;
+  case RPC_FC_STRUCTPAD1:
+  case RPC_FC_STRUCTPAD2:
+  case RPC_FC_STRUCTPAD3:
+  case RPC_FC_STRUCTPAD4:
+  case RPC_FC_STRUCTPAD5:
+  case RPC_FC_STRUCTPAD6:
+  case RPC_FC_STRUCTPAD7:
+    pMemory += *pFormat - RPC_FC_STRUCTPAD1 + 1;
+    break;
+  case RPC_FC_EMBEDDED_COMPLEX:
+    pMemory += pFormat[1];
+    pFormat += 2;
+    desc = pFormat + *(const SHORT*)pFormat;
+    size = EmbeddedComplexSize(pStubMsg, desc);
+    m = NdrBufferSizer[*desc & NDR_TABLE_MASK];
+    if (m)
+    {
+      /* for some reason interface pointers aren't generated as
+       * RPC_FC_POINTER, but instead as RPC_FC_EMBEDDED_COMPLEX, yet
+       * they still need the derefencing treatment that pointers are
+       * given */
+      if (*desc == RPC_FC_IP)
+        m(pStubMsg, *(unsigned char **)pMemory, desc);
       else
-        pFormat += 4;
-      pMemory += sizeof(void*);
-      break;
-    case RPC_FC_ALIGNM2:
-      align_pointer(&pMemory, 2);
-      break;
-    case RPC_FC_ALIGNM4:
-      align_pointer(&pMemory, 4);
+        m(pStubMsg, pMemory, desc);
+    }
+    else FIXME("no buffersizer for embedded type %02x\n", *desc);
+    pMemory += size;
+    *ppFormat = pFormat + 2;
+    return pMemory;
+  case RPC_FC_PAD:
+    break;
+  default:
+    FIXME("unhandled format 0x%02x\n", *pFormat);
+  }
+
+  *ppFormat = pFormat + 1;
+  *ppPointer = pPointer;
+  return pMemory;
+}
+
+static unsigned char *complex_plan_buffer_size(PMIDL_STUB_MESSAGE pStubMsg,
+                                               unsigned char *pMemory,
+                                               const struct complex_plan *plan)
+{
+  const struct complex_op *op, *end = plan->ops + plan->op_count;
+
+  for (op = plan->ops; op < end; op++)
+  {
+    switch (op->type)
+    {
+    case COMPLEX_OP_COPY:
+      safe_buffer_length_increment(pStubMsg, op->size);
+      pMemory += op->size;
       break;
-    case RPC_FC_ALIGNM8:
-      align_pointer(&pMemory, 8);
+    case COMPLEX_OP_SKIP:
+      pMemory += op->size;
       break;
-    case RPC_FC_STRUCTPAD1:
-    case RPC_FC_STRUCTPAD2:
-    case RPC_FC_STRUCTPAD3:
-    case RPC_FC_STRUCTPAD4:
-    case RPC_FC_STRUCTPAD5:
-    case RPC_FC_STRUCTPAD6:
-    case RPC_FC_STRUCTPAD7:
-      pMemory += *pFormat - RPC_FC_STRUCTPAD1 + 1;
+    case COMPLEX_OP_ALIGN:
+      align_pointer(&pMemory, op->size);
       break;
-    case RPC_FC_EMBEDDED_COMPLEX:
-      pMemory += pFormat[1];
-      pFormat += 2;
-      desc = pFormat + *(const SHORT*)pFormat;
-      size = EmbeddedComplexSize(pStubMsg, desc);
-      m = NdrBufferSizer[*desc & NDR_TABLE_MASK];
-      if (m)
-      {
-        /* for some reason interface pointers aren't generated as
-         * RPC_FC_POINTER, but instead as RPC_FC_EMBEDDED_COMPLEX, yet
-         * they still need the derefencing treatment that pointers are
-         * given */
-        if (*desc == RPC_FC_IP)
-          m(pStubMsg, *(unsigned char **)pMemory, desc);
-        else
-          m(pStubMsg, pMemory, desc);
-      }
-      else FIXME("no buffersizer for embedded type %02x\n", *desc);
-      pMemory += size;
-      pFormat += 2;
-      continue;
-    case RPC_FC_PAD:
+    case COMPLEX_OP_MEMBER:
+    {
+      PFORMAT_STRING format = op->format, pointer = op->pointer;
+      pMemory = ComplexBufferSizeMember(pStubMsg, pMemory, &format, &pointer);
       break;
-    default:
-      FIXME("unhandled format 0x%02x\n", *pFormat);
     }
-    pFormat++;
+    }
   }
 
   return pMemory;
 }
 
+static unsigned char * ComplexBufferSize(PMIDL_STUB_MESSAGE pStubMsg,
+                                         unsigned char *pMemory,
+                                         PFORMAT_STRING pFormat,
+                                         PFORMAT_STRING pPointer)
+{
+  const struct complex_plan *plan = get_complex_plan(pFormat, pPointer);
+
+  if (plan)
+    return complex_plan_buffer_size(pStubMsg, pMemory, plan);
+
+  while (*pFormat != RPC_FC_END)
+    pMemory = ComplexBufferSizeMember(pStubMsg, pMemory, &pFormat, &pPointer);
+
+  return pMemory;
+}
+
 static unsigned char * ComplexFree(PMIDL_STUB_MESSAGE pStubMsg,
                                    unsigned char *pMemory,
                                    PFORMAT_STRING pFormat,
@@ -3491,9 +3884,13 @@ static ULONG ComplexStructMemorySize(PMIDL_STUB_MESSAGE pStubMsg,
 
 ULONG ComplexStructSize(PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat)
 {
+  const struct complex_plan *plan = get_complex_plan(pFormat, NULL);
   PFORMAT_STRING desc;
   ULONG size = 0;
 
+  if (plan && plan->fixed_size)
+    return plan->memory_size;
+
   while (*pFormat != RPC_FC_END) {
     switch (*pFormat) {
     case RPC_FC_BYTE:
@@ -474,6 +474,492 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *Connection)
     return -1;
 }
 
+/**** ncalrpc shared memory support ****/
+
+/* The named pipe is only used to establish the connection, to pass the
+ * handshake and for impersonation. Packets are then exchanged through a pair
+ * of rings in a section shared by client and server, so that a call only goes
+ * through wineserver when the other side has to be woken up. */
+
+#define LRPC_HELLO_MAGIC 0x4350524c  /* 'LRPC', doesn't start with rpc_ver 5 */
+#define LRPC_RING_SIZE   0x10000     /* must be a power of 2 */
+#define LRPC_SPIN_COUNT  4000
+
+struct lrpc_ring
+{
+  volatile LONG head;           /* total bytes written, only modified by the writer */
+  volatile LONG tail;           /* total bytes read, only modified by the reader */
+  volatile LONG reader_waiting;
+  volatile LONG writer_waiting;
+  volatile LONG closed;
+  LONG pad[11];                 /* keep the indexes away from the data */
+  char data[LRPC_RING_SIZE];
+};
+
+struct lrpc_shared
+{
+  struct lrpc_ring to_server;
+  struct lrpc_ring to_client;
+};
+
+struct lrpc_hello
+{
+  DWORD magic;
+  DWORD process_id;
+  char name[32];                /* base name of the section and events, empty to use the pipe */
+};
+
+struct lrpc_hello_reply
+{
+  DWORD magic;
+  DWORD status;
+  DWORD process_id;
+};
+
+typedef struct _RpcConnection_lrpc
+{
+  RpcConnection_np np;
+  BOOL handshake_done;
+  struct lrpc_shared *shared;   /* NULL when packets go through the pipe */
+  struct lrpc_ring *in;
+  struct lrpc_ring *out;
+  HANDLE mapping;
+  HANDLE event;                 /* signalled when this side must wake up */
+  HANDLE peer_event;
+  HANDLE peer_process;
+  LONG cancelled;
+  char *pending;                /* data read from the pipe during the handshake */
+  unsigned int pending_size;
+} RpcConnection_lrpc;
+
+static unsigned int lrpc_spin_count = ~0u;
+
+static inline void lrpc_small_pause(void)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __asm__ __volatile__( "rep;nop" : : : "memory" );
+#elif defined(__GNUC__)
+  __asm__ __volatile__( "" : : : "memory" );
+#endif
+}
+
+/* keeps the accesses to the ring data on the right side of the index updates:
+ * the data must be read after seeing the new head, and completely read or
+ * written before the new tail or head is published to the other process */
+static inline void lrpc_memory_barrier(void)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  /* x86 doesn't reorder loads with loads or stores with older loads and stores */
+  __asm__ __volatile__( "" : : : "memory" );
+#elif defined(__GNUC__)
+  __sync_synchronize();
+#else
+  LONG dummy;
+  InterlockedExchange(&dummy, 0);
+#endif
+}
+
+static RpcConnection *rpcrt4_conn_lrpc_alloc(void)
+{
+  RpcConnection_lrpc *lrpc = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(RpcConnection_lrpc));
+  if (lrpc_spin_count == ~0u)
+  {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    /* spinning only helps if the other side can run at the same time */
+    lrpc_spin_count = si.dwNumberOfProcessors > 1 ? LRPC_SPIN_COUNT : 0;
+  }
+  return &lrpc->np.common;
+}
+
+static void rpcrt4_conn_lrpc_destroy_channel(RpcConnection_lrpc *lrpc)
+{
+  if (lrpc->shared)
+  {
+    InterlockedExchange(&lrpc->shared->to_server.closed, TRUE);
+    InterlockedExchange(&lrpc->shared->to_client.closed, TRUE);
+    if (lrpc->peer_event) SetEvent(lrpc->peer_event);
+    UnmapViewOfFile(lrpc->shared);
+    lrpc->shared = NULL;
+    lrpc->in = lrpc->out = NULL;
+  }
+  if (lrpc->mapping) CloseHandle(lrpc->mapping);
+  if (lrpc->event) CloseHandle(lrpc->event);
+  if (lrpc->peer_event) CloseHandle(lrpc->peer_event);
+  if (lrpc->peer_process) CloseHandle(lrpc->peer_process);
+  lrpc->mapping = lrpc->event = lrpc->peer_event = lrpc->peer_process = 0;
+}
+
+static BOOL rpcrt4_conn_lrpc_map(RpcConnection_lrpc *lrpc, BOOL server)
+{
+  lrpc->shared = MapViewOfFile(lrpc->mapping, FILE_MAP_WRITE, 0, 0, sizeof(struct lrpc_shared));
+  if (!lrpc->shared)
+    return FALSE;
+  lrpc->in = server ? &lrpc->shared->to_server : &lrpc->shared->to_client;
+  lrpc->out = server ? &lrpc->shared->to_client : &lrpc->shared->to_server;
+  return TRUE;
+}
+
+/* client side: create the shared objects and pass their name to the server */
+static RPC_STATUS rpcrt4_conn_lrpc_client_handshake(RpcConnection_lrpc *lrpc)
+{
+  static LONG lrpc_channel_id;
+  struct lrpc_hello hello;
+  struct lrpc_hello_reply reply;
+  char name[48];
+  DWORD len;
+
+  memset(&hello, 0, sizeof(hello));
+  hello.magic = LRPC_HELLO_MAGIC;
+  hello.process_id = GetCurrentProcessId();
+  snprintf(hello.name, sizeof(hello.name), "__wine_lrpc_%08x_%08x",
+           hello.process_id, InterlockedIncrement(&lrpc_channel_id));
+
+  lrpc->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                     sizeof(struct lrpc_shared), hello.name);
+  sprintf(name, "%s_c", hello.name);
+  lrpc->event = CreateEventA(NULL, FALSE, FALSE, name);
+  sprintf(name, "%s_s", hello.name);
+  lrpc->peer_event = CreateEventA(NULL, FALSE, FALSE, name);
+  if (!lrpc->mapping || !lrpc->event || !lrpc->peer_event || !rpcrt4_conn_lrpc_map(lrpc, FALSE))
+  {
+    WARN("couldn't create shared memory channel, error %u\n", GetLastError());
+    rpcrt4_conn_lrpc_destroy_channel(lrpc);
+    hello.name[0] = 0;
+  }
+
+  if (!WriteFile(lrpc->np.pipe, &hello, sizeof(hello), &len, NULL) || len != sizeof(hello))
+  {
+    rpcrt4_conn_lrpc_destroy_channel(lrpc);
+    return RPC_S_SERVER_UNAVAILABLE;
+  }
+  if (!hello.name[0])
+    return RPC_S_OK;
+
+  if (!ReadFile(lrpc->np.pipe, &reply, sizeof(reply), &len, NULL) || len != sizeof(reply) ||
+      reply.magic != LRPC_HELLO_MAGIC)
+  {
+    rpcrt4_conn_lrpc_destroy_channel(lrpc);
+    return RPC_S_SERVER_UNAVAILABLE;
+  }
+  if (reply.status == RPC_S_OK)
+    lrpc->peer_process = OpenProcess(SYNCHRONIZE, FALSE, reply.process_id);
+  if (!lrpc->peer_process)
+  {
+    TRACE("server refused shared memory channel, status %u\n", reply.status);
+    rpcrt4_conn_lrpc_destroy_channel(lrpc);
+  }
+  else
+    TRACE("using shared memory channel %s\n", hello.name);
+  return RPC_S_OK;
+}
+
+/* server side: receive the hello sent by the client on connection */
+static BOOL rpcrt4_conn_lrpc_server_handshake(RpcConnection_lrpc *lrpc)
+{
+  struct lrpc_hello hello;
+  struct lrpc_hello_reply reply;
+  char name[48];
+  DWORD len;
+
+  lrpc->handshake_done = TRUE;
+
+  if (!ReadFile(lrpc->np.pipe, &hello, sizeof(hello), &len, NULL) &&
+      GetLastError() != ERROR_MORE_DATA)
+    return FALSE;
+
+  if (len != sizeof(hello) || hello.magic != LRPC_HELLO_MAGIC)
+  {
+    /* not one of our clients, keep what we read for the packet reader */
+    lrpc->pending = HeapAlloc(GetProcessHeap(), 0, len);
+    if (!lrpc->pending)
+      return FALSE;
+    memcpy(lrpc->pending, &hello, len);
+    lrpc->pending_size = len;
+    return TRUE;
+  }
+  if (!hello.name[0])
+    return TRUE;
+  hello.name[sizeof(hello.name) - 1] = 0;
+
+  lrpc->mapping = OpenFileMappingA(FILE_MAP_WRITE, FALSE, hello.name);
+  sprintf(name, "%s_s", hello.name);
+  lrpc->event = OpenEventA(EVENT_MODIFY_STATE|SYNCHRONIZE, FALSE, name);
+  sprintf(name, "%s_c", hello.name);
+  lrpc->peer_event = OpenEventA(EVENT_MODIFY_STATE|SYNCHRONIZE, FALSE, name);
+  lrpc->peer_process = OpenProcess(SYNCHRONIZE, FALSE, hello.process_id);
+
+  reply.magic = LRPC_HELLO_MAGIC;
+  reply.status = RPC_S_OK;
+  reply.process_id = GetCurrentProcessId();
+  if (!lrpc->mapping || !lrpc->event || !lrpc->peer_event || !lrpc->peer_process ||
+      !rpcrt4_conn_lrpc_map(lrpc, TRUE))
+  {
+    WARN("couldn't open shared memory channel %s, error %u\n", debugstr_a(hello.name), GetLastError());
+    rpcrt4_conn_lrpc_destroy_channel(lrpc);
+    reply.status = RPC_S_OUT_OF_RESOURCES;
+  }
+  if (!WriteFile(lrpc->np.pipe, &reply, sizeof(reply), &len, NULL) || len != sizeof(reply))
+  {
+    rpcrt4_conn_lrpc_destroy_channel(lrpc);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static BOOL rpcrt4_conn_lrpc_ready(RpcConnection_lrpc *lrpc)
+{
+  if (lrpc->handshake_done)
+    return TRUE;
+  return rpcrt4_conn_lrpc_server_handshake(lrpc);
+}
+
+/* returns FALSE if the peer went away or the call was cancelled */
+static BOOL rpcrt4_conn_lrpc_sleep(RpcConnection_lrpc *lrpc)
+{
+  HANDLE handles[2];
+  DWORD res;
+
+  handles[0] = lrpc->event;
+  handles[1] = lrpc->peer_process;
+  res = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+  if (res != WAIT_OBJECT_0)
+  {
+    TRACE("peer is gone (%u)\n", res);
+    return FALSE;
+  }
+  if (InterlockedExchange(&lrpc->cancelled, FALSE))
+  {
+    TRACE("call cancelled\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* returns the number of bytes that can be read from the ring, or -1 */
+static int rpcrt4_conn_lrpc_wait_readable(RpcConnection_lrpc *lrpc, struct lrpc_ring *ring)
+{
+  unsigned int spin = lrpc_spin_count;
+  ULONG avail;
+  BOOL ret;
+
+  for (;;)
+  {
+    if ((avail = (ULONG)ring->head - (ULONG)ring->tail))
+    {
+      lrpc_memory_barrier();  /* acquire: the data is read after the head */
+      return avail;
+    }
+    if (ring->closed)
+      return -1;
+    if (spin)
+    {
+      spin--;
+      lrpc_small_pause();
+      continue;
+    }
+    InterlockedExchange(&ring->reader_waiting, TRUE);
+    if ((ULONG)ring->head != (ULONG)ring->tail || ring->closed)
+    {
+      ring->reader_waiting = FALSE;
+      continue;
+    }
+    ret = rpcrt4_conn_lrpc_sleep(lrpc);
+    ring->reader_waiting = FALSE;
+    if (!ret)
+      return -1;
+  }
+}
+
+/* returns the number of bytes that can be written to the ring, or -1 */
+static int rpcrt4_conn_lrpc_wait_writable(RpcConnection_lrpc *lrpc, struct lrpc_ring *ring)
+{
+  unsigned int spin = lrpc_spin_count;
+  ULONG space;
+  BOOL ret;
+
+  for (;;)
+  {
+    if (ring->closed)
+      return -1;
+    if ((space = LRPC_RING_SIZE - ((ULONG)ring->head - (ULONG)ring->tail)))
+    {
+      lrpc_memory_barrier();  /* acquire: the freed data is overwritten after the tail */
+      return space;
+    }
+    if (spin)
+    {
+      spin--;
+      lrpc_small_pause();
+      continue;
+    }
+    InterlockedExchange(&ring->writer_waiting, TRUE);
+    if ((ULONG)ring->head - (ULONG)ring->tail != LRPC_RING_SIZE || ring->closed)
+    {
+      ring->writer_waiting = FALSE;
+      continue;
+    }
+    ret = rpcrt4_conn_lrpc_sleep(lrpc);
+    ring->writer_waiting = FALSE;
+    if (!ret)
+      return -1;
+  }
+}
+
+static int rpcrt4_conn_lrpc_read(RpcConnection *Connection,
+                                 void *buffer, unsigned int count)
+{
+  RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *) Connection;
+  struct lrpc_ring *ring = lrpc->in;
+  char *buf = buffer;
+  unsigned int bytes_left = count;
+
+  if (!rpcrt4_conn_lrpc_ready(lrpc))
+    return -1;
+
+  if (lrpc->pending)
+  {
+    unsigned int len = min(bytes_left, lrpc->pending_size);
+    memcpy(buf, lrpc->pending, len);
+    lrpc->pending_size -= len;
+    memmove(lrpc->pending, lrpc->pending + len, lrpc->pending_size);
+    if (!lrpc->pending_size)
+    {
+      HeapFree(GetProcessHeap(), 0, lrpc->pending);
+      lrpc->pending = NULL;
+    }
+    bytes_left -= len;
+    buf += len;
+    if (!bytes_left)
+      return count;
+  }
+
+  if (!lrpc->shared)
+    return rpcrt4_conn_np_read(Connection, buf, bytes_left) == -1 ? -1 : count;
+
+  while (bytes_left)
+  {
+    ULONG tail = ring->tail, offset = tail & (LRPC_RING_SIZE - 1);
+    int avail = rpcrt4_conn_lrpc_wait_readable(lrpc, ring);
+    unsigned int len;
+
+    if (avail == -1)
+      return -1;
+    len = min(bytes_left, (unsigned int)avail);
+    if (len > LRPC_RING_SIZE - offset)
+    {
+      memcpy(buf, ring->data + offset, LRPC_RING_SIZE - offset);
+      memcpy(buf + LRPC_RING_SIZE - offset, ring->data, len - (LRPC_RING_SIZE - offset));
+    }
+    else
+      memcpy(buf, ring->data + offset, len);
+    lrpc_memory_barrier();  /* release: the data is copied before the space is freed */
+    InterlockedExchange(&ring->tail, tail + len);
+    if (ring->writer_waiting)
+      SetEvent(lrpc->peer_event);
+    bytes_left -= len;
+    buf += len;
+  }
+  return count;
+}
+
+static int rpcrt4_conn_lrpc_write(RpcConnection *Connection,
+                                  const void *buffer, unsigned int count)
+{
+  RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *) Connection;
+  struct lrpc_ring *ring = lrpc->out;
+  const char *buf = buffer;
+  unsigned int bytes_left = count;
+
+  if (!rpcrt4_conn_lrpc_ready(lrpc))
+    return -1;
+
+  if (!lrpc->shared)
+    return rpcrt4_conn_np_write(Connection, buffer, count);
+
+  while (bytes_left)
+  {
+    ULONG head = ring->head, offset = head & (LRPC_RING_SIZE - 1);
+    int space = rpcrt4_conn_lrpc_wait_writable(lrpc, ring);
+    unsigned int len;
+
+    if (space == -1)
+      return -1;
+    len = min(bytes_left, (unsigned int)space);
+    if (len > LRPC_RING_SIZE - offset)
+    {
+      memcpy(ring->data + offset, buf, LRPC_RING_SIZE - offset);
+      memcpy(ring->data, buf + LRPC_RING_SIZE - offset, len - (LRPC_RING_SIZE - offset));
+    }
+    else
+      memcpy(ring->data + offset, buf, len);
+    lrpc_memory_barrier();  /* release: the data is visible before the new head */
+    InterlockedExchange(&ring->head, head + len);
+    if (ring->reader_waiting)
+      SetEvent(lrpc->peer_event);
+    bytes_left -= len;
+    buf += len;
+  }
+  return count;
+}
+
+static RPC_STATUS rpcrt4_conn_lrpc_open(RpcConnection* Connection)
+{
+  RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *) Connection;
+  RPC_STATUS r;
+
+  /* already connected? */
+  if (lrpc->np.pipe)
+    return RPC_S_OK;
+
+  r = rpcrt4_ncalrpc_open(Connection);
+  if (r != RPC_S_OK)
+    return r;
+
+  lrpc->handshake_done = TRUE;
+  r = rpcrt4_conn_lrpc_client_handshake(lrpc);
+  if (r != RPC_S_OK)
+    rpcrt4_conn_np_close(Connection);
+  return r;
+}
+
+static int rpcrt4_conn_lrpc_close(RpcConnection *Connection)
+{
+  RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *) Connection;
+
+  rpcrt4_conn_lrpc_destroy_channel(lrpc);
+  HeapFree(GetProcessHeap(), 0, lrpc->pending);
+  lrpc->pending = NULL;
+  lrpc->pending_size = 0;
+  lrpc->handshake_done = FALSE;
+  return rpcrt4_conn_np_close(Connection);
+}
+
+static void rpcrt4_conn_lrpc_cancel_call(RpcConnection *Connection)
+{
+  RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *) Connection;
+
+  TRACE("%p\n", Connection);
+
+  if (!lrpc->shared)
+    return;
+  InterlockedExchange(&lrpc->cancelled, TRUE);
+  SetEvent(lrpc->event);
+}
+
+static int rpcrt4_conn_lrpc_wait_for_incoming_data(RpcConnection *Connection)
+{
+  RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *) Connection;
+
+  TRACE("%p\n", Connection);
+
+  if (!lrpc->shared)
+    return rpcrt4_conn_np_wait_for_incoming_data(Connection);
+  if (rpcrt4_conn_lrpc_wait_readable(lrpc, lrpc->in) == -1)
+    return -1;
+  return 0;
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -2794,14 +3280,14 @@ static const struct connection_ops conn_protseq_list[] = {
   },
   { "ncalrpc",
     { EPM_PROTOCOL_NCALRPC, EPM_PROTOCOL_PIPE },
-    rpcrt4_conn_np_alloc,
-    rpcrt4_ncalrpc_open,
+    rpcrt4_conn_lrpc_alloc,
+    rpcrt4_conn_lrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_cancel_call,
-    rpcrt4_conn_np_wait_for_incoming_data,
+    rpcrt4_conn_lrpc_read,
+    rpcrt4_conn_lrpc_write,
+    rpcrt4_conn_lrpc_close,
+    rpcrt4_conn_lrpc_cancel_call,
+    rpcrt4_conn_lrpc_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
     NULL,
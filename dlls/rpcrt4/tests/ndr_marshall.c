@@ -2075,6 +2075,132 @@ cleanup:
     HeapFree(GetProcessHeap(), 0, memsrc.array);
 }
 
+static void test_complex_struct_array(void)
+{
+    RPC_MESSAGE RpcMessage;
+    MIDL_STUB_MESSAGE StubMsg;
+    MIDL_STUB_DESC StubDesc;
+    void *ptr;
+    unsigned int i, pass;
+    struct complex_member
+    {
+        double d;
+        unsigned int l;
+        unsigned int pad;
+        unsigned int l2;
+        short s;
+        int e;
+        unsigned char c;
+    };
+    struct complex_member memsrc[10], *mem;
+    unsigned char wiredata[9 * 24 + 21], *p;
+    WORD e16;
+
+    static const unsigned char fmtstr_complex_struct_array[] =
+    {
+/*  0 */        0x1a,           /* FC_BOGUS_STRUCT */
+                0x7,            /* 7 */
+/*  2 */        NdrFcShort( 0x20 ),     /* 32 */
+/*  4 */        NdrFcShort( 0x0 ),      /* 0 */
+/*  6 */        NdrFcShort( 0x0 ),      /* Offset= 0 (6) */
+/*  8 */        0xc,            /* FC_DOUBLE */
+                0x8,            /* FC_LONG */
+/* 10 */        0x40,           /* FC_STRUCTPAD4 */
+                0x8,            /* FC_LONG */
+/* 12 */        0x6,            /* FC_SHORT */
+                0x38,           /* FC_ALIGNM4 */
+/* 14 */        0xd,            /* FC_ENUM16 */
+                0x1,            /* FC_BYTE */
+/* 16 */        0x5c,           /* FC_PAD */
+                0x5b,           /* FC_END */
+/* 18 */
+                0x21,           /* FC_BOGUS_ARRAY */
+                0x7,            /* 7 */
+/* 20 */        NdrFcShort( 0xa ),      /* 10 */
+/* 22 */        NdrFcLong( 0xffffffff ),        /* -1 */
+/* 26 */        NdrFcLong( 0xffffffff ),        /* -1 */
+/* 30 */        0x4c,           /* FC_EMBEDDED_COMPLEX */
+                0x0,            /* 0 */
+/* 32 */        NdrFcShort( 0xffe0 ),   /* Offset= -32 (0) */
+/* 34 */        0x5c,           /* FC_PAD */
+                0x5b,           /* FC_END */
+    };
+
+    /* every member is naturally aligned on the wire, and each element
+     * starts on an 8 byte boundary */
+    memset(wiredata, 0, sizeof(wiredata));
+    for (i = 0; i < 10; i++)
+    {
+        memsrc[i].d = i * 0.25;
+        memsrc[i].l = 0x01020304 * i;
+        memsrc[i].pad = 0;
+        memsrc[i].l2 = 0xdeadbeef ^ i;
+        memsrc[i].s = -(short)i;
+        memsrc[i].e = 100 + i;
+        memsrc[i].c = 'a' + i;
+
+        p = wiredata + 24 * i;
+        memcpy(p, &memsrc[i].d, 8);
+        memcpy(p + 8, &memsrc[i].l, 4);
+        memcpy(p + 12, &memsrc[i].l2, 4);
+        memcpy(p + 16, &memsrc[i].s, 2);
+        e16 = memsrc[i].e;
+        memcpy(p + 18, &e16, 2);
+        p[20] = memsrc[i].c;
+    }
+
+    StubDesc = Object_StubDesc;
+    StubDesc.pFormatTypes = fmtstr_complex_struct_array;
+
+    /* run twice, so that a format string that has been seen before gives
+     * the same result as the first time */
+    for (pass = 0; pass < 2; pass++)
+    {
+        NdrClientInitializeNew(
+                               &RpcMessage,
+                               &StubMsg,
+                               &StubDesc,
+                               0);
+
+        StubMsg.BufferLength = 0;
+        NdrComplexArrayBufferSize( &StubMsg,
+                                   (unsigned char *)memsrc,
+                                   &fmtstr_complex_struct_array[18] );
+        ok(StubMsg.BufferLength >= sizeof(wiredata), "pass %u: length %d\n", pass, StubMsg.BufferLength);
+
+        StubMsg.RpcMsg->Buffer = StubMsg.BufferStart = StubMsg.Buffer =
+            HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, StubMsg.BufferLength);
+        StubMsg.BufferEnd = StubMsg.BufferStart + StubMsg.BufferLength;
+
+        ptr = NdrComplexArrayMarshall( &StubMsg, (unsigned char *)memsrc,
+                                       &fmtstr_complex_struct_array[18] );
+        ok(ptr == NULL, "pass %u: ret %p\n", pass, ptr);
+        ok(StubMsg.Buffer - StubMsg.BufferStart == sizeof(wiredata), "pass %u: length %d\n",
+           pass, (int)(StubMsg.Buffer - StubMsg.BufferStart));
+        ok(!memcmp(StubMsg.BufferStart, wiredata, sizeof(wiredata)), "pass %u: incorrectly marshaled\n", pass);
+
+        /* Server */
+        StubMsg.IsClient = 0;
+        mem = NULL;
+        StubMsg.Buffer = StubMsg.BufferStart;
+        ptr = NdrComplexArrayUnmarshall( &StubMsg, (unsigned char **)&mem, &fmtstr_complex_struct_array[18], 0);
+        ok(ptr == NULL, "pass %u: ret %p\n", pass, ptr);
+        ok(mem != NULL, "pass %u: memory not allocated\n", pass);
+        for (i = 0; mem && i < 10; i++)
+        {
+            ok(mem[i].d == memsrc[i].d, "pass %u: mem[%u].d = %f\n", pass, i, mem[i].d);
+            ok(mem[i].l == memsrc[i].l, "pass %u: mem[%u].l = %08x\n", pass, i, mem[i].l);
+            ok(mem[i].l2 == memsrc[i].l2, "pass %u: mem[%u].l2 = %08x\n", pass, i, mem[i].l2);
+            ok(mem[i].s == memsrc[i].s, "pass %u: mem[%u].s = %d\n", pass, i, mem[i].s);
+            ok(mem[i].e == memsrc[i].e, "pass %u: mem[%u].e = %d\n", pass, i, mem[i].e);
+            ok(mem[i].c == memsrc[i].c, "pass %u: mem[%u].c = %u\n", pass, i, mem[i].c);
+        }
+        if (mem) StubMsg.pfnFree(mem);
+
+        HeapFree(GetProcessHeap(), 0, StubMsg.RpcMsg->Buffer);
+    }
+}
+
 static void test_ndr_buffer(void)
 {
     static unsigned char ncalrpc[] = "ncalrpc";
@@ -2420,6 +2546,7 @@ START_TEST( ndr_marshall )
     test_nonconformant_string();
     test_conf_complex_struct();
     test_conf_complex_array();
+    test_complex_struct_array();
     test_ndr_buffer();
     test_NdrMapCommAndFaultStatus();
     test_NdrGetUserMarshalInfo();
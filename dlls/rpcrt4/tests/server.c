@@ -756,6 +756,17 @@ void __cdecl s_full_pointer_null_test(int *a, int *b)
     ok(b == NULL, "Expected b to be NULL instead of %p\n", b);
 }
 
+void __cdecl s_slow_call(int ms)
+{
+  Sleep(ms);
+}
+
+void __cdecl s_crash(void)
+{
+  /* only called on the server started by server_death_test */
+  ExitProcess(0);
+}
+
 void __cdecl s_stop(void)
 {
   ok(RPC_S_OK == RpcMgmtStopServerListening(NULL), "RpcMgmtStopServerListening\n");
@@ -1457,6 +1468,152 @@ run_tests(void)
   context_handle_test();
 }
 
+static void
+latency_test(const char *protseq)
+{
+  static const int count = 2000;
+  DWORD start, elapsed;
+  int i, failures = 0;
+
+  start = GetTickCount();
+  for (i = 0; i < count; i++)
+    if (square(i) != i * i) failures++;
+  elapsed = GetTickCount() - start;
+  ok(!failures, "%s: %d calls failed\n", protseq, failures);
+
+  if (winetest_debug > 1)
+    trace("%s: %d calls in %u ms, %.1f us per call\n", protseq, count, elapsed,
+          elapsed * 1000.0 / count);
+}
+
+static DWORD WINAPI
+slow_call_thread(void *arg)
+{
+  RPC_STATUS status = RPC_S_OK;
+
+  /* cancel the call right away instead of waiting for the server */
+  RpcMgmtSetCancelTimeout(0);
+  RpcTryExcept
+  {
+    slow_call(3000);
+  }
+  RpcExcept(TRUE)
+  {
+    status = RpcExceptionCode();
+  }
+  RpcEndExcept
+  return status;
+}
+
+static void
+cancel_test(void)
+{
+  HANDLE thread;
+  DWORD start, ret, status;
+
+  thread = CreateThread(NULL, 0, slow_call_thread, NULL, 0, NULL);
+  ok(thread != NULL, "CreateThread failed: %u\n", GetLastError());
+  Sleep(500);  /* let the call reach the server */
+
+  start = GetTickCount();
+  ok(RPC_S_OK == RpcCancelThread(thread), "RpcCancelThread\n");
+  ret = WaitForSingleObject(thread, 10000);
+  ok(ret == WAIT_OBJECT_0, "thread didn't finish\n");
+  ok(GetTickCount() - start < 2000, "call wasn't cancelled\n");
+  GetExitCodeThread(thread, &status);
+  ok(status != RPC_S_OK, "cancelled call succeeded\n");
+  CloseHandle(thread);
+
+  /* the connection of the cancelled call isn't reused */
+  ok(square(7) == 49, "RPC square\n");
+}
+
+static DWORD WINAPI
+crash_thread(void *arg)
+{
+  RPC_STATUS status = RPC_S_OK;
+
+  RpcTryExcept
+  {
+    crash();
+  }
+  RpcExcept(TRUE)
+  {
+    status = RpcExceptionCode();
+  }
+  RpcEndExcept
+  return status;
+}
+
+static void
+crash_server(void)
+{
+  static unsigned char ncalrpc[] = "ncalrpc";
+  static unsigned char guid[] = "00000000-4114-0704-2301-000000000001";
+  HANDLE ready;
+
+  ok(RPC_S_OK == RpcServerUseProtseqEp(ncalrpc, 0, guid, NULL), "RpcServerUseProtseqEp\n");
+  ok(RPC_S_OK == RpcServerRegisterIf(s_IServer_v0_0_s_ifspec, NULL, NULL), "RpcServerRegisterIf\n");
+  ok(RPC_S_OK == RpcServerListen(1, 20, TRUE), "RpcServerListen\n");
+
+  ready = OpenEventA(EVENT_MODIFY_STATE, FALSE, "wine_rpcrt4_test_crash_server");
+  ok(ready != NULL, "OpenEvent failed: %u\n", GetLastError());
+  SetEvent(ready);
+  CloseHandle(ready);
+
+  /* s_crash ends the process */
+  Sleep(10000);
+}
+
+/* a client must not hang when the server dies in the middle of a call */
+static void
+server_death_test(void)
+{
+  static unsigned char ncalrpc[] = "ncalrpc";
+  static unsigned char guid[] = "00000000-4114-0704-2301-000000000001";
+  RPC_BINDING_HANDLE handle = IServer_IfHandle;
+  PROCESS_INFORMATION info;
+  STARTUPINFOA startup;
+  char cmdline[MAX_PATH];
+  unsigned char *binding;
+  HANDLE ready, thread;
+  DWORD ret, status;
+
+  ready = CreateEventA(NULL, FALSE, FALSE, "wine_rpcrt4_test_crash_server");
+  ok(ready != NULL, "CreateEvent failed: %u\n", GetLastError());
+
+  memset(&startup, 0, sizeof startup);
+  startup.cb = sizeof startup;
+  make_cmdline(cmdline, "ncalrpc_crash_server");
+  ok(CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0L, NULL, NULL, &startup, &info), "CreateProcess\n");
+  ret = WaitForSingleObject(ready, 10000);
+  ok(ret == WAIT_OBJECT_0, "server didn't start\n");
+  CloseHandle(ready);
+
+  ok(RPC_S_OK == RpcStringBindingCompose(NULL, ncalrpc, NULL, guid, NULL, &binding), "RpcStringBindingCompose\n");
+  ok(RPC_S_OK == RpcBindingFromStringBinding(binding, &IServer_IfHandle), "RpcBindingFromStringBinding\n");
+
+  thread = CreateThread(NULL, 0, crash_thread, NULL, 0, NULL);
+  ok(thread != NULL, "CreateThread failed: %u\n", GetLastError());
+  ret = WaitForSingleObject(thread, 5000);
+  ok(ret == WAIT_OBJECT_0, "call to a dead server didn't fail\n");
+  if (ret == WAIT_OBJECT_0)
+  {
+    GetExitCodeThread(thread, &status);
+    ok(status != RPC_S_OK, "call to a dead server succeeded\n");
+  }
+  CloseHandle(thread);
+
+  ok(RPC_S_OK == RpcStringFree(&binding), "RpcStringFree\n");
+  if (ret == WAIT_OBJECT_0)
+    ok(RPC_S_OK == RpcBindingFree(&IServer_IfHandle), "RpcBindingFree\n");
+  IServer_IfHandle = handle;
+
+  winetest_wait_child_process( info.hProcess );
+  CloseHandle(info.hProcess);
+  CloseHandle(info.hThread);
+}
+
 static void
 set_auth_info(RPC_BINDING_HANDLE handle)
 {
@@ -1496,6 +1653,7 @@ client(const char *test)
     ok(RPC_S_OK == RpcBindingFromStringBinding(binding, &IServer_IfHandle), "RpcBindingFromStringBinding\n");
 
     run_tests();
+    latency_test("ncacn_ip_tcp");
     authinfo_test(RPC_PROTSEQ_TCP, 0);
 
     ok(RPC_S_OK == RpcStringFree(&binding), "RpcStringFree\n");
@@ -1518,6 +1676,8 @@ client(const char *test)
     ok(RPC_S_OK == RpcBindingFromStringBinding(binding, &IServer_IfHandle), "RpcBindingFromStringBinding\n");
 
     run_tests(); /* can cause RPC_X_BAD_STUB_DATA exception */
+    latency_test("ncalrpc");
+    cancel_test();
     authinfo_test(RPC_PROTSEQ_LRPC, 0);
 
     ok(RPC_S_OK == RpcStringFree(&binding), "RpcStringFree\n");
@@ -1534,12 +1694,17 @@ client(const char *test)
     ok(RPC_S_OK == RpcStringFree(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IServer_IfHandle), "RpcBindingFree\n");
   }
+  else if (strcmp(test, "ncalrpc_crash_server") == 0)
+  {
+    crash_server();
+  }
   else if (strcmp(test, "np_basic") == 0)
   {
     ok(RPC_S_OK == RpcStringBindingCompose(NULL, np, address_np, pipe, NULL, &binding), "RpcStringBindingCompose\n");
     ok(RPC_S_OK == RpcBindingFromStringBinding(binding, &IServer_IfHandle), "RpcBindingFromStringBinding\n");
 
     run_tests();
+    latency_test("ncacn_np");
     authinfo_test(RPC_PROTSEQ_NMP, 0);
     stop();
 
@@ -1600,6 +1765,7 @@ server(void)
       /* we don't need to register RPC_C_AUTHN_WINNT for ncalrpc */
       run_client("ncalrpc_secure");
     }
+    server_death_test();
   }
   else
     skip("lrpc tests skipped due to earlier failure\n");
@@ -28,6 +28,10 @@
  * original version.
  */
 
+#include <stdarg.h>
+
+#include "windef.h"
+#include "winbase.h"
 #include "tomcrypt.h"
 
 static const ulong32 TE0[256] = {
@@ -1264,3 +1268,247 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
         rk[3];
     STORE32H(s3, pt+12);
 }
+
+/*
+ * Multi block functions. When the processor supports the AES instructions
+ * the blocks are processed with them, several at a time where the chaining
+ * mode permits it; otherwise they fall back to the table based code above.
+ * Both variants work in place.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+
+#define AES_NI_KERNELS
+
+#ifdef __i386__
+#define AES_NI_FUNC __attribute__((__target__("aes,sse2"), __force_align_arg_pointer__))
+#else
+#define AES_NI_FUNC __attribute__((__target__("aes,sse2")))
+#endif
+
+/* number of blocks processed in parallel by the AES instructions */
+#define AES_NI_BLOCKS 4
+
+static int aes_ni_supported = -1;
+
+static int use_aes_ni(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (aes_ni_supported == -1)
+    {
+        /* RSAENH_NOAESNI forces the table based code, so that it can be tested on any processor */
+        if (GetEnvironmentVariableA("RSAENH_NOAESNI", NULL, 0))
+            aes_ni_supported = 0;
+        else
+            aes_ni_supported = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES);
+    }
+    return aes_ni_supported;
+}
+
+/* The round keys are stored as big endian words. */
+static void AES_NI_FUNC aes_ni_load_keys(const ulong32 *k, int Nr, __m128i *rk)
+{
+    unsigned char buf[16];
+    int i, j;
+
+    for (i = 0; i <= Nr; i++, k += 4) {
+        for (j = 0; j < 4; j++) STORE32H(k[j], buf + 4 * j);
+        rk[i] = _mm_loadu_si128((const __m128i *)buf);
+    }
+}
+
+static void AES_NI_FUNC aes_ni_ecb_encrypt(const unsigned char *pt, unsigned char *ct,
+                                           unsigned long blocks, aes_key *skey)
+{
+    __m128i rk[15], b0, b1, b2, b3;
+    int Nr = skey->Nr, r;
+
+    aes_ni_load_keys(skey->eK, Nr, rk);
+
+    for (; blocks >= AES_NI_BLOCKS; blocks -= AES_NI_BLOCKS, pt += 64, ct += 64) {
+        b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)pt), rk[0]);
+        b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(pt + 16)), rk[0]);
+        b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(pt + 32)), rk[0]);
+        b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(pt + 48)), rk[0]);
+        for (r = 1; r < Nr; r++) {
+            b0 = _mm_aesenc_si128(b0, rk[r]);
+            b1 = _mm_aesenc_si128(b1, rk[r]);
+            b2 = _mm_aesenc_si128(b2, rk[r]);
+            b3 = _mm_aesenc_si128(b3, rk[r]);
+        }
+        _mm_storeu_si128((__m128i *)ct, _mm_aesenclast_si128(b0, rk[Nr]));
+        _mm_storeu_si128((__m128i *)(ct + 16), _mm_aesenclast_si128(b1, rk[Nr]));
+        _mm_storeu_si128((__m128i *)(ct + 32), _mm_aesenclast_si128(b2, rk[Nr]));
+        _mm_storeu_si128((__m128i *)(ct + 48), _mm_aesenclast_si128(b3, rk[Nr]));
+    }
+
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)pt), rk[0]);
+        for (r = 1; r < Nr; r++) b0 = _mm_aesenc_si128(b0, rk[r]);
+        _mm_storeu_si128((__m128i *)ct, _mm_aesenclast_si128(b0, rk[Nr]));
+    }
+}
+
+/* dK holds the round keys of the equivalent inverse cipher, which is what
+ * the aesdec instruction expects. */
+static void AES_NI_FUNC aes_ni_ecb_decrypt(const unsigned char *ct, unsigned char *pt,
+                                           unsigned long blocks, aes_key *skey)
+{
+    __m128i rk[15], b0, b1, b2, b3;
+    int Nr = skey->Nr, r;
+
+    aes_ni_load_keys(skey->dK, Nr, rk);
+
+    for (; blocks >= AES_NI_BLOCKS; blocks -= AES_NI_BLOCKS, ct += 64, pt += 64) {
+        b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)ct), rk[0]);
+        b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ct + 16)), rk[0]);
+        b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ct + 32)), rk[0]);
+        b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ct + 48)), rk[0]);
+        for (r = 1; r < Nr; r++) {
+            b0 = _mm_aesdec_si128(b0, rk[r]);
+            b1 = _mm_aesdec_si128(b1, rk[r]);
+            b2 = _mm_aesdec_si128(b2, rk[r]);
+            b3 = _mm_aesdec_si128(b3, rk[r]);
+        }
+        _mm_storeu_si128((__m128i *)pt, _mm_aesdeclast_si128(b0, rk[Nr]));
+        _mm_storeu_si128((__m128i *)(pt + 16), _mm_aesdeclast_si128(b1, rk[Nr]));
+        _mm_storeu_si128((__m128i *)(pt + 32), _mm_aesdeclast_si128(b2, rk[Nr]));
+        _mm_storeu_si128((__m128i *)(pt + 48), _mm_aesdeclast_si128(b3, rk[Nr]));
+    }
+
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)ct), rk[0]);
+        for (r = 1; r < Nr; r++) b0 = _mm_aesdec_si128(b0, rk[r]);
+        _mm_storeu_si128((__m128i *)pt, _mm_aesdeclast_si128(b0, rk[Nr]));
+    }
+}
+
+static void AES_NI_FUNC aes_ni_cbc_encrypt(const unsigned char *pt, unsigned char *ct,
+                                           unsigned long blocks, unsigned char *iv, aes_key *skey)
+{
+    __m128i rk[15], b;
+    int Nr = skey->Nr, r;
+
+    aes_ni_load_keys(skey->eK, Nr, rk);
+
+    b = _mm_loadu_si128((const __m128i *)iv);
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        b = _mm_xor_si128(b, _mm_loadu_si128((const __m128i *)pt));
+        b = _mm_xor_si128(b, rk[0]);
+        for (r = 1; r < Nr; r++) b = _mm_aesenc_si128(b, rk[r]);
+        b = _mm_aesenclast_si128(b, rk[Nr]);
+        _mm_storeu_si128((__m128i *)ct, b);
+    }
+    _mm_storeu_si128((__m128i *)iv, b);
+}
+
+static void AES_NI_FUNC aes_ni_cbc_decrypt(const unsigned char *ct, unsigned char *pt,
+                                           unsigned long blocks, unsigned char *iv, aes_key *skey)
+{
+    __m128i rk[15], c0, c1, c2, c3, b0, b1, b2, b3, prev;
+    int Nr = skey->Nr, r;
+
+    aes_ni_load_keys(skey->dK, Nr, rk);
+
+    prev = _mm_loadu_si128((const __m128i *)iv);
+    for (; blocks >= AES_NI_BLOCKS; blocks -= AES_NI_BLOCKS, ct += 64, pt += 64) {
+        c0 = _mm_loadu_si128((const __m128i *)ct);
+        c1 = _mm_loadu_si128((const __m128i *)(ct + 16));
+        c2 = _mm_loadu_si128((const __m128i *)(ct + 32));
+        c3 = _mm_loadu_si128((const __m128i *)(ct + 48));
+        b0 = _mm_xor_si128(c0, rk[0]);
+        b1 = _mm_xor_si128(c1, rk[0]);
+        b2 = _mm_xor_si128(c2, rk[0]);
+        b3 = _mm_xor_si128(c3, rk[0]);
+        for (r = 1; r < Nr; r++) {
+            b0 = _mm_aesdec_si128(b0, rk[r]);
+            b1 = _mm_aesdec_si128(b1, rk[r]);
+            b2 = _mm_aesdec_si128(b2, rk[r]);
+            b3 = _mm_aesdec_si128(b3, rk[r]);
+        }
+        _mm_storeu_si128((__m128i *)pt, _mm_xor_si128(_mm_aesdeclast_si128(b0, rk[Nr]), prev));
+        _mm_storeu_si128((__m128i *)(pt + 16), _mm_xor_si128(_mm_aesdeclast_si128(b1, rk[Nr]), c0));
+        _mm_storeu_si128((__m128i *)(pt + 32), _mm_xor_si128(_mm_aesdeclast_si128(b2, rk[Nr]), c1));
+        _mm_storeu_si128((__m128i *)(pt + 48), _mm_xor_si128(_mm_aesdeclast_si128(b3, rk[Nr]), c2));
+        prev = c3;
+    }
+
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        c0 = _mm_loadu_si128((const __m128i *)ct);
+        b0 = _mm_xor_si128(c0, rk[0]);
+        for (r = 1; r < Nr; r++) b0 = _mm_aesdec_si128(b0, rk[r]);
+        _mm_storeu_si128((__m128i *)pt, _mm_xor_si128(_mm_aesdeclast_si128(b0, rk[Nr]), prev));
+        prev = c0;
+    }
+    _mm_storeu_si128((__m128i *)iv, prev);
+}
+
+#endif /* AES_NI_KERNELS */
+
+void aes_ecb_encrypt_blocks(const unsigned char *pt, unsigned char *ct, unsigned long blocks,
+                            aes_key *skey)
+{
+#ifdef AES_NI_KERNELS
+    if (use_aes_ni()) {
+        aes_ni_ecb_encrypt(pt, ct, blocks, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, pt += 16, ct += 16)
+        aes_ecb_encrypt(pt, ct, skey);
+}
+
+void aes_ecb_decrypt_blocks(const unsigned char *ct, unsigned char *pt, unsigned long blocks,
+                            aes_key *skey)
+{
+#ifdef AES_NI_KERNELS
+    if (use_aes_ni()) {
+        aes_ni_ecb_decrypt(ct, pt, blocks, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, ct += 16, pt += 16)
+        aes_ecb_decrypt(ct, pt, skey);
+}
+
+void aes_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks,
+                     unsigned char *iv, aes_key *skey)
+{
+    int i;
+
+#ifdef AES_NI_KERNELS
+    if (use_aes_ni()) {
+        aes_ni_cbc_encrypt(pt, ct, blocks, iv, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        for (i = 0; i < 16; i++) iv[i] ^= pt[i];
+        aes_ecb_encrypt(iv, iv, skey);
+        memcpy(ct, iv, 16);
+    }
+}
+
+void aes_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks,
+                     unsigned char *iv, aes_key *skey)
+{
+    unsigned char tmp[16];
+    int i;
+
+#ifdef AES_NI_KERNELS
+    if (use_aes_ni()) {
+        aes_ni_cbc_decrypt(ct, pt, blocks, iv, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        memcpy(tmp, ct, 16);
+        aes_ecb_decrypt(ct, pt, skey);
+        for (i = 0; i < 16; i++) pt[i] ^= iv[i];
+        memcpy(iv, tmp, 16);
+    }
+}
@@ -375,6 +375,61 @@ BOOL encrypt_block_impl(ALG_ID aiAlgid, DWORD dwKeySpec, KEY_CONTEXT *pKeyContex
     return TRUE;
 }
 
+BOOL encrypt_blocks_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, DWORD dwMode, BYTE *pbChainVector,
+                         BYTE *pbInOut, DWORD dwLen, DWORD dwBlockLen, DWORD enc)
+{
+    BYTE tmp[16];
+    DWORD i, j, blocks = dwLen / dwBlockLen;
+
+    if (dwMode != CRYPT_MODE_ECB && dwMode != CRYPT_MODE_CBC) {
+        SetLastError(NTE_BAD_ALGID);
+        return FALSE;
+    }
+
+    switch (aiAlgid) {
+        case CALG_AES:
+        case CALG_AES_128:
+        case CALG_AES_192:
+        case CALG_AES_256:
+            if (dwMode == CRYPT_MODE_ECB) {
+                if (enc) aes_ecb_encrypt_blocks(pbInOut, pbInOut, blocks, &pKeyContext->aes);
+                else aes_ecb_decrypt_blocks(pbInOut, pbInOut, blocks, &pKeyContext->aes);
+            } else {
+                if (enc) aes_cbc_encrypt(pbInOut, pbInOut, blocks, pbChainVector, &pKeyContext->aes);
+                else aes_cbc_decrypt(pbInOut, pbInOut, blocks, pbChainVector, &pKeyContext->aes);
+            }
+            return TRUE;
+
+        case CALG_RC2:
+        case CALG_DES:
+        case CALG_3DES:
+        case CALG_3DES_112:
+            break;
+
+        default:
+            SetLastError(NTE_BAD_ALGID);
+            return FALSE;
+    }
+
+    /* The other block ciphers all work in place on blocks of at most 8 bytes. */
+    for (i = 0; i < blocks; i++, pbInOut += dwBlockLen) {
+        if (dwMode == CRYPT_MODE_ECB) {
+            encrypt_block_impl(aiAlgid, 0, pKeyContext, pbInOut, pbInOut, enc);
+        } else if (enc) {
+            for (j = 0; j < dwBlockLen; j++) pbInOut[j] ^= pbChainVector[j];
+            encrypt_block_impl(aiAlgid, 0, pKeyContext, pbInOut, pbInOut, enc);
+            memcpy(pbChainVector, pbInOut, dwBlockLen);
+        } else {
+            memcpy(tmp, pbInOut, dwBlockLen);
+            encrypt_block_impl(aiAlgid, 0, pKeyContext, pbInOut, pbInOut, enc);
+            for (j = 0; j < dwBlockLen; j++) pbInOut[j] ^= pbChainVector[j];
+            memcpy(pbChainVector, tmp, dwBlockLen);
+        }
+    }
+
+    return TRUE;
+}
+
 BOOL encrypt_stream_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, BYTE *stream, DWORD dwLen)
 {
     switch (aiAlgid) {
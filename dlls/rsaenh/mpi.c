@@ -42,6 +42,12 @@
 static const int KARATSUBA_MUL_CUTOFF = 88,  /* Min. number of digits before Karatsuba multiplication is used. */
                  KARATSUBA_SQR_CUTOFF = 128; /* Min. number of digits before Karatsuba squaring is used. */
 
+#if defined(__GNUC__) && defined(__SIZEOF_INT128__)
+#define MP_MONT_EXPTMOD
+/* Exponents shorter than this (public RSA exponents) use the sliding window code. */
+#define MONT_MIN_EXPONENT_BITS 64
+#endif
+
 
 /* trim unused digits */
 static void mp_clamp(mp_int *a);
@@ -98,6 +104,9 @@ static int s_mp_mul_high_digs(const mp_int *a, const mp_int *b, mp_int *c, int d
 static int s_mp_sqr(const mp_int *a, mp_int *b);
 static int s_mp_sub(const mp_int *a, const mp_int *b, mp_int *c);
 static int mp_exptmod_fast(const mp_int *G, const mp_int *X, mp_int *P, mp_int *Y, int mode);
+#ifdef MP_MONT_EXPTMOD
+static int mp_exptmod_mont(const mp_int *G, const mp_int *X, const mp_int *P, mp_int *Y);
+#endif
 static int mp_invmod_slow (const mp_int * a, mp_int * b, mp_int * c);
 static int mp_karatsuba_mul(const mp_int *a, const mp_int *b, mp_int *c);
 static int mp_karatsuba_sqr(const mp_int *a, mp_int *b);
@@ -1955,6 +1964,14 @@ int mp_exptmod (const mp_int * G, const mp_int * X, mp_int * P, mp_int * Y)
 
   dr = 0;
 
+#ifdef MP_MONT_EXPTMOD
+  /* long exponents (private keys, primality tests) with an odd modulus
+   * use the fixed window code working on 64-bit words */
+  if (mp_isodd (P) == 1 && mp_count_bits (X) > MONT_MIN_EXPONENT_BITS) {
+    return mp_exptmod_mont (G, X, P, Y);
+  }
+#endif
+
   /* if the modulus is odd or dr != 0 use the fast method */
   if (mp_isodd (P) == 1 || dr !=  0) {
     return mp_exptmod_fast (G, X, P, Y, dr);
@@ -2224,6 +2241,271 @@ __M:
   return err;
 }
 
+/* Montgomery arithmetic on 64-bit words, used for exponentiations with
+ * long exponents. The numbers are converted from and to the DIGIT_BIT sized
+ * digits of mp_int once per exponentiation. With 32-bit words this is no
+ * faster than the comba code, so it is only built where the compiler offers
+ * a 128-bit type for the products.
+ */
+#ifdef MP_MONT_EXPTMOD
+typedef ULONG64 mont_limb;
+typedef unsigned __int128 mont_dlimb;
+#define MONT_LIMB_BITS ((int)(sizeof(mont_limb) * CHAR_BIT))
+
+static void mp_to_limbs(const mp_int *a, mont_limb *l, int len)
+{
+  int i, bit, idx, shift;
+
+  memset(l, 0, len * sizeof(*l));
+  for (i = 0; i < a->used; i++) {
+    bit = i * DIGIT_BIT;
+    idx = bit / MONT_LIMB_BITS;
+    shift = bit % MONT_LIMB_BITS;
+    if (idx < len) {
+      l[idx] |= (mont_limb)a->dp[i] << shift;
+    }
+    if (shift + DIGIT_BIT > MONT_LIMB_BITS && idx + 1 < len) {
+      l[idx + 1] |= (mont_limb)a->dp[i] >> (MONT_LIMB_BITS - shift);
+    }
+  }
+}
+
+static int mp_from_limbs(mp_int *a, const mont_limb *l, int len)
+{
+  int i, bit, idx, shift, digits, err;
+  mont_limb d;
+
+  digits = (len * MONT_LIMB_BITS + DIGIT_BIT - 1) / DIGIT_BIT;
+  if ((err = mp_grow(a, digits)) != MP_OKAY) {
+    return err;
+  }
+  for (i = 0; i < digits; i++) {
+    bit = i * DIGIT_BIT;
+    idx = bit / MONT_LIMB_BITS;
+    shift = bit % MONT_LIMB_BITS;
+    d = l[idx] >> shift;
+    if (shift + DIGIT_BIT > MONT_LIMB_BITS && idx + 1 < len) {
+      d |= l[idx + 1] << (MONT_LIMB_BITS - shift);
+    }
+    a->dp[i] = (mp_digit)d & MP_MASK;
+  }
+  for (; i < a->alloc; i++) {
+    a->dp[i] = 0;
+  }
+  a->used = digits;
+  a->sign = MP_ZPOS;
+  mp_clamp(a);
+  return MP_OKAY;
+}
+
+/* r = t - n if t + top * R >= n, t otherwise, without branching on the values */
+static void mont_final_sub(mont_limb *r, const mont_limb *t, mont_limb top, const mont_limb *n, int len)
+{
+  mont_dlimb p;
+  mont_limb borrow, mask;
+  int j;
+
+  borrow = 0;
+  for (j = 0; j < len; j++) {
+    p = (mont_dlimb)t[j] - n[j] - borrow;
+    r[j] = (mont_limb)p;
+    borrow = (mont_limb)(p >> MONT_LIMB_BITS) & 1;
+  }
+  mask = (mont_limb)0 - (borrow & (top ^ 1));
+  for (j = 0; j < len; j++) {
+    r[j] = (t[j] & mask) | (r[j] & ~mask);
+  }
+}
+
+/* r = a * b / R mod n, with R = 2**(len * MONT_LIMB_BITS) and a, b < n.
+ * t is scratch space of len + 2 limbs; r may be the same as a or b.
+ */
+static void mont_mul(mont_limb *r, const mont_limb *a, const mont_limb *b, const mont_limb *n,
+                     mont_limb n0, int len, mont_limb *t)
+{
+  mont_dlimb p;
+  mont_limb c, m;
+  int i, j;
+
+  memset(t, 0, (len + 2) * sizeof(*t));
+  for (i = 0; i < len; i++) {
+    c = 0;
+    for (j = 0; j < len; j++) {
+      p = (mont_dlimb)a[j] * b[i] + t[j] + c;
+      t[j] = (mont_limb)p;
+      c = (mont_limb)(p >> MONT_LIMB_BITS);
+    }
+    p = (mont_dlimb)t[len] + c;
+    t[len] = (mont_limb)p;
+    t[len + 1] = (mont_limb)(p >> MONT_LIMB_BITS);
+
+    m = t[0] * n0;
+    p = (mont_dlimb)m * n[0] + t[0];
+    c = (mont_limb)(p >> MONT_LIMB_BITS);
+    for (j = 1; j < len; j++) {
+      p = (mont_dlimb)m * n[j] + t[j] + c;
+      t[j - 1] = (mont_limb)p;
+      c = (mont_limb)(p >> MONT_LIMB_BITS);
+    }
+    p = (mont_dlimb)t[len] + c;
+    t[len - 1] = (mont_limb)p;
+    t[len] = t[len + 1] + (mont_limb)(p >> MONT_LIMB_BITS);
+  }
+  mont_final_sub(r, t, t[len], n, len);
+}
+
+/* r = a * a / R mod n. The cross products are only computed once, which
+ * saves about a quarter of the work of mont_mul. t is scratch space of
+ * 2 * len limbs.
+ */
+static void mont_sqr(mont_limb *r, const mont_limb *a, const mont_limb *n, mont_limb n0, int len,
+                     mont_limb *t)
+{
+  mont_dlimb p;
+  mont_limb c, m, top;
+  int i, j;
+
+  memset(t, 0, 2 * len * sizeof(*t));
+  for (i = 0; i < len; i++) {
+    c = 0;
+    for (j = i + 1; j < len; j++) {
+      p = (mont_dlimb)a[i] * a[j] + t[i + j] + c;
+      t[i + j] = (mont_limb)p;
+      c = (mont_limb)(p >> MONT_LIMB_BITS);
+    }
+    t[i + len] = c;
+  }
+
+  c = 0;
+  for (i = 0; i < 2 * len; i++) {
+    m = t[i] >> (MONT_LIMB_BITS - 1);
+    t[i] = (t[i] << 1) | c;
+    c = m;
+  }
+
+  c = 0;
+  for (i = 0; i < len; i++) {
+    p = (mont_dlimb)a[i] * a[i] + t[2 * i] + c;
+    t[2 * i] = (mont_limb)p;
+    p = (mont_dlimb)t[2 * i + 1] + (mont_limb)(p >> MONT_LIMB_BITS);
+    t[2 * i + 1] = (mont_limb)p;
+    c = (mont_limb)(p >> MONT_LIMB_BITS);
+  }
+
+  top = 0;
+  for (i = 0; i < len; i++) {
+    m = t[i] * n0;
+    c = 0;
+    for (j = 0; j < len; j++) {
+      p = (mont_dlimb)m * n[j] + t[i + j] + c;
+      t[i + j] = (mont_limb)p;
+      c = (mont_limb)(p >> MONT_LIMB_BITS);
+    }
+    p = (mont_dlimb)t[i + len] + c + top;
+    t[i + len] = (mont_limb)p;
+    top = (mont_limb)(p >> MONT_LIMB_BITS);
+  }
+  mont_final_sub(r, t + len, top, n, len);
+}
+
+static int mp_get_bit(const mp_int *a, int bit)
+{
+  if (bit / DIGIT_BIT >= a->used) {
+    return 0;
+  }
+  return (a->dp[bit / DIGIT_BIT] >> (bit % DIGIT_BIT)) & 1;
+}
+
+/* computes Y == G**X mod P for odd P
+ *
+ * Uses a left-to-right fixed window, with the table entries read in
+ * constant time, so the sequence of operations only depends on the
+ * length of the exponent.
+ */
+static int mp_exptmod_mont(const mp_int *G, const mp_int *X, const mp_int *P, mp_int *Y)
+{
+  mp_int     t;
+  mont_limb *n, *table, *acc, *sel, *tmp, n0, inv, mask;
+  int        err, len, bits, winsize, size, win, i, j, k;
+
+  len = (mp_count_bits(P) + MONT_LIMB_BITS - 1) / MONT_LIMB_BITS;
+  bits = mp_count_bits(X);
+  winsize = bits > 1536 ? 6 : (bits > 384 ? 5 : 4);
+  size = 1 << winsize;
+
+  n = HeapAlloc(GetProcessHeap(), 0, ((size + 5) * len + 2) * sizeof(mont_limb));
+  if (n == NULL) {
+    return MP_MEM;
+  }
+  table = n + len;
+  acc = table + size * len;
+  sel = acc + len;
+  tmp = sel + len;
+
+  if ((err = mp_init(&t)) != MP_OKAY) {
+    HeapFree(GetProcessHeap(), 0, n);
+    return err;
+  }
+
+  mp_to_limbs(P, n, len);
+
+  /* n0 = -1/n mod 2**MONT_LIMB_BITS, each step doubles the correct bits */
+  inv = n[0];
+  for (i = 3; i < MONT_LIMB_BITS; i *= 2) {
+    inv *= 2 - n[0] * inv;
+  }
+  n0 = (mont_limb)0 - inv;
+
+  /* table[0] = R mod P, table[1] = G * R mod P */
+  if ((err = mp_2expt(&t, len * MONT_LIMB_BITS)) != MP_OKAY ||
+      (err = mp_mod(&t, (mp_int *)P, &t)) != MP_OKAY) {
+    goto LBL_ERR;
+  }
+  mp_to_limbs(&t, table, len);
+  if ((err = mp_mod(G, (mp_int *)P, &t)) != MP_OKAY ||
+      (err = mp_mul_2d(&t, len * MONT_LIMB_BITS, &t)) != MP_OKAY ||
+      (err = mp_mod(&t, (mp_int *)P, &t)) != MP_OKAY) {
+    goto LBL_ERR;
+  }
+  mp_to_limbs(&t, table + len, len);
+  for (i = 2; i < size; i++) {
+    mont_mul(table + i * len, table + (i - 1) * len, table + len, n, n0, len, tmp);
+  }
+
+  memcpy(acc, table, len * sizeof(mont_limb));
+  for (i = (bits + winsize - 1) / winsize * winsize - winsize; i >= 0; i -= winsize) {
+    for (j = 0; j < winsize; j++) {
+      mont_sqr(acc, acc, n, n0, len, tmp);
+    }
+    win = 0;
+    for (j = winsize - 1; j >= 0; j--) {
+      win = (win << 1) | mp_get_bit(X, i + j);
+    }
+    memset(sel, 0, len * sizeof(mont_limb));
+    for (k = 0; k < size; k++) {
+      mask = (mont_limb)0 - (mont_limb)(k == win);
+      for (j = 0; j < len; j++) {
+        sel[j] |= table[k * len + j] & mask;
+      }
+    }
+    mont_mul(acc, acc, sel, n, n0, len, tmp);
+  }
+
+  /* leave the Montgomery representation */
+  memset(sel, 0, len * sizeof(mont_limb));
+  sel[0] = 1;
+  mont_mul(acc, acc, sel, n, n0, len, tmp);
+  err = mp_from_limbs(Y, acc, len);
+
+LBL_ERR:
+  memset(n, 0, ((size + 5) * len + 2) * sizeof(mont_limb));
+  HeapFree(GetProcessHeap(), 0, n);
+  mp_clear(&t);
+  return err;
+}
+
+#endif /* MP_MONT_EXPTMOD */
+
 /* Greatest Common Divisor using the binary method */
 int mp_gcd (const mp_int * a, const mp_int * b, mp_int * c)
 {
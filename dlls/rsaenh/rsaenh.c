@@ -2140,7 +2140,7 @@ BOOL WINAPI RSAENH_CPEncrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
                              DWORD dwFlags, BYTE *pbData, DWORD *pdwDataLen, DWORD dwBufLen)
 {
     CRYPTKEY *pCryptKey;
-    BYTE *in, out[RSAENH_MAX_BLOCK_SIZE], o[RSAENH_MAX_BLOCK_SIZE];
+    BYTE *in, o[RSAENH_MAX_BLOCK_SIZE];
     DWORD dwEncryptedLen, i, j, k;
         
     TRACE("(hProv=%08lx, hKey=%08lx, hHash=%08lx, Final=%d, dwFlags=%08x, pbData=%p, "
@@ -2200,36 +2200,32 @@ BOOL WINAPI RSAENH_CPEncrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
         for (i=*pdwDataLen; i<dwEncryptedLen; i++) pbData[i] = dwEncryptedLen - *pdwDataLen;
         *pdwDataLen = dwEncryptedLen;
 
-        for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
-            switch (pCryptKey->dwMode) {
-                case CRYPT_MODE_ECB:
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_ENCRYPT);
-                    break;
-                
-                case CRYPT_MODE_CBC:
-                    for (j=0; j<pCryptKey->dwBlockLen; j++) in[j] ^= pCryptKey->abChainVector[j];
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_ENCRYPT);
-                    memcpy(pCryptKey->abChainVector, out, pCryptKey->dwBlockLen);
-                    break;
+        switch (pCryptKey->dwMode) {
+            case CRYPT_MODE_ECB:
+            case CRYPT_MODE_CBC:
+                if (!encrypt_blocks_impl(pCryptKey->aiAlgid, &pCryptKey->context, pCryptKey->dwMode,
+                                         pCryptKey->abChainVector, pbData, *pdwDataLen,
+                                         pCryptKey->dwBlockLen, RSAENH_ENCRYPT))
+                    return FALSE;
+                break;
 
-                case CRYPT_MODE_CFB:
+            case CRYPT_MODE_CFB:
+                for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
                     for (j=0; j<pCryptKey->dwBlockLen; j++) {
                         encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, 
                                            pCryptKey->abChainVector, o, RSAENH_ENCRYPT);
-                        out[j] = in[j] ^ o[0];
+                        in[j] ^= o[0];
                         for (k=0; k<pCryptKey->dwBlockLen-1; k++) 
                             pCryptKey->abChainVector[k] = pCryptKey->abChainVector[k+1];
-                        pCryptKey->abChainVector[k] = out[j];
+                        pCryptKey->abChainVector[k] = in[j];
                     }
-                    break;
-                    
-                default:
-                    SetLastError(NTE_BAD_ALGID);
-                    return FALSE;
-            }
-            memcpy(in, out, pCryptKey->dwBlockLen); 
+                }
+                break;
+
+            default:
+                if (!*pdwDataLen) break;
+                SetLastError(NTE_BAD_ALGID);
+                return FALSE;
         }
     } else if (GET_ALG_TYPE(pCryptKey->aiAlgid) == ALG_TYPE_STREAM) {
         if (pbData == NULL) {
@@ -2292,7 +2288,7 @@ BOOL WINAPI RSAENH_CPDecrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
                              DWORD dwFlags, BYTE *pbData, DWORD *pdwDataLen)
 {
     CRYPTKEY *pCryptKey;
-    BYTE *in, out[RSAENH_MAX_BLOCK_SIZE], o[RSAENH_MAX_BLOCK_SIZE];
+    BYTE *in, o[RSAENH_MAX_BLOCK_SIZE];
     DWORD i, j, k;
     DWORD dwMax;
 
@@ -2329,36 +2325,32 @@ BOOL WINAPI RSAENH_CPDecrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
     dwMax=*pdwDataLen;
 
     if (GET_ALG_TYPE(pCryptKey->aiAlgid) == ALG_TYPE_BLOCK) {
-        for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
-            switch (pCryptKey->dwMode) {
-                case CRYPT_MODE_ECB:
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_DECRYPT);
-                    break;
-                
-                case CRYPT_MODE_CBC:
-                    encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
-                                       RSAENH_DECRYPT);
-                    for (j=0; j<pCryptKey->dwBlockLen; j++) out[j] ^= pCryptKey->abChainVector[j];
-                    memcpy(pCryptKey->abChainVector, in, pCryptKey->dwBlockLen);
-                    break;
+        switch (pCryptKey->dwMode) {
+            case CRYPT_MODE_ECB:
+            case CRYPT_MODE_CBC:
+                if (!encrypt_blocks_impl(pCryptKey->aiAlgid, &pCryptKey->context, pCryptKey->dwMode,
+                                         pCryptKey->abChainVector, pbData, *pdwDataLen,
+                                         pCryptKey->dwBlockLen, RSAENH_DECRYPT))
+                    return FALSE;
+                break;
 
-                case CRYPT_MODE_CFB:
+            case CRYPT_MODE_CFB:
+                for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
                     for (j=0; j<pCryptKey->dwBlockLen; j++) {
                         encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, 
                                            pCryptKey->abChainVector, o, RSAENH_ENCRYPT);
-                        out[j] = in[j] ^ o[0];
                         for (k=0; k<pCryptKey->dwBlockLen-1; k++) 
                             pCryptKey->abChainVector[k] = pCryptKey->abChainVector[k+1];
                         pCryptKey->abChainVector[k] = in[j];
+                        in[j] ^= o[0];
                     }
-                    break;
-                    
-                default:
-                    SetLastError(NTE_BAD_ALGID);
-                    return FALSE;
-            }
-            memcpy(in, out, pCryptKey->dwBlockLen);
+                }
+                break;
+
+            default:
+                if (!*pdwDataLen) break;
+                SetLastError(NTE_BAD_ALGID);
+                return FALSE;
         }
         if (Final) {
             if (pbData[*pdwDataLen-1] &&
@@ -456,6 +456,116 @@ void SHA256_Transform(SHA256_CTX* context, const sha2_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+/*
+ * Processors with the SHA extensions hash whole blocks with them, straight
+ * from the input buffer; otherwise SHA256_Transform is called per block.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA256_NI_KERNELS
+
+#ifdef __i386__
+#define SHA_NI_FUNC __attribute__((__target__("sha,sse4.1,ssse3"), __force_align_arg_pointer__))
+#else
+#define SHA_NI_FUNC __attribute__((__target__("sha,sse4.1,ssse3")))
+#endif
+
+static int sha_ni_supported = -1;
+
+static int use_sha_ni(void) {
+	unsigned int	eax, ebx, ecx, edx;
+
+	if (sha_ni_supported == -1) {
+		sha_ni_supported = 0;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+		    (ecx & bit_SSSE3) && (ecx & bit_SSE4_1) &&
+		    __get_cpuid_max(0, NULL) >= 7) {
+			__cpuid_count(7, 0, eax, ebx, ecx, edx);
+			sha_ni_supported = (ebx & (1 << 29)) != 0;
+		}
+	}
+	return sha_ni_supported;
+}
+
+/*
+ * Rounds 4*g to 4*g+3.  m0 holds their message words, m1 the next ones and
+ * m3 the previous ones; the schedule for later rounds is interleaved.
+ */
+#define ROUND256_NI(g,m0,m1,m2,m3)	\
+	msg = _mm_add_epi32(m0, _mm_loadu_si128((const __m128i*)&K256[4 * (g)])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+	if ((g) >= 3 && (g) <= 14) \
+		m1 = _mm_sha256msg2_epu32(_mm_add_epi32(m1, _mm_alignr_epi8(m0, m3, 4)), m0); \
+	msg = _mm_shuffle_epi32(msg, 0x0e); \
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg); \
+	if ((g) >= 1 && (g) <= 12) \
+		m3 = _mm_sha256msg1_epu32(m3, m0);
+
+#define LOAD256_NI(m,i)	\
+	m = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * (i))), mask);
+
+static void SHA_NI_FUNC SHA256_Transform_ni(SHA256_CTX* context, const sha2_byte *data, size_t blocks) {
+	const __m128i	mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i		state0, state1, save0, save1, msg, msg0, msg1, msg2, msg3, tmp;
+
+	/* The instructions want the state as ABEF and CDGH */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&context->state[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&context->state[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	for (; blocks; blocks--, data += SHA256_BLOCK_LENGTH) {
+		save0 = state0;
+		save1 = state1;
+
+		LOAD256_NI(msg0, 0);
+		ROUND256_NI( 0, msg0, msg1, msg2, msg3);
+		LOAD256_NI(msg1, 1);
+		ROUND256_NI( 1, msg1, msg2, msg3, msg0);
+		LOAD256_NI(msg2, 2);
+		ROUND256_NI( 2, msg2, msg3, msg0, msg1);
+		LOAD256_NI(msg3, 3);
+		ROUND256_NI( 3, msg3, msg0, msg1, msg2);
+		ROUND256_NI( 4, msg0, msg1, msg2, msg3);
+		ROUND256_NI( 5, msg1, msg2, msg3, msg0);
+		ROUND256_NI( 6, msg2, msg3, msg0, msg1);
+		ROUND256_NI( 7, msg3, msg0, msg1, msg2);
+		ROUND256_NI( 8, msg0, msg1, msg2, msg3);
+		ROUND256_NI( 9, msg1, msg2, msg3, msg0);
+		ROUND256_NI(10, msg2, msg3, msg0, msg1);
+		ROUND256_NI(11, msg3, msg0, msg1, msg2);
+		ROUND256_NI(12, msg0, msg1, msg2, msg3);
+		ROUND256_NI(13, msg1, msg2, msg3, msg0);
+		ROUND256_NI(14, msg2, msg3, msg0, msg1);
+		ROUND256_NI(15, msg3, msg0, msg1, msg2);
+
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	_mm_storeu_si128((__m128i*)&context->state[0], _mm_blend_epi16(tmp, state1, 0xf0));
+	_mm_storeu_si128((__m128i*)&context->state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#endif /* SHA256_NI_KERNELS */
+
+static void SHA256_Blocks(SHA256_CTX* context, const sha2_byte *data, size_t blocks) {
+#ifdef SHA256_NI_KERNELS
+	if (use_sha_ni()) {
+		SHA256_Transform_ni(context, data, blocks);
+		return;
+	}
+#endif
+	for (; blocks; blocks--, data += SHA256_BLOCK_LENGTH)
+		SHA256_Transform(context, (const sha2_word32*)data);
+}
+
 void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 	unsigned int	freespace, usedspace;
 
@@ -478,7 +588,7 @@ void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 			context->bitcount += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA256_Transform(context, (sha2_word32*)context->buffer);
+			SHA256_Blocks(context, context->buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			MEMCPY_BCOPY(&context->buffer[usedspace], data, len);
@@ -488,12 +598,12 @@ void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 			return;
 		}
 	}
-	while (len >= SHA256_BLOCK_LENGTH) {
+	if (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA256_Transform(context, (const sha2_word32*)data);
-		context->bitcount += SHA256_BLOCK_LENGTH << 3;
-		len -= SHA256_BLOCK_LENGTH;
-		data += SHA256_BLOCK_LENGTH;
+		SHA256_Blocks(context, data, len / SHA256_BLOCK_LENGTH);
+		context->bitcount += (sha2_word64)(len & ~(size_t)(SHA256_BLOCK_LENGTH - 1)) << 3;
+		data += len & ~(size_t)(SHA256_BLOCK_LENGTH - 1);
+		len &= SHA256_BLOCK_LENGTH - 1;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -530,7 +640,7 @@ void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 					MEMSET_BZERO(&context->buffer[usedspace], SHA256_BLOCK_LENGTH - usedspace);
 				}
 				/* Do second-to-last transform: */
-				SHA256_Transform(context, (sha2_word32*)context->buffer);
+				SHA256_Blocks(context, context->buffer, 1);
 
 				/* And set-up for the last transform: */
 				MEMSET_BZERO(context->buffer, SHA256_SHORT_BLOCK_LENGTH);
@@ -546,7 +656,7 @@ void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 		*(sha2_word64*)&context->buffer[SHA256_SHORT_BLOCK_LENGTH] = context->bitcount;
 
 		/* Final transform: */
-		SHA256_Transform(context, (sha2_word32*)context->buffer);
+		SHA256_Blocks(context, context->buffer, 1);
 
 #ifndef WORDS_BIGENDIAN
 		{
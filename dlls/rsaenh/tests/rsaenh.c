@@ -985,6 +985,180 @@ static void test_aes(int keylen)
     ok(result, "%08x\n", GetLastError());
 }
 
+static void test_aes_known_answer(void)
+{
+    /* CBC-AES128 and ECB-AES128 vectors from NIST SP 800-38A */
+    static const BYTE key[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    static const BYTE iv[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    static const BYTE plain[64] = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+        0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+        0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+        0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 };
+    static const BYTE cbc[64] = {
+        0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+        0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+        0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+        0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7 };
+    static const BYTE ecb[64] = {
+        0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60, 0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+        0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d, 0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+        0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23, 0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+        0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f, 0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4 };
+    struct
+    {
+        BLOBHEADER header;
+        DWORD key_len;
+        BYTE key[16];
+    } blob;
+    HCRYPTKEY hKey;
+    BYTE abData[64];
+    DWORD dwMode, dwLen;
+    BOOL result;
+
+    blob.header.bType = PLAINTEXTKEYBLOB;
+    blob.header.bVersion = CUR_BLOB_VERSION;
+    blob.header.reserved = 0;
+    blob.header.aiKeyAlg = CALG_AES_128;
+    blob.key_len = sizeof(key);
+    memcpy(blob.key, key, sizeof(key));
+    result = CryptImportKey(hProv, (BYTE *)&blob, sizeof(blob), 0, 0, &hKey);
+    if (!result)
+    {
+        win_skip("importing plaintext AES keys not supported: %08x\n", GetLastError());
+        return;
+    }
+
+    result = CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    ok(result, "%08x\n", GetLastError());
+
+    /* the chaining state carries over between the calls */
+    memcpy(abData, plain, sizeof(plain));
+    dwLen = 16;
+    result = CryptEncrypt(hKey, 0, FALSE, 0, abData, &dwLen, sizeof(abData));
+    ok(result && dwLen == 16, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    dwLen = 48;
+    result = CryptEncrypt(hKey, 0, FALSE, 0, abData + 16, &dwLen, sizeof(abData) - 16);
+    ok(result && dwLen == 48, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    ok(!memcmp(abData, cbc, sizeof(cbc)), "wrong CBC ciphertext\n");
+
+    CryptDestroyKey(hKey);
+    result = CryptImportKey(hProv, (BYTE *)&blob, sizeof(blob), 0, 0, &hKey);
+    ok(result, "%08x\n", GetLastError());
+    result = CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    ok(result, "%08x\n", GetLastError());
+
+    dwLen = 64;
+    result = CryptDecrypt(hKey, 0, FALSE, 0, abData, &dwLen);
+    ok(result && dwLen == 64, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    ok(!memcmp(abData, plain, sizeof(plain)), "wrong CBC plaintext\n");
+
+    dwMode = CRYPT_MODE_ECB;
+    result = CryptSetKeyParam(hKey, KP_MODE, (BYTE *)&dwMode, 0);
+    ok(result, "%08x\n", GetLastError());
+
+    dwLen = 64;
+    result = CryptEncrypt(hKey, 0, FALSE, 0, abData, &dwLen, sizeof(abData));
+    ok(result && dwLen == 64, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    ok(!memcmp(abData, ecb, sizeof(ecb)), "wrong ECB ciphertext\n");
+
+    dwLen = 64;
+    result = CryptDecrypt(hKey, 0, FALSE, 0, abData, &dwLen);
+    ok(result && dwLen == 64, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    ok(!memcmp(abData, plain, sizeof(plain)), "wrong ECB plaintext\n");
+
+    CryptDestroyKey(hKey);
+}
+
+/* Encrypting a buffer in a single call must give the same result as
+ * encrypting it a few blocks at a time. */
+static void test_block_cipher_bulk(ALG_ID aiAlgid, DWORD dwMode)
+{
+    static const DWORD data_len = 1000;
+    HCRYPTKEY hKey;
+    BYTE *plain, *bulk, *pieces;
+    DWORD i, dwLen, block_len, enc_len, chunk;
+    BOOL result;
+
+    if (!derive_key(aiAlgid, &hKey, 0)) return;
+
+    result = CryptSetKeyParam(hKey, KP_MODE, (BYTE *)&dwMode, 0);
+    ok(result, "%08x\n", GetLastError());
+    dwLen = sizeof(block_len);
+    result = CryptGetKeyParam(hKey, KP_BLOCKLEN, (BYTE *)&block_len, &dwLen, 0);
+    ok(result, "%08x\n", GetLastError());
+    block_len /= 8;
+    enc_len = (data_len / block_len + 1) * block_len;
+
+    plain = HeapAlloc(GetProcessHeap(), 0, enc_len);
+    bulk = HeapAlloc(GetProcessHeap(), 0, enc_len);
+    pieces = HeapAlloc(GetProcessHeap(), 0, enc_len);
+    for (i = 0; i < data_len; i++) plain[i] = (BYTE)(i * 7 + 3);
+
+    memcpy(bulk, plain, data_len);
+    dwLen = data_len;
+    result = CryptEncrypt(hKey, 0, TRUE, 0, bulk, &dwLen, enc_len);
+    ok(result && dwLen == enc_len, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+
+    memcpy(pieces, plain, data_len);
+    for (i = 0, chunk = 1; data_len - i > chunk * block_len; i += chunk * block_len, chunk++)
+    {
+        dwLen = chunk * block_len;
+        result = CryptEncrypt(hKey, 0, FALSE, 0, pieces + i, &dwLen, enc_len - i);
+        ok(result && dwLen == chunk * block_len, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    }
+    dwLen = data_len - i;
+    result = CryptEncrypt(hKey, 0, TRUE, 0, pieces + i, &dwLen, enc_len - i);
+    ok(result && dwLen == enc_len - i, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    ok(!memcmp(bulk, pieces, enc_len), "algid %04x mode %d: ciphertexts differ\n", aiAlgid, dwMode);
+
+    for (i = 0, chunk = 1; enc_len - i > chunk * block_len; i += chunk * block_len, chunk++)
+    {
+        dwLen = chunk * block_len;
+        result = CryptDecrypt(hKey, 0, FALSE, 0, bulk + i, &dwLen);
+        ok(result && dwLen == chunk * block_len, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    }
+    dwLen = enc_len - i;
+    result = CryptDecrypt(hKey, 0, TRUE, 0, bulk + i, &dwLen);
+    ok(result && i + dwLen == data_len, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    ok(!memcmp(bulk, plain, data_len), "algid %04x mode %d: wrong plaintext\n", aiAlgid, dwMode);
+
+    dwLen = enc_len;
+    result = CryptDecrypt(hKey, 0, TRUE, 0, pieces, &dwLen);
+    ok(result && dwLen == data_len, "%08x, dwLen: %d\n", GetLastError(), dwLen);
+    ok(!memcmp(pieces, plain, data_len), "algid %04x mode %d: wrong plaintext\n", aiAlgid, dwMode);
+
+    if (winetest_debug > 1)
+    {
+        static const DWORD bulk_len = 1024 * 1024;
+        BYTE *buf = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, bulk_len);
+        DWORD start, elapsed;
+
+        start = GetTickCount();
+        for (i = 0; i < 8; i++)
+        {
+            dwLen = bulk_len;
+            CryptEncrypt(hKey, 0, FALSE, 0, buf, &dwLen, bulk_len);
+        }
+        elapsed = GetTickCount() - start;
+        for (i = 0; i < 8; i++)
+        {
+            dwLen = bulk_len;
+            CryptDecrypt(hKey, 0, FALSE, 0, buf, &dwLen);
+        }
+        trace("algid %04x mode %d: encrypt %u ms, decrypt %u ms for 8 MB\n", aiAlgid, dwMode,
+              elapsed, GetTickCount() - start - elapsed);
+        HeapFree(GetProcessHeap(), 0, buf);
+    }
+
+    HeapFree(GetProcessHeap(), 0, plain);
+    HeapFree(GetProcessHeap(), 0, bulk);
+    HeapFree(GetProcessHeap(), 0, pieces);
+    CryptDestroyKey(hKey);
+}
+
 static void test_sha2(void)
 {
     static const unsigned char sha256hash[32] = {
@@ -1087,6 +1261,70 @@ static void test_sha2(void)
     }
 }
 
+static const BYTE md5_million_a[16] = {
+    0x77, 0x07, 0xd6, 0xae, 0x4e, 0x02, 0x7c, 0x70, 0xee, 0xa2,
+    0xa9, 0x35, 0xc2, 0x29, 0x6f, 0x21
+};
+static const BYTE sha1_million_a[20] = {
+    0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4, 0xf6, 0x1e,
+    0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31, 0x65, 0x34, 0x01, 0x6f
+};
+static const BYTE sha256_million_a[32] = {
+    0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1,
+    0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67, 0xf1, 0x80, 0x9a, 0x48,
+    0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11,
+    0x2c, 0xd0
+};
+
+static void test_hash_long_message(ALG_ID aiAlgid, const BYTE *expected, DWORD hashlen)
+{
+    static const DWORD chunks[] = { 1, 55, 64, 65, 1000, 4096, 1000000 };
+    static const DWORD data_len = 1000000;
+    BYTE *data, pbHashValue[64];
+    HCRYPTHASH hHash;
+    DWORD len, i, j, start;
+    BOOL result;
+
+    /* one million repetitions of 'a', hashed in different chunk sizes and
+     * from a misaligned buffer */
+    data = HeapAlloc(GetProcessHeap(), 0, data_len + 1);
+    memset(data, 'a', data_len + 1);
+
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+    {
+        result = CryptCreateHash(hProv, aiAlgid, 0, 0, &hHash);
+        if (!result && GetLastError() == NTE_BAD_ALGID)
+        {
+            win_skip("algid %04x is not supported\n", aiAlgid);
+            break;
+        }
+        ok(result, "%08x\n", GetLastError());
+        for (j = 0; result && j < data_len; j += chunks[i])
+        {
+            result = CryptHashData(hHash, data + (i & 1), min(chunks[i], data_len - j), 0);
+            ok(result, "%08x\n", GetLastError());
+        }
+        len = hashlen;
+        result = CryptGetHashParam(hHash, HP_HASHVAL, pbHashValue, &len, 0);
+        ok(result && len == hashlen, "%08x, len: %d\n", GetLastError(), len);
+        ok(!memcmp(pbHashValue, expected, hashlen), "algid %04x chunk %d: wrong hash\n",
+           aiAlgid, chunks[i]);
+        CryptDestroyHash(hHash);
+    }
+
+    if (i == sizeof(chunks) / sizeof(chunks[0]) && winetest_debug > 1)
+    {
+        start = GetTickCount();
+        result = CryptCreateHash(hProv, aiAlgid, 0, 0, &hHash);
+        for (i = 0; result && i < 64; i++)
+            CryptHashData(hHash, data, data_len, 0);
+        trace("algid %04x: %u ms for 64 MB\n", aiAlgid, GetTickCount() - start);
+        CryptDestroyHash(hHash);
+    }
+
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
 static void test_rc2(void)
 {
     static const BYTE rc2_40_encrypted[16] = {
@@ -2561,6 +2799,58 @@ static void test_rsa_round_trip(void)
      CRYPT_DELETEKEYSET);
 }
 
+static void test_rsa_sign_speed(void)
+{
+    static const DWORD key_lens[] = { 1024, 2048, 4096 };
+    static const BYTE data[] = "Signature speed test";
+    HCRYPTPROV prov;
+    HCRYPTKEY key;
+    HCRYPTHASH hash;
+    BYTE sig[512];
+    DWORD i, len, count, start, gen_time;
+    BOOL result;
+
+    if (winetest_debug <= 1) return;
+
+    result = CryptAcquireContext(&prov, NULL, szProvider, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
+    ok(result, "CryptAcquireContext failed: %08x\n", GetLastError());
+    if (!result) return;
+
+    for (i = 0; i < sizeof(key_lens) / sizeof(key_lens[0]); i++)
+    {
+        start = GetTickCount();
+        result = CryptGenKey(prov, AT_SIGNATURE, key_lens[i] << 16, &key);
+        gen_time = GetTickCount() - start;
+        ok(result, "CryptGenKey failed: %08x\n", GetLastError());
+        if (!result) continue;
+
+        result = CryptCreateHash(prov, CALG_SHA1, 0, 0, &hash);
+        ok(result, "CryptCreateHash failed: %08x\n", GetLastError());
+        result = CryptHashData(hash, data, sizeof(data), 0);
+        ok(result, "CryptHashData failed: %08x\n", GetLastError());
+
+        count = 0;
+        start = GetTickCount();
+        do
+        {
+            len = sizeof(sig);
+            result = CryptSignHash(hash, AT_SIGNATURE, NULL, 0, sig, &len);
+            count++;
+        } while (result && GetTickCount() - start < 1000);
+        ok(result && len == key_lens[i] / 8, "CryptSignHash failed: %08x, len %u\n", GetLastError(), len);
+        trace("%u bit key: generated in %u ms, %u signatures in %u ms\n", key_lens[i], gen_time,
+              count, GetTickCount() - start);
+
+        result = CryptVerifySignature(hash, sig, len, key, NULL, 0);
+        ok(result, "CryptVerifySignature failed: %08x\n", GetLastError());
+
+        CryptDestroyHash(hash);
+        CryptDestroyKey(key);
+    }
+
+    CryptReleaseContext(prov, 0);
+}
+
 static void test_enum_container(void)
 {
     BYTE abContainerName[MAX_PATH + 2]; /* Larger than maximum name len */
@@ -3001,8 +3291,49 @@ static void test_key_initialization(void)
      CRYPT_DELETEKEYSET);
 }
 
+/* Wine's provider uses the AES instructions when the processor has them,
+ * run the AES tests again in a child process that is told not to. */
+static void test_aes_tables(const char *argv0)
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si;
+    char cmdline[MAX_PATH + 32];
+    BOOL result;
+
+    memset(&si, 0, sizeof(si));
+    si.cb = sizeof(si);
+    sprintf(cmdline, "\"%s\" rsaenh aes_tables", argv0);
+
+    SetEnvironmentVariableA("RSAENH_NOAESNI", "1");
+    result = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(result, "CreateProcess failed: %08x\n", GetLastError());
+    SetEnvironmentVariableA("RSAENH_NOAESNI", NULL);
+    if (!result) return;
+
+    winetest_wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+}
+
 START_TEST(rsaenh)
 {
+    char **argv;
+    int argc;
+
+    argc = winetest_get_mainargs(&argv);
+    if (argc >= 3 && !strcmp(argv[2], "aes_tables"))
+    {
+        if (!init_aes_environment())
+            return;
+        test_aes(128);
+        test_aes(256);
+        test_aes_known_answer();
+        test_block_cipher_bulk(CALG_AES_128, CRYPT_MODE_CBC);
+        test_block_cipher_bulk(CALG_AES_256, CRYPT_MODE_ECB);
+        clean_up_aes_environment();
+        return;
+    }
+
     if (!init_base_environment(0))
         return;
     test_prov();
@@ -3022,6 +3353,7 @@ START_TEST(rsaenh)
     test_import_export();
     test_import_hmac();
     test_enum_container();
+    test_rsa_sign_speed();
     clean_up_base_environment();
     test_key_permissions();
     test_key_initialization();
@@ -3033,6 +3365,15 @@ START_TEST(rsaenh)
     test_aes(128);
     test_aes(192);
     test_aes(256);
+    test_aes_known_answer();
+    test_block_cipher_bulk(CALG_AES_128, CRYPT_MODE_CBC);
+    test_block_cipher_bulk(CALG_AES_256, CRYPT_MODE_ECB);
+    test_block_cipher_bulk(CALG_AES_256, CRYPT_MODE_CFB);
+    test_block_cipher_bulk(CALG_3DES, CRYPT_MODE_CBC);
     test_sha2();
+    test_hash_long_message(CALG_MD5, md5_million_a, sizeof(md5_million_a));
+    test_hash_long_message(CALG_SHA1, sha1_million_a, sizeof(sha1_million_a));
+    test_hash_long_message(CALG_SHA_256, sha256_million_a, sizeof(sha256_million_a));
     clean_up_aes_environment();
+    test_aes_tables(argv[0]);
 }
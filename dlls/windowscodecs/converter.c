@@ -92,6 +92,199 @@ static void make_grayscale_palette(WICColor *colors, UINT num_colors)
     }
 }
 
+/*
+ * Vector versions of the most common row conversions. They convert the bulk
+ * of a row and return the number of pixels done, the scalar loops finish the
+ * row. Results are identical to the scalar code.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+
+#include <cpuid.h>
+#include <tmmintrin.h>
+
+#ifdef __i386__
+#define SSE2_FUNC  __attribute__((__target__("sse2"), __force_align_arg_pointer__))
+#define SSSE3_FUNC __attribute__((__target__("ssse3"), __force_align_arg_pointer__))
+#else
+#define SSE2_FUNC  __attribute__((__target__("sse2")))
+#define SSSE3_FUNC __attribute__((__target__("ssse3")))
+#endif
+
+enum simd_level { SIMD_UNKNOWN = -1, SIMD_NONE, SIMD_SSE2, SIMD_SSSE3 };
+
+static enum simd_level simd_level = SIMD_UNKNOWN;
+
+static enum simd_level get_simd_level(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    enum simd_level level = SIMD_NONE;
+
+    if (simd_level != SIMD_UNKNOWN) return simd_level;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2))
+        level = (ecx & bit_SSSE3) ? SIMD_SSSE3 : SIMD_SSE2;
+    TRACE("using simd level %u\n", level);
+    return simd_level = level;
+}
+
+/* 24bppBGR to 32bppBGRA, reads up to 4 bytes past the last pixel */
+static UINT SSSE3_FUNC expand_bgr24_ssse3(DWORD *dst, const BYTE *src, UINT len)
+{
+    const __m128i mask = _mm_setr_epi8(0, 1, 2, 0x80, 3, 4, 5, 0x80, 6, 7, 8, 0x80, 9, 10, 11, 0x80);
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    UINT x;
+
+    for (x=0; x+4 <= len; x+=4)
+        _mm_storeu_si128((__m128i *)(dst + x),
+            _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 3)), mask), alpha));
+    return x;
+}
+
+/* 48bppRGB to 32bppBGRA keeping the first byte of each channel, reads up to
+ * 4 bytes past the last pixel */
+static UINT SSSE3_FUNC narrow_rgb48_ssse3(DWORD *dst, const BYTE *src, UINT len)
+{
+    const __m128i lo = _mm_setr_epi8(4, 2, 0, 0x80, 10, 8, 6, 0x80,
+                                     0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80);
+    const __m128i hi = _mm_setr_epi8(0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                     4, 2, 0, 0x80, 10, 8, 6, 0x80);
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    UINT x;
+
+    for (x=0; x+4 <= len; x+=4)
+    {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 6)), lo);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 6 + 12)), hi);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(_mm_or_si128(a, b), alpha));
+    }
+    return x;
+}
+
+/* 64bppRGBA to 32bppBGRA keeping the first byte of each channel */
+static UINT SSE2_FUNC narrow_rgba64_sse2(DWORD *dst, const BYTE *src, UINT len)
+{
+    const __m128i low_bytes = _mm_set1_epi16(0x00ff);
+    const __m128i ga = _mm_set1_epi32(0xff00ff00), r = _mm_set1_epi32(0x000000ff);
+    UINT x;
+
+    for (x=0; x+4 <= len; x+=4)
+    {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + x * 8)), low_bytes);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + x * 8 + 16)), low_bytes);
+        __m128i rgba = _mm_packus_epi16(a, b);
+
+        /* swap red and blue */
+        _mm_storeu_si128((__m128i *)(dst + x),
+            _mm_or_si128(_mm_and_si128(rgba, ga),
+                _mm_or_si128(_mm_slli_epi32(_mm_and_si128(rgba, r), 16),
+                             _mm_and_si128(_mm_srli_epi32(rgba, 16), r))));
+    }
+    return x;
+}
+
+static UINT SSE2_FUNC set_alpha_sse2(DWORD *pixels, UINT len)
+{
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    UINT x;
+
+    for (x=0; x+4 <= len; x+=4)
+        _mm_storeu_si128((__m128i *)(pixels + x),
+            _mm_or_si128(_mm_loadu_si128((const __m128i *)(pixels + x)), alpha));
+    return x;
+}
+
+/* color * alpha / 255, using (v + 1 + (v >> 8)) >> 8 == v / 255 for v <= 255 * 255 */
+static UINT SSE2_FUNC premultiply_sse2(DWORD *pixels, UINT len)
+{
+    const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+    const __m128i color = _mm_set1_epi32(0x00ffffff), alpha_mask = _mm_set1_epi32(0xff000000);
+    UINT x;
+
+    for (x=0; x+4 <= len; x+=4)
+    {
+        __m128i src = _mm_loadu_si128((const __m128i *)(pixels + x));
+        __m128i lo = _mm_unpacklo_epi8(src, zero), hi = _mm_unpackhi_epi8(src, zero);
+        __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+        __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+
+        lo = _mm_mullo_epi16(lo, alo);
+        hi = _mm_mullo_epi16(hi, ahi);
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+
+        _mm_storeu_si128((__m128i *)(pixels + x),
+            _mm_or_si128(_mm_and_si128(_mm_packus_epi16(lo, hi), color), _mm_and_si128(src, alpha_mask)));
+    }
+    return x;
+}
+
+static inline UINT expand_bgr24(DWORD *dst, const BYTE *src, UINT len)
+{
+    if (get_simd_level() < SIMD_SSSE3) return 0;
+    return expand_bgr24_ssse3(dst, src, len);
+}
+
+static inline UINT narrow_rgb48(DWORD *dst, const BYTE *src, UINT len)
+{
+    if (get_simd_level() < SIMD_SSSE3) return 0;
+    return narrow_rgb48_ssse3(dst, src, len);
+}
+
+static inline UINT narrow_rgba64(DWORD *dst, const BYTE *src, UINT len)
+{
+    if (get_simd_level() < SIMD_SSE2) return 0;
+    return narrow_rgba64_sse2(dst, src, len);
+}
+
+static inline UINT set_alpha(DWORD *pixels, UINT len)
+{
+    if (get_simd_level() < SIMD_SSE2) return 0;
+    return set_alpha_sse2(pixels, len);
+}
+
+static inline UINT premultiply(DWORD *pixels, UINT len)
+{
+    if (get_simd_level() < SIMD_SSE2) return 0;
+    return premultiply_sse2(pixels, len);
+}
+
+#else  /* no vector support */
+
+static inline UINT expand_bgr24(DWORD *dst, const BYTE *src, UINT len) { return 0; }
+static inline UINT narrow_rgb48(DWORD *dst, const BYTE *src, UINT len) { return 0; }
+static inline UINT narrow_rgba64(DWORD *dst, const BYTE *src, UINT len) { return 0; }
+static inline UINT set_alpha(DWORD *pixels, UINT len) { return 0; }
+static inline UINT premultiply(DWORD *pixels, UINT len) { return 0; }
+
+#endif
+
+/* Copy the source pixels straight into the destination buffer, where each
+ * source row fits at the start of its destination row, so that the rows can
+ * be converted one at a time. The returned row buffer has room for one source
+ * row plus the bytes the vector loops may read past its end. */
+static HRESULT copypixels_in_place(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, UINT srcstride, BYTE **row)
+{
+    HRESULT res;
+
+    *row = HeapAlloc(GetProcessHeap(), 0, srcstride + 16);
+    if (!*row) return E_OUTOFMEMORY;
+
+    res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+    if (FAILED(res))
+    {
+        HeapFree(GetProcessHeap(), 0, *row);
+        *row = NULL;
+    }
+
+    return res;
+}
+
+/* Source rows that don't fit in the destination are read in bands of about
+ * this many bytes. */
+#define CONVERT_BAND_SIZE 65536
+
 static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRect *prc,
     UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, enum pixelformat source_format)
 {
@@ -104,8 +297,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const BYTE *srcbyte;
             BYTE *dstrow;
             DWORD *dstpixel;
@@ -133,35 +325,28 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             }
 
             srcstride = (prc->Width+7)/8;
-            srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x+=8) {
-                        BYTE srcval;
-                        srcval=*srcbyte++;
-                        *dstpixel++ = colors[srcval>>7&1];
-                        if (x+1 < prc->Width) *dstpixel++ = colors[srcval>>6&1];
-                        if (x+2 < prc->Width) *dstpixel++ = colors[srcval>>5&1];
-                        if (x+3 < prc->Width) *dstpixel++ = colors[srcval>>4&1];
-                        if (x+4 < prc->Width) *dstpixel++ = colors[srcval>>3&1];
-                        if (x+5 < prc->Width) *dstpixel++ = colors[srcval>>2&1];
-                        if (x+6 < prc->Width) *dstpixel++ = colors[srcval>>1&1];
-                        if (x+7 < prc->Width) *dstpixel++ = colors[srcval&1];
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcbyte = srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x+=8) {
+                    BYTE srcval;
+                    srcval=*srcbyte++;
+                    *dstpixel++ = colors[srcval>>7&1];
+                    if (x+1 < prc->Width) *dstpixel++ = colors[srcval>>6&1];
+                    if (x+2 < prc->Width) *dstpixel++ = colors[srcval>>5&1];
+                    if (x+3 < prc->Width) *dstpixel++ = colors[srcval>>4&1];
+                    if (x+4 < prc->Width) *dstpixel++ = colors[srcval>>3&1];
+                    if (x+5 < prc->Width) *dstpixel++ = colors[srcval>>2&1];
+                    if (x+6 < prc->Width) *dstpixel++ = colors[srcval>>1&1];
+                    if (x+7 < prc->Width) *dstpixel++ = colors[srcval&1];
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -176,8 +361,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const BYTE *srcbyte;
             BYTE *dstrow;
             DWORD *dstpixel;
@@ -202,31 +386,24 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 make_grayscale_palette(colors, 4);
 
             srcstride = (prc->Width+3)/4;
-            srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x+=4) {
-                        BYTE srcval;
-                        srcval=*srcbyte++;
-                        *dstpixel++ = colors[srcval>>6];
-                        if (x+1 < prc->Width) *dstpixel++ = colors[srcval>>4&0x3];
-                        if (x+2 < prc->Width) *dstpixel++ = colors[srcval>>2&0x3];
-                        if (x+1 < prc->Width) *dstpixel++ = colors[srcval&0x3];
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcbyte = srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x+=4) {
+                    BYTE srcval;
+                    srcval=*srcbyte++;
+                    *dstpixel++ = colors[srcval>>6];
+                    if (x+1 < prc->Width) *dstpixel++ = colors[srcval>>4&0x3];
+                    if (x+2 < prc->Width) *dstpixel++ = colors[srcval>>2&0x3];
+                    if (x+3 < prc->Width) *dstpixel++ = colors[srcval&0x3];
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -241,8 +418,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const BYTE *srcbyte;
             BYTE *dstrow;
             DWORD *dstpixel;
@@ -267,29 +443,22 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 make_grayscale_palette(colors, 16);
 
             srcstride = (prc->Width+1)/2;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x+=2) {
-                        BYTE srcval;
-                        srcval=*srcbyte++;
-                        *dstpixel++ = colors[srcval>>4];
-                        if (x+1 < prc->Width) *dstpixel++ = colors[srcval&0xf];
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcbyte = srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x+=2) {
+                    BYTE srcval;
+                    srcval=*srcbyte++;
+                    *dstpixel++ = colors[srcval>>4];
+                    if (x+1 < prc->Width) *dstpixel++ = colors[srcval&0xf];
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -303,35 +472,27 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const BYTE *srcbyte;
             BYTE *dstrow;
             DWORD *dstpixel;
 
             srcstride = prc->Width;
-            srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++)
-                    {
-                        *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
-                        srcbyte++;
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcbyte = srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x++)
+                {
+                    *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
+                    srcbyte++;
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -345,8 +506,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const BYTE *srcbyte;
             BYTE *dstrow;
             DWORD *dstpixel;
@@ -366,25 +526,27 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             if (FAILED(res)) return res;
 
             srcstride = prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++)
-                        *dstpixel++ = colors[*srcbyte++];
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcbyte = srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x+4<=prc->Width; x+=4)
+                {
+                    dstpixel[0] = colors[srcbyte[0]];
+                    dstpixel[1] = colors[srcbyte[1]];
+                    dstpixel[2] = colors[srcbyte[2]];
+                    dstpixel[3] = colors[srcbyte[3]];
+                    dstpixel += 4;
+                    srcbyte += 4;
                 }
+                for (; x<prc->Width; x++)
+                    *dstpixel++ = colors[*srcbyte++];
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -398,35 +560,27 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const BYTE *srcbyte;
             BYTE *dstrow;
             DWORD *dstpixel;
 
             srcstride = prc->Width * 2;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++)
-                    {
-                        *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
-                        srcbyte+=2;
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcbyte = srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x++)
+                {
+                    *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
+                    srcbyte+=2;
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -440,41 +594,33 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const WORD *srcpixel;
             BYTE *dstrow;
             DWORD *dstpixel;
 
             srcstride = 2 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=(const WORD*)srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        WORD srcval;
-                        srcval=*srcpixel++;
-                        *dstpixel++=0xff000000 | /* constant 255 alpha */
-                                    ((srcval << 9) & 0xf80000) | /* r */
-                                    ((srcval << 4) & 0x070000) | /* r - 3 bits */
-                                    ((srcval << 6) & 0x00f800) | /* g */
-                                    ((srcval << 1) & 0x000700) | /* g - 3 bits */
-                                    ((srcval << 3) & 0x0000f8) | /* b */
-                                    ((srcval >> 2) & 0x000007);  /* b - 3 bits */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcpixel=(const WORD*)srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x++) {
+                    WORD srcval;
+                    srcval=*srcpixel++;
+                    *dstpixel++=0xff000000 | /* constant 255 alpha */
+                                ((srcval << 9) & 0xf80000) | /* r */
+                                ((srcval << 4) & 0x070000) | /* r - 3 bits */
+                                ((srcval << 6) & 0x00f800) | /* g */
+                                ((srcval << 1) & 0x000700) | /* g - 3 bits */
+                                ((srcval << 3) & 0x0000f8) | /* b */
+                                ((srcval >> 2) & 0x000007);  /* b - 3 bits */
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -488,41 +634,33 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const WORD *srcpixel;
             BYTE *dstrow;
             DWORD *dstpixel;
 
             srcstride = 2 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=(const WORD*)srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        WORD srcval;
-                        srcval=*srcpixel++;
-                        *dstpixel++=0xff000000 | /* constant 255 alpha */
-                                    ((srcval << 8) & 0xf80000) | /* r */
-                                    ((srcval << 3) & 0x070000) | /* r - 3 bits */
-                                    ((srcval << 5) & 0x00fc00) | /* g */
-                                    ((srcval >> 1) & 0x000300) | /* g - 2 bits */
-                                    ((srcval << 3) & 0x0000f8) | /* b */
-                                    ((srcval >> 2) & 0x000007);  /* b - 3 bits */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcpixel=(const WORD*)srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x++) {
+                    WORD srcval;
+                    srcval=*srcpixel++;
+                    *dstpixel++=0xff000000 | /* constant 255 alpha */
+                                ((srcval << 8) & 0xf80000) | /* r */
+                                ((srcval << 3) & 0x070000) | /* r - 3 bits */
+                                ((srcval << 5) & 0x00fc00) | /* g */
+                                ((srcval >> 1) & 0x000300) | /* g - 2 bits */
+                                ((srcval << 3) & 0x0000f8) | /* b */
+                                ((srcval >> 2) & 0x000007);  /* b - 3 bits */
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -536,41 +674,33 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const WORD *srcpixel;
             BYTE *dstrow;
             DWORD *dstpixel;
 
             srcstride = 2 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=(const WORD*)srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        WORD srcval;
-                        srcval=*srcpixel++;
-                        *dstpixel++=((srcval & 0x8000) ? 0xff000000 : 0) | /* alpha */
-                                    ((srcval << 9) & 0xf80000) | /* r */
-                                    ((srcval << 4) & 0x070000) | /* r - 3 bits */
-                                    ((srcval << 6) & 0x00f800) | /* g */
-                                    ((srcval << 1) & 0x000700) | /* g - 3 bits */
-                                    ((srcval << 3) & 0x0000f8) | /* b */
-                                    ((srcval >> 2) & 0x000007);  /* b - 3 bits */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                srcpixel=(const WORD*)srcdata;
+                dstpixel=(DWORD*)dstrow;
+                for (x=0; x<prc->Width; x++) {
+                    WORD srcval;
+                    srcval=*srcpixel++;
+                    *dstpixel++=((srcval & 0x8000) ? 0xff000000 : 0) | /* alpha */
+                                ((srcval << 9) & 0xf80000) | /* r */
+                                ((srcval << 4) & 0x070000) | /* r - 3 bits */
+                                ((srcval << 6) & 0x00f800) | /* g */
+                                ((srcval << 1) & 0x000700) | /* g - 3 bits */
+                                ((srcval << 3) & 0x0000f8) | /* b */
+                                ((srcval >> 2) & 0x000007);  /* b - 3 bits */
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -584,36 +714,29 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             UINT x, y;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride;
             const BYTE *srcpixel;
             BYTE *dstrow;
             BYTE *dstpixel;
 
             srcstride = 3 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = copypixels_in_place(This, prc, cbStride, cbBufferSize, pbBuffer, srcstride, &srcdata);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y++) {
+                memcpy(srcdata, dstrow, srcstride);
+                x = expand_bgr24((DWORD*)dstrow, srcdata, prc->Width);
+                srcpixel=srcdata+3*x;
+                dstpixel=dstrow+4*x;
+                for (; x<prc->Width; x++) {
+                    *dstpixel++=*srcpixel++; /* blue */
+                    *dstpixel++=*srcpixel++; /* green */
+                    *dstpixel++=*srcpixel++; /* red */
+                    *dstpixel++=255; /* alpha */
                 }
+                dstrow += cbStride;
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -632,8 +755,12 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+            {
+                DWORD *dstpixel = (DWORD*)(pbBuffer+cbStride*y);
+
+                for (x=set_alpha(dstpixel, prc->Width); x<prc->Width; x++)
+                    dstpixel[x] |= 0xff000000;
+            }
         }
         return S_OK;
     case format_32bppBGRA:
@@ -665,38 +792,42 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
     case format_48bppRGB:
         if (prc)
         {
-            HRESULT res;
-            UINT x, y;
+            HRESULT res = S_OK;
+            UINT x, y, row;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride, bandrows;
             const BYTE *srcpixel;
             BYTE *dstrow;
             DWORD *dstpixel;
+            WICRect rc;
 
             srcstride = 6 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
+            bandrows = srcstride ? max(1, min(prc->Height, CONVERT_BAND_SIZE / srcstride)) : 1;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = HeapAlloc(GetProcessHeap(), 0, srcstride * bandrows + 16);
             if (!srcdata) return E_OUTOFMEMORY;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            rc = *prc;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y+=bandrows) {
+                rc.Y = prc->Y + y;
+                rc.Height = min(bandrows, prc->Height - y);
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
+                res = IWICBitmapSource_CopyPixels(This->source, &rc, srcstride, srcstride * rc.Height, srcdata);
+                if (FAILED(res)) break;
+
+                for (row=0; row<rc.Height; row++) {
                     dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++) {
+                    x = narrow_rgb48(dstpixel, srcdata+srcstride*row, prc->Width);
+                    srcpixel=srcdata+srcstride*row+6*x;
+                    dstpixel+=x;
+                    for (; x<prc->Width; x++) {
                         BYTE red, green, blue;
                         red = *srcpixel++; srcpixel++;
                         green = *srcpixel++; srcpixel++;
                         blue = *srcpixel++; srcpixel++;
                         *dstpixel++=0xff000000|red<<16|green<<8|blue;
                     }
-                    srcrow += srcstride;
                     dstrow += cbStride;
                 }
             }
@@ -709,31 +840,36 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
     case format_64bppRGBA:
         if (prc)
         {
-            HRESULT res;
-            UINT x, y;
+            HRESULT res = S_OK;
+            UINT x, y, row;
             BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
+            UINT srcstride, bandrows;
             const BYTE *srcpixel;
             BYTE *dstrow;
             DWORD *dstpixel;
+            WICRect rc;
 
             srcstride = 8 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
+            bandrows = srcstride ? max(1, min(prc->Height, CONVERT_BAND_SIZE / srcstride)) : 1;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+            srcdata = HeapAlloc(GetProcessHeap(), 0, srcstride * bandrows);
             if (!srcdata) return E_OUTOFMEMORY;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            rc = *prc;
+            dstrow = pbBuffer;
+            for (y=0; y<prc->Height; y+=bandrows) {
+                rc.Y = prc->Y + y;
+                rc.Height = min(bandrows, prc->Height - y);
 
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
+                res = IWICBitmapSource_CopyPixels(This->source, &rc, srcstride, srcstride * rc.Height, srcdata);
+                if (FAILED(res)) break;
+
+                for (row=0; row<rc.Height; row++) {
                     dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++) {
+                    x = narrow_rgba64(dstpixel, srcdata+srcstride*row, prc->Width);
+                    srcpixel=srcdata+srcstride*row+8*x;
+                    dstpixel+=x;
+                    for (; x<prc->Width; x++) {
                         BYTE red, green, blue, alpha;
                         red = *srcpixel++; srcpixel++;
                         green = *srcpixel++; srcpixel++;
@@ -741,7 +877,6 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                         alpha = *srcpixel++; srcpixel++;
                         *dstpixel++=alpha<<24|red<<16|green<<8|blue;
                     }
-                    srcrow += srcstride;
                     dstrow += cbStride;
                 }
             }
@@ -811,7 +946,7 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
             UINT x, y;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
+                for (x=premultiply((DWORD*)(pbBuffer+cbStride*y), prc->Width); x<prc->Width; x++)
                 {
                     BYTE alpha = pbBuffer[cbStride*y+4*x+3];
                     if (alpha != 255)
@@ -258,8 +258,8 @@ static HRESULT WINAPI ImagingFactory_CreateFormatConverter(IWICImagingFactory *i
 static HRESULT WINAPI ImagingFactory_CreateBitmapScaler(IWICImagingFactory *iface,
     IWICBitmapScaler **ppIBitmapScaler)
 {
-    FIXME("(%p,%p): stub\n", iface, ppIBitmapScaler);
-    return E_NOTIMPL;
+    TRACE("(%p,%p)\n", iface, ppIBitmapScaler);
+    return BitmapScaler_Create(ppIBitmapScaler);
 }
 
 static HRESULT WINAPI ImagingFactory_CreateBitmapClipper(IWICImagingFactory *iface,
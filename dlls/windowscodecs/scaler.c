@@ -0,0 +1,656 @@
+/*
+ * Copyright 2011 The Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+
+#include <stdarg.h>
+#include <math.h>
+
+#define COBJMACROS
+
+#include "windef.h"
+#include "winbase.h"
+#include "objbase.h"
+#include "wincodec.h"
+
+#include "wincodecs_private.h"
+
+#include "wine/debug.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
+
+/* Number of source rows fetched from the source at once. */
+#define SCALER_BAND_ROWS 16
+
+struct scaler_format {
+    const WICPixelFormatGUID *guid;
+    UINT bpp;
+    UINT channels; /* number of 8-bit channels, 0 if the format can't be filtered */
+};
+
+static const struct scaler_format scaler_formats[] = {
+    {&GUID_WICPixelFormat1bppIndexed, 1, 0},
+    {&GUID_WICPixelFormat2bppIndexed, 2, 0},
+    {&GUID_WICPixelFormat4bppIndexed, 4, 0},
+    {&GUID_WICPixelFormat8bppIndexed, 8, 0},
+    {&GUID_WICPixelFormatBlackWhite, 1, 0},
+    {&GUID_WICPixelFormat2bppGray, 2, 0},
+    {&GUID_WICPixelFormat4bppGray, 4, 0},
+    {&GUID_WICPixelFormat8bppGray, 8, 1},
+    {&GUID_WICPixelFormat16bppGray, 16, 0},
+    {&GUID_WICPixelFormat16bppBGR555, 16, 0},
+    {&GUID_WICPixelFormat16bppBGR565, 16, 0},
+    {&GUID_WICPixelFormat16bppBGRA5551, 16, 0},
+    {&GUID_WICPixelFormat24bppBGR, 24, 3},
+    {&GUID_WICPixelFormat32bppBGR, 32, 4},
+    {&GUID_WICPixelFormat32bppBGRA, 32, 4},
+    {&GUID_WICPixelFormat32bppPBGRA, 32, 4},
+    {&GUID_WICPixelFormat48bppRGB, 48, 0},
+    {&GUID_WICPixelFormat64bppRGBA, 64, 0},
+    {&GUID_WICPixelFormat32bppCMYK, 32, 4},
+    {NULL}
+};
+
+/* Weights of a separable filter along one axis, in 1.14 fixed point. */
+struct scaler_filter {
+    UINT taps;      /* number of source pixels per destination pixel */
+    UINT *index;    /* source pixel of each tap */
+    INT *coeffs;    /* weight of each tap, they add up to 1 << 14 */
+};
+
+typedef struct BitmapScaler {
+    IWICBitmapScaler IWICBitmapScaler_iface;
+    LONG ref;
+    IWICBitmapSource *source;
+    UINT width, height;
+    UINT src_width, src_height;
+    const struct scaler_format *format;
+    WICBitmapInterpolationMode mode;
+    struct scaler_filter xfilter, yfilter;
+    CRITICAL_SECTION lock; /* must be held when initialized */
+} BitmapScaler;
+
+static inline BitmapScaler *impl_from_IWICBitmapScaler(IWICBitmapScaler *iface)
+{
+    return CONTAINING_RECORD(iface, BitmapScaler, IWICBitmapScaler_iface);
+}
+
+static const struct scaler_format *get_scaler_format(const WICPixelFormatGUID *format)
+{
+    UINT i;
+
+    for (i=0; scaler_formats[i].guid; i++)
+        if (IsEqualGUID(scaler_formats[i].guid, format)) return &scaler_formats[i];
+
+    return NULL;
+}
+
+static double filter_kernel(WICBitmapInterpolationMode mode, double x)
+{
+    x = fabs(x);
+
+    if (mode == WICBitmapInterpolationModeCubic)
+    {
+        /* Keys cubic convolution, a = -0.5 */
+        if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+        if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+        return 0.0;
+    }
+
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+static void free_scaler_filter(struct scaler_filter *filter)
+{
+    HeapFree(GetProcessHeap(), 0, filter->index);
+    HeapFree(GetProcessHeap(), 0, filter->coeffs);
+    filter->index = NULL;
+    filter->coeffs = NULL;
+}
+
+static HRESULT init_scaler_filter(struct scaler_filter *filter, WICBitmapInterpolationMode mode,
+    UINT src_size, UINT dst_size)
+{
+    double scale = (double)src_size / dst_size, support, *weights;
+    UINT i, j;
+
+    /* Fant shrinks by averaging the covered area, the others widen their
+     * kernel so that every source pixel contributes. */
+    support = mode == WICBitmapInterpolationModeCubic ? 2.0 : 1.0;
+    if (scale > 1.0)
+        support *= scale;
+
+    if (mode == WICBitmapInterpolationModeFant && scale > 1.0)
+        filter->taps = (UINT)ceil(scale) + 1;
+    else
+        filter->taps = (UINT)ceil(support * 2.0);
+
+    filter->index = HeapAlloc(GetProcessHeap(), 0, sizeof(UINT) * filter->taps * dst_size);
+    filter->coeffs = HeapAlloc(GetProcessHeap(), 0, sizeof(INT) * filter->taps * dst_size);
+    weights = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * filter->taps);
+    if (!filter->index || !filter->coeffs || !weights)
+    {
+        free_scaler_filter(filter);
+        HeapFree(GetProcessHeap(), 0, weights);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i=0; i<dst_size; i++)
+    {
+        UINT *index = filter->index + i * filter->taps;
+        INT *coeffs = filter->coeffs + i * filter->taps;
+        INT first, total = 0, largest = 0;
+        double sum = 0.0;
+
+        if (mode == WICBitmapInterpolationModeFant && scale > 1.0)
+        {
+            double start = i * scale, end = (i + 1) * scale;
+
+            first = (INT)floor(start);
+            for (j=0; j<filter->taps; j++)
+            {
+                double left = max(start, first + j), right = min(end, first + j + 1);
+                weights[j] = right > left ? right - left : 0.0;
+            }
+        }
+        else
+        {
+            double center = (i + 0.5) * scale - 0.5;
+
+            first = (INT)floor(center - support) + 1;
+            for (j=0; j<filter->taps; j++)
+                weights[j] = filter_kernel(mode, (first + (INT)j - center) * (scale > 1.0 ? 1.0 / scale : 1.0));
+        }
+
+        for (j=0; j<filter->taps; j++)
+            sum += weights[j];
+
+        for (j=0; j<filter->taps; j++)
+        {
+            INT pos = first + (INT)j;
+
+            index[j] = pos < 0 ? 0 : (pos >= (INT)src_size ? src_size - 1 : pos);
+            coeffs[j] = (INT)floor(weights[j] / sum * (1 << 14) + 0.5);
+            total += coeffs[j];
+            if (coeffs[j] > coeffs[largest]) largest = j;
+        }
+        coeffs[largest] += (1 << 14) - total;
+    }
+
+    HeapFree(GetProcessHeap(), 0, weights);
+
+    return S_OK;
+}
+
+/* Filter one source row horizontally, the result has 8 fractional bits. */
+static void scale_row(const struct scaler_filter *filter, UINT channels, const BYTE *src,
+    UINT src_x, UINT x, UINT width, INT *dst)
+{
+    const UINT *index = filter->index + x * filter->taps;
+    const INT *coeffs = filter->coeffs + x * filter->taps;
+    UINT i, j, c;
+
+    for (i=0; i<width; i++)
+    {
+        INT sum[4] = {0, 0, 0, 0};
+
+        for (j=0; j<filter->taps; j++)
+        {
+            const BYTE *pixel = src + (index[j] - src_x) * channels;
+
+            for (c=0; c<channels; c++)
+                sum[c] += coeffs[j] * pixel[c];
+        }
+
+        for (c=0; c<channels; c++)
+            *dst++ = (sum[c] + (1 << 5)) >> 6;
+
+        index += filter->taps;
+        coeffs += filter->taps;
+    }
+}
+
+static HRESULT scale_filtered(BitmapScaler *This, const WICRect *prc, UINT cbStride, BYTE *pbBuffer)
+{
+    const struct scaler_filter *xfilter = &This->xfilter, *yfilter = &This->yfilter;
+    UINT channels = This->format->channels, count = prc->Width * channels;
+    UINT src_x, src_right, src_bottom, band_start = 0, band_rows = 0, src_stride;
+    UINT x, y, i, *row_tags;
+    INT *rows, *sums;
+    BYTE *band;
+    HRESULT hr = S_OK;
+
+    /* the source columns and rows this rectangle depends on */
+    src_x = xfilter->index[prc->X * xfilter->taps];
+    src_right = xfilter->index[(prc->X + prc->Width) * xfilter->taps - 1] + 1;
+    src_bottom = yfilter->index[(prc->Y + prc->Height) * yfilter->taps - 1] + 1;
+    src_stride = (src_right - src_x) * channels;
+
+    band = HeapAlloc(GetProcessHeap(), 0, src_stride * SCALER_BAND_ROWS);
+    rows = HeapAlloc(GetProcessHeap(), 0, sizeof(INT) * count * yfilter->taps);
+    row_tags = HeapAlloc(GetProcessHeap(), 0, sizeof(UINT) * yfilter->taps);
+    sums = HeapAlloc(GetProcessHeap(), 0, sizeof(INT) * count);
+    if (!band || !rows || !row_tags || !sums)
+    {
+        hr = E_OUTOFMEMORY;
+        goto end;
+    }
+
+    for (i=0; i<yfilter->taps; i++)
+        row_tags[i] = ~0u;
+
+    for (y=prc->Y; y - prc->Y < prc->Height; y++)
+    {
+        const UINT *index = yfilter->index + y * yfilter->taps;
+        const INT *coeffs = yfilter->coeffs + y * yfilter->taps;
+        BYTE *dst = pbBuffer + cbStride * (y - prc->Y);
+
+        memset(sums, 0, sizeof(INT) * count);
+
+        for (i=0; i<yfilter->taps; i++)
+        {
+            /* the taps of consecutive rows slide forward, so a source row
+             * always maps to the same slot while it is needed */
+            UINT srcy = index[i], slot = srcy % yfilter->taps;
+            INT *row = rows + count * slot;
+
+            if (row_tags[slot] != srcy)
+            {
+                if (srcy < band_start || srcy >= band_start + band_rows)
+                {
+                    WICRect rc;
+
+                    band_start = srcy;
+                    band_rows = min(SCALER_BAND_ROWS, src_bottom - srcy);
+
+                    rc.X = src_x;
+                    rc.Y = band_start;
+                    rc.Width = src_right - src_x;
+                    rc.Height = band_rows;
+
+                    hr = IWICBitmapSource_CopyPixels(This->source, &rc, src_stride,
+                        src_stride * band_rows, band);
+                    if (FAILED(hr)) goto end;
+                }
+
+                scale_row(xfilter, channels, band + src_stride * (srcy - band_start),
+                    src_x, prc->X, prc->Width, row);
+                row_tags[slot] = srcy;
+            }
+
+            for (x=0; x<count; x++)
+                sums[x] += coeffs[i] * row[x];
+        }
+
+        for (x=0; x<count; x++)
+        {
+            INT value = (sums[x] + (1 << 21)) >> 22;
+            dst[x] = value < 0 ? 0 : (value > 255 ? 255 : value);
+        }
+    }
+
+end:
+    HeapFree(GetProcessHeap(), 0, band);
+    HeapFree(GetProcessHeap(), 0, rows);
+    HeapFree(GetProcessHeap(), 0, row_tags);
+    HeapFree(GetProcessHeap(), 0, sums);
+    return hr;
+}
+
+static inline UINT nearest_pixel(UINT x, UINT src_size, UINT dst_size)
+{
+    return (UINT)(((ULONGLONG)x * 2 + 1) * src_size / (dst_size * 2ull));
+}
+
+static HRESULT scale_nearest(BitmapScaler *This, const WICRect *prc, UINT cbStride, BYTE *pbBuffer)
+{
+    UINT bpp = This->format->bpp, bytesperpixel = bpp / 8;
+    UINT src_x, src_right, src_stride, srcy = ~0u, x, y, *columns;
+    BYTE *row;
+    HRESULT hr = S_OK;
+
+    columns = HeapAlloc(GetProcessHeap(), 0, sizeof(UINT) * prc->Width);
+    if (!columns) return E_OUTOFMEMORY;
+
+    for (x=0; x<prc->Width; x++)
+        columns[x] = nearest_pixel(prc->X + x, This->src_width, This->width);
+
+    /* sources don't have to support copying from the middle of a byte */
+    src_x = columns[0];
+    if (bpp < 8) src_x &= ~(8 / bpp - 1);
+    src_right = columns[prc->Width - 1] + 1;
+    src_stride = ((src_right - src_x) * bpp + 7) / 8;
+
+    row = HeapAlloc(GetProcessHeap(), 0, src_stride);
+    if (!row)
+    {
+        HeapFree(GetProcessHeap(), 0, columns);
+        return E_OUTOFMEMORY;
+    }
+
+    for (y=prc->Y; y - prc->Y < prc->Height; y++)
+    {
+        BYTE *dst = pbBuffer + cbStride * (y - prc->Y);
+
+        if (srcy != nearest_pixel(y, This->src_height, This->height))
+        {
+            WICRect rc;
+
+            srcy = nearest_pixel(y, This->src_height, This->height);
+
+            rc.X = src_x;
+            rc.Y = srcy;
+            rc.Width = src_right - src_x;
+            rc.Height = 1;
+
+            hr = IWICBitmapSource_CopyPixels(This->source, &rc, src_stride, src_stride, row);
+            if (FAILED(hr)) break;
+        }
+
+        if (bpp >= 8)
+        {
+            for (x=0; x<prc->Width; x++)
+                memcpy(dst + x * bytesperpixel, row + (columns[x] - src_x) * bytesperpixel, bytesperpixel);
+        }
+        else
+        {
+            BYTE mask = (1 << bpp) - 1;
+
+            memset(dst, 0, (prc->Width * bpp + 7) / 8);
+            for (x=0; x<prc->Width; x++)
+            {
+                UINT srcbit = (columns[x] - src_x) * bpp, dstbit = x * bpp;
+                BYTE value = (row[srcbit / 8] >> (8 - bpp - srcbit % 8)) & mask;
+                dst[dstbit / 8] |= value << (8 - bpp - dstbit % 8);
+            }
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, row);
+    HeapFree(GetProcessHeap(), 0, columns);
+    return hr;
+}
+
+static HRESULT WINAPI BitmapScaler_QueryInterface(IWICBitmapScaler *iface, REFIID iid,
+    void **ppv)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    TRACE("(%p,%s,%p)\n", iface, debugstr_guid(iid), ppv);
+
+    if (!ppv) return E_INVALIDARG;
+
+    if (IsEqualIID(&IID_IUnknown, iid) ||
+        IsEqualIID(&IID_IWICBitmapSource, iid) ||
+        IsEqualIID(&IID_IWICBitmapScaler, iid))
+    {
+        *ppv = This;
+    }
+    else
+    {
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+
+    IUnknown_AddRef((IUnknown*)*ppv);
+    return S_OK;
+}
+
+static ULONG WINAPI BitmapScaler_AddRef(IWICBitmapScaler *iface)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    ULONG ref = InterlockedIncrement(&This->ref);
+
+    TRACE("(%p) refcount=%u\n", iface, ref);
+
+    return ref;
+}
+
+static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    ULONG ref = InterlockedDecrement(&This->ref);
+
+    TRACE("(%p) refcount=%u\n", iface, ref);
+
+    if (ref == 0)
+    {
+        This->lock.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&This->lock);
+        if (This->source) IWICBitmapSource_Release(This->source);
+        free_scaler_filter(&This->xfilter);
+        free_scaler_filter(&This->yfilter);
+        HeapFree(GetProcessHeap(), 0, This);
+    }
+
+    return ref;
+}
+
+static HRESULT WINAPI BitmapScaler_GetSize(IWICBitmapScaler *iface,
+    UINT *puiWidth, UINT *puiHeight)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    TRACE("(%p,%p,%p)\n", iface, puiWidth, puiHeight);
+
+    if (!puiWidth || !puiHeight)
+        return E_INVALIDARG;
+
+    if (!This->source)
+        return WINCODEC_ERR_NOTINITIALIZED;
+
+    *puiWidth = This->width;
+    *puiHeight = This->height;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI BitmapScaler_GetPixelFormat(IWICBitmapScaler *iface,
+    WICPixelFormatGUID *pPixelFormat)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    TRACE("(%p,%p)\n", iface, pPixelFormat);
+
+    if (!pPixelFormat)
+        return E_INVALIDARG;
+
+    if (!This->source)
+        return WINCODEC_ERR_NOTINITIALIZED;
+
+    memcpy(pPixelFormat, This->format->guid, sizeof(GUID));
+
+    return S_OK;
+}
+
+static HRESULT WINAPI BitmapScaler_GetResolution(IWICBitmapScaler *iface,
+    double *pDpiX, double *pDpiY)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    TRACE("(%p,%p,%p)\n", iface, pDpiX, pDpiY);
+
+    if (!This->source)
+        return WINCODEC_ERR_NOTINITIALIZED;
+
+    return IWICBitmapSource_GetResolution(This->source, pDpiX, pDpiY);
+}
+
+static HRESULT WINAPI BitmapScaler_CopyPalette(IWICBitmapScaler *iface,
+    IWICPalette *pIPalette)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    TRACE("(%p,%p)\n", iface, pIPalette);
+
+    if (!This->source)
+        return WINCODEC_ERR_NOTINITIALIZED;
+
+    return IWICBitmapSource_CopyPalette(This->source, pIPalette);
+}
+
+static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
+    const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    UINT bytesperrow;
+    WICRect rect;
+
+    TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
+
+    if (!This->source)
+        return WINCODEC_ERR_NOTINITIALIZED;
+
+    if (!prc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = This->width;
+        rect.Height = This->height;
+        prc = &rect;
+    }
+    else
+    {
+        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->width || prc->Y+prc->Height > This->height)
+            return E_INVALIDARG;
+    }
+
+    if (!pbBuffer)
+        return E_INVALIDARG;
+
+    if (prc->Width <= 0 || prc->Height <= 0)
+        return S_OK;
+
+    bytesperrow = (This->format->bpp * prc->Width + 7) / 8;
+
+    if (cbStride < bytesperrow)
+        return E_INVALIDARG;
+
+    if ((cbStride * prc->Height) > cbBufferSize)
+        return E_INVALIDARG;
+
+    if (This->mode == WICBitmapInterpolationModeNearestNeighbor)
+        return scale_nearest(This, prc, cbStride, pbBuffer);
+    else
+        return scale_filtered(This, prc, cbStride, pbBuffer);
+}
+
+static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
+    IWICBitmapSource *pISource, UINT uiWidth, UINT uiHeight,
+    WICBitmapInterpolationMode mode)
+{
+    BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    WICPixelFormatGUID src_format;
+    HRESULT hr;
+
+    TRACE("(%p,%p,%u,%u,%u)\n", iface, pISource, uiWidth, uiHeight, mode);
+
+    if (!pISource || !uiWidth || !uiHeight)
+        return E_INVALIDARG;
+
+    if (mode > WICBitmapInterpolationModeFant)
+        return E_INVALIDARG;
+
+    EnterCriticalSection(&This->lock);
+
+    if (This->source)
+    {
+        hr = WINCODEC_ERR_WRONGSTATE;
+        goto end;
+    }
+
+    hr = IWICBitmapSource_GetSize(pISource, &This->src_width, &This->src_height);
+    if (FAILED(hr)) goto end;
+
+    hr = IWICBitmapSource_GetPixelFormat(pISource, &src_format);
+    if (FAILED(hr)) goto end;
+
+    This->format = get_scaler_format(&src_format);
+    if (!This->format)
+    {
+        FIXME("Unsupported source format %s\n", debugstr_guid(&src_format));
+        hr = WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+        goto end;
+    }
+
+    if (mode != WICBitmapInterpolationModeNearestNeighbor && !This->format->channels)
+    {
+        FIXME("Can't filter %s, using nearest neighbor\n", debugstr_guid(&src_format));
+        mode = WICBitmapInterpolationModeNearestNeighbor;
+    }
+
+    if (mode != WICBitmapInterpolationModeNearestNeighbor)
+    {
+        hr = init_scaler_filter(&This->xfilter, mode, This->src_width, uiWidth);
+        if (FAILED(hr)) goto end;
+
+        hr = init_scaler_filter(&This->yfilter, mode, This->src_height, uiHeight);
+        if (FAILED(hr))
+        {
+            free_scaler_filter(&This->xfilter);
+            goto end;
+        }
+    }
+
+    This->width = uiWidth;
+    This->height = uiHeight;
+    This->mode = mode;
+
+    IWICBitmapSource_AddRef(pISource);
+    This->source = pISource;
+
+end:
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
+}
+
+static const IWICBitmapScalerVtbl BitmapScaler_Vtbl = {
+    BitmapScaler_QueryInterface,
+    BitmapScaler_AddRef,
+    BitmapScaler_Release,
+    BitmapScaler_GetSize,
+    BitmapScaler_GetPixelFormat,
+    BitmapScaler_GetResolution,
+    BitmapScaler_CopyPalette,
+    BitmapScaler_CopyPixels,
+    BitmapScaler_Initialize
+};
+
+HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
+{
+    BitmapScaler *This;
+
+    This = HeapAlloc(GetProcessHeap(), 0, sizeof(BitmapScaler));
+    if (!This) return E_OUTOFMEMORY;
+
+    This->IWICBitmapScaler_iface.lpVtbl = &BitmapScaler_Vtbl;
+    This->ref = 1;
+    This->source = NULL;
+    This->width = 0;
+    This->height = 0;
+    This->src_width = 0;
+    This->src_height = 0;
+    This->format = NULL;
+    This->mode = WICBitmapInterpolationModeNearestNeighbor;
+    This->xfilter.taps = 0;
+    This->xfilter.index = NULL;
+    This->xfilter.coeffs = NULL;
+    This->yfilter = This->xfilter;
+    InitializeCriticalSection(&This->lock);
+    This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
+
+    *scaler = &This->IWICBitmapScaler_iface;
+
+    return S_OK;
+}
@@ -289,6 +289,14 @@ static const BYTE bits_32bppBGRA[] = {
 static const struct bitmap_data testdata_32bppBGRA = {
     &GUID_WICPixelFormat32bppBGRA, 32, bits_32bppBGRA, 4, 2, 96.0, 96.0};
 
+static const BYTE bits_24bppBGR_2x[] = {
+    255,0,0, 255,0,0, 0,255,0, 0,255,0, 0,0,255, 0,0,255, 0,0,0, 0,0,0,
+    255,0,0, 255,0,0, 0,255,0, 0,255,0, 0,0,255, 0,0,255, 0,0,0, 0,0,0,
+    0,255,255, 0,255,255, 255,0,255, 255,0,255, 255,255,0, 255,255,0, 255,255,255, 255,255,255,
+    0,255,255, 0,255,255, 255,0,255, 255,0,255, 255,255,0, 255,255,0, 255,255,255, 255,255,255};
+static const struct bitmap_data testdata_24bppBGR_2x = {
+    &GUID_WICPixelFormat24bppBGR, 24, bits_24bppBGR_2x, 8, 4, 96.0, 96.0};
+
 static void test_conversion(const struct bitmap_data *src, const struct bitmap_data *dst, const char *name, BOOL todo)
 {
     BitmapTestSrc *src_obj;
@@ -492,6 +500,247 @@ static const struct bitmap_data *multiple_frames[3] = {
     &testdata_24bppBGR,
     NULL};
 
+static void test_scaler(void)
+{
+    IWICImagingFactory *factory;
+    IWICBitmapScaler *scaler;
+    IWICBitmapSource *converted;
+    BitmapTestSrc *src_obj;
+    UINT width, height, i;
+    BYTE bits[8];
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICImagingFactory, (void**)&factory);
+    ok(SUCCEEDED(hr), "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return;
+
+    CreateTestBitmap(&testdata_24bppBGR, &src_obj);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(SUCCEEDED(hr), "CreateBitmapScaler failed, hr=%x\n", hr);
+    if (FAILED(hr))
+    {
+        DeleteTestBitmap(src_obj);
+        IWICImagingFactory_Release(factory);
+        return;
+    }
+
+    hr = IWICBitmapScaler_GetSize(scaler, &width, &height);
+    ok(hr == WINCODEC_ERR_NOTINITIALIZED, "GetSize returned %x\n", hr);
+
+    hr = IWICBitmapScaler_Initialize(scaler, &src_obj->IWICBitmapSource_iface, 0, 4,
+        WICBitmapInterpolationModeNearestNeighbor);
+    ok(hr == E_INVALIDARG, "Initialize returned %x\n", hr);
+
+    hr = IWICBitmapScaler_Initialize(scaler, &src_obj->IWICBitmapSource_iface, 8, 4,
+        WICBitmapInterpolationModeNearestNeighbor);
+    ok(SUCCEEDED(hr), "Initialize returned %x\n", hr);
+
+    hr = IWICBitmapScaler_Initialize(scaler, &src_obj->IWICBitmapSource_iface, 8, 4,
+        WICBitmapInterpolationModeNearestNeighbor);
+    ok(hr == WINCODEC_ERR_WRONGSTATE, "Initialize returned %x\n", hr);
+
+    compare_bitmap_data(&testdata_24bppBGR_2x, (IWICBitmapSource*)scaler, "nearest neighbor scaler");
+
+    IWICBitmapScaler_Release(scaler);
+
+    /* the scaler pulls pixels through a format converter without copying the whole image */
+    hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA, &src_obj->IWICBitmapSource_iface, &converted);
+    ok(SUCCEEDED(hr), "WICConvertBitmapSource failed, hr=%x\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(SUCCEEDED(hr), "CreateBitmapScaler failed, hr=%x\n", hr);
+
+    hr = IWICBitmapScaler_Initialize(scaler, converted, 2, 1, WICBitmapInterpolationModeFant);
+    ok(SUCCEEDED(hr), "Initialize returned %x\n", hr);
+
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 8, sizeof(bits), bits);
+    ok(SUCCEEDED(hr), "CopyPixels returned %x\n", hr);
+    for (i = 0; i < 8; i++)
+    {
+        /* every 2x2 block averages to half intensity */
+        BYTE expected = (i % 4 == 3) ? 0xff : 0x80;
+        ok(abs(bits[i] - expected) <= 1, "byte %u: expected %02x, got %02x\n", i, expected, bits[i]);
+    }
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmapSource_Release(converted);
+
+    DeleteTestBitmap(src_obj);
+    IWICImagingFactory_Release(factory);
+}
+
+static void test_scaler_filters(void)
+{
+    static const struct {
+        WICBitmapInterpolationMode mode;
+        const char *name;
+    } tests[] = {
+        {WICBitmapInterpolationModeLinear, "linear"},
+        {WICBitmapInterpolationModeCubic, "cubic"},
+    };
+    /* tall enough for the scaler to fetch several bands of source rows */
+    const UINT src_width = 16, src_height = 40, width = 8, height = 20;
+    IWICImagingFactory *factory;
+    IWICBitmapScaler *scaler;
+    BitmapTestSrc *src_obj;
+    struct bitmap_data data;
+    BYTE src_bits[16 * 40], bits[8 * 20], rect_bits[5 * 14];
+    UINT i, x, y;
+    WICRect rc;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICImagingFactory, (void**)&factory);
+    ok(SUCCEEDED(hr), "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return;
+
+    /* a linear ramp stays linear under any symmetric filter, away from the
+     * edges where the source pixels are clamped */
+    for (y = 0; y < src_height; y++)
+        for (x = 0; x < src_width; x++)
+            src_bits[y * src_width + x] = 2 * x + 4 * y + 10;
+
+    data.format = &GUID_WICPixelFormat8bppGray;
+    data.bpp = 8;
+    data.bits = src_bits;
+    data.width = src_width;
+    data.height = src_height;
+    data.xres = data.yres = 96.0;
+    CreateTestBitmap(&data, &src_obj);
+
+    for (i = 0; i < sizeof(tests)/sizeof(tests[0]); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(SUCCEEDED(hr), "CreateBitmapScaler failed, hr=%x\n", hr);
+        if (FAILED(hr)) continue;
+
+        hr = IWICBitmapScaler_Initialize(scaler, &src_obj->IWICBitmapSource_iface, width, height, tests[i].mode);
+        ok(SUCCEEDED(hr), "%s: Initialize returned %x\n", tests[i].name, hr);
+
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, width, sizeof(bits), bits);
+        ok(SUCCEEDED(hr), "%s: CopyPixels returned %x\n", tests[i].name, hr);
+
+        /* destination pixel x,y is centered on source pixel 2x+0.5,2y+0.5 */
+        for (y = 2; y < height - 2; y++)
+            for (x = 2; x < width - 2; x++)
+            {
+                BYTE expected = 4 * x + 8 * y + 13;
+                ok(abs(bits[y * width + x] - expected) <= 1, "%s: pixel %u,%u: expected %u, got %u\n",
+                   tests[i].name, x, y, expected, bits[y * width + x]);
+            }
+
+        /* a rectangle away from the origin matches the same part of the whole image */
+        rc.X = 1;
+        rc.Y = 3;
+        rc.Width = 5;
+        rc.Height = 14;
+        hr = IWICBitmapScaler_CopyPixels(scaler, &rc, rc.Width, sizeof(rect_bits), rect_bits);
+        ok(SUCCEEDED(hr), "%s: CopyPixels returned %x\n", tests[i].name, hr);
+
+        for (y = 0; y < rc.Height; y++)
+            for (x = 0; x < rc.Width; x++)
+                ok(rect_bits[y * rc.Width + x] == bits[(rc.Y + y) * width + rc.X + x],
+                   "%s: pixel %u,%u: expected %u, got %u\n", tests[i].name, rc.X + x, rc.Y + y,
+                   bits[(rc.Y + y) * width + rc.X + x], rect_bits[y * rc.Width + x]);
+
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    DeleteTestBitmap(src_obj);
+    IWICImagingFactory_Release(factory);
+}
+
+static BYTE expected_bgra_byte(const WICPixelFormatGUID *format, const BYTE *src, UINT x, UINT i)
+{
+    if (IsEqualGUID(format, &GUID_WICPixelFormat24bppBGR))
+        return i == 3 ? 0xff : src[x * 3 + i];
+    if (IsEqualGUID(format, &GUID_WICPixelFormat48bppRGB))
+        return i == 3 ? 0xff : src[x * 6 + (2 - i) * 2];
+    if (IsEqualGUID(format, &GUID_WICPixelFormat64bppRGBA))
+        return i == 3 ? src[x * 8 + 6] : src[x * 8 + (2 - i) * 2];
+    /* 32bppBGRA to 32bppPBGRA */
+    return i == 3 ? src[x * 4 + 3] : src[x * 4 + i] * src[x * 4 + 3] / 255;
+}
+
+static void test_converter_throughput(void)
+{
+    static const struct {
+        const WICPixelFormatGUID *src_format;
+        UINT bpp;
+        const WICPixelFormatGUID *dst_format;
+        const char *name;
+    } tests[] = {
+        {&GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat32bppBGRA, "24bppBGR -> 32bppBGRA"},
+        {&GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat32bppPBGRA, "32bppBGRA -> 32bppPBGRA"},
+        {&GUID_WICPixelFormat48bppRGB, 48, &GUID_WICPixelFormat32bppBGRA, "48bppRGB -> 32bppBGRA"},
+        {&GUID_WICPixelFormat64bppRGBA, 64, &GUID_WICPixelFormat32bppBGRA, "64bppRGBA -> 32bppBGRA"},
+    };
+    const UINT width = 509, height = 256, repeat = 8;
+    struct bitmap_data data;
+    BitmapTestSrc *src_obj;
+    IWICBitmapSource *dst_bitmap;
+    BYTE *src_bits, *dst_bits;
+    UINT i, j, x, y, stride;
+    DWORD start, elapsed;
+    HRESULT hr;
+
+    src_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 8);
+    dst_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 4);
+
+    for (i = 0; i < sizeof(tests)/sizeof(tests[0]); i++)
+    {
+        BOOL equal = TRUE;
+
+        /* the two bytes of a 16-bit channel always differ, the conversion
+         * keeps the first one */
+        for (j = 0; j < width * height * 8; j++)
+            src_bits[j] = j * 7 + j / 251;
+
+        data.format = tests[i].src_format;
+        data.bpp = tests[i].bpp;
+        data.bits = src_bits;
+        data.width = width;
+        data.height = height;
+        data.xres = data.yres = 96.0;
+        CreateTestBitmap(&data, &src_obj);
+
+        hr = WICConvertBitmapSource(tests[i].dst_format, &src_obj->IWICBitmapSource_iface, &dst_bitmap);
+        ok(SUCCEEDED(hr), "WICConvertBitmapSource(%s) failed, hr=%x\n", tests[i].name, hr);
+        if (FAILED(hr))
+        {
+            DeleteTestBitmap(src_obj);
+            continue;
+        }
+
+        start = GetTickCount();
+        for (j = 0; j < repeat; j++)
+        {
+            hr = IWICBitmapSource_CopyPixels(dst_bitmap, NULL, width * 4, width * height * 4, dst_bits);
+            ok(SUCCEEDED(hr), "CopyPixels(%s) failed, hr=%x\n", tests[i].name, hr);
+        }
+        elapsed = GetTickCount() - start;
+        trace("%s: %u ms for %u pixels\n", tests[i].name, elapsed, width * height * repeat);
+
+        stride = (width * tests[i].bpp + 7) / 8;
+        for (y = 0; y < height && equal; y++)
+            for (x = 0; x < width * 4 && equal; x++)
+                if (dst_bits[y * width * 4 + x] != expected_bgra_byte(tests[i].src_format, src_bits + y * stride, x / 4, x % 4))
+                {
+                    equal = FALSE;
+                    ok(0, "%s: byte %u of pixel %u,%u is %u, expected %u\n", tests[i].name, x % 4, x / 4, y,
+                       dst_bits[y * width * 4 + x], expected_bgra_byte(tests[i].src_format, src_bits + y * stride, x / 4, x % 4));
+                }
+
+        IWICBitmapSource_Release(dst_bitmap);
+        DeleteTestBitmap(src_obj);
+    }
+
+    HeapFree(GetProcessHeap(), 0, src_bits);
+    HeapFree(GetProcessHeap(), 0, dst_bits);
+}
+
 START_TEST(converter)
 {
     CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
@@ -501,6 +750,9 @@ START_TEST(converter)
     test_conversion(&testdata_32bppBGRA, &testdata_32bppBGRA, "BGRA -> BGRA", 0);
     test_invalid_conversion();
     test_default_converter();
+    test_scaler();
+    test_scaler_filters();
+    test_converter_throughput();
 
     test_encoder(&testdata_32bppBGR, &CLSID_WICBmpEncoder,
                  &testdata_32bppBGR, &CLSID_WICBmpDecoder, "BMP encoder 32bppBGR");
@@ -118,6 +118,69 @@ static void X11DRV_DIB_DoProtectDIBSection( X_PHYSBITMAP *physBitmap, DWORD new_
     TRACE("Changed protection from %d to %d\n", old_prot, new_prot);
 }
 
+/***********************************************************************
+ *           X11DRV_DIB_GetPageBase
+ *
+ * Return the start of the first page spanned by the DIB bits.
+ */
+static inline BYTE *X11DRV_DIB_GetPageBase( const X_PHYSBITMAP *physBitmap )
+{
+    const UINT_PTR pagemask = getpagesize() - 1;
+
+    return (BYTE *)((UINT_PTR)physBitmap->base & ~pagemask);
+}
+
+/***********************************************************************
+ *           X11DRV_DIB_GetPageCount
+ *
+ * Return the number of pages spanned by the DIB bits.
+ */
+static inline UINT X11DRV_DIB_GetPageCount( const X_PHYSBITMAP *physBitmap )
+{
+    const UINT_PTR pagemask = getpagesize() - 1;
+    UINT_PTR end = ((UINT_PTR)physBitmap->base + physBitmap->size + pagemask) & ~pagemask;
+
+    return (end - (UINT_PTR)X11DRV_DIB_GetPageBase( physBitmap )) / (pagemask + 1);
+}
+
+/***********************************************************************
+ *           X11DRV_DIB_SetDirty
+ *
+ * Mark all the pages of the DIB as written by the app, or none of them.
+ */
+static void X11DRV_DIB_SetDirty( X_PHYSBITMAP *physBitmap, BOOL dirty )
+{
+    UINT pages = X11DRV_DIB_GetPageCount( physBitmap );
+
+    if (!physBitmap->dirty) return;
+    memset( physBitmap->dirty, dirty ? 0xff : 0, (pages + 7) / 8 );
+    physBitmap->dirty_pages = dirty ? pages : 0;
+}
+
+/***********************************************************************
+ *           X11DRV_DIB_CountSync
+ *
+ * Keep track of the amount of data converted between DIBs and pixmaps.
+ */
+static void X11DRV_DIB_CountSync( SIZE_T bytes )
+{
+    static LONG total;
+    static DWORD start;
+    DWORD now;
+    LONG count;
+
+    if (!TRACE_ON(bitmap)) return;
+    now = GetTickCount();
+    count = InterlockedExchangeAdd( &total, bytes ) + bytes;
+    if (!start) start = now;
+    if (now - start >= 1000)
+    {
+        TRACE( "synced %d bytes in %u ms\n", count, now - start );
+        InterlockedExchangeAdd( &total, -count );
+        start = now;
+    }
+}
+
 /***********************************************************************
  *           X11DRV_DIB_GetXImageWidthBytes
  *
@@ -3143,11 +3206,14 @@ static void X11DRV_DIB_GetImageBits_32( X11DRV_PDEVICE *physDev, int lines, BYTE
  *
  * Transfer the bits to an X image.
  * Helper function for SetDIBits() and SetDIBitsToDevice().
+ * When the cached image of a DIB section is used, only the lines
+ * starting at ySrc are converted.
  */
 static int X11DRV_DIB_SetImageBits( const X11DRV_DIB_IMAGEBITS_DESCR *descr )
 {
     int lines = descr->lines >= 0 ? descr->lines : -descr->lines;
     void *old_data = NULL;
+    char *band_data = NULL;
     XImage *bmpImage;
 
     wine_tsx11_lock();
@@ -3180,8 +3246,7 @@ static int X11DRV_DIB_SetImageBits( const X11DRV_DIB_IMAGEBITS_DESCR *descr )
 
 #ifdef HAVE_LIBXXSHM
     if (descr->shm_mode == X11DRV_SHM_PIXMAP
-            && descr->xSrc == 0 && descr->ySrc == 0
-            && descr->xDest == 0 && descr->yDest == 0)
+            && descr->xSrc == descr->xDest && descr->ySrc == descr->yDest)
     {
         TRACE("Using the shared pixmap data.\n");
 
@@ -3194,6 +3259,14 @@ static int X11DRV_DIB_SetImageBits( const X11DRV_DIB_IMAGEBITS_DESCR *descr )
     }
 #endif
 
+    /* the conversion fills the image from its first line, so point it
+     * to the band of lines that is being updated */
+    if (descr->image && descr->ySrc)
+    {
+        band_data = bmpImage->data;
+        bmpImage->data += descr->ySrc * bmpImage->bytes_per_line;
+    }
+
       /* Transfer the pixels */
     __TRY
     {
@@ -3249,6 +3322,8 @@ static int X11DRV_DIB_SetImageBits( const X11DRV_DIB_IMAGEBITS_DESCR *descr )
     }
     __ENDTRY
 
+    if (band_data) bmpImage->data = band_data;
+
     TRACE("XPutImage(%ld,%p,%p,%d,%d,%d,%d,%d,%d)\n",
      descr->drawable, descr->gc, bmpImage,
      descr->xSrc, descr->ySrc, descr->xDest, descr->yDest,
@@ -3259,8 +3334,7 @@ static int X11DRV_DIB_SetImageBits( const X11DRV_DIB_IMAGEBITS_DESCR *descr )
     {
 #ifdef HAVE_LIBXXSHM
         if (descr->shm_mode == X11DRV_SHM_PIXMAP
-                && descr->xSrc == 0 && descr->ySrc == 0
-                && descr->xDest == 0 && descr->yDest == 0)
+                && descr->xSrc == descr->xDest && descr->ySrc == descr->yDest)
         {
             XSync( gdi_display, False );
         }
@@ -3453,7 +3527,7 @@ static void X11DRV_DIB_DoCopyDIBSection(X_PHYSBITMAP *physBitmap, BOOL toDIB,
   descr.palentry    = NULL;
   descr.infoWidth   = dibSection.dsBmih.biWidth;
   descr.infoBpp     = dibSection.dsBmih.biBitCount;
-  descr.lines       = physBitmap->topdown ? -dibSection.dsBmih.biHeight : dibSection.dsBmih.biHeight;
+  descr.lines       = physBitmap->topdown ? -height : height;
   descr.image       = physBitmap->image;
   descr.colorMap    = colorMap;
   descr.nColorMap   = nColorMap;
@@ -3508,6 +3582,12 @@ static void X11DRV_DIB_DoCopyDIBSection(X_PHYSBITMAP *physBitmap, BOOL toDIB,
 #endif
   descr.dibpitch = dibSection.dsBm.bmWidthBytes;
 
+  /* only copy the lines between ySrc and ySrc + height */
+  if (physBitmap->topdown)
+      descr.bits = (BYTE *)descr.bits + ySrc * descr.dibpitch;
+  else
+      descr.bits = (BYTE *)descr.bits + (dibSection.dsBm.bmHeight - ySrc - height) * descr.dibpitch;
+
   if (toDIB)
     {
       TRACE("Copying from Pixmap to DIB bits\n");
@@ -3526,12 +3606,124 @@ static void X11DRV_DIB_DoCopyDIBSection(X_PHYSBITMAP *physBitmap, BOOL toDIB,
 static void X11DRV_DIB_DoUpdateDIBSection(X_PHYSBITMAP *physBitmap, BOOL toDIB)
 {
     BITMAP bitmap;
+    const SIZE_T pagesize = getpagesize();
+    BYTE *page_base;
+    UINT page, end_page, pages;
+    SIZE_T offset, start, end, prev_end = 0;
+    int y, lines;
 
     GetObjectW( physBitmap->hbitmap, sizeof(bitmap), &bitmap );
-    X11DRV_DIB_DoCopyDIBSection(physBitmap, toDIB,
-                                physBitmap->colorMap, physBitmap->nColorMap,
-                                physBitmap->pixmap, get_bitmap_gc(physBitmap->depth),
-                                0, 0, 0, 0, bitmap.bmWidth, bitmap.bmHeight);
+
+    pages = X11DRV_DIB_GetPageCount( physBitmap );
+    if (toDIB || !physBitmap->dirty || physBitmap->dirty_pages == pages)
+    {
+        X11DRV_DIB_DoCopyDIBSection(physBitmap, toDIB,
+                                    physBitmap->colorMap, physBitmap->nColorMap,
+                                    physBitmap->pixmap, get_bitmap_gc(physBitmap->depth),
+                                    0, 0, 0, 0, bitmap.bmWidth, bitmap.bmHeight);
+        X11DRV_DIB_CountSync( bitmap.bmHeight * bitmap.bmWidthBytes );
+        return;
+    }
+
+    /* only upload the lines covered by the runs of pages written by the app */
+    page_base = X11DRV_DIB_GetPageBase( physBitmap );
+    offset = physBitmap->base - page_base;
+    for (page = 0; page < pages; page = end_page)
+    {
+        if (!(physBitmap->dirty[page / 8] & (1 << (page % 8))))
+        {
+            end_page = page + 1;
+            continue;
+        }
+        for (end_page = page + 1; end_page < pages; end_page++)
+            if (!(physBitmap->dirty[end_page / 8] & (1 << (end_page % 8)))) break;
+
+        start = page * pagesize > offset ? page * pagesize - offset : 0;
+        end = min( end_page * pagesize - offset, physBitmap->size );
+
+        /* lines of the DIB memory, in the order they are stored */
+        start = max( start / bitmap.bmWidthBytes, prev_end );
+        end = min( (end + bitmap.bmWidthBytes - 1) / bitmap.bmWidthBytes, bitmap.bmHeight );
+        if (start >= end) continue;
+        prev_end = end;
+
+        lines = end - start;
+        y = physBitmap->topdown ? start : bitmap.bmHeight - end;
+        TRACE( "%p: uploading lines %d-%d\n", physBitmap->hbitmap, y, y + lines - 1 );
+        X11DRV_DIB_DoCopyDIBSection(physBitmap, FALSE,
+                                    physBitmap->colorMap, physBitmap->nColorMap,
+                                    physBitmap->pixmap, get_bitmap_gc(physBitmap->depth),
+                                    0, y, 0, y, bitmap.bmWidth, lines);
+        X11DRV_DIB_CountSync( lines * bitmap.bmWidthBytes );
+    }
+}
+
+/***********************************************************************
+ *           X11DRV_DIB_TrackWrite
+ *
+ * Handle a write from the app to the DIB bits. Only the page that was
+ * written to is made writable, so that the next update of the pixmap can
+ * skip the others, until enough pages are written that it's not worth
+ * taking a fault for each of them.
+ */
+static void X11DRV_DIB_TrackWrite(X_PHYSBITMAP *physBitmap, BYTE *addr)
+{
+    const SIZE_T pagesize = getpagesize();
+    BYTE *page_base = X11DRV_DIB_GetPageBase( physBitmap );
+    UINT page = (addr - page_base) / pagesize;
+    UINT pages = X11DRV_DIB_GetPageCount( physBitmap );
+    DWORD old_prot;
+
+    if (!physBitmap->dirty || page >= pages)
+    {
+        X11DRV_DIB_Coerce( physBitmap, DIB_Status_AppMod );
+        return;
+    }
+
+    EnterCriticalSection(&physBitmap->lock);
+    switch (physBitmap->status)
+    {
+    case DIB_Status_GdiMod:
+        TRACE("AppMod requested in status GdiMod\n" );
+        X11DRV_DIB_DoProtectDIBSection( physBitmap, PAGE_READWRITE );
+        X11DRV_DIB_DoUpdateDIBSection( physBitmap, TRUE );
+        X11DRV_DIB_DoProtectDIBSection( physBitmap, PAGE_READONLY );
+        X11DRV_DIB_SetDirty( physBitmap, FALSE );
+        physBitmap->status = DIB_Status_AppMod;
+        break;
+
+    case DIB_Status_InSync:
+        TRACE("AppMod requested in status InSync\n" );
+        physBitmap->status = DIB_Status_AppMod;
+        break;
+
+    case DIB_Status_AppMod:
+        break;
+
+    default:
+        LeaveCriticalSection(&physBitmap->lock);
+        return;
+    }
+
+    if (physBitmap->dirty[page / 8] & (1 << (page % 8)))
+    {
+        /* the page was protected again through another DIB sharing it */
+        VirtualProtect( page_base + page * pagesize, pagesize, PAGE_READWRITE, &old_prot );
+    }
+    else if ((physBitmap->dirty_pages + 1) * 8 > pages)
+    {
+        TRACE("%p: %u of %u pages written, making the DIB writable\n",
+              physBitmap->hbitmap, physBitmap->dirty_pages + 1, pages );
+        X11DRV_DIB_DoProtectDIBSection( physBitmap, PAGE_READWRITE );
+        X11DRV_DIB_SetDirty( physBitmap, TRUE );
+    }
+    else
+    {
+        physBitmap->dirty[page / 8] |= 1 << (page % 8);
+        physBitmap->dirty_pages++;
+        VirtualProtect( page_base + page * pagesize, pagesize, PAGE_READWRITE, &old_prot );
+    }
+    LeaveCriticalSection(&physBitmap->lock);
 }
 
 /***********************************************************************
@@ -3571,7 +3763,7 @@ static LONG CALLBACK X11DRV_DIB_FaultHandler( PEXCEPTION_POINTERS ep )
     X11DRV_DIB_Lock( physBitmap, DIB_Status_None );
     if (ep->ExceptionRecord->ExceptionInformation[0] == EXCEPTION_WRITE_FAULT) {
         /* the app tried to write the DIB bits */
-        X11DRV_DIB_Coerce( physBitmap, DIB_Status_AppMod);
+        X11DRV_DIB_TrackWrite( physBitmap, addr );
     } else {
         /* the app tried to read the DIB bits */
         X11DRV_DIB_Coerce( physBitmap, DIB_Status_InSync);
@@ -3620,6 +3812,7 @@ static INT X11DRV_DIB_Coerce(X_PHYSBITMAP *physBitmap, INT req)
 	  X11DRV_DIB_DoProtectDIBSection( physBitmap, PAGE_READONLY );
 	  X11DRV_DIB_DoUpdateDIBSection( physBitmap, FALSE );
 	  X11DRV_DIB_DoProtectDIBSection( physBitmap, PAGE_NOACCESS );
+	  X11DRV_DIB_SetDirty( physBitmap, FALSE );
 	  physBitmap->p_status = DIB_Status_AppMod;
 	  physBitmap->status = DIB_Status_GdiMod;
 	  break;
@@ -3671,12 +3864,14 @@ static INT X11DRV_DIB_Coerce(X_PHYSBITMAP *physBitmap, INT req)
 	  TRACE("AppMod requested in status GdiMod\n" );
 	  X11DRV_DIB_DoProtectDIBSection( physBitmap, PAGE_READWRITE );
 	  X11DRV_DIB_DoUpdateDIBSection( physBitmap, TRUE );
+	  X11DRV_DIB_SetDirty( physBitmap, TRUE );
 	  physBitmap->status = DIB_Status_AppMod;
 	  break;
 
         case DIB_Status_InSync:
 	  TRACE("AppMod requested in status InSync\n" );
 	  X11DRV_DIB_DoProtectDIBSection( physBitmap, PAGE_READWRITE );
+	  X11DRV_DIB_SetDirty( physBitmap, TRUE );
 	  physBitmap->status = DIB_Status_AppMod;
 	  break;
 
@@ -3977,6 +4172,9 @@ HBITMAP X11DRV_CreateDIBSection( PHYSDEV dev, HBITMAP hbitmap, BITMAPINFO *bmi,
     physBitmap->base   = dib.dsBm.bmBits;
     physBitmap->size   = dib.dsBmih.biSizeImage;
     physBitmap->status = DIB_Status_AppMod;
+    physBitmap->dirty  = HeapAlloc( GetProcessHeap(), 0,
+                                    (X11DRV_DIB_GetPageCount( physBitmap ) + 7) / 8 );
+    X11DRV_DIB_SetDirty( physBitmap, TRUE );
 
     if (!dibs_handler)
         dibs_handler = AddVectoredExceptionHandler( TRUE, X11DRV_DIB_FaultHandler );
@@ -4030,6 +4228,7 @@ void X11DRV_DIB_DeleteDIBSection(X_PHYSBITMAP *physBitmap, DIBSECTION *dib)
   }
 
   HeapFree(GetProcessHeap(), 0, physBitmap->colorMap);
+  HeapFree(GetProcessHeap(), 0, physBitmap->dirty);
   physBitmap->lock.DebugInfo->Spare[0] = 0;
   DeleteCriticalSection(&physBitmap->lock);
 }
@@ -4062,6 +4261,8 @@ UINT X11DRV_SetDIBColorTable( PHYSDEV dev, UINT start, UINT count, const RGBQUAD
         X11DRV_DIB_Lock( physBitmap, DIB_Status_AppMod );
         X11DRV_DIB_GenColorMap( physDev, physBitmap->colorMap, DIB_RGB_COLORS,
                                 dib.dsBm.bmBitsPixel, colors, start, end );
+        /* every pixel may map to a different X11 color now */
+        X11DRV_DIB_SetDirty( physBitmap, TRUE );
         X11DRV_DIB_Unlock( physBitmap, TRUE );
         ret = end - start;
     }
@@ -135,6 +135,8 @@ typedef struct
     struct list   entry;            /* Entry in global DIB list */
     BYTE         *base;             /* Base address */
     SIZE_T        size;             /* Size in bytes */
+    BYTE         *dirty;            /* bitmap of the pages written by the app */
+    UINT          dirty_pages;      /* number of pages set in the dirty bitmap */
 } X_PHYSBITMAP;
 
   /* X physical font */
@@ -301,6 +303,7 @@ extern int client_side_with_core DECLSPEC_HIDDEN;
 extern int client_side_with_render DECLSPEC_HIDDEN;
 extern int client_side_antialias_with_core DECLSPEC_HIDDEN;
 extern int client_side_antialias_with_render DECLSPEC_HIDDEN;
+extern int glyph_cache_size DECLSPEC_HIDDEN;
 extern int using_client_side_fonts DECLSPEC_HIDDEN;
 extern const struct gdi_dc_funcs *X11DRV_XRender_Init(void) DECLSPEC_HIDDEN;
 extern void X11DRV_XRender_Finalize(void) DECLSPEC_HIDDEN;
@@ -41,6 +41,7 @@
 int using_client_side_fonts = FALSE;
 
 WINE_DEFAULT_DEBUG_CHANNEL(xrender);
+WINE_DECLARE_DEBUG_CHANNEL(glyphcache);
 
 #ifdef SONAME_LIBXRENDER
 
@@ -136,6 +137,16 @@ typedef struct
 
 typedef enum { AA_None = 0, AA_Grey, AA_RGB, AA_BGR, AA_VRGB, AA_VBGR, AA_MAXVALUE } AA_Type;
 
+struct glyph_lru
+{
+    struct list  entry;    /* entry in glyph_lru_list, most recently used first */
+    int          cache_index;
+    AA_Type      format;
+    int          glyph;
+    unsigned int size;     /* bytes accounted for this glyph */
+    DWORD        stamp;    /* text run that last used the glyph */
+};
+
 typedef struct
 {
     GlyphSet glyphset;
@@ -144,6 +155,7 @@ typedef struct
     BOOL *realized;
     void **bitmaps;
     XGlyphInfo *gis;
+    struct glyph_lru **lru;
 } gsCacheEntryFormat;
 
 typedef struct
@@ -181,6 +193,22 @@ static INT mru = -1;
 
 #define INIT_CACHE_SIZE 10
 
+/* glyphs of all the cache entries, evicted least recently used first once
+ * glyph_cache_bytes exceeds the GlyphCacheSize option */
+static struct list glyph_lru_list = LIST_INIT( glyph_lru_list );
+static SIZE_T glyph_cache_bytes;
+static DWORD glyph_stamp;
+
+static struct
+{
+    unsigned int font_hits;
+    unsigned int font_misses;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+    unsigned int count;
+} glyph_stats;
+
 static int antialias = 1;
 
 static void *xrender_handle;
@@ -194,6 +222,7 @@ MAKE_FUNCPTR(XRenderCreatePicture)
 MAKE_FUNCPTR(XRenderFillRectangle)
 MAKE_FUNCPTR(XRenderFindFormat)
 MAKE_FUNCPTR(XRenderFindVisualFormat)
+MAKE_FUNCPTR(XRenderFreeGlyphs)
 MAKE_FUNCPTR(XRenderFreeGlyphSet)
 MAKE_FUNCPTR(XRenderFreePicture)
 MAKE_FUNCPTR(XRenderSetPictureClipRectangles)
@@ -373,6 +402,7 @@ LOAD_FUNCPTR(XRenderCreatePicture)
 LOAD_FUNCPTR(XRenderFillRectangle)
 LOAD_FUNCPTR(XRenderFindFormat)
 LOAD_FUNCPTR(XRenderFindVisualFormat)
+LOAD_FUNCPTR(XRenderFreeGlyphs)
 LOAD_FUNCPTR(XRenderFreeGlyphSet)
 LOAD_FUNCPTR(XRenderFreePicture)
 LOAD_FUNCPTR(XRenderSetPictureClipRectangles)
@@ -718,11 +748,13 @@ static int LookupEntry(LFANDSIZE *plfsz)
 	mru = i;
       }
       TRACE("found font in cache %d\n", i);
+      glyph_stats.font_hits++;
       return i;
     }
     prev_i = i;
   }
   TRACE("font not in cache\n");
+  glyph_stats.font_misses++;
   return -1;
 }
 
@@ -745,6 +777,15 @@ static void FreeEntry(int entry)
             formatEntry->glyphset = 0;
         }
         if(formatEntry->nrealized) {
+            for(i = 0; i < formatEntry->nrealized; i++) {
+                if(!formatEntry->lru[i]) continue;
+                glyph_cache_bytes -= formatEntry->lru[i]->size;
+                glyph_stats.count--;
+                list_remove(&formatEntry->lru[i]->entry);
+                HeapFree(GetProcessHeap(), 0, formatEntry->lru[i]);
+            }
+            HeapFree(GetProcessHeap(), 0, formatEntry->lru);
+            formatEntry->lru = NULL;
             HeapFree(GetProcessHeap(), 0, formatEntry->realized);
             formatEntry->realized = NULL;
             if(formatEntry->bitmaps) {
@@ -1065,6 +1106,15 @@ static void dec_ref_cache(int index)
     glyphsetCache[index].count--;
 }
 
+static void dump_glyph_stats(void)
+{
+    TRACE_(glyphcache)( "fonts: %u hits %u misses, glyphs: %u hits %u misses %u evictions, "
+                        "%u glyphs in %lu bytes\n",
+                        glyph_stats.font_hits, glyph_stats.font_misses, glyph_stats.hits,
+                        glyph_stats.misses, glyph_stats.evictions, glyph_stats.count,
+                        (unsigned long)glyph_cache_bytes );
+}
+
 static void lfsz_calc_hash(LFANDSIZE *plfsz)
 {
   DWORD hash = 0, *ptr, two_chars;
@@ -1099,6 +1149,7 @@ void X11DRV_XRender_Finalize(void)
     int i;
 
     EnterCriticalSection(&xrender_cs);
+    if (TRACE_ON(glyphcache)) dump_glyph_stats();
     for(i = mru; i >= 0; i = glyphsetCache[i].next)
 	FreeEntry(i);
     LeaveCriticalSection(&xrender_cs);
@@ -1134,6 +1185,8 @@ static HFONT xrenderdrv_SelectFont( PHYSDEV dev, HFONT hfont )
 
         /* Not used fields, would break hashing */
         lfsz.xform.eDx = lfsz.xform.eDy = 0;
+        /* underline and strikeout are drawn by gdi32, the glyphs are the same */
+        lfsz.lf.lfUnderline = lfsz.lf.lfStrikeOut = 0;
 
         lfsz_calc_hash(&lfsz);
 
@@ -1379,6 +1432,58 @@ BOOL X11DRV_XRender_SetPhysBitmapDepth(X_PHYSBITMAP *physBitmap, int bits_pixel,
     return TRUE;
 }
 
+static inline void touch_glyph( struct glyph_lru *lru )
+{
+    glyph_stats.hits++;
+    lru->stamp = glyph_stamp;
+    list_remove( &lru->entry );
+    list_add_head( &glyph_lru_list, &lru->entry );
+}
+
+/************************************************************************
+ *   evict_glyphs
+ *
+ * Free the least recently used glyphs until the cache fits in its budget
+ * again. Glyphs used by the current text run are never freed.
+ * Must be called inside xrender_cs.
+ */
+static void evict_glyphs(void)
+{
+    SIZE_T limit = (SIZE_T)glyph_cache_size * 1024;
+    struct list *ptr;
+
+    if (!glyph_cache_size) return;
+
+    while (glyph_cache_bytes > limit && (ptr = list_tail( &glyph_lru_list )))
+    {
+        struct glyph_lru *lru = LIST_ENTRY( ptr, struct glyph_lru, entry );
+        gsCacheEntryFormat *formatEntry = glyphsetCache[lru->cache_index].format[lru->format];
+
+        if (lru->stamp == glyph_stamp) break;
+
+        if (formatEntry->glyphset)
+        {
+            Glyph gid = lru->glyph;
+
+            wine_tsx11_lock();
+            pXRenderFreeGlyphs( gdi_display, formatEntry->glyphset, &gid, 1 );
+            wine_tsx11_unlock();
+        }
+        else if (formatEntry->bitmaps)
+        {
+            HeapFree( GetProcessHeap(), 0, formatEntry->bitmaps[lru->glyph] );
+            formatEntry->bitmaps[lru->glyph] = NULL;
+        }
+        formatEntry->realized[lru->glyph] = FALSE;
+        formatEntry->lru[lru->glyph] = NULL;
+        glyph_cache_bytes -= lru->size;
+        glyph_stats.count--;
+        glyph_stats.evictions++;
+        list_remove( &lru->entry );
+        HeapFree( GetProcessHeap(), 0, lru );
+    }
+}
+
 /************************************************************************
  *   UploadGlyph
  *
@@ -1393,6 +1498,7 @@ static void UploadGlyph(struct xrender_physdev *physDev, int glyph, AA_Type form
     XGlyphInfo gi;
     gsCacheEntry *entry = glyphsetCache + physDev->cache_index;
     gsCacheEntryFormat *formatEntry;
+    struct glyph_lru *lru;
     UINT ggo_format = GGO_GLYPH_INDEX;
     enum wxr_format wxr_format;
     static const char zero[4];
@@ -1456,6 +1562,16 @@ static void UploadGlyph(struct xrender_physdev *physDev, int glyph, AA_Type form
     if(formatEntry->nrealized <= glyph) {
         formatEntry->nrealized = (glyph / 128 + 1) * 128;
 
+        if (formatEntry->lru)
+            formatEntry->lru = HeapReAlloc(GetProcessHeap(),
+                                   HEAP_ZERO_MEMORY,
+                                   formatEntry->lru,
+                                   formatEntry->nrealized * sizeof(formatEntry->lru[0]));
+        else
+            formatEntry->lru = HeapAlloc(GetProcessHeap(),
+                                   HEAP_ZERO_MEMORY,
+                                   formatEntry->nrealized * sizeof(formatEntry->lru[0]));
+
 	if (formatEntry->realized)
 	    formatEntry->realized = HeapReAlloc(GetProcessHeap(),
 				      HEAP_ZERO_MEMORY,
@@ -1610,6 +1726,21 @@ static void UploadGlyph(struct xrender_physdev *physDev, int glyph, AA_Type form
     }
 
     formatEntry->gis[glyph] = gi;
+
+    if ((lru = HeapAlloc(GetProcessHeap(), 0, sizeof(*lru))))
+    {
+        lru->cache_index = physDev->cache_index;
+        lru->format = format;
+        lru->glyph = glyph;
+        lru->size = buflen + sizeof(*lru);
+        lru->stamp = glyph_stamp;
+        list_add_head(&glyph_lru_list, &lru->entry);
+        formatEntry->lru[glyph] = lru;
+        glyph_cache_bytes += lru->size;
+        glyph_stats.count++;
+    }
+    glyph_stats.misses++;
+    evict_glyphs();
 }
 
 static void SharpGlyphMono(struct xrender_physdev *physDev, INT x, INT y,
@@ -2033,6 +2164,8 @@ static BOOL xrenderdrv_ExtTextOut( PHYSDEV dev, INT x, INT y, UINT flags,
 
     EnterCriticalSection(&xrender_cs);
 
+    if (!(++glyph_stamp % 4096) && TRACE_ON(glyphcache)) dump_glyph_stats();
+
     entry = glyphsetCache + physdev->cache_index;
     if( disable_antialias == FALSE )
         aa_type = entry->aa_default;
@@ -2047,7 +2180,9 @@ static BOOL xrenderdrv_ExtTextOut( PHYSDEV dev, INT x, INT y, UINT flags,
             formatEntry = entry->format[aa_type];
         } else if( wstr[idx] >= formatEntry->nrealized || formatEntry->realized[wstr[idx]] == FALSE) {
 	    UploadGlyph(physdev, wstr[idx], aa_type);
-	}
+	} else if (formatEntry->lru[wstr[idx]])
+            /* glyphs whose lru entry couldn't be allocated stay untracked */
+            touch_glyph(formatEntry->lru[wstr[idx]]);
     }
     if (!formatEntry)
     {
@@ -2062,6 +2197,7 @@ static BOOL xrenderdrv_ExtTextOut( PHYSDEV dev, INT x, INT y, UINT flags,
     if(X11DRV_XRender_Installed)
     {
         XGlyphElt16 *elts = HeapAlloc(GetProcessHeap(), 0, sizeof(XGlyphElt16) * count);
+        unsigned int nelts = 0;
         POINT offset = {0, 0};
         POINT desired, current;
         int render_op = PictOpOver;
@@ -2086,14 +2222,23 @@ static BOOL xrenderdrv_ExtTextOut( PHYSDEV dev, INT x, INT y, UINT flags,
 
         for(idx = 0; idx < count; idx++)
         {
-            elts[idx].glyphset = formatEntry->glyphset;
-            elts[idx].chars = wstr + idx;
-            elts[idx].nchars = 1;
-            elts[idx].xOff = desired.x - current.x;
-            elts[idx].yOff = desired.y - current.y;
+            int xOff = desired.x - current.x, yOff = desired.y - current.y;
+
+            /* glyphs that land at their natural advance share one element */
+            if (nelts && !xOff && !yOff)
+                elts[nelts - 1].nchars++;
+            else
+            {
+                elts[nelts].glyphset = formatEntry->glyphset;
+                elts[nelts].chars = wstr + idx;
+                elts[nelts].nchars = 1;
+                elts[nelts].xOff = xOff;
+                elts[nelts].yOff = yOff;
+                nelts++;
+            }
 
-            current.x += (elts[idx].xOff + formatEntry->gis[wstr[idx]].xOff);
-            current.y += (elts[idx].yOff + formatEntry->gis[wstr[idx]].yOff);
+            current.x += (xOff + formatEntry->gis[wstr[idx]].xOff);
+            current.y += (yOff + formatEntry->gis[wstr[idx]].yOff);
 
             if(!lpDx)
             {
@@ -2121,7 +2266,7 @@ static BOOL xrenderdrv_ExtTextOut( PHYSDEV dev, INT x, INT y, UINT flags,
                                 tile_pict,
                                 pict,
                                 formatEntry->font_format,
-                                0, 0, 0, 0, elts, count);
+                                0, 0, 0, 0, elts, nelts);
         wine_tsx11_unlock();
         HeapFree(GetProcessHeap(), 0, elts);
     } else {
@@ -231,6 +231,9 @@ static CRITICAL_SECTION connection_pool_cs = { &connection_pool_debug, -1, 0, 0,
 static struct list connection_pool = LIST_INIT(connection_pool);
 static BOOL collector_running;
 
+/* limit set with INTERNET_OPTION_MAX_CONNS_PER_SERVER, 0 if there is none */
+ULONG max_conns = 0;
+
 void server_addref(server_t *server)
 {
     InterlockedIncrement(&server->ref);
@@ -265,11 +268,16 @@ static server_t *get_server(const WCHAR *name, INTERNET_PORT port)
             server->addr_len = 0;
             server->ref = 1;
             server->port = port;
+            server->conn_count = 0;
             list_init(&server->conn_pool);
             server->name = heap_strdupW(name);
-            if(server->name) {
+            server->conn_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+            if(server->name && server->conn_event) {
                 list_add_head(&connection_pool, &server->entry);
             }else {
+                if(server->conn_event)
+                    CloseHandle(server->conn_event);
+                heap_free(server->name);
                 heap_free(server);
                 server = NULL;
             }
@@ -305,6 +313,7 @@ BOOL collect_connections(BOOL collect_all)
             if(collect_all || server->keep_until < now) {
                 list_remove(&server->entry);
 
+                CloseHandle(server->conn_event);
                 heap_free(server->name);
                 heap_free(server);
             }else {
@@ -384,11 +393,14 @@ static void reset_data_stream(http_request_t *req)
 
 #ifdef HAVE_ZLIB
 
+/* compressed data is read in pieces of up to this size, if the caller's buffer is large enough */
+#define GZIP_BUFFER_SIZE 0x10000
+
 typedef struct {
     data_stream_t stream;
     data_stream_t *parent_stream;
     z_stream zstream;
-    BYTE buf[READ_BUFFER_SIZE];
+    BYTE buf[GZIP_BUFFER_SIZE];
     DWORD buf_size;
     DWORD buf_pos;
     BOOL end_of_data;
@@ -425,8 +437,10 @@ static DWORD gzip_read(data_stream_t *stream, http_request_t *req, BYTE *buf, DW
                     memmove(gzip_stream->buf, gzip_stream->buf+gzip_stream->buf_pos, gzip_stream->buf_size);
                 gzip_stream->buf_pos = 0;
             }
+            /* read larger pieces for larger output buffers, so big downloads don't
+             * take a trip through the parent stream for every 8k of input */
             res = gzip_stream->parent_stream->vtbl->read(gzip_stream->parent_stream, req, gzip_stream->buf+gzip_stream->buf_size,
-                    sizeof(gzip_stream->buf)-gzip_stream->buf_size, &current_read, read_mode);
+                    min(sizeof(gzip_stream->buf)-gzip_stream->buf_size, max(size, READ_BUFFER_SIZE)), &current_read, read_mode);
             gzip_stream->buf_size += current_read;
             if(res != ERROR_SUCCESS)
                 break;
@@ -1860,6 +1874,7 @@ static void http_release_netconn(http_request_t *req, BOOL reuse)
 
         list_add_head(&req->netconn->server->conn_pool, &req->netconn->pool_entry);
         req->netconn->keep_until = GetTickCount64() + COLLECT_TIME;
+        SetEvent(req->netconn->server->conn_event);
         req->netconn = NULL;
 
         run_collector = !collector_running;
@@ -2360,7 +2375,7 @@ static DWORD netconn_read(data_stream_t *stream, http_request_t *req, BYTE *buf,
 static BOOL netconn_drain_content(data_stream_t *stream, http_request_t *req)
 {
     netconn_stream_t *netconn_stream = (netconn_stream_t*)stream;
-    BYTE buf[1024];
+    BYTE buf[READ_BUFFER_SIZE];
     DWORD avail;
     int len;
 
@@ -4548,6 +4563,7 @@ static DWORD open_http_connection(http_request_t *request, BOOL *reusing)
 {
     const BOOL is_https = (request->hdr.dwFlags & INTERNET_FLAG_SECURE) != 0;
     http_session_t *session = request->session;
+    DWORD timeout = session->appInfo->connect_timeout, start = 0, elapsed;
     netconn_t *netconn = NULL;
     server_t *server;
     DWORD res;
@@ -4567,22 +4583,54 @@ static DWORD open_http_connection(http_request_t *request, BOOL *reusing)
 
     EnterCriticalSection(&connection_pool_cs);
 
-    while(!list_empty(&server->conn_pool)) {
-        netconn = LIST_ENTRY(list_head(&server->conn_pool), netconn_t, pool_entry);
-        list_remove(&netconn->pool_entry);
+    while(1) {
+        while(!list_empty(&server->conn_pool)) {
+            netconn = LIST_ENTRY(list_head(&server->conn_pool), netconn_t, pool_entry);
+            list_remove(&netconn->pool_entry);
 
-        if(NETCON_is_alive(netconn))
+            if(NETCON_is_alive(netconn))
+                break;
+
+            TRACE("connection %p closed during idle\n", netconn);
+            free_netconn(netconn);
+            netconn = NULL;
+        }
+
+        if(netconn || !max_conns || server->conn_count < max_conns)
             break;
 
-        TRACE("connection %p closed during idle\n", netconn);
-        free_netconn(netconn);
-        netconn = NULL;
+        if(!start) {
+            TRACE("waiting for one of %d connections to %s\n", server->conn_count, debugstr_w(server->name));
+            start = GetTickCount();
+        }
+
+        /* closing the request handle doesn't signal the event, so check it regularly */
+        elapsed = GetTickCount() - start;
+        if(!request->hdr.valid_handle || elapsed >= timeout) {
+            LeaveCriticalSection(&connection_pool_cs);
+            server_release(server);
+            return request->hdr.valid_handle ? ERROR_INTERNET_TIMEOUT : ERROR_INTERNET_OPERATION_CANCELLED;
+        }
+
+        /* wait until another request releases its connection to the server */
+        LeaveCriticalSection(&connection_pool_cs);
+        WaitForSingleObject(server->conn_event, min(timeout - elapsed, 100));
+        EnterCriticalSection(&connection_pool_cs);
     }
 
+    /* the connection we are about to create takes one of the slots */
+    if(!netconn)
+        InterlockedIncrement(&server->conn_count);
+
+    /* several connections may have been released while we were waiting */
+    if(max_conns && (!list_empty(&server->conn_pool) || server->conn_count < max_conns))
+        SetEvent(server->conn_event);
+
     LeaveCriticalSection(&connection_pool_cs);
 
     if(netconn) {
         TRACE("<-- reusing %p netconn\n", netconn);
+        server_release(server);
         request->netconn = netconn;
         *reusing = TRUE;
         return ERROR_SUCCESS;
@@ -4594,11 +4642,14 @@ static DWORD open_http_connection(http_request_t *request, BOOL *reusing)
                           strlen(server->addr_str)+1);
 
     res = create_netconn(is_https, server, request->security_flags, &netconn);
-    server_release(server);
     if(res != ERROR_SUCCESS) {
         ERR("create_netconn failed: %u\n", res);
+        InterlockedDecrement(&server->conn_count);
+        SetEvent(server->conn_event);
+        server_release(server);
         return res;
     }
+    server_release(server);
 
     request->netconn = netconn;
 
@@ -4616,7 +4667,7 @@ static DWORD open_http_connection(http_request_t *request, BOOL *reusing)
         if(session->appInfo->proxy)
             res = HTTP_SecureProxyConnect(request);
         if(res == ERROR_SUCCESS)
-            res = NETCON_secure_connect(request->netconn, session->hostName);
+            res = NETCON_secure_connect(request->netconn, session->hostName, session->hostPort);
         if(res != ERROR_SUCCESS)
         {
             WARN("Couldn't connect securely to host\n");
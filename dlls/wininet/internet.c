@@ -942,6 +942,7 @@ HINTERNET WINAPI InternetOpenW(LPCWSTR lpszAgent, DWORD dwAccessType,
     lpwai->hdr.htype = WH_HINIT;
     lpwai->hdr.dwFlags = dwFlags;
     lpwai->accessType = dwAccessType;
+    lpwai->connect_timeout = 60000;
     lpwai->proxyUsername = NULL;
     lpwai->proxyPassword = NULL;
 
@@ -2336,7 +2337,7 @@ DWORD INET_QueryOption(object_header_t *hdr, DWORD option, void *buffer, DWORD *
         if (*size < sizeof(ULONG))
             return ERROR_INSUFFICIENT_BUFFER;
 
-        *(ULONG*)buffer = 2;
+        *(ULONG*)buffer = max_conns ? max_conns : 2;
         *size = sizeof(ULONG);
 
         return ERROR_SUCCESS;
@@ -2656,7 +2657,15 @@ BOOL WINAPI InternetSetOptionW(HINTERNET hInternet, DWORD dwOption,
     case INTERNET_OPTION_CONNECT_TIMEOUT:
       {
         ULONG connecttimeout = *(ULONG *)lpBuffer;
-        FIXME("Option INTERNET_OPTION_CONNECT_TIMEOUT (%d): STUB\n", connecttimeout);
+
+        /* only used for now to bound the wait for a free connection */
+        if (lpwhh && lpwhh->htype == WH_HINIT)
+        {
+            TRACE("INTERNET_OPTION_CONNECT_TIMEOUT: %u\n", connecttimeout);
+            ((appinfo_t *)lpwhh)->connect_timeout = connecttimeout;
+        }
+        else
+            FIXME("Option INTERNET_OPTION_CONNECT_TIMEOUT (%d): STUB\n", connecttimeout);
       }
       break;
     case INTERNET_OPTION_DATA_RECEIVE_TIMEOUT:
@@ -2666,11 +2675,22 @@ BOOL WINAPI InternetSetOptionW(HINTERNET hInternet, DWORD dwOption,
       }
       break;
     case INTERNET_OPTION_MAX_CONNS_PER_SERVER:
-      {
-        ULONG conns = *(ULONG *)lpBuffer;
-        FIXME("Option INTERNET_OPTION_MAX_CONNS_PER_SERVER (%d): STUB\n", conns);
-      }
-      break;
+        if (!lpBuffer || dwBufferLength != sizeof(ULONG))
+        {
+            SetLastError(ERROR_INTERNET_BAD_OPTION_LENGTH);
+            ret = FALSE;
+        }
+        else if (!*(ULONG *)lpBuffer)
+        {
+            SetLastError(ERROR_BAD_ARGUMENTS);
+            ret = FALSE;
+        }
+        else
+        {
+            max_conns = *(ULONG *)lpBuffer;
+            TRACE("INTERNET_OPTION_MAX_CONNS_PER_SERVER: %u\n", max_conns);
+        }
+        break;
     case INTERNET_OPTION_MAX_CONNS_PER_1_0_SERVER:
       {
         ULONG conns = *(ULONG *)lpBuffer;
@@ -63,6 +63,9 @@ typedef struct {
     LONG ref;
     DWORD64 keep_until;
 
+    LONG conn_count; /* open connections, including idle ones in conn_pool */
+    HANDLE conn_event; /* signaled when a connection is released */
+
     struct list entry;
     struct list conn_pool;
 } server_t;
@@ -71,6 +74,8 @@ void server_addref(server_t*) DECLSPEC_HIDDEN;
 void server_release(server_t*) DECLSPEC_HIDDEN;
 BOOL collect_connections(BOOL) DECLSPEC_HIDDEN;
 
+extern ULONG max_conns DECLSPEC_HIDDEN;
+
 /* used for netconnection.c stuff */
 typedef struct
 {
@@ -253,6 +258,7 @@ typedef struct
     LPWSTR  proxyUsername;
     LPWSTR  proxyPassword;
     DWORD   accessType;
+    DWORD   connect_timeout;
 } appinfo_t;
 
 typedef struct
@@ -518,7 +524,7 @@ BOOL INTERNET_FindProxyForProtocol(LPCWSTR szProxy, LPCWSTR proto, WCHAR *foundP
 DWORD create_netconn(BOOL,server_t*,DWORD,netconn_t**) DECLSPEC_HIDDEN;
 void free_netconn(netconn_t*) DECLSPEC_HIDDEN;
 void NETCON_unload(void) DECLSPEC_HIDDEN;
-DWORD NETCON_secure_connect(netconn_t *connection, LPWSTR hostname) DECLSPEC_HIDDEN;
+DWORD NETCON_secure_connect(netconn_t *connection, LPWSTR hostname, INTERNET_PORT port) DECLSPEC_HIDDEN;
 DWORD NETCON_send(netconn_t *connection, const void *msg, size_t len, int flags,
 		int *sent /* out */) DECLSPEC_HIDDEN;
 DWORD NETCON_recv(netconn_t *connection, void *buf, size_t len, int flags,
@@ -146,6 +146,15 @@ MAKE_FUNCPTR(SSL_CTX_set_default_verify_paths);
 MAKE_FUNCPTR(SSL_CTX_set_verify);
 MAKE_FUNCPTR(SSL_get_current_cipher);
 MAKE_FUNCPTR(SSL_CIPHER_get_bits);
+MAKE_FUNCPTR(SSL_get1_session);
+MAKE_FUNCPTR(SSL_set_session);
+MAKE_FUNCPTR(SSL_SESSION_free);
+MAKE_FUNCPTR(SSL_SESSION_get_time);
+MAKE_FUNCPTR(SSL_SESSION_get_timeout);
+/* optional, SSL_session_reused is a function only since OpenSSL 1.1,
+ * which dropped the SSL_CTRL_GET_SESSION_REUSED control used before */
+static int (*pSSL_session_reused)(const SSL *);
+static long (*pSSL_ctrl)(SSL *, int, long, void *);
 
 /* OpenSSL's libcrypto functions that we use */
 MAKE_FUNCPTR(BIO_new_fp);
@@ -357,6 +366,136 @@ static int netconn_secure_verify(int preverify_ok, X509_STORE_CTX *ctx)
     return ret;
 }
 
+/* Client side session cache. Sessions are keyed by the target host name and
+ * port, which aren't the ones of the proxy we may connect through, and the
+ * security flags the certificate was verified against, since a resumed
+ * handshake doesn't verify the certificate again. */
+#define MAX_SSL_SESSIONS 32
+
+typedef struct {
+    struct list entry;
+    WCHAR *host;
+    INTERNET_PORT port;
+    DWORD security_flags;
+    SSL_SESSION *session;
+} ssl_session_t;
+
+static struct list ssl_session_cache = LIST_INIT(ssl_session_cache);
+static unsigned int ssl_session_count;
+static LONG ssl_session_hits, ssl_session_misses;
+
+static CRITICAL_SECTION ssl_session_cs;
+static CRITICAL_SECTION_DEBUG ssl_session_cs_debug =
+{
+    0, 0, &ssl_session_cs,
+    { &ssl_session_cs_debug.ProcessLocksList,
+      &ssl_session_cs_debug.ProcessLocksList },
+    0, 0, { (DWORD_PTR)(__FILE__ ": ssl_session_cs") }
+};
+static CRITICAL_SECTION ssl_session_cs = { &ssl_session_cs_debug, -1, 0, 0, 0, 0 };
+
+static void free_ssl_session(ssl_session_t *cached)
+{
+    list_remove(&cached->entry);
+    ssl_session_count--;
+    pSSL_SESSION_free(cached->session);
+    heap_free(cached->host);
+    heap_free(cached);
+}
+
+/* must be called inside ssl_session_cs */
+static ssl_session_t *find_ssl_session(const WCHAR *host, INTERNET_PORT port, netconn_t *conn)
+{
+    ssl_session_t *iter;
+
+    LIST_FOR_EACH_ENTRY(iter, &ssl_session_cache, ssl_session_t, entry) {
+        if(iter->port == port && iter->security_flags == conn->security_flags
+           && !strcmpiW(iter->host, host))
+            return iter;
+    }
+
+    return NULL;
+}
+
+static void set_cached_ssl_session(SSL *ssl, const WCHAR *host, INTERNET_PORT port, netconn_t *conn)
+{
+    ssl_session_t *cached;
+
+    EnterCriticalSection(&ssl_session_cs);
+
+    cached = find_ssl_session(host, port, conn);
+    if(cached) {
+        if(pSSL_SESSION_get_time(cached->session) + pSSL_SESSION_get_timeout(cached->session) <= time(NULL)) {
+            TRACE("session for %s expired\n", debugstr_w(host));
+            free_ssl_session(cached);
+        }else if(pSSL_set_session(ssl, cached->session)) {
+            /* keep the list in least recently used order */
+            list_remove(&cached->entry);
+            list_add_head(&ssl_session_cache, &cached->entry);
+        }
+    }
+
+    LeaveCriticalSection(&ssl_session_cs);
+}
+
+static void store_ssl_session(SSL *ssl, const WCHAR *host, INTERNET_PORT port, netconn_t *conn)
+{
+    ssl_session_t *cached;
+    SSL_SESSION *session;
+
+    session = pSSL_get1_session(ssl);
+    if(!session)
+        return;
+
+    EnterCriticalSection(&ssl_session_cs);
+
+    cached = find_ssl_session(host, port, conn);
+    if(cached) {
+        pSSL_SESSION_free(cached->session);
+        cached->session = session;
+        list_remove(&cached->entry);
+        list_add_head(&ssl_session_cache, &cached->entry);
+    }else if((cached = heap_alloc(sizeof(*cached))) && (cached->host = heap_strdupW(host))) {
+        if(ssl_session_count == MAX_SSL_SESSIONS)
+            free_ssl_session(LIST_ENTRY(list_tail(&ssl_session_cache), ssl_session_t, entry));
+
+        cached->port = port;
+        cached->security_flags = conn->security_flags;
+        cached->session = session;
+        list_add_head(&ssl_session_cache, &cached->entry);
+        ssl_session_count++;
+    }else {
+        heap_free(cached);
+        pSSL_SESSION_free(session);
+    }
+
+    LeaveCriticalSection(&ssl_session_cs);
+}
+
+static BOOL ssl_session_reused(SSL *ssl)
+{
+    if(pSSL_session_reused)
+        return pSSL_session_reused(ssl) != 0;
+#ifdef SSL_CTRL_GET_SESSION_REUSED
+    if(pSSL_ctrl)
+        return pSSL_ctrl(ssl, SSL_CTRL_GET_SESSION_REUSED, 0, NULL) != 0;
+#endif
+    return FALSE;
+}
+
+static void remove_ssl_session(const WCHAR *host, INTERNET_PORT port, netconn_t *conn)
+{
+    ssl_session_t *cached;
+
+    EnterCriticalSection(&ssl_session_cs);
+
+    cached = find_ssl_session(host, port, conn);
+    if(cached)
+        free_ssl_session(cached);
+
+    LeaveCriticalSection(&ssl_session_cs);
+}
+
 #endif
 
 static CRITICAL_SECTION init_ssl_cs;
@@ -422,8 +561,16 @@ static DWORD init_openssl(void)
     DYNSSL(SSL_CTX_set_verify);
     DYNSSL(SSL_get_current_cipher);
     DYNSSL(SSL_CIPHER_get_bits);
+    DYNSSL(SSL_get1_session);
+    DYNSSL(SSL_set_session);
+    DYNSSL(SSL_SESSION_free);
+    DYNSSL(SSL_SESSION_get_time);
+    DYNSSL(SSL_SESSION_get_timeout);
 #undef DYNSSL
 
+    pSSL_session_reused = wine_dlsym(OpenSSL_ssl_handle, "SSL_session_reused", NULL, 0);
+    pSSL_ctrl = wine_dlsym(OpenSSL_ssl_handle, "SSL_ctrl", NULL, 0);
+
 #define DYNCRYPTO(x) \
     p##x = wine_dlsym(OpenSSL_crypto_handle, #x, NULL, 0); \
     if (!p##x) { \
@@ -548,7 +695,7 @@ DWORD create_netconn(BOOL useSSL, server_t *server, DWORD security_flags, netcon
 
 void free_netconn(netconn_t *netconn)
 {
-    server_release(netconn->server);
+    server_t *server = netconn->server;
 
 #ifdef SONAME_LIBSSL
     if (netconn->ssl_s) {
@@ -559,11 +706,20 @@ void free_netconn(netconn_t *netconn)
 
     closesocket(netconn->socketFD);
     heap_free(netconn);
+
+    /* let a request waiting for a connection slot go ahead */
+    InterlockedDecrement(&server->conn_count);
+    SetEvent(server->conn_event);
+    server_release(server);
 }
 
 void NETCON_unload(void)
 {
 #if defined(SONAME_LIBSSL) && defined(SONAME_LIBCRYPTO)
+    if (ssl_session_hits || ssl_session_misses)
+        TRACE("resumed %d of %d sessions\n", ssl_session_hits, ssl_session_hits + ssl_session_misses);
+    while (!list_empty(&ssl_session_cache))
+        free_ssl_session(LIST_ENTRY(list_head(&ssl_session_cache), ssl_session_t, entry));
     if (OpenSSL_crypto_handle)
     {
         pERR_free_strings();
@@ -655,11 +811,12 @@ int sock_get_error( int err )
  * NETCON_secure_connect
  * Initiates a secure connection over an existing plaintext connection.
  */
-DWORD NETCON_secure_connect(netconn_t *connection, LPWSTR hostname)
+DWORD NETCON_secure_connect(netconn_t *connection, LPWSTR hostname, INTERNET_PORT port)
 {
     DWORD res = ERROR_NOT_SUPPORTED;
 #ifdef SONAME_LIBSSL
     void *ssl_s;
+    BOOL reused;
 
     /* can't connect if we are already connected */
     if (connection->ssl_s)
@@ -698,15 +855,29 @@ DWORD NETCON_secure_connect(netconn_t *connection, LPWSTR hostname)
         res = ERROR_INTERNET_SECURITY_CHANNEL_ERROR;
         goto fail;
     }
+
+    set_cached_ssl_session(ssl_s, hostname, port, connection);
+
     if (pSSL_connect(ssl_s) <= 0)
     {
         res = (DWORD_PTR)pSSL_get_ex_data(ssl_s, error_idx);
         if (!res)
             res = ERROR_INTERNET_SECURITY_CHANNEL_ERROR;
         ERR("SSL_connect failed: %d\n", res);
+        remove_ssl_session(hostname, port, connection);
         goto fail;
     }
 
+    reused = ssl_session_reused(ssl_s);
+    if (reused)
+        InterlockedIncrement(&ssl_session_hits);
+    else
+        InterlockedIncrement(&ssl_session_misses);
+    TRACE("%s session, %d of %d resumed\n", reused ? "resumed" : "new",
+          ssl_session_hits, ssl_session_hits + ssl_session_misses);
+
+    store_ssl_session(ssl_s, hostname, port, connection);
+
     connection->ssl_s = ssl_s;
     return ERROR_SUCCESS;
 
@@ -773,18 +944,33 @@ DWORD NETCON_recv(netconn_t *connection, void *buf, size_t len, int flags,
     else
     {
 #ifdef SONAME_LIBSSL
+        size_t size = 0;
+        int ret;
+
         if(!connection->ssl_s) {
             FIXME("not connected\n");
             return ERROR_NOT_SUPPORTED;
         }
-	*recvd = pSSL_read(connection->ssl_s, buf, len);
+
+        /* SSL_read returns at most one record, keep reading for MSG_WAITALL
+         * like recv() does so that large reads aren't cut into 16k pieces */
+        do {
+            ret = pSSL_read(connection->ssl_s, (BYTE*)buf+size, len-size);
+            if(ret <= 0)
+                break;
+            size += ret;
+        }while((flags & MSG_WAITALL) && size < len);
+
+        *recvd = size;
+        if(size)
+            return ERROR_SUCCESS;
 
         /* Check if EOF was received */
-        if(!*recvd && (pSSL_get_error(connection->ssl_s, *recvd)==SSL_ERROR_ZERO_RETURN
-                    || pSSL_get_error(connection->ssl_s, *recvd)==SSL_ERROR_SYSCALL))
+        if(!ret && (pSSL_get_error(connection->ssl_s, ret)==SSL_ERROR_ZERO_RETURN
+                    || pSSL_get_error(connection->ssl_s, ret)==SSL_ERROR_SYSCALL))
             return ERROR_SUCCESS;
 
-        return *recvd > 0 ? ERROR_SUCCESS : ERROR_INTERNET_CONNECTION_ABORTED;
+        return ERROR_INTERNET_CONNECTION_ABORTED;
 #else
 	return ERROR_NOT_SUPPORTED;
 #endif
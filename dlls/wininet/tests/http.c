@@ -1570,6 +1570,20 @@ struct server_info {
     int num_testH_retrievals;
 };
 
+static DWORD crc32_update(DWORD crc, const BYTE *data, DWORD size)
+{
+    int i;
+
+    crc = ~crc;
+    while (size--)
+    {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
 static DWORD CALLBACK server_thread(LPVOID param)
 {
     struct server_info *si = param;
@@ -1774,6 +1788,50 @@ static DWORD CALLBACK server_thread(LPVOID param)
             static const char nocontentmsg[] = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
             send(c, nocontentmsg, sizeof(nocontentmsg)-1, 0);
         }
+        if (strstr(buffer, "GET /test_large_data"))
+        {
+            static const char large_data_header[] =
+                "HTTP/1.1 200 OK\r\nContent-Length: 4194304\r\nConnection: close\r\n\r\n";
+            static char data[0x10000];
+
+            send(c, large_data_header, sizeof(large_data_header)-1, 0);
+            for (i = 0; i < sizeof(data); i++) data[i] = i * 7;
+            for (i = 0; i < 4194304 / sizeof(data); i++)
+                send(c, data, sizeof(data), 0);
+        }
+        if (strstr(buffer, "GET /test_large_gzip"))
+        {
+            /* the same data as above, as a gzip stream of stored deflate blocks */
+            static const char large_gzip_header[] =
+                "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: %u\r\nConnection: close\r\n\r\n";
+            static const BYTE gzip_header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+            static BYTE block[5 + 0x8000];
+            DWORD crc = 0, trailer[2];
+            char header[128];
+
+            for (i = 0; i < 0x8000; i++) block[5 + i] = i * 7;
+            for (i = 0; i < 4194304 / 0x8000; i++)
+                crc = crc32_update(crc, block + 5, 0x8000);
+            trailer[0] = crc;
+            trailer[1] = 4194304;
+
+            /* stored block of 0x8000 bytes */
+            block[1] = 0x00;
+            block[2] = 0x80;
+            block[3] = 0xff;
+            block[4] = 0x7f;
+
+            sprintf(header, large_gzip_header,
+                    (UINT)(sizeof(gzip_header) + 4194304 / 0x8000 * sizeof(block) + sizeof(trailer)));
+            send(c, header, strlen(header), 0);
+            send(c, (const char *)gzip_header, sizeof(gzip_header), 0);
+            for (i = 0; i < 4194304 / 0x8000; i++)
+            {
+                block[0] = (i == 4194304 / 0x8000 - 1); /* BFINAL */
+                send(c, (const char *)block, sizeof(block), 0);
+            }
+            send(c, (const char *)trailer, sizeof(trailer), 0);
+        }
         if (strstr(buffer, "GET /test_conn_close"))
         {
             static const char conn_close_response[] = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nsome content";
@@ -1822,6 +1880,130 @@ static void test_basic_request(int port, const char *verb, const char *url)
     InternetCloseHandle(hi);
 }
 
+static void test_large_data(int port, BOOL gzip)
+{
+    HINTERNET hi, hc, hr;
+    DWORD r, count, total, start, i;
+    BOOL data_ok = TRUE, decoding = TRUE, compressed = FALSE;
+    char *buffer;
+
+    hi = InternetOpen(NULL, INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
+    ok(hi != NULL, "open failed\n");
+
+    hc = InternetConnect(hi, "localhost", port, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
+    ok(hc != NULL, "connect failed\n");
+
+    hr = HttpOpenRequest(hc, NULL, gzip ? "/test_large_gzip" : "/test_large_data", NULL, NULL, NULL,
+                         INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_RELOAD, 0);
+    ok(hr != NULL, "HttpOpenRequest failed\n");
+
+    if (gzip && !InternetSetOption(hr, INTERNET_OPTION_HTTP_DECODING, &decoding, sizeof(decoding)))
+    {
+        win_skip("INTERNET_OPTION_HTTP_DECODING not supported\n");
+        InternetCloseHandle(hr);
+        InternetCloseHandle(hc);
+        InternetCloseHandle(hi);
+        return;
+    }
+
+    r = HttpSendRequest(hr, NULL, 0, NULL, 0);
+    ok(r, "HttpSendRequest failed\n");
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, 0x40000);
+    start = GetTickCount();
+    total = 0;
+    do
+    {
+        count = 0;
+        r = InternetReadFile(hr, buffer, 0x40000, &count);
+        ok(r, "InternetReadFile failed %u\n", GetLastError());
+        if (gzip && !total && count >= 2 && (BYTE)buffer[0] == 0x1f && (BYTE)buffer[1] == 0x8b)
+        {
+            skip("gzip decoding not supported\n");
+            compressed = TRUE;
+            break;
+        }
+        for (i = 0; i < count && data_ok; i++)
+            if (buffer[i] != (char)((total + i) * 7)) data_ok = FALSE;
+        total += count;
+    } while (r && count);
+
+    if (!compressed)
+    {
+        ok(total == 4194304, "read %u bytes\n", total);
+        ok(data_ok, "data corrupted\n");
+        trace("read %u bytes in %u ms\n", total, GetTickCount() - start);
+    }
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    InternetCloseHandle(hr);
+    InternetCloseHandle(hc);
+    InternetCloseHandle(hi);
+}
+
+static DWORD CALLBACK send_request_thread(LPVOID param)
+{
+    HINTERNET hr = param;
+
+    return HttpSendRequest(hr, NULL, 0, NULL, 0) ? ERROR_SUCCESS : GetLastError();
+}
+
+static void test_max_conns(int port)
+{
+    HINTERNET hi, hc, hr[3];
+    DWORD r, len, max_conns, val;
+    HANDLE thread;
+    int i;
+
+    len = sizeof(max_conns);
+    r = InternetQueryOption(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &max_conns, &len);
+    ok(r, "InternetQueryOption failed: %u\n", GetLastError());
+    val = 2;
+    r = InternetSetOption(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &val, sizeof(val));
+    ok(r, "InternetSetOption failed: %u\n", GetLastError());
+
+    hi = InternetOpen(NULL, INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
+    ok(hi != NULL, "open failed\n");
+
+    hc = InternetConnect(hi, "localhost", port, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
+    ok(hc != NULL, "connect failed\n");
+
+    for (i = 0; i < 3; i++)
+    {
+        hr[i] = HttpOpenRequest(hc, NULL, "/test1", NULL, NULL, NULL,
+                                INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_RELOAD, 0);
+        ok(hr[i] != NULL, "HttpOpenRequest failed\n");
+    }
+
+    /* the content isn't read, so each request keeps its connection */
+    for (i = 0; i < 2; i++)
+    {
+        r = HttpSendRequest(hr[i], NULL, 0, NULL, 0);
+        ok(r, "HttpSendRequest failed: %u\n", GetLastError());
+    }
+
+    /* one more request has to wait until a connection is released */
+    thread = CreateThread(NULL, 0, send_request_thread, hr[2], 0, NULL);
+    ok(thread != NULL, "CreateThread failed: %u\n", GetLastError());
+    r = WaitForSingleObject(thread, 500);
+    ok(r == WAIT_TIMEOUT, "request didn't wait for a connection\n");
+
+    InternetCloseHandle(hr[0]);
+    r = WaitForSingleObject(thread, 5000);
+    ok(r == WAIT_OBJECT_0, "request still waiting for a connection\n");
+    GetExitCodeThread(thread, &val);
+    ok(val == ERROR_SUCCESS, "HttpSendRequest failed: %u\n", val);
+    CloseHandle(thread);
+
+    InternetCloseHandle(hr[2]);
+    InternetCloseHandle(hr[1]);
+    InternetCloseHandle(hc);
+    InternetCloseHandle(hi);
+
+    r = InternetSetOption(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &max_conns, sizeof(max_conns));
+    ok(r, "InternetSetOption failed: %u\n", GetLastError());
+}
+
 static void test_last_error(int port)
 {
     HINTERNET hi, hc, hr;
@@ -2827,6 +3009,10 @@ static void test_http_connection(void)
     test_url_caching(si.port, &si.num_testH_retrievals);
     test_no_content(si.port);
     test_conn_close(si.port);
+    test_large_data(si.port, FALSE);
+    test_large_data(si.port, TRUE);
+    /* restoring the previous value still sets an explicit limit, so run it last */
+    test_max_conns(si.port);
 
     /* send the basic request again to shutdown the server thread */
     test_basic_request(si.port, "GET", "/quit");
@@ -2845,6 +3031,68 @@ static void release_cert_info(INTERNET_CERTIFICATE_INFOA *info)
     LocalFree(info->lpszEncryptionAlgName);
 }
 
+/* the second connection to the server resumes the TLS session of the first */
+static void test_secure_resume(void)
+{
+    static const char conn_close[] = "Connection: close\r\n";
+    INTERNET_CERTIFICATE_INFOA cert;
+    HINTERNET ses, con, req;
+    char subject[256];
+    DWORD size, flags;
+    BOOL ret;
+    int i;
+
+    ses = InternetOpen("winetest", INTERNET_OPEN_TYPE_PRECONFIG, NULL, NULL, 0);
+    ok(ses != NULL, "InternetOpen failed\n");
+
+    con = InternetConnect(ses, "testbot.winehq.org", INTERNET_DEFAULT_HTTPS_PORT, NULL, NULL,
+                          INTERNET_SERVICE_HTTP, 0, 0);
+    ok(con != NULL, "InternetConnect failed\n");
+
+    subject[0] = 0;
+    for (i = 0; i < 2; i++)
+    {
+        req = HttpOpenRequest(con, "GET", "/", NULL, NULL, NULL,
+                              INTERNET_FLAG_SECURE | INTERNET_FLAG_RELOAD, 0);
+        ok(req != NULL, "HttpOpenRequest failed\n");
+
+        /* don't let the second request reuse the connection */
+        ret = HttpSendRequest(req, conn_close, -1, NULL, 0);
+        if (!ret && GetLastError() == ERROR_INTERNET_NAME_NOT_RESOLVED)
+        {
+            skip("network unreachable\n");
+            InternetCloseHandle(req);
+            break;
+        }
+        ok(ret, "HttpSendRequest %d failed: %d\n", i, GetLastError());
+
+        size = sizeof(flags);
+        ret = InternetQueryOption(req, INTERNET_OPTION_SECURITY_FLAGS, &flags, &size);
+        ok(ret, "InternetQueryOption failed: %d\n", GetLastError());
+        ok(flags & SECURITY_FLAG_SECURE, "request %d: expected secure flag to be set\n", i);
+
+        /* a resumed session still reports the server certificate */
+        size = sizeof(cert);
+        ret = InternetQueryOption(req, INTERNET_OPTION_SECURITY_CERTIFICATE_STRUCT, &cert, &size);
+        ok(ret, "request %d: InternetQueryOption failed: %d\n", i, GetLastError());
+        if (ret)
+        {
+            ok(cert.lpszSubjectInfo != NULL, "request %d: expected a subject name\n", i);
+            if (!i && cert.lpszSubjectInfo)
+                lstrcpynA(subject, cert.lpszSubjectInfo, sizeof(subject));
+            else if (cert.lpszSubjectInfo)
+                ok(!strcmp(subject, cert.lpszSubjectInfo), "got subject %s, expected %s\n",
+                   cert.lpszSubjectInfo, subject);
+            release_cert_info(&cert);
+        }
+
+        InternetCloseHandle(req);
+    }
+
+    InternetCloseHandle(con);
+    InternetCloseHandle(ses);
+}
+
 static void test_secure_connection(void)
 {
     static const WCHAR gizmo5[] = {'G','i','z','m','o','5',0};
@@ -3531,6 +3779,7 @@ START_TEST(http)
     HttpHeaders_test();
     test_http_connection();
     test_secure_connection();
+    test_secure_resume();
     test_user_agent_header();
     test_bogus_accept_types_array();
     InternetReadFile_chunked_test();
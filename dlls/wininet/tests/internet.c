@@ -253,6 +253,40 @@ static void test_InternetQueryOptionA(void)
 
 }
 
+static void test_max_conns(void)
+{
+  DWORD len, val, max_conns;
+  BOOL retval;
+
+  len = sizeof(max_conns);
+  retval = InternetQueryOptionA(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &max_conns, &len);
+  ok(retval, "InternetQueryOption failed: %u\n", GetLastError());
+
+  val = 0;
+  SetLastError(0xdeadbeef);
+  retval = InternetSetOptionA(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &val, sizeof(val));
+  ok(!retval, "InternetSetOption succeeded\n");
+  ok(GetLastError() == ERROR_BAD_ARGUMENTS, "got %u\n", GetLastError());
+
+  val = 8;
+  SetLastError(0xdeadbeef);
+  retval = InternetSetOptionA(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &val, sizeof(val)-1);
+  ok(!retval, "InternetSetOption succeeded\n");
+  ok(GetLastError() == ERROR_INTERNET_BAD_OPTION_LENGTH, "got %u\n", GetLastError());
+
+  retval = InternetSetOptionA(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &val, sizeof(val));
+  ok(retval, "InternetSetOption failed: %u\n", GetLastError());
+
+  val = 0;
+  len = sizeof(val);
+  retval = InternetQueryOptionA(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &val, &len);
+  ok(retval == TRUE,"Got wrong return value %d\n", retval);
+  ok(val == 8, "got %d\n", val);
+
+  retval = InternetSetOptionA(NULL, INTERNET_OPTION_MAX_CONNS_PER_SERVER, &max_conns, sizeof(max_conns));
+  ok(retval, "InternetSetOption failed: %u\n", GetLastError());
+}
+
 static void test_get_cookie(void)
 {
   DWORD len;
@@ -1311,6 +1345,7 @@ START_TEST(internet)
     test_Option_PerConnectionOption();
     test_Option_PerConnectionOptionA();
     test_InternetErrorDlg();
+    test_max_conns();
 
     if (!pInternetTimeFromSystemTimeA)
         win_skip("skipping the InternetTime tests\n");
@@ -24,6 +24,7 @@
 
 #include "windef.h"
 #include "winbase.h"
+#include "winioctl.h"
 #include "wininet.h"
 #include "winineti.h"
 
@@ -767,6 +768,70 @@ static void test_GetDiskInfoA(void)
     ok(error == ERROR_INVALID_PARAMETER, "got %u expected ERROR_INVALID_PARAMETER\n", error);
 }
 
+static void test_scavenger(void)
+{
+    static const char sticky_url[] = "http://urlcachetest.winehq.org/sticky.html";
+    static const char large_url[] = "http://urlcachetest.winehq.org/large.html";
+    static const FILETIME filetime_zero;
+    char sticky_file[MAX_PATH], large_file[MAX_PATH];
+    LARGE_INTEGER size;
+    BYTE zero_byte = 0;
+    HANDLE file;
+    DWORD count, i;
+    BOOL ret;
+
+    /* this fills the cache, which evicts the user's entries on Windows */
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("not filling the cache on Windows\n");
+        return;
+    }
+
+    ret = CreateUrlCacheEntry(sticky_url, 0, "html", sticky_file, 0);
+    ok(ret, "CreateUrlCacheEntry failed with error %d\n", GetLastError());
+    create_and_write_file(sticky_file, &zero_byte, sizeof(zero_byte));
+    ret = CommitUrlCacheEntry(sticky_url, sticky_file, filetime_zero, filetime_zero,
+                              STICKY_CACHE_ENTRY, NULL, 0, "html", NULL);
+    ok(ret, "CommitUrlCacheEntry failed with error %d\n", GetLastError());
+
+    /* a sparse file larger than the default cache limit */
+    ret = CreateUrlCacheEntry(large_url, 0, "html", large_file, 0);
+    ok(ret, "CreateUrlCacheEntry failed with error %d\n", GetLastError());
+    file = CreateFileA(large_file, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "CreateFileA failed with error %d\n", GetLastError());
+    DeviceIoControl(file, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &count, NULL);
+    size.QuadPart = 0x40000000;
+    ret = SetFilePointerEx(file, size, NULL, FILE_BEGIN) && SetEndOfFile(file);
+    ok(ret, "couldn't extend the file: %d\n", GetLastError());
+    CloseHandle(file);
+    ret = CommitUrlCacheEntry(large_url, large_file, filetime_zero, filetime_zero,
+                              NORMAL_CACHE_ENTRY, NULL, 0, "html", NULL);
+    ok(ret, "CommitUrlCacheEntry failed with error %d\n", GetLastError());
+
+    /* the cache is freed in the background */
+    for (i = 0; i < 50; i++)
+    {
+        count = 0;
+        if (!GetUrlCacheEntryInfo(large_url, NULL, &count) && GetLastError() == ERROR_FILE_NOT_FOUND)
+            break;
+        Sleep(100);
+    }
+    ok(i < 50, "the entry that filled the cache wasn't removed\n");
+    ok(GetFileAttributesA(large_file) == INVALID_FILE_ATTRIBUTES, "the file of the entry wasn't deleted\n");
+
+    count = 0;
+    ret = GetUrlCacheEntryInfo(sticky_url, NULL, &count);
+    ok(!ret && GetLastError() == ERROR_INSUFFICIENT_BUFFER, "the sticky entry was removed: %d\n", GetLastError());
+
+    ret = DeleteUrlCacheEntry(sticky_url);
+    ok(ret, "DeleteUrlCacheEntry failed with error %d\n", GetLastError());
+    if (i == 50)
+    {
+        DeleteUrlCacheEntry(large_url);
+        DeleteFileA(large_file);
+    }
+}
+
 START_TEST(urlcache)
 {
     HMODULE hdll;
@@ -782,4 +847,5 @@ START_TEST(urlcache)
     test_urlcacheA();
     test_FindCloseUrlCache();
     test_GetDiskInfoA();
+    test_scavenger();
 }
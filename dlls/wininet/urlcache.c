@@ -71,6 +71,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(wininet);
 #define HASHTABLE_NUM_ENTRIES   (HASHTABLE_SIZE / HASHTABLE_BLOCKSIZE)
 #define NEWFILE_NUM_BLOCKS	0xd80
 #define NEWFILE_SIZE		(NEWFILE_NUM_BLOCKS * BLOCKSIZE + ENTRY_START_OFFSET)
+#define SCAVENGE_TARGET_PERCENT 90 /* usage the scavenger frees the cache down to */
 
 #define DWORD_SIG(a,b,c,d)  (a | (b << 8) | (c << 16) | (d << 24))
 #define URL_SIGNATURE   DWORD_SIG('U','R','L',' ')
@@ -175,7 +176,11 @@ typedef struct _URLCACHECONTAINER
     LPWSTR cache_prefix; /* string that has to be prefixed for this container to be used */
     LPWSTR path; /* path to url container directory */
     HANDLE hMapping; /* handle of file mapping */
+    URLCACHE_HEADER *pHeader; /* view of the mapping, kept while it is open */
     DWORD file_size; /* size of file when mapping was opened */
+    HANDLE hGeneration; /* shared mapping counting the index files created for the container */
+    LONG *generation; /* view of the count, NULL if it couldn't be created */
+    LONG index_generation; /* value of the count when the index was mapped */
     HANDLE hMutex; /* handle of mutex */
 } URLCACHECONTAINER;
 
@@ -185,6 +190,8 @@ static struct list UrlContainers = LIST_INIT(UrlContainers);
 
 static DWORD URLCache_CreateHashTable(LPURLCACHE_HEADER pHeader, HASH_CACHEFILE_ENTRY *pPrevHash, HASH_CACHEFILE_ENTRY **ppHash);
 
+static const WCHAR wszIndex[] = {'i','n','d','e','x','.','d','a','t',0};
+
 /***********************************************************************
  *           URLCache_PathToObjectName (Internal)
  *
@@ -221,8 +228,10 @@ static DWORD URLCacheContainer_OpenIndex(URLCACHECONTAINER * pContainer)
     WCHAR wszFilePath[MAX_PATH];
     DWORD dwFileSize;
 
-    static const WCHAR wszIndex[] = {'i','n','d','e','x','.','d','a','t',0};
-    static const WCHAR wszMappingFormat[] = {'%','s','%','s','_','%','l','u',0};
+    BY_HANDLE_FILE_INFORMATION info;
+    /* the file identity keeps a replaced index from sharing the old mapping */
+    static const WCHAR wszMappingFormat[] = {'%','s','%','s','_','%','l','u','_',
+                                             '%','0','8','x','%','0','8','x','%','0','8','x',0};
 
     WaitForSingleObject(pContainer->hMutex, INFINITE);
 
@@ -418,9 +427,14 @@ static DWORD URLCacheContainer_OpenIndex(URLCACHECONTAINER * pContainer)
 	    return dwError;
 	}
 
+        /* other processes may still have the previous index mapped */
+        if (pContainer->generation) InterlockedIncrement(pContainer->generation);
     }
 
-    wsprintfW(wszFilePath, wszMappingFormat, pContainer->path, wszIndex, dwFileSize);
+    if (!GetFileInformationByHandle(hFile, &info))
+        memset(&info, 0, sizeof(info));
+    wsprintfW(wszFilePath, wszMappingFormat, pContainer->path, wszIndex, dwFileSize,
+              info.dwVolumeSerialNumber, info.nFileIndexHigh, info.nFileIndexLow);
     URLCache_PathToObjectName(wszFilePath, '_');
     pContainer->hMapping = OpenFileMappingW(FILE_MAP_WRITE, FALSE, wszFilePath);
     if (!pContainer->hMapping)
@@ -433,6 +447,19 @@ static DWORD URLCacheContainer_OpenIndex(URLCACHECONTAINER * pContainer)
         return GetLastError();
     }
 
+    pContainer->pHeader = MapViewOfFile(pContainer->hMapping, FILE_MAP_WRITE, 0, 0, 0);
+    if (!pContainer->pHeader)
+    {
+        DWORD dwError = GetLastError();
+        ERR("Couldn't MapViewOfFile. Error: %d\n", dwError);
+        CloseHandle(pContainer->hMapping);
+        pContainer->hMapping = NULL;
+        ReleaseMutex(pContainer->hMutex);
+        return dwError;
+    }
+    pContainer->file_size = dwFileSize;
+    if (pContainer->generation) pContainer->index_generation = *pContainer->generation;
+
     ReleaseMutex(pContainer->hMutex);
 
     return ERROR_SUCCESS;
@@ -449,14 +476,19 @@ static DWORD URLCacheContainer_OpenIndex(URLCACHECONTAINER * pContainer)
  */
 static void URLCacheContainer_CloseIndex(URLCACHECONTAINER * pContainer)
 {
+    if (pContainer->pHeader)
+        UnmapViewOfFile(pContainer->pHeader);
+    pContainer->pHeader = NULL;
     CloseHandle(pContainer->hMapping);
     pContainer->hMapping = NULL;
 }
 
 static BOOL URLCacheContainers_AddContainer(LPCWSTR cache_prefix, LPCWSTR path, LPWSTR mutex_name)
 {
+    static const WCHAR wszGeneration[] = {'_','g','e','n','e','r','a','t','i','o','n',0};
     URLCACHECONTAINER * pContainer = heap_alloc(sizeof(URLCACHECONTAINER));
     int cache_prefix_len = strlenW(cache_prefix);
+    LPWSTR generation_name;
 
     if (!pContainer)
     {
@@ -464,7 +496,11 @@ static BOOL URLCacheContainers_AddContainer(LPCWSTR cache_prefix, LPCWSTR path,
     }
 
     pContainer->hMapping = NULL;
+    pContainer->pHeader = NULL;
     pContainer->file_size = 0;
+    pContainer->hGeneration = NULL;
+    pContainer->generation = NULL;
+    pContainer->index_generation = 0;
 
     pContainer->path = heap_strdupW(path);
     if (!pContainer->path)
@@ -494,6 +530,22 @@ static BOOL URLCacheContainers_AddContainer(LPCWSTR cache_prefix, LPCWSTR path,
         return FALSE;
     }
 
+    /* a process that creates a new index bumps the count, so that the
+     * others notice that the index they have mapped was replaced */
+    generation_name = heap_alloc((strlenW(mutex_name) + sizeof(wszGeneration) / sizeof(WCHAR)) * sizeof(WCHAR));
+    if (generation_name)
+    {
+        strcpyW(generation_name, mutex_name);
+        strcatW(generation_name, wszGeneration);
+        pContainer->hGeneration = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                                     0, sizeof(LONG), generation_name);
+        if (pContainer->hGeneration)
+            pContainer->generation = MapViewOfFile(pContainer->hGeneration, FILE_MAP_WRITE, 0, 0, sizeof(LONG));
+        heap_free(generation_name);
+    }
+    if (!pContainer->generation)
+        WARN("couldn't map the index generation (error is %d)\n", GetLastError());
+
     list_add_head(&UrlContainers, &pContainer->entry);
 
     return TRUE;
@@ -504,6 +556,8 @@ static void URLCacheContainer_DeleteContainer(URLCACHECONTAINER * pContainer)
     list_remove(&pContainer->entry);
 
     URLCacheContainer_CloseIndex(pContainer);
+    if (pContainer->generation) UnmapViewOfFile(pContainer->generation);
+    if (pContainer->hGeneration) CloseHandle(pContainer->hGeneration);
     CloseHandle(pContainer->hMutex);
     heap_free(pContainer->path);
     heap_free(pContainer->cache_prefix);
@@ -659,29 +713,18 @@ static BOOL URLCacheContainers_Enum(LPCWSTR lpwszSearchPattern, DWORD dwIndex, U
 static LPURLCACHE_HEADER URLCacheContainer_LockIndex(URLCACHECONTAINER * pContainer)
 {
     BYTE index;
-    LPVOID pIndexData;
     URLCACHE_HEADER * pHeader;
     DWORD error;
 
     /* acquire mutex */
     WaitForSingleObject(pContainer->hMutex, INFINITE);
 
-    pIndexData = MapViewOfFile(pContainer->hMapping, FILE_MAP_WRITE, 0, 0, 0);
-
-    if (!pIndexData)
-    {
-        ReleaseMutex(pContainer->hMutex);
-        ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
-        return NULL;
-    }
-    pHeader = (URLCACHE_HEADER *)pIndexData;
-
-    /* file has grown - we need to remap to prevent us getting
-     * access violations when we try and access beyond the end
-     * of the memory mapped file */
-    if (pHeader->dwFileSize != pContainer->file_size)
+    /* the view stays mapped between locks, it only has to be
+     * recreated if another process has grown or replaced the file */
+    pHeader = pContainer->pHeader;
+    if (!pHeader || pHeader->dwFileSize != pContainer->file_size ||
+        (pContainer->generation && *pContainer->generation != pContainer->index_generation))
     {
-        UnmapViewOfFile( pHeader );
         URLCacheContainer_CloseIndex(pContainer);
         error = URLCacheContainer_OpenIndex(pContainer);
         if (error != ERROR_SUCCESS)
@@ -690,15 +733,7 @@ static LPURLCACHE_HEADER URLCacheContainer_LockIndex(URLCACHECONTAINER * pContai
             SetLastError(error);
             return NULL;
         }
-        pIndexData = MapViewOfFile(pContainer->hMapping, FILE_MAP_WRITE, 0, 0, 0);
-
-        if (!pIndexData)
-        {
-            ReleaseMutex(pContainer->hMutex);
-            ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
-            return NULL;
-        }
-        pHeader = (URLCACHE_HEADER *)pIndexData;
+        pHeader = pContainer->pHeader;
     }
 
     TRACE("Signature: %s, file size: %d bytes\n", pHeader->szSignature, pHeader->dwFileSize);
@@ -718,8 +753,7 @@ static LPURLCACHE_HEADER URLCacheContainer_LockIndex(URLCACHECONTAINER * pContai
 static BOOL URLCacheContainer_UnlockIndex(URLCACHECONTAINER * pContainer, LPURLCACHE_HEADER pHeader)
 {
     /* release mutex */
-    ReleaseMutex(pContainer->hMutex);
-    return UnmapViewOfFile(pHeader);
+    return ReleaseMutex(pContainer->hMutex);
 }
 
 
@@ -2160,6 +2194,137 @@ static BOOL DeleteUrlCacheEntryInternal(LPURLCACHE_HEADER pHeader,
     return TRUE;
 }
 
+struct scavenge_entry
+{
+    FILETIME access_time;
+    struct _HASH_ENTRY *hash_entry;
+};
+
+static LONG scavenger_running;
+
+static int scavenge_entry_cmp(const void *a, const void *b)
+{
+    const struct scavenge_entry *x = a, *y = b;
+    return CompareFileTime(&x->access_time, &y->access_time);
+}
+
+/***********************************************************************
+ *           URLCache_Scavenge (Internal)
+ *
+ *  Deletes the least recently accessed entries that are neither sticky
+ * nor in use, together with their files, until the container is back
+ * below SCAVENGE_TARGET_PERCENT of its size limit.
+ *
+ */
+static void URLCache_Scavenge(URLCACHECONTAINER * pContainer)
+{
+    LPURLCACHE_HEADER pHeader;
+    HASH_CACHEFILE_ENTRY *pHashTable;
+    const struct _HASH_ENTRY *pHashEntry;
+    struct scavenge_entry *entries = NULL, *new_entries;
+    DWORD dwHashTableNumber, dwIndex, count = 0, size = 0, i;
+    ULONGLONG target;
+    WCHAR wszPath[MAX_PATH];
+    LONG lBufferSize;
+
+    if (!(pHeader = URLCacheContainer_LockIndex(pContainer)))
+        return;
+
+    if (pHeader->CacheUsage.QuadPart + pHeader->ExemptUsage.QuadPart <= pHeader->CacheLimit.QuadPart)
+        goto done;
+    target = pHeader->CacheLimit.QuadPart / 100 * SCAVENGE_TARGET_PERCENT;
+
+    for (dwHashTableNumber = 0; URLCache_EnumHashTables(pHeader, &dwHashTableNumber, &pHashTable); dwHashTableNumber++)
+    {
+        for (dwIndex = 0; URLCache_EnumHashTableEntries(pHeader, pHashTable, &dwIndex, &pHashEntry); dwIndex++)
+        {
+            const URL_CACHEFILE_ENTRY *pUrlEntry = (const URL_CACHEFILE_ENTRY *)((LPBYTE)pHeader + pHashEntry->dwOffsetEntry);
+
+            if (pUrlEntry->CacheFileEntry.dwSignature != URL_SIGNATURE ||
+                (pUrlEntry->CacheEntryType & STICKY_CACHE_ENTRY) || pUrlEntry->dwUseCount)
+                continue;
+
+            if (count == size)
+            {
+                size = size ? size * 2 : 256;
+                if (entries)
+                    new_entries = heap_realloc(entries, size * sizeof(*entries));
+                else
+                    new_entries = heap_alloc(size * sizeof(*entries));
+                if (!new_entries)
+                    goto done;
+                entries = new_entries;
+            }
+            entries[count].access_time = pUrlEntry->LastAccessTime;
+            entries[count].hash_entry = (struct _HASH_ENTRY *)pHashEntry;
+            count++;
+        }
+    }
+
+    qsort(entries, count, sizeof(*entries), scavenge_entry_cmp);
+
+    for (i = 0; i < count && pHeader->CacheUsage.QuadPart + pHeader->ExemptUsage.QuadPart > target; i++)
+    {
+        const URL_CACHEFILE_ENTRY *pUrlEntry = (const URL_CACHEFILE_ENTRY *)((LPBYTE)pHeader + entries[i].hash_entry->dwOffsetEntry);
+
+        if (pUrlEntry->dwOffsetLocalName)
+        {
+            lBufferSize = sizeof(wszPath);
+            if (URLCache_LocalFileNameToPathW(pContainer, pHeader, (LPCSTR)pUrlEntry + pUrlEntry->dwOffsetLocalName,
+                                              pUrlEntry->CacheDir, wszPath, &lBufferSize) &&
+                !DeleteFileW(wszPath) && GetLastError() != ERROR_FILE_NOT_FOUND)
+            {
+                /* the file is still open somewhere, keep the entry */
+                TRACE("couldn't delete %s\n", debugstr_w(wszPath));
+                continue;
+            }
+        }
+
+        TRACE("deleting %s\n", debugstr_a((LPCSTR)pUrlEntry + pUrlEntry->dwOffsetUrl));
+        DeleteUrlCacheEntryInternal(pHeader, entries[i].hash_entry);
+    }
+
+done:
+    URLCacheContainer_UnlockIndex(pContainer, pHeader);
+    heap_free(entries);
+}
+
+static DWORD WINAPI URLCache_ScavengeProc(void *arg)
+{
+    URLCache_Scavenge(arg);
+    InterlockedExchange(&scavenger_running, FALSE);
+
+    FreeLibraryAndExitThread(WININET_hModule, 0);
+}
+
+/***********************************************************************
+ *           URLCache_StartScavenger (Internal)
+ *
+ *  Frees space in the container on a background thread, unless a
+ * scavenger is already running.
+ *
+ */
+static void URLCache_StartScavenger(URLCACHECONTAINER * pContainer)
+{
+    HANDLE thread = NULL;
+    HMODULE module;
+
+    if (InterlockedCompareExchange(&scavenger_running, TRUE, FALSE))
+        return;
+
+    GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR*)WININET_hModule, &module);
+    if (module)
+        thread = CreateThread(NULL, 0, URLCache_ScavengeProc, pContainer, 0, NULL);
+    if (thread)
+        CloseHandle(thread);
+    else
+    {
+        InterlockedExchange(&scavenger_running, FALSE);
+        if (module)
+            FreeLibrary(module);
+    }
+}
+
 /***********************************************************************
  *           UnlockUrlCacheEntryFileA (WININET.@)
  *
@@ -2577,6 +2742,7 @@ static BOOL CommitUrlCacheEntryInternal(
     DWORD dwOffsetHeader = 0;
     DWORD dwOffsetFileExtension = 0;
     LARGE_INTEGER file_size;
+    BOOL scavenge = FALSE;
     BYTE cDirectory = 0;
     char achFile[MAX_PATH];
     LPSTR lpszUrlNameA = NULL;
@@ -2790,7 +2956,10 @@ static BOOL CommitUrlCacheEntryInternal(
             pHeader->CacheUsage.QuadPart += file_size.QuadPart;
         if (pHeader->CacheUsage.QuadPart + pHeader->ExemptUsage.QuadPart >
             pHeader->CacheLimit.QuadPart)
-            FIXME("file of size %s bytes fills cache\n", wine_dbgstr_longlong(file_size.QuadPart));
+        {
+            TRACE("file of size %s bytes fills cache\n", wine_dbgstr_longlong(file_size.QuadPart));
+            scavenge = TRUE;
+        }
     }
 
 cleanup:
@@ -2798,6 +2967,9 @@ cleanup:
     heap_free(lpszUrlNameA);
     heap_free(lpszFileExtensionA);
 
+    if (scavenge)
+        URLCache_StartScavenger(pContainer);
+
     if (error == ERROR_SUCCESS)
         return TRUE;
     else
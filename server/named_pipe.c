@@ -77,6 +77,8 @@ struct pipe_server
     struct timeout_user *flush_poll;
     struct event        *event;
     unsigned int         options;    /* pipe options */
+    unsigned int         pipe_flags; /* read mode of this end */
+    int                  msg_socket; /* socket keeps message boundaries */
 };
 
 struct pipe_client
@@ -85,6 +87,8 @@ struct pipe_client
     struct fd           *fd;         /* pipe file descriptor */
     struct pipe_server  *server;     /* server that this client is connected to */
     unsigned int         flags;      /* file flags */
+    unsigned int         pipe_flags; /* read mode of this end */
+    int                  msg_socket; /* socket keeps message boundaries */
 };
 
 struct named_pipe
@@ -577,14 +581,18 @@ static inline int is_overlapped( unsigned int options )
     return !(options & (FILE_SYNCHRONOUS_IO_ALERT | FILE_SYNCHRONOUS_IO_NONALERT));
 }
 
+/* the read mode isn't part of the fd type, since the fd is cached by the
+ * clients and the mode can be changed through any handle */
 static enum server_fd_type pipe_server_get_fd_type( struct fd *fd )
 {
-    return FD_TYPE_PIPE;
+    struct pipe_server *server = get_fd_user( fd );
+    return server->msg_socket ? FD_TYPE_PIPE_MESSAGE : FD_TYPE_PIPE;
 }
 
 static enum server_fd_type pipe_client_get_fd_type( struct fd *fd )
 {
-    return FD_TYPE_PIPE;
+    struct pipe_client *client = get_fd_user( fd );
+    return client->msg_socket ? FD_TYPE_PIPE_MESSAGE : FD_TYPE_PIPE;
 }
 
 static obj_handle_t alloc_wait_event( struct process *process )
@@ -750,6 +758,8 @@ static struct pipe_server *create_pipe_server( struct named_pipe *pipe, unsigned
     server->client = NULL;
     server->flush_poll = NULL;
     server->options = options;
+    server->pipe_flags = pipe->flags & (NAMED_PIPE_MESSAGE_STREAM_READ | NAMED_PIPE_NONBLOCKING_MODE);
+    server->msg_socket = 0;
 
     list_add_head( &pipe->servers, &server->entry );
     grab_object( pipe );
@@ -773,6 +783,8 @@ static struct pipe_client *create_pipe_client( unsigned int flags )
     client->fd = NULL;
     client->server = NULL;
     client->flags = flags;
+    client->pipe_flags = 0;  /* clients always start in byte read mode */
+    client->msg_socket = 0;
 
     return client;
 }
@@ -805,7 +817,7 @@ static struct object *named_pipe_open_file( struct object *obj, unsigned int acc
     struct pipe_server *server;
     struct pipe_client *client;
     unsigned int pipe_sharing;
-    int fds[2];
+    int fds[2], msg_socket = 0, ret = -1;
 
     if (!(server = find_available_server( pipe )))
     {
@@ -824,7 +836,17 @@ static struct object *named_pipe_open_file( struct object *obj, unsigned int acc
 
     if ((client = create_pipe_client( options )))
     {
-        if (!socketpair( PF_UNIX, SOCK_STREAM, 0, fds ))
+#if defined(SOCK_SEQPACKET) && defined(__linux__)
+        /* message-type pipes use a socket that keeps the message boundaries,
+         * so that clients can read and write messages directly on the fd.
+         * Only done on Linux, where recv() with MSG_TRUNC returns the real
+         * size of a packet; ntdll splits the messages that don't fit in one. */
+        if (pipe->flags & NAMED_PIPE_MESSAGE_STREAM_WRITE)
+            msg_socket = !(ret = socketpair( PF_UNIX, SOCK_SEQPACKET, 0, fds ));
+#endif
+        if (ret) ret = socketpair( PF_UNIX, SOCK_STREAM, 0, fds );
+
+        if (!ret)
         {
             assert( !server->fd );
 
@@ -856,7 +878,9 @@ static struct object *named_pipe_open_file( struct object *obj, unsigned int acc
                     fd_async_wake_up( server->ioctl_fd, ASYNC_TYPE_WAIT, STATUS_SUCCESS );
                 set_server_state( server, ps_connected_server );
                 server->client = client;
+                server->msg_socket = msg_socket;
                 client->server = server;
+                client->msg_socket = msg_socket;
             }
             else
             {
@@ -1023,10 +1047,16 @@ DECL_HANDLER(get_named_pipe_info)
         client = (struct pipe_client *)get_handle_obj( current->process, req->handle,
                                                        0, &pipe_client_ops );
         if (!client) return;
-        server = client->server;
+        if (!(server = client->server))
+        {
+            set_error( STATUS_PIPE_DISCONNECTED );
+            release_object( client );
+            return;
+        }
     }
 
-    reply->flags        = server->pipe->flags;
+    reply->flags        = server->pipe->flags & ~(NAMED_PIPE_MESSAGE_STREAM_READ | NAMED_PIPE_NONBLOCKING_MODE);
+    reply->flags       |= client ? client->pipe_flags : server->pipe_flags;
     reply->sharing      = server->pipe->sharing;
     reply->maxinstances = server->pipe->maxinstances;
     reply->instances    = server->pipe->instances;
@@ -1041,3 +1071,43 @@ DECL_HANDLER(get_named_pipe_info)
         release_object(server);
     }
 }
+
+DECL_HANDLER(set_named_pipe_info)
+{
+    struct pipe_server *server;
+    struct pipe_client *client = NULL;
+
+    server = get_pipe_server_obj( current->process, req->handle, FILE_WRITE_ATTRIBUTES );
+    if (!server)
+    {
+        if (get_error() != STATUS_OBJECT_TYPE_MISMATCH)
+            return;
+
+        clear_error();
+        client = (struct pipe_client *)get_handle_obj( current->process, req->handle,
+                                                       FILE_WRITE_ATTRIBUTES, &pipe_client_ops );
+        if (!client) return;
+        if (!(server = client->server))
+        {
+            set_error( STATUS_PIPE_DISCONNECTED );
+            release_object( client );
+            return;
+        }
+    }
+
+    if ((req->flags & ~(NAMED_PIPE_MESSAGE_STREAM_READ | NAMED_PIPE_NONBLOCKING_MODE)) ||
+        ((req->flags & NAMED_PIPE_MESSAGE_STREAM_READ) && !(server->pipe->flags & NAMED_PIPE_MESSAGE_STREAM_WRITE)))
+    {
+        /* a byte-type pipe can't be read in message mode */
+        set_error( STATUS_INVALID_PARAMETER );
+    }
+    else if (client)
+        client->pipe_flags = req->flags;
+    else
+        server->pipe_flags = req->flags;
+
+    if (client)
+        release_object( client );
+    else
+        release_object( server );
+}
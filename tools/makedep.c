@@ -29,6 +29,8 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
@@ -37,9 +39,13 @@
 /* Max first-level includes per file */
 #define MAX_INCLUDES 200
 
+/* Size of the file name hash tables */
+#define HASH_SIZE 997
+
 typedef struct _INCL_FILE
 {
     struct list        entry;
+    struct list        hash_entry;
     char              *name;
     char              *filename;
     char              *sourcename;    /* source file name for generated headers */
@@ -52,6 +58,39 @@ typedef struct _INCL_FILE
 
 static struct list sources = LIST_INIT(sources);
 static struct list includes = LIST_INIT(includes);
+static struct list source_hash[HASH_SIZE];
+static struct list include_hash[HASH_SIZE];
+
+/* the includes found in a file, kept across directories so that a given
+ * file is only read and parsed once */
+enum file_type
+{
+    FILE_C,       /* C or rc-like #include directives */
+    FILE_RC,      /* resource file */
+    FILE_IDL,     /* idl file */
+    FILE_IDL_H    /* header generated from an idl file */
+};
+
+typedef struct _PARSED_INCLUDE
+{
+    char *name;
+    int   line;
+    int   system;
+} PARSED_INCLUDE;
+
+typedef struct _PARSED_FILE
+{
+    struct list     entry;
+    dev_t           dev;
+    ino_t           ino;
+    enum file_type  type;
+    unsigned int    count;
+    unsigned int    size;
+    PARSED_INCLUDE *includes;
+} PARSED_FILE;
+
+static struct list parsed_files[HASH_SIZE];
+static PARSED_FILE *parsing;
 
 typedef struct _OBJECT_EXTENSION
 {
@@ -75,6 +114,7 @@ static const char *top_obj_dir;
 static const char *OutputFileName = "Makefile";
 static const char *Separator = "### Dependencies";
 static const char *ProgramName;
+static const char *DirListName;
 static int input_line;
 
 static const char Usage[] =
@@ -85,7 +125,10 @@ static const char Usage[] =
     "   -Sdir   Set the top source directory\n"
     "   -Tdir   Set the top object directory\n"
     "   -fxxx   Store output in file 'xxx' (default: Makefile)\n"
-    "   -sxxx   Use 'xxx' as separator (default: \"### Dependencies\")\n";
+    "   -sxxx   Use 'xxx' as separator (default: \"### Dependencies\")\n"
+    "   -Mxxx   Read a list of directories from file 'xxx', one per line, each\n"
+    "           followed by its own options and files; the command line options\n"
+    "           apply to all of them\n";
 
 
 /*******************************************************************
@@ -249,6 +292,16 @@ static void add_include_path( const char *name )
     path->name = name;
 }
 
+/*******************************************************************
+ *         hash_filename
+ */
+static unsigned int hash_filename( const char *name )
+{
+    unsigned int ret = 0;
+    while (*name) ret = (ret << 7) + (ret << 3) + *name++;
+    return ret % HASH_SIZE;
+}
+
 /*******************************************************************
  *         find_src_file
  */
@@ -256,7 +309,7 @@ static INCL_FILE *find_src_file( const char *name )
 {
     INCL_FILE *file;
 
-    LIST_FOR_EACH_ENTRY( file, &sources, INCL_FILE, entry )
+    LIST_FOR_EACH_ENTRY( file, &source_hash[hash_filename( name )], INCL_FILE, hash_entry )
         if (!strcmp( name, file->name )) return file;
     return NULL;
 }
@@ -268,7 +321,7 @@ static INCL_FILE *find_include_file( const char *name )
 {
     INCL_FILE *file;
 
-    LIST_FOR_EACH_ENTRY( file, &includes, INCL_FILE, entry )
+    LIST_FOR_EACH_ENTRY( file, &include_hash[hash_filename( name )], INCL_FILE, hash_entry )
         if (!strcmp( name, file->name )) return file;
     return NULL;
 }
@@ -284,6 +337,19 @@ static INCL_FILE *add_include( INCL_FILE *pFile, const char *name, int line, int
     char *ext;
     int pos;
 
+    if (parsing)
+    {
+        if (parsing->count == parsing->size)
+        {
+            parsing->size = parsing->size ? parsing->size * 2 : 16;
+            parsing->includes = xrealloc( parsing->includes, parsing->size * sizeof(*parsing->includes) );
+        }
+        parsing->includes[parsing->count].name = xstrdup( name );
+        parsing->includes[parsing->count].line = line;
+        parsing->includes[parsing->count].system = system;
+        parsing->count++;
+    }
+
     for (pos = 0; pos < MAX_INCLUDES; pos++) if (!pFile->files[pos]) break;
     if (pos >= MAX_INCLUDES)
         fatal_error( "%s: %s: error: too many included files, please fix MAX_INCLUDES\n",
@@ -319,8 +385,7 @@ static INCL_FILE *add_include( INCL_FILE *pFile, const char *name, int line, int
                          pFile->filename, line );
     }
 
-    LIST_FOR_EACH_ENTRY( include, &includes, INCL_FILE, entry )
-        if (!strcmp( name, include->name )) goto found;
+    if ((include = find_include_file( name ))) goto found;
 
     include = xmalloc( sizeof(INCL_FILE) );
     memset( include, 0, sizeof(INCL_FILE) );
@@ -329,6 +394,7 @@ static INCL_FILE *add_include( INCL_FILE *pFile, const char *name, int line, int
     include->included_line = line;
     include->system = system;
     list_add_tail( &includes, &include->entry );
+    list_add_tail( &include_hash[hash_filename( name )], &include->hash_entry );
 found:
     pFile->files[pos] = include;
     return include;
@@ -770,12 +836,49 @@ static void parse_generated_idl( INCL_FILE *source )
     free( basename );
 }
 
+/*******************************************************************
+ *         get_parsed_file
+ *
+ * Find the includes of an already parsed file, or start recording them.
+ */
+static PARSED_FILE *get_parsed_file( FILE *file, enum file_type type, int *found )
+{
+    struct stat st;
+    PARSED_FILE *parsed;
+    struct list *bucket;
+
+    *found = 0;
+    if (fstat( fileno(file), &st ) == -1 || !st.st_ino) return NULL;
+
+    bucket = &parsed_files[(unsigned int)st.st_ino % HASH_SIZE];
+    LIST_FOR_EACH_ENTRY( parsed, bucket, PARSED_FILE, entry )
+    {
+        if (parsed->ino == st.st_ino && parsed->dev == st.st_dev && parsed->type == type)
+        {
+            *found = 1;
+            return parsed;
+        }
+    }
+
+    parsed = xmalloc( sizeof(*parsed) );
+    memset( parsed, 0, sizeof(*parsed) );
+    parsed->dev = st.st_dev;
+    parsed->ino = st.st_ino;
+    parsed->type = type;
+    list_add_tail( bucket, &parsed->entry );
+    return parsed;
+}
+
 /*******************************************************************
  *         parse_file
  */
 static void parse_file( INCL_FILE *pFile, int src )
 {
     FILE *file;
+    PARSED_FILE *parsed;
+    enum file_type type;
+    unsigned int i;
+    int found;
 
     /* special case for source files generated from idl */
     if (strendswith( pFile->name, "_c.c" ) ||
@@ -801,16 +904,42 @@ static void parse_file( INCL_FILE *pFile, int src )
     if (!file) return;
 
     if (pFile->sourcename && strendswith( pFile->sourcename, ".idl" ))
-        parse_idl_file( pFile, file, 1 );
+        type = FILE_IDL_H;
     else if (strendswith( pFile->filename, ".idl" ))
-        parse_idl_file( pFile, file, 0 );
+        type = FILE_IDL;
     else if (strendswith( pFile->filename, ".c" ) ||
              strendswith( pFile->filename, ".h" ) ||
              strendswith( pFile->filename, ".l" ) ||
              strendswith( pFile->filename, ".y" ))
-        parse_c_file( pFile, file );
+        type = FILE_C;
     else if (strendswith( pFile->filename, ".rc" ))
-        parse_rc_file( pFile, file );
+        type = FILE_RC;
+    else
+    {
+        fclose(file);
+        return;
+    }
+
+    parsed = get_parsed_file( file, type, &found );
+    if (found)
+    {
+        /* replay the includes found the first time */
+        for (i = 0; i < parsed->count; i++)
+            add_include( pFile, parsed->includes[i].name,
+                         parsed->includes[i].line, parsed->includes[i].system );
+        fclose(file);
+        return;
+    }
+
+    parsing = parsed;
+    switch (type)
+    {
+    case FILE_IDL_H: parse_idl_file( pFile, file, 1 ); break;
+    case FILE_IDL:   parse_idl_file( pFile, file, 0 ); break;
+    case FILE_C:     parse_c_file( pFile, file ); break;
+    case FILE_RC:    parse_rc_file( pFile, file ); break;
+    }
+    parsing = NULL;
     fclose(file);
 }
 
@@ -829,6 +958,7 @@ static INCL_FILE *add_src_file( const char *name )
     memset( file, 0, sizeof(*file) );
     file->name = xstrdup(name);
     list_add_tail( &sources, &file->entry );
+    list_add_tail( &source_hash[hash_filename( name )], &file->hash_entry );
     parse_file( file, 1 );
     return file;
 }
@@ -1060,6 +1190,9 @@ static void parse_option( const char *opt )
     case 'x':
         if (opt[2]) add_object_extension( opt + 2 );
         break;
+    case 'M':
+        if (opt[2]) DirListName = opt + 2;
+        break;
     default:
         fprintf( stderr, "Unknown option '%s'\n", opt );
         fprintf( stderr, Usage, ProgramName );
@@ -1069,18 +1202,68 @@ static void parse_option( const char *opt )
 
 
 /*******************************************************************
- *         main
+ *         init_state
+ *
+ * Reset the per-directory state to the defaults.
  */
-int main( int argc, char *argv[] )
+static void init_state(void)
 {
-    INCL_FILE *pFile;
-    INCL_PATH *path, *next;
-    int i, j;
+    int i;
+
+    src_dir = NULL;
+    top_src_dir = NULL;
+    top_obj_dir = NULL;
+    OutputFileName = "Makefile";
+    Separator = "### Dependencies";
+    list_init( &sources );
+    list_init( &includes );
+    list_init( &paths );
+    list_init( &object_extensions );
+    for (i = 0; i < HASH_SIZE; i++)
+    {
+        list_init( &source_hash[i] );
+        list_init( &include_hash[i] );
+    }
+}
+
+
+/*******************************************************************
+ *         free_state
+ */
+static void free_state(void)
+{
+    INCL_FILE *file, *next_file;
+    INCL_PATH *path, *next_path;
+    OBJECT_EXTENSION *ext, *next_ext;
+
+    LIST_FOR_EACH_ENTRY_SAFE( file, next_file, &sources, INCL_FILE, entry )
+    {
+        free( file->name );
+        free( file->filename );
+        free( file->sourcename );
+        free( file );
+    }
+    LIST_FOR_EACH_ENTRY_SAFE( file, next_file, &includes, INCL_FILE, entry )
+    {
+        free( file->name );
+        free( file->filename );
+        free( file->sourcename );
+        free( file );
+    }
+    LIST_FOR_EACH_ENTRY_SAFE( path, next_path, &paths, INCL_PATH, entry ) free( path );
+    LIST_FOR_EACH_ENTRY_SAFE( ext, next_ext, &object_extensions, OBJECT_EXTENSION, entry ) free( ext );
+}
 
-    if ((ProgramName = strrchr( argv[0], '/' ))) ProgramName++;
-    else ProgramName = argv[0];
 
-    i = 1;
+/*******************************************************************
+ *         parse_options
+ *
+ * Parse the options, and remove them from the argument list.
+ */
+static int parse_options( int argc, char *argv[] )
+{
+    int i = 1, j;
+
     while (i < argc)
     {
         if (argv[i][0] == '-')
@@ -1091,6 +1274,21 @@ int main( int argc, char *argv[] )
         }
         else i++;
     }
+    return argc;
+}
+
+
+/*******************************************************************
+ *         make_dependencies
+ *
+ * Output the dependencies of the given source files, once the options
+ * for the current directory have been set.
+ */
+static void make_dependencies( int argc, char *argv[] )
+{
+    INCL_FILE *pFile;
+    INCL_PATH *path, *next;
+    int i;
 
     /* ignore redundant source paths */
     if (src_dir && !strcmp( src_dir, "." )) src_dir = NULL;
@@ -1120,5 +1318,116 @@ int main( int argc, char *argv[] )
     }
     LIST_FOR_EACH_ENTRY( pFile, &includes, INCL_FILE, entry ) parse_file( pFile, 0 );
     output_dependencies();
+}
+
+
+/*******************************************************************
+ *         make_dir_list_dependencies
+ *
+ * Process each directory of the list file in turn. Each line contains a
+ * directory name followed by the arguments that would be passed to makedep
+ * when running from that directory, so that parsed files can be shared
+ * between directories.
+ */
+static void make_dir_list_dependencies( int nb_opts, char *opts[] )
+{
+    FILE *list;
+    char *buffer, *line, *p, *cwd;
+    char **argv = NULL;
+    int argc, max_argc = 0, i;
+    size_t size = 256;
+
+    if (!(list = fopen( DirListName, "r" )))
+    {
+        perror( DirListName );
+        exit(1);
+    }
+
+    for (;;)
+    {
+        cwd = xmalloc( size );
+        if (getcwd( cwd, size )) break;
+        if (errno != ERANGE) fatal_error( "%s: error: cannot get current directory\n", ProgramName );
+        free( cwd );
+        size *= 2;
+    }
+
+    while ((buffer = get_line( list )))
+    {
+        line = xstrdup( buffer );
+        argc = 0;
+        for (p = strtok( line, " \t" ); p; p = strtok( NULL, " \t" ))
+        {
+            if (argc + 1 >= max_argc)
+            {
+                max_argc = max_argc ? max_argc * 2 : 64;
+                argv = xrealloc( argv, max_argc * sizeof(*argv) );
+            }
+            argv[argc++] = p;
+        }
+        if (!argc)
+        {
+            free( line );
+            continue;
+        }
+        argv[argc] = NULL;
+
+        if (chdir( argv[0] ) == -1)
+        {
+            fprintf( stderr, "%s: error: ", ProgramName );
+            perror( argv[0] );
+            exit(1);
+        }
+
+        init_state();
+        for (i = 0; i < nb_opts; i++) parse_option( opts[i] );
+        argc = parse_options( argc, argv );
+        make_dependencies( argc, argv );
+        free_state();
+        free( line );
+
+        if (chdir( cwd ) == -1)
+        {
+            fprintf( stderr, "%s: error: ", ProgramName );
+            perror( cwd );
+            exit(1);
+        }
+    }
+
+    fclose( list );
+    free( argv );
+    free( cwd );
+}
+
+
+/*******************************************************************
+ *         main
+ */
+int main( int argc, char *argv[] )
+{
+    char **opts;
+    int i, nb_opts = 0;
+
+    if ((ProgramName = strrchr( argv[0], '/' ))) ProgramName++;
+    else ProgramName = argv[0];
+
+    for (i = 0; i < HASH_SIZE; i++) list_init( &parsed_files[i] );
+    init_state();
+
+    /* save the options, they apply to every directory of a list file */
+    opts = xmalloc( argc * sizeof(*opts) );
+    for (i = 1; i < argc; i++) if (argv[i][0] == '-') opts[nb_opts++] = argv[i];
+
+    argc = parse_options( argc, argv );
+
+    if (DirListName)
+    {
+        if (argc > 1) fatal_error( "%s: error: source files cannot be used with -M\n", ProgramName );
+        free_state();
+        make_dir_list_dependencies( nb_opts, opts );
+        return 0;
+    }
+
+    make_dependencies( argc, argv );
     return 0;
 }